@@ -0,0 +1,154 @@
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+volatile uint32_t bench_sink;
+
+// Thời gian một lần gọi của từng lô (tĩnh: target có stack nhỏ)
+static double s_samples[BENCH_MAX_REPETITIONS];
+
+void bench_default_config(bench_config_t *config)
+{
+    config->warmup = 20;
+    config->repetitions = 200;
+    config->min_rep_ticks = 0;
+    config->filter = NULL;
+}
+
+static uint64_t time_batch(const bench_case_t *bench, uint32_t iterations)
+{
+    uint64_t start = bench_clock();
+    bench->run(iterations);
+    return bench_clock() - start;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Phân vị theo nearest-rank trên mảng đã sắp xếp
+ */
+static double percentile(const double *sorted, uint32_t count, uint32_t pct)
+{
+    uint32_t rank = (count * pct + 99) / 100;
+    return sorted[(rank > 0 ? rank : 1) - 1];
+}
+
+int bench_run_case(const bench_case_t *bench, const bench_config_t *config, bench_result_t *result)
+{
+    if (bench == NULL || config == NULL || result == NULL ||
+        config->repetitions == 0 || config->repetitions > BENCH_MAX_REPETITIONS) {
+        return -1;
+    }
+
+    // Chọn kích thước lô: nhân đôi tới khi lô đủ dài
+    uint32_t iterations = 1;
+    while (iterations < BENCH_MAX_ITERATIONS && time_batch(bench, iterations) < config->min_rep_ticks) {
+        iterations *= 2;
+    }
+
+    for (uint32_t i = 0; i < config->warmup; i++) {
+        time_batch(bench, iterations);
+    }
+
+    double sum = 0.0;
+    for (uint32_t i = 0; i < config->repetitions; i++) {
+        s_samples[i] = (double)time_batch(bench, iterations) / iterations;
+        sum += s_samples[i];
+    }
+    qsort(s_samples, config->repetitions, sizeof(s_samples[0]), compare_double);
+
+    result->name = bench->name;
+    result->iterations = iterations;
+    result->repetitions = config->repetitions;
+    result->min = s_samples[0];
+    result->median = percentile(s_samples, config->repetitions, 50);
+    result->p99 = percentile(s_samples, config->repetitions, 99);
+    result->max = s_samples[config->repetitions - 1];
+    result->mean = sum / config->repetitions;
+    result->bytes = (bench->bytes != NULL) ? bench->bytes() : 0;
+    return 0;
+}
+
+static void print_header(bench_format_t format, const bench_config_t *config)
+{
+    switch (format) {
+    case BENCH_FORMAT_CSV:
+        printf("name,unit,iterations,repetitions,min,median,p99,max,mean,bytes\n");
+        break;
+    case BENCH_FORMAT_JSON:
+        printf("{\"unit\":\"%s\",\"warmup\":%lu,\"repetitions\":%lu,\"results\":[",
+               bench_clock_unit, (unsigned long)config->warmup, (unsigned long)config->repetitions);
+        break;
+    default:
+        printf("%-28s %10s %10s %10s %10s %10s %8s  (%s/call, %lu reps)\n",
+               "benchmark", "iters", "min", "median", "p99", "max", "bytes",
+               bench_clock_unit, (unsigned long)config->repetitions);
+        break;
+    }
+}
+
+static void print_result(bench_format_t format, const bench_result_t *r, bool first)
+{
+    // Case không tạo payload: cột bytes để trống (CSV), "-" (text), bỏ trường (JSON)
+    char bytes[12] = "";
+    if (r->bytes > 0) {
+        snprintf(bytes, sizeof(bytes), "%lu", (unsigned long)r->bytes);
+    }
+
+    switch (format) {
+    case BENCH_FORMAT_CSV:
+        printf("%s,%s,%lu,%lu,%.1f,%.1f,%.1f,%.1f,%.1f,%s\n",
+               r->name, bench_clock_unit, (unsigned long)r->iterations, (unsigned long)r->repetitions,
+               r->min, r->median, r->p99, r->max, r->mean, bytes);
+        break;
+    case BENCH_FORMAT_JSON:
+        printf("%s{\"name\":\"%s\",\"iterations\":%lu,\"min\":%.1f,\"median\":%.1f,"
+               "\"p99\":%.1f,\"max\":%.1f,\"mean\":%.1f",
+               first ? "" : ",", r->name, (unsigned long)r->iterations,
+               r->min, r->median, r->p99, r->max, r->mean);
+        if (r->bytes > 0) {
+            printf(",\"bytes\":%s", bytes);
+        }
+        printf("}");
+        break;
+    default:
+        printf("%-28s %10lu %10.1f %10.1f %10.1f %10.1f %8s\n",
+               r->name, (unsigned long)r->iterations, r->min, r->median, r->p99, r->max,
+               r->bytes > 0 ? bytes : "-");
+        break;
+    }
+    fflush(stdout);
+}
+
+int bench_run_all(const bench_config_t *config, bench_format_t format)
+{
+    if (config == NULL) {
+        return -1;
+    }
+
+    int count = 0;
+    print_header(format, config);
+    for (size_t i = 0; i < bench_case_count; i++) {
+        const bench_case_t *bench = &bench_cases[i];
+        if (config->filter != NULL && strstr(bench->name, config->filter) == NULL) {
+            continue;
+        }
+
+        bench_result_t result;
+        if (bench_run_case(bench, config, &result) != 0) {
+            return -1;
+        }
+        print_result(format, &result, count == 0);
+        count++;
+    }
+    if (format == BENCH_FORMAT_JSON) {
+        printf("]}\n");
+    }
+    return count;
+}
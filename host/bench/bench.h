@@ -0,0 +1,99 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Bộ micro-benchmark cho các đường nóng của firmware, dùng chung cho bản
+ * host (bench_main.c, đồng hồ CLOCK_MONOTONIC, đơn vị ns) và bản chạy trên
+ * ESP32 (target/, bộ đếm chu kỳ CCOUNT, đơn vị cycle).
+ *
+ * Mỗi case được gọi theo lô `iterations` lần; số lần trong lô được nhân đôi
+ * cho tới khi một lô dài ít nhất min_rep_ticks để sai số của đồng hồ không
+ * đáng kể. Sau `warmup` lô bỏ đi, `repetitions` lô được đo và báo min,
+ * median, p99, max, mean của thời gian một lần gọi.
+ */
+
+#define BENCH_MAX_REPETITIONS 1000
+#define BENCH_MAX_ITERATIONS (1UL << 24)
+
+typedef struct {
+    const char *name;
+    const char *description;
+    void (*run)(uint32_t iterations);   // Gọi đường nóng `iterations` lần
+    uint32_t (*bytes)(void);            // Độ dài payload một lần gọi (case serialize), NULL nếu không có
+} bench_case_t;
+
+typedef struct {
+    uint32_t warmup;            // Số lô chạy trước, không đo
+    uint32_t repetitions;       // Số lô được đo (<= BENCH_MAX_REPETITIONS)
+    uint64_t min_rep_ticks;     // Thời gian tối thiểu của một lô (đơn vị bench_clock())
+    const char *filter;         // Chỉ chạy case có tên chứa chuỗi này (NULL: tất cả)
+} bench_config_t;
+
+typedef struct {
+    const char *name;
+    uint32_t iterations;        // Số lần gọi trong một lô
+    uint32_t repetitions;
+    // Thời gian một lần gọi (đơn vị bench_clock())
+    double min;
+    double median;
+    double p99;
+    double max;
+    double mean;
+    uint32_t bytes;             // Độ dài payload (bytes), 0 nếu case không tạo payload
+} bench_result_t;
+
+typedef enum {
+    BENCH_FORMAT_TEXT = 0,
+    BENCH_FORMAT_CSV,
+    BENCH_FORMAT_JSON,
+} bench_format_t;
+
+// ==== Do chương trình chạy (host/target) cung cấp ====
+
+/**
+ * @brief Đồng hồ đo, đơn vị bench_clock_unit
+ */
+uint64_t bench_clock(void);
+
+extern const char *const bench_clock_unit;
+
+// ==== Case (bench_cases.c) ====
+
+extern const bench_case_t bench_cases[];
+extern const size_t bench_case_count;
+
+/**
+ * @brief Khởi tạo trạng thái chung của các case (cảm biến, MQTT, dữ liệu đầu vào)
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int bench_cases_init(void);
+
+// ==== Chạy và báo cáo ====
+
+/**
+ * @brief Giá trị mà case ghi vào để compiler không bỏ lời gọi đường nóng
+ */
+extern volatile uint32_t bench_sink;
+
+/**
+ * @brief Cấu hình mặc định (min_rep_ticks phải do chương trình chạy đặt)
+ */
+void bench_default_config(bench_config_t *config);
+
+/**
+ * @brief Đo một case
+ * @return 0 nếu thành công, -1 nếu cấu hình không hợp lệ
+ */
+int bench_run_case(const bench_case_t *bench, const bench_config_t *config, bench_result_t *result);
+
+/**
+ * @brief Đo mọi case khớp filter và in kết quả ra stdout
+ * @return Số case đã chạy, -1 nếu lỗi
+ */
+int bench_run_all(const bench_config_t *config, bench_format_t format);
+
+#endif // BENCH_H
@@ -0,0 +1,501 @@
+#include "bench.h"
+#include <string.h>
+#include "sensor/sensor.h"
+#include "telemetry/telemetry.h"
+#include "telemetry_batch/telemetry_batch.h"
+#include "mqtt/mqtt.h"
+#include "command/command.h"
+
+#ifdef BENCH_HAVE_CJSON
+#include <stdlib.h>
+#include "cJSON.h"
+#endif
+
+/*
+ * Case đo các đường nóng với đầu vào giống khi chạy thật:
+ *   - sensor_process_sample(): một mẫu của một cảm biến (lọc, chuẩn hóa,
+ *     so ngưỡng, debounce, lịch sử), đầu vào là chuỗi mẫu có nhiễu và các
+ *     đoạn tăng vượt ngưỡng để bộ lọc/debounce đổi trạng thái
+ *   - so ngưỡng một mẫu: cặp float (raw / 4095.0f >= ngưỡng, đường cũ trước
+ *     khi đổi sang Q15) và số nguyên (Q15 + raw >= ngưỡng raw) trên cùng
+ *     chuỗi mẫu
+ *   - sensor_detect_fire(): xoay vòng giữa không kích hoạt, một nguồn, hai
+ *     nguồn và cảm biến báo ngay
+ *   - payload batch (10 mẫu) và cảnh báo như publish_sensor_batch()/warning_task,
+ *     kèm độ dài payload; khi có cJSON (BENCH_HAVE_CJSON) thêm cùng payload dựng
+ *     bằng cây cJSON làm mốc so sánh (cảnh báo: cJSON_Print như firmware trước
+ *     json_writer)
+ *   - mqtt_event_handler() với MQTT_EVENT_DATA: lệnh điều khiển một fragment
+ *     và message ghép từ 4 fragment, gồm cả nhận/trả block về pool
+ *   - command_dispatch(): xoay vòng 4 payload điều khiển (có khoảng trắng,
+ *     trường thừa, object lồng), và cả đường của mqtt_control_task từ
+ *     MQTT_EVENT_DATA tới handler; 1e9 / ns mỗi lần gọi là số lệnh mỗi giây
+ */
+
+#define BENCH_TRACE_LEN 256             // Số chu kỳ đọc trong chuỗi mẫu (lũy thừa 2)
+#define BENCH_AMBIENT_RAW 600
+#define BENCH_FIRE_RAW 3800
+#define BENCH_NOISE_RAW 24
+#define BENCH_SAMPLE_PERIOD_MS 500
+
+#define BENCH_MQTT_FRAGMENTS 4
+#define BENCH_MQTT_FRAGMENT_LEN 120
+#define BENCH_COMMANDS 4                // Số payload điều khiển (lũy thừa 2)
+#define BENCH_COMMAND_MAX_LEN 80
+
+_Static_assert((BENCH_TRACE_LEN & (BENCH_TRACE_LEN - 1)) == 0, "BENCH_TRACE_LEN must be a power of 2");
+_Static_assert(BENCH_MQTT_FRAGMENTS * BENCH_MQTT_FRAGMENT_LEN < MQTT_PAYLOAD_MAX_LEN, "fragmented message must fit a block");
+_Static_assert((BENCH_COMMANDS & (BENCH_COMMANDS - 1)) == 0, "BENCH_COMMANDS must be a power of 2");
+
+// ==== Trạng thái chung ====
+
+static sensor_status_t s_status;
+static uint16_t s_raw_trace[BENCH_TRACE_LEN][SENSOR_MAX_COUNT];
+static uint32_t s_trace_pos;
+static uint8_t s_sample_index;
+
+// Ngưỡng và kết quả chuẩn hóa cho cặp case so ngưỡng float / số nguyên
+static float s_threshold[SENSOR_MAX_COUNT];
+static uint16_t s_threshold_raw[SENSOR_MAX_COUNT];
+static float s_normalized[SENSOR_MAX_COUNT];
+static uint16_t s_normalized_q15[SENSOR_MAX_COUNT];
+static uint32_t s_threshold_pos;
+static uint8_t s_threshold_index;
+
+static sensor_status_t s_detect_status[4];
+static sensor_status_t s_batch[TELEMETRY_BATCH_MAX_SAMPLES];
+
+static char s_json_buf[TELEMETRY_BATCH_JSON_MAX_LEN(TELEMETRY_BATCH_MAX_SAMPLES)];
+static uint8_t s_frame_buf[TELEMETRY_BATCH_MAX_SAMPLES * TELEMETRY_FRAME_MAX_LEN];
+
+static mqtt_config_t s_mqtt;
+static char s_control_topic[] = MQTT_TOPIC_CONTROL;
+static char s_command[] = "{\"command\":\"buzzer_on\"}";
+static char s_large_payload[BENCH_MQTT_FRAGMENTS * BENCH_MQTT_FRAGMENT_LEN];
+static esp_mqtt_event_t s_command_event;
+static esp_mqtt_event_t s_fragment_event[BENCH_MQTT_FRAGMENTS];
+
+// Lệnh điều khiển như từ dashboard; tokenizer ghi đè buffer nên mỗi lần gọi chép lại payload
+static const char *const s_command_names[BENCH_COMMANDS] = { "buzzer_on", "buzzer_off", "test_alarm", "trace_report" };
+static const char *const s_command_payloads[BENCH_COMMANDS] = {
+    "{\"command\":\"buzzer_on\"}",
+    "{\"command\":\"buzzer_off\"}",
+    "{ \"command\" : \"test_alarm\", \"duration_ms\": 3000 }",
+    "{\"source\":\"dashboard\",\"command\":\"trace_report\",\"meta\":{\"id\":7}}",
+};
+static size_t s_command_len[BENCH_COMMANDS];
+static char s_command_buf[BENCH_COMMAND_MAX_LEN];
+static uint32_t s_command_pos;
+
+static uint32_t s_rand = 0x12345678u;
+
+static uint32_t bench_rand(void)
+{
+    // xorshift32: cùng chuỗi trên host và target
+    s_rand ^= s_rand << 13;
+    s_rand ^= s_rand >> 17;
+    s_rand ^= s_rand << 5;
+    return s_rand;
+}
+
+/**
+ * @brief Chuỗi mẫu: nền có nhiễu, mỗi 64 chu kỳ có 16 chu kỳ vượt ngưỡng
+ */
+static void build_trace(void)
+{
+    for (uint32_t t = 0; t < BENCH_TRACE_LEN; t++) {
+        bool fire = (t % 64) >= 48;
+        for (uint8_t i = 0; i < s_status.count; i++) {
+            const sensor_desc_t *desc = sensor_get_desc(i);
+            if (!desc->is_analog) {
+                s_raw_trace[t][i] = (fire && (t % 4) == 0) ? 4095 : 0;
+                continue;
+            }
+            int raw = (fire ? BENCH_FIRE_RAW : BENCH_AMBIENT_RAW) +
+                      (int)(bench_rand() % (2 * BENCH_NOISE_RAW + 1)) - BENCH_NOISE_RAW;
+            s_raw_trace[t][i] = (uint16_t)raw;
+        }
+    }
+}
+
+static void process_cycle(sensor_status_t *status)
+{
+    status->last_read_time += BENCH_SAMPLE_PERIOD_MS;
+    for (uint8_t i = 0; i < status->count; i++) {
+        sensor_process_sample(status, i, s_raw_trace[s_trace_pos][i]);
+    }
+    s_trace_pos = (s_trace_pos + 1) & (BENCH_TRACE_LEN - 1);
+    sensor_evaluate(status);
+}
+
+/**
+ * @brief Lấy ngưỡng của các cảm biến; hai cách so ngưỡng phải cho cùng kết quả với mọi giá trị 12 bit
+ */
+static int init_thresholds(void)
+{
+    for (uint8_t i = 0; i < s_status.count; i++) {
+        if (sensor_get_threshold(i, &s_threshold[i], &s_threshold_raw[i]) != 0) {
+            return -1;
+        }
+        for (uint16_t raw = 0; raw <= SENSOR_RAW_MAX; raw++) {
+            if (((float)raw / 4095.0f >= s_threshold[i]) != (raw >= s_threshold_raw[i])) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void init_mqtt_events(void)
+{
+    s_command_event.event_id = MQTT_EVENT_DATA;
+    s_command_event.topic = s_control_topic;
+    s_command_event.topic_len = (int)strlen(s_control_topic);
+    s_command_event.data = s_command;
+    s_command_event.data_len = (int)strlen(s_command);
+    s_command_event.total_data_len = s_command_event.data_len;
+    s_command_event.qos = MQTT_QOS_1;
+
+    // JSON dài với một trường đệm, cắt thành các fragment như khi vượt buffer client
+    static const char prefix[] = "{\"command\":\"test_alarm\",\"pad\":\"";
+    memset(s_large_payload, 'x', sizeof(s_large_payload));
+    memcpy(s_large_payload, prefix, sizeof(prefix) - 1);
+    memcpy(s_large_payload + sizeof(s_large_payload) - 2, "\"}", 2);
+
+    for (int f = 0; f < BENCH_MQTT_FRAGMENTS; f++) {
+        esp_mqtt_event_t *ev = &s_fragment_event[f];
+        ev->event_id = MQTT_EVENT_DATA;
+        ev->topic = (f == 0) ? s_control_topic : NULL;
+        ev->topic_len = (f == 0) ? (int)strlen(s_control_topic) : 0;
+        ev->data = s_large_payload + f * BENCH_MQTT_FRAGMENT_LEN;
+        ev->data_len = BENCH_MQTT_FRAGMENT_LEN;
+        ev->total_data_len = (int)sizeof(s_large_payload);
+        ev->current_data_offset = f * BENCH_MQTT_FRAGMENT_LEN;
+        ev->qos = MQTT_QOS_1;
+    }
+}
+
+static int bench_command_handler(const command_request_t *req, void *ctx)
+{
+    (void)ctx;
+    bench_sink += req->num_fields;
+    return 0;
+}
+
+static int init_commands(void)
+{
+    for (int i = 0; i < BENCH_COMMANDS; i++) {
+        s_command_len[i] = strlen(s_command_payloads[i]) + 1;
+        if (s_command_len[i] > sizeof(s_command_buf) ||
+            command_register(s_command_names[i], bench_command_handler, NULL) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int bench_cases_init(void)
+{
+    if (sensor_system_init(&s_status) != 0) {
+        return -1;
+    }
+    build_trace();
+    if (init_thresholds() != 0) {
+        return -1;
+    }
+
+    // Làm nóng bộ lọc rồi lấy các bản chụp cho case serialize
+    for (uint32_t t = 0; t < BENCH_TRACE_LEN; t++) {
+        process_cycle(&s_status);
+    }
+    for (uint8_t i = 0; i < TELEMETRY_BATCH_MAX_SAMPLES; i++) {
+        process_cycle(&s_status);
+        s_batch[i] = s_status;
+    }
+
+    // Các trạng thái cho sensor_detect_fire()
+    int smoke = sensor_find(SENSOR_TYPE_SMOKE);
+    int gas = sensor_find(SENSOR_TYPE_GAS);
+    int ir = sensor_find(SENSOR_TYPE_IR_FLAME);
+    if (smoke < 0 || gas < 0 || ir < 0) {
+        return -1;
+    }
+    for (int i = 0; i < 4; i++) {
+        s_detect_status[i] = s_status;
+        s_detect_status[i].ror_triggered = false;
+    }
+    s_detect_status[0].triggered_mask = 0;
+    s_detect_status[1].triggered_mask = 1UL << smoke;
+    s_detect_status[2].triggered_mask = (1UL << smoke) | (1UL << gas);
+    s_detect_status[2].fire_detected = true;
+    s_detect_status[3].triggered_mask = 1UL << ir;
+
+    if (mqtt_init(&s_mqtt, "mqtt://bench.invalid", NULL, NULL, "fire_system_bench", false) != 0) {
+        return -1;
+    }
+    init_mqtt_events();
+    return init_commands();
+}
+
+// ==== Case ====
+
+static void bench_sensor_process_sample(uint32_t iterations)
+{
+    for (uint32_t n = 0; n < iterations; n++) {
+        sensor_process_sample(&s_status, s_sample_index, s_raw_trace[s_trace_pos][s_sample_index]);
+        if (++s_sample_index == s_status.count) {
+            s_sample_index = 0;
+            s_status.last_read_time += BENCH_SAMPLE_PERIOD_MS;
+            s_trace_pos = (s_trace_pos + 1) & (BENCH_TRACE_LEN - 1);
+        }
+    }
+    bench_sink += s_status.triggered_mask;
+}
+
+static void threshold_next(void)
+{
+    if (++s_threshold_index == s_status.count) {
+        s_threshold_index = 0;
+        s_threshold_pos = (s_threshold_pos + 1) & (BENCH_TRACE_LEN - 1);
+    }
+}
+
+static void bench_threshold_float(uint32_t iterations)
+{
+    uint32_t triggered = 0;
+    for (uint32_t n = 0; n < iterations; n++) {
+        uint8_t i = s_threshold_index;
+        float value = (float)s_raw_trace[s_threshold_pos][i] / 4095.0f;
+        s_normalized[i] = value;
+        triggered += (value >= s_threshold[i]);
+        threshold_next();
+    }
+    bench_sink += triggered;
+}
+
+static void bench_threshold_fixed(uint32_t iterations)
+{
+    uint32_t triggered = 0;
+    for (uint32_t n = 0; n < iterations; n++) {
+        uint8_t i = s_threshold_index;
+        uint16_t raw = s_raw_trace[s_threshold_pos][i];
+        s_normalized_q15[i] = sensor_raw_to_q15(raw);
+        triggered += (raw >= s_threshold_raw[i]);
+        threshold_next();
+    }
+    bench_sink += triggered;
+}
+
+static void bench_sensor_detect_fire(uint32_t iterations)
+{
+    uint32_t detected = 0;
+    for (uint32_t n = 0; n < iterations; n++) {
+        detected += sensor_detect_fire(&s_detect_status[n & 3]);
+    }
+    bench_sink += detected;
+}
+
+static void bench_batch_json(uint32_t iterations)
+{
+    for (uint32_t n = 0; n < iterations; n++) {
+        bench_sink += telemetry_build_batch_json(s_json_buf, sizeof(s_json_buf), s_batch, TELEMETRY_BATCH_MAX_SAMPLES);
+    }
+}
+
+static void bench_alert_json(uint32_t iterations)
+{
+    for (uint32_t n = 0; n < iterations; n++) {
+        bench_sink += telemetry_build_alert_json(s_json_buf, TELEMETRY_JSON_MAX_LEN, &s_detect_status[2]);
+    }
+}
+
+static void bench_batch_frame(uint32_t iterations)
+{
+    for (uint32_t n = 0; n < iterations; n++) {
+        bench_sink += telemetry_build_batch_frame(s_frame_buf, sizeof(s_frame_buf), s_batch, TELEMETRY_BATCH_MAX_SAMPLES);
+    }
+}
+
+static uint32_t batch_json_bytes(void)
+{
+    int len = telemetry_build_batch_json(s_json_buf, sizeof(s_json_buf), s_batch, TELEMETRY_BATCH_MAX_SAMPLES);
+    return (len > 0) ? (uint32_t)len : 0;
+}
+
+static uint32_t alert_json_bytes(void)
+{
+    int len = telemetry_build_alert_json(s_json_buf, TELEMETRY_JSON_MAX_LEN, &s_detect_status[2]);
+    return (len > 0) ? (uint32_t)len : 0;
+}
+
+static uint32_t batch_frame_bytes(void)
+{
+    int len = telemetry_build_batch_frame(s_frame_buf, sizeof(s_frame_buf), s_batch, TELEMETRY_BATCH_MAX_SAMPLES);
+    return (len > 0) ? (uint32_t)len : 0;
+}
+
+#ifdef BENCH_HAVE_CJSON
+/**
+ * @brief Trường cảm biến dạng cJSON: giá trị chuẩn hóa (double) hoặc trạng thái kích hoạt
+ */
+static void cjson_add_sensor_fields(cJSON *json, const sensor_status_t *status)
+{
+    for (uint8_t i = 0; i < status->count; i++) {
+        const sensor_desc_t *desc = sensor_get_desc(i);
+        if (desc->is_analog) {
+            cJSON_AddNumberToObject(json, desc->name, sensor_normalize(status, i));
+        } else {
+            cJSON_AddBoolToObject(json, desc->name, sensor_is_triggered(status, i));
+        }
+    }
+}
+
+static char *cjson_batch_print(void)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON *samples = cJSON_AddArrayToObject(root, "samples");
+    for (uint8_t i = 0; i < TELEMETRY_BATCH_MAX_SAMPLES; i++) {
+        cJSON *sample = cJSON_CreateObject();
+        cJSON_AddNumberToObject(sample, "timestamp", (double)s_batch[i].last_read_time);
+        cjson_add_sensor_fields(sample, &s_batch[i]);
+        cJSON_AddBoolToObject(sample, "fire_detected", s_batch[i].fire_detected);
+        cJSON_AddItemToArray(samples, sample);
+    }
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    return json;
+}
+
+static char *cjson_alert_print(void)
+{
+    const sensor_status_t *status = &s_detect_status[2];
+    cJSON *alert = cJSON_CreateObject();
+    cJSON_AddStringToObject(alert, "type", "fire_alert");
+    cJSON_AddBoolToObject(alert, "detected", true);
+    cJSON_AddNumberToObject(alert, "timestamp", (double)status->detection_timestamp);
+    cjson_add_sensor_fields(alert, status);
+    char *json = cJSON_Print(alert);
+    cJSON_Delete(alert);
+    return json;
+}
+
+static uint32_t cjson_bytes(char *(*print)(void))
+{
+    char *json = print();
+    uint32_t len = (json != NULL) ? (uint32_t)strlen(json) : 0;
+    cJSON_free(json);
+    return len;
+}
+
+static void bench_cjson_batch_json(uint32_t iterations)
+{
+    for (uint32_t n = 0; n < iterations; n++) {
+        char *json = cjson_batch_print();
+        bench_sink += (json != NULL);
+        cJSON_free(json);
+    }
+}
+
+static uint32_t cjson_batch_json_bytes(void)
+{
+    return cjson_bytes(cjson_batch_print);
+}
+
+static void bench_cjson_alert_json(uint32_t iterations)
+{
+    for (uint32_t n = 0; n < iterations; n++) {
+        char *json = cjson_alert_print();
+        bench_sink += (json != NULL);
+        cJSON_free(json);
+    }
+}
+
+static uint32_t cjson_alert_json_bytes(void)
+{
+    return cjson_bytes(cjson_alert_print);
+}
+#endif // BENCH_HAVE_CJSON
+
+/**
+ * @brief Lấy message vừa ghép xong và trả block về pool như mqtt_task
+ */
+static void drain_message(void)
+{
+    mqtt_message_t *msg = NULL;
+    if (mqtt_receive_message(&s_mqtt, &msg, 1)) {
+        bench_sink += msg->payload_len;
+        mqtt_release_message(&s_mqtt, msg);
+    }
+}
+
+static void bench_mqtt_data_single(uint32_t iterations)
+{
+    for (uint32_t n = 0; n < iterations; n++) {
+        mqtt_event_handler(&s_mqtt, NULL, MQTT_EVENT_DATA, &s_command_event);
+        drain_message();
+    }
+}
+
+static void bench_mqtt_data_fragmented(uint32_t iterations)
+{
+    for (uint32_t n = 0; n < iterations; n++) {
+        for (int f = 0; f < BENCH_MQTT_FRAGMENTS; f++) {
+            mqtt_event_handler(&s_mqtt, NULL, MQTT_EVENT_DATA, &s_fragment_event[f]);
+        }
+        drain_message();
+    }
+}
+
+static void bench_command_dispatch(uint32_t iterations)
+{
+    for (uint32_t n = 0; n < iterations; n++) {
+        uint32_t k = s_command_pos++ & (BENCH_COMMANDS - 1);
+        memcpy(s_command_buf, s_command_payloads[k], s_command_len[k]);
+        bench_sink += (command_dispatch(s_command_buf) == 0);
+    }
+}
+
+static void bench_command_rx_dispatch(uint32_t iterations)
+{
+    mqtt_message_t *msg = NULL;
+
+    for (uint32_t n = 0; n < iterations; n++) {
+        mqtt_event_handler(&s_mqtt, NULL, MQTT_EVENT_DATA, &s_command_event);
+        if (mqtt_receive_message(&s_mqtt, &msg, 1)) {
+            if (strcmp(msg->topic, MQTT_TOPIC_CONTROL) == 0) {
+                bench_sink += (command_dispatch(msg->payload) == 0);
+            }
+            mqtt_release_message(&s_mqtt, msg);
+        }
+    }
+}
+
+const bench_case_t bench_cases[] = {
+    { "sensor_process_sample", "one sample of one sensor: filter, Q15, threshold, debounce, history",
+      bench_sensor_process_sample },
+    { "sensor_threshold_float", "normalize + threshold, float path: raw / 4095.0f >= threshold",
+      bench_threshold_float },
+    { "sensor_threshold_fixed", "normalize + threshold, fixed path: Q15 multiply-shift, raw >= threshold_raw",
+      bench_threshold_fixed },
+    { "sensor_detect_fire", "fusion over idle / one / two / instant-trigger states",
+      bench_sensor_detect_fire },
+    { "telemetry_batch_json", "10-sample batch JSON (sensor/data)", bench_batch_json, batch_json_bytes },
+    { "telemetry_alert_json", "fire alert JSON (alert)", bench_alert_json, alert_json_bytes },
+    { "telemetry_batch_frame", "10-sample binary batch (sensor/data/bin)", bench_batch_frame, batch_frame_bytes },
+#ifdef BENCH_HAVE_CJSON
+    { "cjson_batch_json", "baseline: same batch as a cJSON tree, cJSON_PrintUnformatted + free",
+      bench_cjson_batch_json, cjson_batch_json_bytes },
+    { "cjson_alert_json", "baseline: alert as before json_writer, cJSON tree + cJSON_Print + free",
+      bench_cjson_alert_json, cjson_alert_json_bytes },
+#endif
+    { "mqtt_data_single", "MQTT_EVENT_DATA control command, one fragment, receive + release",
+      bench_mqtt_data_single },
+    { "mqtt_data_fragmented", "480-byte message in 4 fragments, receive + release",
+      bench_mqtt_data_fragmented },
+    { "command_dispatch", "control payload copy + in-place tokenize + table lookup + handler, 4 commands",
+      bench_command_dispatch },
+    { "command_rx_dispatch", "mqtt_control_task path: MQTT_EVENT_DATA, receive, dispatch, release",
+      bench_command_rx_dispatch },
+};
+
+const size_t bench_case_count = sizeof(bench_cases) / sizeof(bench_cases[0]);
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp_log.h"
+#include "host_hal.h"
+#include "bench.h"
+
+/*
+ * Chạy bộ micro-benchmark trên bản build host, đơn vị ns/lần gọi.
+ *
+ *   fire_system_bench [--format text|csv|json] [--reps N] [--warmup N]
+ *                     [--min-time-us N] [--filter S] [--list]
+ *
+ * Số đo trên máy tính chỉ dùng để so sánh trước/sau một thay đổi trên cùng
+ * máy; số tuyệt đối trên ESP32 lấy bằng bản chạy trên target (target/).
+ */
+
+#define BENCH_HOST_MIN_REP_US 50
+
+const char *const bench_clock_unit = "ns";
+
+uint64_t bench_clock(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [--format text|csv|json] [--reps N] [--warmup N] [--min-time-us N] [--filter S] [--list]\n"
+            "  --format F       output format (default text)\n"
+            "  --reps N         measured batches per benchmark (default 200, max %d)\n"
+            "  --warmup N       unmeasured batches before measuring (default 20)\n"
+            "  --min-time-us N  minimum duration of one batch (default %d)\n"
+            "  --filter S       run only benchmarks whose name contains S\n"
+            "  --list           list benchmarks and exit\n",
+            prog, BENCH_MAX_REPETITIONS, BENCH_HOST_MIN_REP_US);
+}
+
+static int parse_format(const char *name, bench_format_t *format)
+{
+    if (strcmp(name, "text") == 0) {
+        *format = BENCH_FORMAT_TEXT;
+    } else if (strcmp(name, "csv") == 0) {
+        *format = BENCH_FORMAT_CSV;
+    } else if (strcmp(name, "json") == 0) {
+        *format = BENCH_FORMAT_JSON;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    bench_config_t config;
+    bench_format_t format = BENCH_FORMAT_TEXT;
+    bool list = false;
+
+    bench_default_config(&config);
+    config.min_rep_ticks = BENCH_HOST_MIN_REP_US * 1000ULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool has_value = (i + 1 < argc);
+
+        if (strcmp(arg, "--list") == 0) {
+            list = true;
+        } else if (strcmp(arg, "--format") == 0 && has_value) {
+            if (parse_format(argv[++i], &format) != 0) {
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(arg, "--reps") == 0 && has_value) {
+            config.repetitions = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(arg, "--warmup") == 0 && has_value) {
+            config.warmup = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(arg, "--min-time-us") == 0 && has_value) {
+            config.min_rep_ticks = strtoull(argv[++i], NULL, 0) * 1000ULL;
+        } else if (strcmp(arg, "--filter") == 0 && has_value) {
+            config.filter = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (config.repetitions == 0 || config.repetitions > BENCH_MAX_REPETITIONS) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (list) {
+        for (size_t i = 0; i < bench_case_count; i++) {
+            printf("%-28s %s\n", bench_cases[i].name, bench_cases[i].description);
+        }
+        return 0;
+    }
+
+    // Log khởi tạo cảm biến/MQTT không được lẫn vào kết quả
+    host_log_set_level(ESP_LOG_ERROR);
+    if (bench_cases_init() != 0) {
+        fprintf(stderr, "Benchmark setup failed\n");
+        return 1;
+    }
+
+    int count = bench_run_all(&config, format);
+    if (count <= 0) {
+        fprintf(stderr, count == 0 ? "No benchmark matches the filter\n" : "Benchmark failed\n");
+        return 1;
+    }
+
+    // Luồng dịch vụ của mock vẫn chạy: kết thúc cả tiến trình
+    fflush(stdout);
+    _Exit(0);
+}
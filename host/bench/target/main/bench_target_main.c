@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "bench.h"
+
+/*
+ * Chạy bộ micro-benchmark trên ESP32, đơn vị cycle CPU/lần gọi (CCOUNT).
+ * Kết quả in ra UART dạng CSV giữa hai dòng BENCH_BEGIN / BENCH_END để
+ * lọc từ log monitor.
+ */
+
+static const char *TAG = "BENCH";
+
+#define BENCH_TARGET_CORE 1             // Task đo ghim một core: CCOUNT của hai core không đồng bộ
+#define BENCH_TARGET_PRIORITY 10
+#define BENCH_TARGET_STACK 4096
+#define BENCH_TARGET_MIN_REP_CYCLES 20000
+
+#ifndef BENCH_TARGET_FORMAT
+#define BENCH_TARGET_FORMAT BENCH_FORMAT_CSV
+#endif
+
+const char *const bench_clock_unit = "cycles";
+
+// Mở rộng CCOUNT 32 bit (tràn sau ~27 giây ở 160 MHz); chỉ task đo gọi
+static uint32_t s_last_ccount;
+static uint64_t s_ccount_high;
+
+uint64_t bench_clock(void)
+{
+    uint32_t now = esp_cpu_get_cycle_count();
+    if (now < s_last_ccount) {
+        s_ccount_high += 1ULL << 32;
+    }
+    s_last_ccount = now;
+    return s_ccount_high | now;
+}
+
+static void bench_task(void *arg)
+{
+    (void)arg;
+
+    if (bench_cases_init() != 0) {
+        ESP_LOGE(TAG, "Benchmark setup failed");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    bench_config_t config;
+    bench_default_config(&config);
+    config.min_rep_ticks = BENCH_TARGET_MIN_REP_CYCLES;
+
+    // Log của module khác không được chen vào giữa kết quả
+    esp_log_level_set("*", ESP_LOG_ERROR);
+    printf("BENCH_BEGIN cpu=%lu MHz core=%d\n", (unsigned long)esp_rom_get_cpu_ticks_per_us(), BENCH_TARGET_CORE);
+    int count = bench_run_all(&config, BENCH_TARGET_FORMAT);
+    printf("BENCH_END count=%d\n", count);
+    esp_log_level_set("*", ESP_LOG_INFO);
+
+    vTaskDelete(NULL);
+}
+
+void app_main(void)
+{
+    xTaskCreatePinnedToCore(bench_task, "bench", BENCH_TARGET_STACK, NULL,
+                            BENCH_TARGET_PRIORITY, NULL, BENCH_TARGET_CORE);
+}
@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include "telemetry_frame.h"
+
+/*
+ * Giải mã payload frame telemetry nhị phân (topic .../bin) ra text, CSV hoặc
+ * JSON. Chỉ dùng telemetry_frame.c, giống một bộ giải mã phía server.
+ *
+ *   fire_system_frame_decode [--format text|csv|json] [--hex] [FILE...]
+ *
+ * Mỗi FILE (hoặc stdin nếu không có / "-") là một payload: một frame hoặc
+ * các frame nối tiếp của batch. --hex đọc payload dạng hex (bỏ qua khoảng
+ * trắng), ví dụ đầu ra của `mosquitto_sub -F %x`.
+ * Giá trị cảm biến in ra là raw 0-4095 sau lọc như trong frame; JSON của
+ * firmware cho cùng chu kỳ là giá trị này / 4095 (analog) hoặc bit của cảm
+ * biến trong triggered_mask (digital).
+ * Mã thoát: 0 giải mã hết, 1 lỗi đọc file hoặc frame không hợp lệ, 2 sai tham số.
+ */
+
+#define DECODE_EXIT_INVALID 1
+#define DECODE_EXIT_USAGE 2
+
+// Tối đa một payload (MQTT_PAYLOAD_MAX_LEN của firmware nhỏ hơn nhiều)
+#define DECODE_MAX_PAYLOAD (64 * 1024)
+
+typedef enum {
+    DECODE_FORMAT_TEXT = 0,
+    DECODE_FORMAT_CSV,
+    DECODE_FORMAT_JSON,
+} decode_format_t;
+
+typedef struct {
+    decode_format_t format;
+    bool hex;
+} decode_options_t;
+
+// Tên theo sensor_type_t của firmware (main/sensor/sensor.h)
+static const char *const s_type_names[] = { "smoke", "temperature", "ir_flame", "gas", "co" };
+
+static const char *type_name(uint8_t type, char *buf, size_t size)
+{
+    if (type < sizeof(s_type_names) / sizeof(s_type_names[0])) {
+        return s_type_names[type];
+    }
+    snprintf(buf, size, "type%u", type);
+    return buf;
+}
+
+static const char *kind_name(uint8_t kind)
+{
+    switch (kind) {
+    case TELEMETRY_FRAME_SENSOR_DATA:
+        return "sensor_data";
+    case TELEMETRY_FRAME_ALERT:
+        return "alert";
+    default:
+        return "unknown";
+    }
+}
+
+// ==== Đọc payload ====
+
+static int hex_digit(int c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c = tolower(c);
+    return (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+}
+
+/**
+ * @brief Đọc cả payload từ file; dạng hex được đổi sang byte
+ * @return Số byte, -1 nếu lỗi đọc, hex sai hoặc quá DECODE_MAX_PAYLOAD
+ */
+static long read_payload(FILE *f, bool hex, uint8_t *buf, size_t size)
+{
+    size_t len = 0;
+    int c;
+
+    if (!hex) {
+        len = fread(buf, 1, size, f);
+        if (ferror(f) || (len == size && fgetc(f) != EOF)) {
+            return -1;
+        }
+        return (long)len;
+    }
+
+    int high = -1;
+    while ((c = fgetc(f)) != EOF) {
+        if (isspace(c)) {
+            continue;
+        }
+        int v = hex_digit(c);
+        if (v < 0 || (high < 0 && len == size)) {
+            return -1;
+        }
+        if (high < 0) {
+            high = v;
+        } else {
+            buf[len++] = (uint8_t)((high << 4) | v);
+            high = -1;
+        }
+    }
+    return (ferror(f) || high >= 0) ? -1 : (long)len;
+}
+
+// ==== In ====
+
+static void print_frame(const decode_options_t *opt, const char *source, uint32_t index,
+                        const telemetry_frame_t *frame, bool first)
+{
+    char name[16];
+
+    switch (opt->format) {
+    case DECODE_FORMAT_CSV:
+        if (first) {
+            printf("source,index,kind,timestamp_ms,fire,ror,triggered_mask,temperature_rate,sensor,value\n");
+        }
+        for (uint8_t i = 0; i < frame->count; i++) {
+            printf("%s,%" PRIu32 ",%s,%" PRIu32 ",%d,%d,%u,%d,%s,%u\n",
+                   source, index, kind_name(frame->kind), frame->timestamp_ms,
+                   (frame->flags & TELEMETRY_FRAME_FLAG_FIRE) != 0, (frame->flags & TELEMETRY_FRAME_FLAG_ROR) != 0,
+                   frame->triggered_mask, frame->temperature_rate,
+                   type_name(frame->sensor_type[i], name, sizeof(name)), frame->value[i]);
+        }
+        break;
+    case DECODE_FORMAT_JSON:
+        printf("%s{\"source\":\"%s\",\"index\":%" PRIu32 ",\"kind\":\"%s\",\"timestamp_ms\":%" PRIu32 ","
+               "\"fire\":%s,\"ror\":%s,\"triggered_mask\":%u,\"temperature_rate\":%d,\"values\":{",
+               first ? "" : ",", source, index, kind_name(frame->kind), frame->timestamp_ms,
+               (frame->flags & TELEMETRY_FRAME_FLAG_FIRE) ? "true" : "false",
+               (frame->flags & TELEMETRY_FRAME_FLAG_ROR) ? "true" : "false",
+               frame->triggered_mask, frame->temperature_rate);
+        for (uint8_t i = 0; i < frame->count; i++) {
+            printf("%s\"%s\":%u", i ? "," : "", type_name(frame->sensor_type[i], name, sizeof(name)), frame->value[i]);
+        }
+        printf("}}");
+        break;
+    default:
+        printf("%s #%" PRIu32 " %-11s t=%" PRIu32 " ms%s%s mask=0x%02x rate=%d",
+               source, index, kind_name(frame->kind), frame->timestamp_ms,
+               (frame->flags & TELEMETRY_FRAME_FLAG_FIRE) ? " FIRE" : "",
+               (frame->flags & TELEMETRY_FRAME_FLAG_ROR) ? " ROR" : "",
+               frame->triggered_mask, frame->temperature_rate);
+        for (uint8_t i = 0; i < frame->count; i++) {
+            printf(" %s=%u", type_name(frame->sensor_type[i], name, sizeof(name)), frame->value[i]);
+        }
+        printf("\n");
+        break;
+    }
+}
+
+/**
+ * @brief Giải mã lần lượt các frame của một payload
+ * @return Số frame đã in, -1 nếu có frame không hợp lệ (các frame trước vẫn được in)
+ */
+static int decode_payload(const decode_options_t *opt, const char *source, const uint8_t *buf, size_t len,
+                          bool *first)
+{
+    telemetry_frame_t frame;
+    size_t off = 0;
+    uint32_t index = 0;
+
+    while (off < len) {
+        int n = telemetry_frame_decode_next(buf + off, len - off, &frame);
+        if (n < 0) {
+            fprintf(stderr, "%s: invalid frame #%" PRIu32 " at byte %zu\n", source, index, off);
+            return -1;
+        }
+        print_frame(opt, source, index, &frame, *first);
+        *first = false;
+        off += (size_t)n;
+        index++;
+    }
+    return (int)index;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options] [FILE...]\n"
+            "  --format F  text (default), csv or json\n"
+            "  --hex       input is hex text (whitespace ignored)\n"
+            "FILE holds one payload (a frame or a batch of frames); none or \"-\" reads stdin.\n",
+            prog);
+}
+
+int main(int argc, char **argv)
+{
+    decode_options_t opt = { .format = DECODE_FORMAT_TEXT };
+    int first_path = argc;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            const char *f = argv[++i];
+            if (strcmp(f, "text") == 0) {
+                opt.format = DECODE_FORMAT_TEXT;
+            } else if (strcmp(f, "csv") == 0) {
+                opt.format = DECODE_FORMAT_CSV;
+            } else if (strcmp(f, "json") == 0) {
+                opt.format = DECODE_FORMAT_JSON;
+            } else {
+                usage(argv[0]);
+                return DECODE_EXIT_USAGE;
+            }
+        } else if (strcmp(argv[i], "--hex") == 0) {
+            opt.hex = true;
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            usage(argv[0]);
+            return DECODE_EXIT_USAGE;
+        } else {
+            first_path = i;
+            break;
+        }
+    }
+
+    static uint8_t payload[DECODE_MAX_PAYLOAD];
+    static char *const stdin_path[] = { "-" };
+    char *const *paths = (first_path < argc) ? &argv[first_path] : stdin_path;
+    int num_paths = (first_path < argc) ? argc - first_path : 1;
+    bool first = true;
+    int ret = 0;
+
+    if (opt.format == DECODE_FORMAT_JSON) {
+        printf("[");
+    }
+    for (int p = 0; p < num_paths; p++) {
+        bool use_stdin = strcmp(paths[p], "-") == 0;
+        const char *source = use_stdin ? "stdin" : paths[p];
+        FILE *f = use_stdin ? stdin : fopen(paths[p], opt.hex ? "r" : "rb");
+        if (f == NULL) {
+            perror(paths[p]);
+            ret = DECODE_EXIT_INVALID;
+            continue;
+        }
+        long len = read_payload(f, opt.hex, payload, sizeof(payload));
+        if (!use_stdin) {
+            fclose(f);
+        }
+        if (len < 0) {
+            fprintf(stderr, "%s: cannot read payload\n", source);
+            ret = DECODE_EXIT_INVALID;
+            continue;
+        }
+        if (decode_payload(&opt, source, payload, (size_t)len, &first) < 0) {
+            ret = DECODE_EXIT_INVALID;
+        }
+    }
+    if (opt.format == DECODE_FORMAT_JSON) {
+        printf("]\n");
+    }
+
+    return ret;
+}
@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/ledc.h"
+#include "hal/adc_types.h"
+#include "host_hal.h"
+
+/*
+ * Chạy firmware trên Linux: app_main() trong task "main" như trên ESP32,
+ * luồng chính đóng vai môi trường (đặt giá trị cảm biến theo kịch bản) rồi
+ * in tóm tắt khi hết thời gian.
+ *
+ *   fire_system_host [--duration S] [--fire-at S] [--clear-at S] [--seed N] [--virtual] [-v]
+ *
+ * --virtual chạy theo đồng hồ ảo: thời gian nhảy thẳng tới sự kiện kế tiếp
+ * khi mọi task đều đang chờ, nên chạy nhanh hơn thời gian thực nhiều lần và
+ * cho cùng kết quả ở mọi lần chạy.
+ */
+
+#define HOST_SMOKE_CHANNEL ADC_CHANNEL_6
+#define HOST_TEMPERATURE_CHANNEL ADC_CHANNEL_7
+#define HOST_GAS_CHANNEL ADC_CHANNEL_5
+#define HOST_BUZZER_CHANNEL LEDC_CHANNEL_0
+
+#define HOST_AMBIENT_RAW 600            // Không khí sạch, ~15% thang đo
+#define HOST_FIRE_RAW 3800              // Khói + gas vượt ngưỡng 0.7
+#define HOST_NOISE_RAW 20
+
+extern void app_main(void);
+
+typedef struct {
+    double duration_s;
+    double fire_at_s;                   // < 0: không có cháy
+    double clear_at_s;                  // < 0: không dập
+    uint32_t seed;
+    bool virtual_clock;
+    bool verbose;
+} host_options_t;
+
+static void main_task(void *arg)
+{
+    (void)arg;
+    app_main();
+    vTaskDelete(NULL);
+}
+
+static void on_publish(const char *topic, const uint8_t *data, int len, int qos, bool retain, void *ctx)
+{
+    (void)ctx;
+
+    // Payload nhị phân (topic .../bin) chỉ in độ dài
+    const char *suffix = strrchr(topic, '/');
+    if (suffix != NULL && strcmp(suffix, "/bin") == 0) {
+        printf("PUB %s qos=%d%s [%d bytes]\n", topic, qos, retain ? " retain" : "", len);
+    } else {
+        printf("PUB %s qos=%d%s %.*s\n", topic, qos, retain ? " retain" : "", len, (const char *)data);
+    }
+    fflush(stdout);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [--duration S] [--fire-at S] [--clear-at S] [--seed N] [--virtual] [-v]\n"
+            "  --duration S   run time in seconds (default 10)\n"
+            "  --fire-at S    raise smoke and gas above threshold at S seconds\n"
+            "  --clear-at S   return sensors to ambient at S seconds\n"
+            "  --seed N       seed for esp_random() and ADC noise\n"
+            "  --virtual      run on the virtual clock (faster than real time, repeatable)\n"
+            "  -v             print every MQTT publish\n", prog);
+}
+
+static int parse_options(int argc, char **argv, host_options_t *opt)
+{
+    opt->duration_s = 10.0;
+    opt->fire_at_s = -1.0;
+    opt->clear_at_s = -1.0;
+    opt->seed = 1;
+    opt->virtual_clock = false;
+    opt->verbose = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool has_value = (i + 1 < argc);
+
+        if (strcmp(arg, "-v") == 0) {
+            opt->verbose = true;
+        } else if (strcmp(arg, "--virtual") == 0) {
+            opt->virtual_clock = true;
+        } else if (strcmp(arg, "--duration") == 0 && has_value) {
+            opt->duration_s = atof(argv[++i]);
+        } else if (strcmp(arg, "--fire-at") == 0 && has_value) {
+            opt->fire_at_s = atof(argv[++i]);
+        } else if (strcmp(arg, "--clear-at") == 0 && has_value) {
+            opt->clear_at_s = atof(argv[++i]);
+        } else if (strcmp(arg, "--seed") == 0 && has_value) {
+            opt->seed = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else {
+            return -1;
+        }
+    }
+    return (opt->duration_s > 0) ? 0 : -1;
+}
+
+/**
+ * @brief Ngủ tới thời điểm at_s (giây kể từ khởi động)
+ */
+static void sleep_until_s(double at_s)
+{
+    int64_t delta = (int64_t)(at_s * 1e6) - host_clock_now_us();
+    if (delta > 0) {
+        host_clock_advance_us(delta);
+    }
+}
+
+static void set_fire(bool fire)
+{
+    uint16_t raw = fire ? HOST_FIRE_RAW : HOST_AMBIENT_RAW;
+    host_adc_set_raw(HOST_SMOKE_CHANNEL, raw);
+    host_adc_set_raw(HOST_GAS_CHANNEL, raw);
+    printf("HOST t=%.3fs sensors %s\n", host_clock_now_us() / 1e6, fire ? "FIRE" : "ambient");
+    fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+    host_options_t opt;
+    if (parse_options(argc, argv, &opt) != 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    host_clock_set_mode(opt.virtual_clock ? HOST_CLOCK_VIRTUAL : HOST_CLOCK_REALTIME);
+    host_random_seed(opt.seed);
+    if (opt.verbose) {
+        host_mqtt_set_publish_hook(on_publish, NULL);
+    }
+
+    host_adc_set_raw(HOST_SMOKE_CHANNEL, HOST_AMBIENT_RAW);
+    host_adc_set_raw(HOST_GAS_CHANNEL, HOST_AMBIENT_RAW);
+    host_adc_set_raw(HOST_TEMPERATURE_CHANNEL, HOST_AMBIENT_RAW);
+    host_adc_set_noise(HOST_SMOKE_CHANNEL, HOST_NOISE_RAW);
+    host_adc_set_noise(HOST_GAS_CHANNEL, HOST_NOISE_RAW);
+    host_adc_set_noise(HOST_TEMPERATURE_CHANNEL, HOST_NOISE_RAW);
+
+    if (xTaskCreatePinnedToCore(main_task, "main", 3584, NULL, 1, NULL, 0) != pdPASS) {
+        fprintf(stderr, "Failed to start main task\n");
+        return 1;
+    }
+
+    // Các mốc theo thứ tự thời gian
+    if (opt.fire_at_s >= 0 && opt.fire_at_s < opt.duration_s) {
+        sleep_until_s(opt.fire_at_s);
+        set_fire(true);
+    }
+    if (opt.clear_at_s >= 0 && opt.clear_at_s < opt.duration_s && opt.clear_at_s >= opt.fire_at_s) {
+        sleep_until_s(opt.clear_at_s);
+        set_fire(false);
+    }
+    sleep_until_s(opt.duration_s);
+
+    host_mqtt_stats_t mqtt;
+    uint32_t frames_read = 0;
+    uint32_t frames_dropped = 0;
+    host_mqtt_get_stats(&mqtt);
+    host_adc_get_counts(&frames_read, &frames_dropped);
+
+    printf("HOST summary: %.1fs, adc frames %lu read / %lu dropped, mqtt %lu connects, "
+           "%lu published, %lu acked, %lu delivered, buzzer duty %lu\n",
+           opt.duration_s, (unsigned long)frames_read, (unsigned long)frames_dropped,
+           (unsigned long)mqtt.connects, (unsigned long)mqtt.published, (unsigned long)mqtt.acked,
+           (unsigned long)mqtt.delivered, (unsigned long)host_ledc_get_duty(HOST_BUZZER_CHANNEL));
+    fflush(stdout);
+
+    // Các task vẫn đang chạy: kết thúc cả tiến trình
+    _Exit(0);
+}
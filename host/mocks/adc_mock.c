@@ -0,0 +1,368 @@
+#include <stdlib.h>
+#include <string.h>
+#include "esp_adc/adc_continuous.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "host_hal.h"
+#include "host_kernel.h"
+
+/*
+ * ADC liên tục giả lập. Frame thứ k hoàn tất tại start + (k + 1) * chu kỳ
+ * frame; số frame đã chuyển đổi được tính lại từ đồng hồ mỗi lần đọc nên
+ * không cần luồng DMA. Ring buffer giữ tối đa max_store/frame frame, phần
+ * dư bị bỏ và báo qua on_pool_ovf như driver thật.
+ *
+ * Khi có on_conv_done, mỗi frame còn được đưa cho callback đúng lúc hoàn tất
+ * (công việc hẹn giờ, trong vùng tới hạn như ISR) và tính là đã đọc.
+ */
+
+#define HOST_ADC_CHANNELS 10
+#define HOST_ADC_VREF_MV 3100
+
+struct adc_continuous_ctx_t {
+    uint32_t frame_bytes;
+    uint32_t pool_frames;
+    adc_digi_pattern_config_t pattern[SOC_ADC_PATT_LEN_MAX];
+    uint32_t pattern_num;
+    int64_t frame_period_us;
+    adc_continuous_evt_cbs_t cbs;
+    void *user_data;
+    bool running;
+    int64_t start_us;
+    uint64_t consumed;                  // Frame đã đọc hoặc đã bỏ
+    uint64_t delivered;                 // Frame đã đưa cho on_conv_done
+    host_work_t conv_done_work;
+    uint8_t *conv_buf;                  // Frame đưa cho on_conv_done
+};
+
+struct adc_cali_scheme_t {
+    adc_atten_t atten;
+};
+
+static void conv_done_fire(void *arg);
+
+static uint16_t s_raw[HOST_ADC_CHANNELS];
+static uint16_t s_noise[HOST_ADC_CHANNELS];
+static uint32_t s_seed = 0x9E3779B9;
+static uint32_t s_frames_read = 0;
+static uint32_t s_frames_dropped = 0;
+
+void host_adc_set_raw(uint8_t channel, uint16_t raw)
+{
+    if (channel < HOST_ADC_CHANNELS) {
+        __atomic_store_n(&s_raw[channel], raw > 4095 ? 4095 : raw, __ATOMIC_RELAXED);
+    }
+}
+
+void host_adc_set_noise(uint8_t channel, uint16_t amplitude)
+{
+    if (channel < HOST_ADC_CHANNELS) {
+        __atomic_store_n(&s_noise[channel], amplitude, __ATOMIC_RELAXED);
+    }
+}
+
+void host_adc_set_seed(uint32_t seed)
+{
+    s_seed = seed;
+}
+
+void host_adc_get_counts(uint32_t *frames_read, uint32_t *frames_dropped)
+{
+    host_lock();
+    if (frames_read != NULL) {
+        *frames_read = s_frames_read;
+    }
+    if (frames_dropped != NULL) {
+        *frames_dropped = s_frames_dropped;
+    }
+    host_unlock();
+}
+
+esp_err_t adc_continuous_new_handle(const adc_continuous_handle_cfg_t *hdl_config,
+                                    adc_continuous_handle_t *ret_handle)
+{
+    if (hdl_config == NULL || ret_handle == NULL || hdl_config->conv_frame_size == 0 ||
+        hdl_config->conv_frame_size % SOC_ADC_DIGI_RESULT_BYTES != 0 ||
+        hdl_config->max_store_buf_size < hdl_config->conv_frame_size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct adc_continuous_ctx_t *ctx = calloc(1, sizeof(struct adc_continuous_ctx_t));
+    if (ctx == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ctx->frame_bytes = hdl_config->conv_frame_size;
+    ctx->pool_frames = hdl_config->max_store_buf_size / hdl_config->conv_frame_size;
+    ctx->conv_buf = malloc(ctx->frame_bytes);
+    if (ctx->conv_buf == NULL) {
+        free(ctx);
+        return ESP_ERR_NO_MEM;
+    }
+
+    *ret_handle = ctx;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_config(adc_continuous_handle_t handle, const adc_continuous_config_t *config)
+{
+    if (handle == NULL || config == NULL || config->pattern_num == 0 ||
+        config->pattern_num > SOC_ADC_PATT_LEN_MAX || config->sample_freq_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (handle->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    memcpy(handle->pattern, config->adc_pattern, config->pattern_num * sizeof(adc_digi_pattern_config_t));
+    handle->pattern_num = config->pattern_num;
+
+    uint32_t results = handle->frame_bytes / SOC_ADC_DIGI_RESULT_BYTES;
+    handle->frame_period_us = (int64_t)results * 1000000 / config->sample_freq_hz;
+    if (handle->frame_period_us == 0) {
+        handle->frame_period_us = 1;
+    }
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_register_event_callbacks(adc_continuous_handle_t handle,
+                                                  const adc_continuous_evt_cbs_t *cbs, void *user_data)
+{
+    if (handle == NULL || cbs == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    handle->cbs = *cbs;
+    handle->user_data = user_data;
+    handle->conv_done_work.fn = conv_done_fire;
+    handle->conv_done_work.arg = handle;
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_start(adc_continuous_handle_t handle)
+{
+    if (handle == NULL || handle->pattern_num == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    host_lock();
+    if (handle->running) {
+        host_unlock();
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->running = true;
+    handle->start_us = host_now_us();
+    handle->consumed = 0;
+    handle->delivered = 0;
+    bool conv_done = (handle->cbs.on_conv_done != NULL);
+    host_unlock();
+
+    if (conv_done) {
+        host_work_schedule(&handle->conv_done_work, handle->start_us + handle->frame_period_us);
+    }
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_stop(adc_continuous_handle_t handle)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    host_lock();
+    if (!handle->running) {
+        host_unlock();
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->running = false;
+    host_wake_all();
+    host_unlock();
+
+    host_work_cancel(&handle->conv_done_work);
+    return ESP_OK;
+}
+
+esp_err_t adc_continuous_deinit(adc_continuous_handle_t handle)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (handle->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    free(handle->conv_buf);
+    free(handle);
+    return ESP_OK;
+}
+
+static uint64_t frames_produced_locked(const struct adc_continuous_ctx_t *ctx)
+{
+    int64_t elapsed = host_now_us() - ctx->start_us;
+    return (elapsed > 0) ? (uint64_t)(elapsed / ctx->frame_period_us) : 0;
+}
+
+/**
+ * @brief Bỏ các frame không còn chỗ trong ring buffer, trả về số frame đã bỏ
+ */
+static uint32_t drop_overflow_locked(struct adc_continuous_ctx_t *ctx)
+{
+    uint64_t produced = frames_produced_locked(ctx);
+    if (produced - ctx->consumed <= ctx->pool_frames) {
+        return 0;
+    }
+
+    uint32_t dropped = (uint32_t)(produced - ctx->pool_frames - ctx->consumed);
+    ctx->consumed = produced - ctx->pool_frames;
+    s_frames_dropped += dropped;
+    return dropped;
+}
+
+static uint32_t hash32(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+/**
+ * @brief Điền frame thứ index theo pattern (định dạng TYPE1)
+ */
+static void fill_frame(const struct adc_continuous_ctx_t *ctx, uint64_t index, uint8_t *buf, uint32_t len)
+{
+    uint32_t results = len / SOC_ADC_DIGI_RESULT_BYTES;
+    uint64_t first = index * (ctx->frame_bytes / SOC_ADC_DIGI_RESULT_BYTES);
+
+    for (uint32_t i = 0; i < results; i++) {
+        uint8_t channel = ctx->pattern[(first + i) % ctx->pattern_num].channel;
+        int value = 0;
+        if (channel < HOST_ADC_CHANNELS) {
+            value = __atomic_load_n(&s_raw[channel], __ATOMIC_RELAXED);
+            uint16_t noise = __atomic_load_n(&s_noise[channel], __ATOMIC_RELAXED);
+            if (noise > 0) {
+                uint32_t r = hash32((uint32_t)(first + i) ^ s_seed);
+                value += (int)(r % (2u * noise + 1)) - noise;
+            }
+        }
+        if (value < 0) {
+            value = 0;
+        } else if (value > 4095) {
+            value = 4095;
+        }
+
+        adc_digi_output_data_t out;
+        out.type1.data = (uint16_t)value;
+        out.type1.channel = channel & 0xF;
+        memcpy(buf + i * SOC_ADC_DIGI_RESULT_BYTES, &out.val, SOC_ADC_DIGI_RESULT_BYTES);
+    }
+}
+
+/**
+ * @brief Đưa frame vừa hoàn tất cho on_conv_done rồi hẹn frame kế tiếp
+ */
+static void conv_done_fire(void *arg)
+{
+    struct adc_continuous_ctx_t *ctx = arg;
+
+    host_lock();
+    if (!ctx->running) {
+        host_unlock();
+        return;
+    }
+    uint64_t index = ctx->delivered++;
+    s_frames_read++;
+    host_unlock();
+    host_work_schedule(&ctx->conv_done_work, ctx->start_us + (int64_t)(index + 2) * ctx->frame_period_us);
+
+    fill_frame(ctx, index, ctx->conv_buf, ctx->frame_bytes);
+    adc_continuous_evt_data_t edata = {
+        .conv_frame_buffer = ctx->conv_buf,
+        .size = ctx->frame_bytes,
+    };
+    host_critical_enter();
+    ctx->cbs.on_conv_done(ctx, &edata, ctx->user_data);
+    host_critical_exit();
+}
+
+esp_err_t adc_continuous_read(adc_continuous_handle_t handle, uint8_t *buf, uint32_t length_max,
+                              uint32_t *out_length, uint32_t timeout_ms)
+{
+    if (handle == NULL || buf == NULL || out_length == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    int64_t deadline = host_now_us() + (int64_t)timeout_ms * 1000;
+    uint32_t dropped = 0;
+    uint64_t index = 0;
+    esp_err_t ret = ESP_OK;
+
+    host_lock();
+    while (1) {
+        if (!handle->running) {
+            ret = ESP_ERR_INVALID_STATE;
+            break;
+        }
+        dropped += drop_overflow_locked(handle);
+        if (frames_produced_locked(handle) > handle->consumed) {
+            index = handle->consumed++;
+            s_frames_read++;
+            break;
+        }
+        // Chờ tới lúc frame kế tiếp hoàn tất hoặc hết thời gian
+        int64_t next = handle->start_us + (int64_t)(handle->consumed + 1) * handle->frame_period_us;
+        if (host_wait(next < deadline ? next : deadline) != 0 && host_now_us() >= deadline) {
+            ret = ESP_ERR_TIMEOUT;
+            break;
+        }
+    }
+    host_unlock();
+
+    for (uint32_t i = 0; i < dropped && handle->cbs.on_pool_ovf != NULL; i++) {
+        handle->cbs.on_pool_ovf(handle, NULL, handle->user_data);
+    }
+    if (ret != ESP_OK) {
+        *out_length = 0;
+        return ret;
+    }
+
+    uint32_t len = (length_max < handle->frame_bytes) ? length_max : handle->frame_bytes;
+    len -= len % SOC_ADC_DIGI_RESULT_BYTES;
+    fill_frame(handle, index, buf, len);
+    *out_length = len;
+    return ESP_OK;
+}
+
+// ==== Hiệu chuẩn ====
+
+esp_err_t adc_cali_create_scheme_line_fitting(const adc_cali_line_fitting_config_t *config,
+                                              adc_cali_handle_t *ret_handle)
+{
+    if (config == NULL || ret_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct adc_cali_scheme_t *cali = calloc(1, sizeof(struct adc_cali_scheme_t));
+    if (cali == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    cali->atten = config->atten;
+    *ret_handle = cali;
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_delete_scheme_line_fitting(adc_cali_handle_t handle)
+{
+    free(handle);
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t handle, int raw, int *voltage)
+{
+    if (handle == NULL || voltage == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Đường thẳng lý tưởng cho 12 dB
+    *voltage = raw * HOST_ADC_VREF_MV / 4095;
+    return ESP_OK;
+}
@@ -0,0 +1,133 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "host_hal.h"
+#include "host_kernel.h"
+
+#define HOST_HEAP_SIZE (300 * 1024)     // Giá trị cố định cho chẩn đoán heap
+
+static int s_log_level = ESP_LOG_INFO;
+static uint32_t s_random_state = 0x2545F491;
+
+// ==== Log ====
+
+void host_log_set_level(int level)
+{
+    s_log_level = level;
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    (void)tag;
+    s_log_level = level;
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return (uint32_t)(host_now_us() / 1000);
+}
+
+void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    static const char letters[] = { 'N', 'E', 'W', 'I', 'D', 'V' };
+    char line[512];
+
+    if ((int)level > s_log_level || level == ESP_LOG_NONE) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    // Một lệnh printf mỗi dòng để các luồng không xen nhau
+    printf("%c (%lu) %s: %s\n", letters[level], (unsigned long)esp_log_timestamp(), tag, line);
+    fflush(stdout);
+}
+
+// ==== Ngẫu nhiên ====
+
+void host_random_seed(uint32_t seed)
+{
+    host_critical_enter();
+    s_random_state = (seed != 0) ? seed : 0x2545F491;
+    host_critical_exit();
+    host_adc_set_seed(seed);
+}
+
+uint32_t esp_random(void)
+{
+    // xorshift32: lặp lại được với cùng seed
+    host_critical_enter();
+    uint32_t x = s_random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    s_random_state = x;
+    host_critical_exit();
+    return x;
+}
+
+// ==== Heap / hệ thống ====
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    (void)caps;
+    return HOST_HEAP_SIZE;
+}
+
+size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    (void)caps;
+    return HOST_HEAP_SIZE;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    (void)caps;
+    return HOST_HEAP_SIZE / 2;
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return HOST_HEAP_SIZE;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    return HOST_HEAP_SIZE;
+}
+
+void esp_restart(void)
+{
+    printf("esp_restart() called, exiting\n");
+    fflush(stdout);
+    exit(0);
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK: return "ESP_OK";
+        case ESP_FAIL: return "ESP_FAIL";
+        case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_CRC: return "ESP_ERR_INVALID_CRC";
+        case ESP_ERR_NVS_NOT_INITIALIZED: return "ESP_ERR_NVS_NOT_INITIALIZED";
+        case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+        case ESP_ERR_NVS_INVALID_LENGTH: return "ESP_ERR_NVS_INVALID_LENGTH";
+        case ESP_ERR_NVS_NO_FREE_PAGES: return "ESP_ERR_NVS_NO_FREE_PAGES";
+        case ESP_ERR_NVS_NEW_VERSION_FOUND: return "ESP_ERR_NVS_NEW_VERSION_FOUND";
+        default: return "UNKNOWN_ERROR";
+    }
+}
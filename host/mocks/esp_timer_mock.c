@@ -0,0 +1,205 @@
+#include <stdlib.h>
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "esp_freertos_hooks.h"
+#include "host_kernel.h"
+
+/*
+ * esp_timer, bộ đếm chu kỳ CPU và tick hook trên hàng đợi công việc của
+ * host_kernel. Callback timer chạy trên luồng dịch vụ (như task esp_timer).
+ */
+
+#define HOST_TICK_PERIOD_US (1000000 / configTICK_RATE_HZ)
+#define HOST_MAX_TICK_HOOKS 8
+
+struct esp_timer {
+    host_work_t work;
+    esp_timer_cb_t callback;
+    void *arg;
+    uint64_t period_us;                 // 0: one-shot
+};
+
+static esp_freertos_tick_cb_t s_tick_hooks[portNUM_PROCESSORS][HOST_MAX_TICK_HOOKS];
+static host_work_t s_tick_work;
+static bool s_tick_started = false;
+
+int64_t esp_timer_get_time(void)
+{
+    return host_now_us();
+}
+
+static void timer_fire(void *arg)
+{
+    struct esp_timer *timer = arg;
+
+    if (timer->period_us > 0) {
+        host_work_schedule(&timer->work, timer->work.when_us + (int64_t)timer->period_us);
+    }
+    timer->callback(timer->arg);
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if (create_args == NULL || create_args->callback == NULL || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    struct esp_timer *timer = calloc(1, sizeof(struct esp_timer));
+    if (timer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->callback = create_args->callback;
+    timer->arg = create_args->arg;
+    timer->work.fn = timer_fire;
+    timer->work.arg = timer;
+
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+static esp_err_t timer_start(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (esp_timer_is_active(timer)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    timer->period_us = period_us;
+    host_work_schedule(&timer->work, host_now_us() + (int64_t)timeout_us);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return timer_start(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    return timer_start(timer, period_us, period_us);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Như trên target: dừng timer periodic đang chạy callback vẫn là ESP_OK
+    timer->period_us = 0;
+    return host_work_cancel(&timer->work) ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (timer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (esp_timer_is_active(timer)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    free(timer);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    host_lock();
+    bool armed = timer->work.armed;
+    host_unlock();
+    return armed;
+}
+
+// ==== CPU ====
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void)
+{
+    return (esp_cpu_cycle_count_t)((uint64_t)host_now_us() * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+}
+
+int esp_cpu_get_core_id(void)
+{
+    return host_task_core_id();
+}
+
+uint32_t esp_rom_get_cpu_ticks_per_us(void)
+{
+    return CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+}
+
+// ==== Tick hook ====
+
+/**
+ * @brief Một "ngắt tick": chạy hook của từng core trong critical section, như ngắt thật
+ */
+static void tick_fire(void *arg)
+{
+    (void)arg;
+    host_work_schedule(&s_tick_work, s_tick_work.when_us + HOST_TICK_PERIOD_US);
+
+    for (int cpu = 0; cpu < portNUM_PROCESSORS; cpu++) {
+        host_critical_enter();
+        host_set_core_override(cpu);
+        for (int i = 0; i < HOST_MAX_TICK_HOOKS; i++) {
+            if (s_tick_hooks[cpu][i] != NULL) {
+                s_tick_hooks[cpu][i]();
+            }
+        }
+        host_set_core_override(-1);
+        host_critical_exit();
+    }
+}
+
+void host_tick_hooks_start(void)
+{
+    host_lock();
+    bool start = !s_tick_started;
+    s_tick_started = true;
+    host_unlock();
+
+    if (start) {
+        s_tick_work.fn = tick_fire;
+        host_work_schedule(&s_tick_work, host_now_us() + HOST_TICK_PERIOD_US);
+    }
+}
+
+esp_err_t esp_register_freertos_tick_hook_for_cpu(esp_freertos_tick_cb_t new_tick_cb, UBaseType_t cpuid)
+{
+    if (new_tick_cb == NULL || cpuid >= portNUM_PROCESSORS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    host_critical_enter();
+    for (int i = 0; i < HOST_MAX_TICK_HOOKS; i++) {
+        if (s_tick_hooks[cpuid][i] == NULL) {
+            s_tick_hooks[cpuid][i] = new_tick_cb;
+            ret = ESP_OK;
+            break;
+        }
+    }
+    host_critical_exit();
+
+    if (ret == ESP_OK) {
+        host_tick_hooks_start();
+    }
+    return ret;
+}
+
+void esp_deregister_freertos_tick_hook_for_cpu(esp_freertos_tick_cb_t old_tick_cb, UBaseType_t cpuid)
+{
+    if (cpuid >= portNUM_PROCESSORS) {
+        return;
+    }
+
+    host_critical_enter();
+    for (int i = 0; i < HOST_MAX_TICK_HOOKS; i++) {
+        if (s_tick_hooks[cpuid][i] == old_tick_cb) {
+            s_tick_hooks[cpuid][i] = NULL;
+        }
+    }
+    host_critical_exit();
+}
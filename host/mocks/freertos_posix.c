@@ -0,0 +1,634 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "host_kernel.h"
+
+/*
+ * Task, notification, queue, semaphore và event group trên pthreads. Mọi
+ * trạng thái được bảo vệ bởi khóa chung của host_kernel; bên chờ dùng
+ * host_wait() nên chạy được với cả đồng hồ thật và đồng hồ ảo.
+ */
+
+struct host_task {
+    char name[configMAX_TASK_NAME_LEN];
+    TaskFunction_t fn;
+    void *arg;
+    pthread_t thread;
+    UBaseType_t number;
+    UBaseType_t priority;
+    uint32_t stack_depth;
+    BaseType_t core;                    // tskNO_AFFINITY nếu không ghim
+    bool external;                      // Luồng không do xTaskCreate tạo (main, dịch vụ)
+    host_thread_t *sched;
+    uint32_t notify_value;
+    bool notify_pending;
+    struct host_task *next;
+};
+
+struct host_queue {
+    uint8_t *storage;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;                   // Phần tử đọc kế tiếp
+    UBaseType_t count;
+};
+
+struct host_event_group {
+    EventBits_t bits;
+};
+
+static struct host_task *s_tasks = NULL;            // Chỉ task do xTaskCreate tạo
+static UBaseType_t s_task_count = 0;
+static UBaseType_t s_next_number = 1;
+static __thread struct host_task *t_current = NULL;
+static __thread int t_core_override = -1;
+
+// ==== Task ====
+
+static void *task_entry(void *arg)
+{
+    struct host_task *task = arg;
+
+    t_current = task;
+    host_thread_start(task->sched);
+    task->fn(task->arg);
+
+    // Task FreeRTOS không được return; coi như tự xóa
+    vTaskDelete(NULL);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t pxTaskCode, const char *pcName, uint32_t usStackDepth,
+                                   void *pvParameters, UBaseType_t uxPriority,
+                                   TaskHandle_t *pxCreatedTask, BaseType_t xCoreID)
+{
+    struct host_task *task = calloc(1, sizeof(struct host_task));
+    if (task == NULL) {
+        return pdFAIL;
+    }
+
+    strncpy(task->name, pcName != NULL ? pcName : "", sizeof(task->name) - 1);
+    task->fn = pxTaskCode;
+    task->arg = pvParameters;
+    task->priority = uxPriority;
+    task->stack_depth = usStackDepth;
+    task->core = xCoreID;
+
+    host_lock();
+    task->number = s_next_number++;
+    task->next = s_tasks;
+    s_tasks = task;
+    s_task_count++;
+    task->sched = host_thread_register_locked(uxPriority, task->number);
+
+    // Tạo thread khi giữ khóa: task chưa chạy được trước khi có trong danh sách
+    int rc = -1;
+    if (task->sched != NULL) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        rc = pthread_create(&task->thread, &attr, task_entry, task);
+        pthread_attr_destroy(&attr);
+    }
+
+    if (rc != 0) {
+        if (task->sched != NULL) {
+            host_thread_exit_locked(task->sched);
+        }
+        s_tasks = task->next;
+        s_task_count--;
+        host_unlock();
+        free(task);
+        return pdFAIL;
+    }
+    if (pxCreatedTask != NULL) {
+        *pxCreatedTask = task;
+    }
+    host_unlock();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char *pcName, uint32_t usStackDepth,
+                       void *pvParameters, UBaseType_t uxPriority, TaskHandle_t *pxCreatedTask)
+{
+    return xTaskCreatePinnedToCore(pxTaskCode, pcName, usStackDepth, pvParameters, uxPriority,
+                                   pxCreatedTask, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t xTaskToDelete)
+{
+    // pthreads không hủy được thread khác an toàn: chỉ hỗ trợ task tự xóa
+    configASSERT(xTaskToDelete == NULL || xTaskToDelete == t_current);
+
+    struct host_task *task = t_current;
+    if (task == NULL || task->external) {
+        pthread_exit(NULL);
+    }
+
+    host_lock();
+    for (struct host_task **pp = &s_tasks; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == task) {
+            *pp = task->next;
+            s_task_count--;
+            break;
+        }
+    }
+    host_thread_exit_locked(task->sched);
+    host_unlock();
+
+    // Handle có thể còn bị giữ ở nơi khác (như trên target sau khi xóa): không giải phóng
+    t_current = NULL;
+    pthread_exit(NULL);
+}
+
+/**
+ * @brief Task của luồng hiện tại, tạo bản ghi ngoài danh sách nếu luồng không phải task
+ */
+static struct host_task *current_task(void)
+{
+    if (t_current == NULL) {
+        struct host_task *task = calloc(1, sizeof(struct host_task));
+        configASSERT(task != NULL);
+        strncpy(task->name, "host", sizeof(task->name) - 1);
+        task->thread = pthread_self();
+        task->core = 0;
+        task->external = true;
+        t_current = task;
+    }
+    return t_current;
+}
+
+int host_task_core_id(void)
+{
+    if (t_core_override >= 0) {
+        return t_core_override;
+    }
+
+    struct host_task *task = t_current;
+    if (task == NULL) {
+        return 0;
+    }
+    if (task->core != tskNO_AFFINITY) {
+        return (int)task->core;
+    }
+    return (int)(task->number % portNUM_PROCESSORS);
+}
+
+void host_set_core_override(int core)
+{
+    t_core_override = core;
+}
+
+static void sleep_until(int64_t deadline_us)
+{
+    host_lock();
+    while (host_wait(deadline_us) == 0) {
+    }
+    host_unlock();
+}
+
+void vTaskDelay(TickType_t xTicksToDelay)
+{
+    if (xTicksToDelay == 0) {
+        sched_yield();
+        return;
+    }
+    sleep_until(host_deadline_from_ticks(xTicksToDelay));
+}
+
+BaseType_t xTaskDelayUntil(TickType_t *pxPreviousWakeTime, TickType_t xTimeIncrement)
+{
+    TickType_t wake = *pxPreviousWakeTime + xTimeIncrement;
+    TickType_t now = xTaskGetTickCount();
+
+    *pxPreviousWakeTime = wake;
+    if ((int32_t)(wake - now) <= 0) {
+        return pdFALSE;
+    }
+    vTaskDelay(wake - now);
+    return pdTRUE;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(host_now_us() / (1000000 / configTICK_RATE_HZ));
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return xTaskGetTickCount();
+}
+
+// ==== Notification ====
+
+BaseType_t xTaskNotify(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction)
+{
+    if (xTaskToNotify == NULL) {
+        return pdFAIL;
+    }
+
+    BaseType_t ret = pdPASS;
+    host_lock();
+    switch (eAction) {
+        case eSetBits:
+            xTaskToNotify->notify_value |= ulValue;
+            break;
+        case eIncrement:
+            xTaskToNotify->notify_value++;
+            break;
+        case eSetValueWithOverwrite:
+            xTaskToNotify->notify_value = ulValue;
+            break;
+        case eSetValueWithoutOverwrite:
+            if (xTaskToNotify->notify_pending) {
+                ret = pdFAIL;
+            } else {
+                xTaskToNotify->notify_value = ulValue;
+            }
+            break;
+        case eNoAction:
+        default:
+            break;
+    }
+    if (ret == pdPASS) {
+        xTaskToNotify->notify_pending = true;
+        host_wake_all();
+    }
+    host_unlock();
+    return ret;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction,
+                              BaseType_t *pxHigherPriorityTaskWoken)
+{
+    if (pxHigherPriorityTaskWoken != NULL) {
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    }
+    return xTaskNotify(xTaskToNotify, ulValue, eAction);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    xTaskNotifyFromISR(xTaskToNotify, 0, eIncrement, pxHigherPriorityTaskWoken);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit,
+                           uint32_t *pulNotificationValue, TickType_t xTicksToWait)
+{
+    struct host_task *task = current_task();
+    int64_t deadline = host_deadline_from_ticks(xTicksToWait);
+    BaseType_t ret = pdTRUE;
+
+    host_lock();
+    if (!task->notify_pending) {
+        task->notify_value &= ~ulBitsToClearOnEntry;
+    }
+    while (!task->notify_pending) {
+        if (host_wait(deadline) != 0) {
+            ret = pdFALSE;
+            break;
+        }
+    }
+    if (pulNotificationValue != NULL) {
+        *pulNotificationValue = task->notify_value;
+    }
+    if (ret == pdTRUE) {
+        task->notify_value &= ~ulBitsToClearOnExit;
+    }
+    task->notify_pending = false;
+    host_unlock();
+    return ret;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    struct host_task *task = current_task();
+    int64_t deadline = host_deadline_from_ticks(xTicksToWait);
+
+    host_lock();
+    while (task->notify_value == 0) {
+        if (host_wait(deadline) != 0) {
+            break;
+        }
+    }
+    uint32_t value = task->notify_value;
+    if (value != 0) {
+        task->notify_value = xClearCountOnExit ? 0 : value - 1;
+    }
+    task->notify_pending = false;
+    host_unlock();
+    return value;
+}
+
+// ==== Thông tin task ====
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return current_task();
+}
+
+const char *pcTaskGetName(TaskHandle_t xTaskToQuery)
+{
+    struct host_task *task = (xTaskToQuery != NULL) ? xTaskToQuery : current_task();
+    return task->name;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t xTask)
+{
+    struct host_task *task = (xTask != NULL) ? xTask : current_task();
+    return task->stack_depth;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    host_lock();
+    UBaseType_t count = s_task_count;
+    host_unlock();
+    return count;
+}
+
+static uint32_t thread_cpu_us(pthread_t thread)
+{
+    clockid_t cid;
+    struct timespec ts;
+
+    // Đồng hồ ảo: task chạy không tốn thời gian, giữ kết quả lặp lại được
+    if (host_clock_is_virtual() ||
+        pthread_getcpuclockid(thread, &cid) != 0 || clock_gettime(cid, &ts) != 0) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t *pxTaskStatusArray, UBaseType_t uxArraySize,
+                                 uint32_t *pulTotalRunTime)
+{
+    UBaseType_t count = 0;
+
+    host_lock();
+    if (s_task_count > uxArraySize) {
+        host_unlock();
+        return 0;
+    }
+
+    for (struct host_task *task = s_tasks; task != NULL; task = task->next) {
+        TaskStatus_t *st = &pxTaskStatusArray[count++];
+        memset(st, 0, sizeof(TaskStatus_t));
+        st->xHandle = task;
+        st->pcTaskName = task->name;
+        st->xTaskNumber = task->number;
+        st->eCurrentState = (task == t_current) ? eRunning : eBlocked;
+        st->uxCurrentPriority = task->priority;
+        st->uxBasePriority = task->priority;
+        st->ulRunTimeCounter = thread_cpu_us(task->thread);
+        st->usStackHighWaterMark = task->stack_depth;
+        st->xCoreID = task->core;
+    }
+    if (pulTotalRunTime != NULL) {
+        *pulTotalRunTime = (uint32_t)host_now_us();
+    }
+    host_unlock();
+    return count;
+}
+
+// ==== Queue / semaphore ====
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize)
+{
+    if (uxQueueLength == 0) {
+        return NULL;
+    }
+
+    struct host_queue *q = calloc(1, sizeof(struct host_queue));
+    if (q == NULL) {
+        return NULL;
+    }
+    if (uxItemSize > 0) {
+        q->storage = malloc(uxQueueLength * uxItemSize);
+        if (q->storage == NULL) {
+            free(q);
+            return NULL;
+        }
+    }
+    q->length = uxQueueLength;
+    q->item_size = uxItemSize;
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t xQueue)
+{
+    if (xQueue != NULL) {
+        free(xQueue->storage);
+        free(xQueue);
+    }
+}
+
+static BaseType_t queue_send(QueueHandle_t q, const void *item, TickType_t ticks, bool front, bool overwrite)
+{
+    if (q == NULL) {
+        return errQUEUE_FULL;
+    }
+
+    int64_t deadline = host_deadline_from_ticks(ticks);
+    host_lock();
+    while (q->count == q->length && !overwrite) {
+        if (host_wait(deadline) != 0) {
+            host_unlock();
+            return errQUEUE_FULL;
+        }
+    }
+
+    if (q->count == q->length) {
+        // Chỉ xQueueOverwrite (queue 1 phần tử): thay phần tử hiện có
+        q->count = 0;
+    }
+
+    UBaseType_t slot;
+    if (front) {
+        q->head = (q->head + q->length - 1) % q->length;
+        slot = q->head;
+    } else {
+        slot = (q->head + q->count) % q->length;
+    }
+    if (q->item_size > 0) {
+        memcpy(q->storage + slot * q->item_size, item, q->item_size);
+    }
+    q->count++;
+
+    host_wake_all();
+    host_unlock();
+    return pdPASS;
+}
+
+BaseType_t xQueueSendToBack(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait)
+{
+    return queue_send(xQueue, pvItemToQueue, xTicksToWait, false, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void *pvItemToQueue, TickType_t xTicksToWait)
+{
+    return queue_send(xQueue, pvItemToQueue, xTicksToWait, true, false);
+}
+
+BaseType_t xQueueOverwrite(QueueHandle_t xQueue, const void *pvItemToQueue)
+{
+    return queue_send(xQueue, pvItemToQueue, 0, false, true);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t xQueue, const void *pvItemToQueue,
+                             BaseType_t *pxHigherPriorityTaskWoken)
+{
+    if (pxHigherPriorityTaskWoken != NULL) {
+        *pxHigherPriorityTaskWoken = pdFALSE;
+    }
+    return queue_send(xQueue, pvItemToQueue, 0, false, false);
+}
+
+static BaseType_t queue_receive(QueueHandle_t q, void *buffer, TickType_t ticks, bool peek)
+{
+    if (q == NULL) {
+        return errQUEUE_EMPTY;
+    }
+
+    int64_t deadline = host_deadline_from_ticks(ticks);
+    host_lock();
+    while (q->count == 0) {
+        if (host_wait(deadline) != 0) {
+            host_unlock();
+            return errQUEUE_EMPTY;
+        }
+    }
+
+    if (q->item_size > 0 && buffer != NULL) {
+        memcpy(buffer, q->storage + q->head * q->item_size, q->item_size);
+    }
+    if (!peek) {
+        q->head = (q->head + 1) % q->length;
+        q->count--;
+        host_wake_all();
+    }
+    host_unlock();
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait)
+{
+    return queue_receive(xQueue, pvBuffer, xTicksToWait, false);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t xQueue, void *pvBuffer, TickType_t xTicksToWait)
+{
+    return queue_receive(xQueue, pvBuffer, xTicksToWait, true);
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t xQueue)
+{
+    host_lock();
+    UBaseType_t count = xQueue->count;
+    host_unlock();
+    return count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(QueueHandle_t xQueue)
+{
+    host_lock();
+    UBaseType_t spaces = xQueue->length - xQueue->count;
+    host_unlock();
+    return spaces;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    // Không có kế thừa ưu tiên; mutex bắt đầu ở trạng thái "đã give"
+    SemaphoreHandle_t sem = xQueueCreate(1, 0);
+    if (sem != NULL) {
+        sem->count = 1;
+    }
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t uxMaxCount, UBaseType_t uxInitialCount)
+{
+    SemaphoreHandle_t sem = xQueueCreate(uxMaxCount, 0);
+    if (sem != NULL) {
+        sem->count = uxInitialCount;
+    }
+    return sem;
+}
+
+// ==== Event group ====
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    return calloc(1, sizeof(struct host_event_group));
+}
+
+void vEventGroupDelete(EventGroupHandle_t xEventGroup)
+{
+    free(xEventGroup);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t xEventGroup, EventBits_t uxBitsToSet)
+{
+    host_lock();
+    xEventGroup->bits |= uxBitsToSet;
+    EventBits_t bits = xEventGroup->bits;
+    host_wake_all();
+    host_unlock();
+    return bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t xEventGroup, EventBits_t uxBitsToClear)
+{
+    host_lock();
+    EventBits_t bits = xEventGroup->bits;
+    xEventGroup->bits &= ~uxBitsToClear;
+    host_unlock();
+    return bits;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t xEventGroup)
+{
+    host_lock();
+    EventBits_t bits = xEventGroup->bits;
+    host_unlock();
+    return bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t xEventGroup, EventBits_t uxBitsToWaitFor,
+                                BaseType_t xClearOnExit, BaseType_t xWaitForAllBits,
+                                TickType_t xTicksToWait)
+{
+    int64_t deadline = host_deadline_from_ticks(xTicksToWait);
+
+    host_lock();
+    while (1) {
+        EventBits_t match = xEventGroup->bits & uxBitsToWaitFor;
+        bool done = xWaitForAllBits ? (match == uxBitsToWaitFor) : (match != 0);
+        if (done) {
+            EventBits_t bits = xEventGroup->bits;
+            if (xClearOnExit) {
+                xEventGroup->bits &= ~uxBitsToWaitFor;
+            }
+            host_unlock();
+            return bits;
+        }
+        if (host_wait(deadline) != 0) {
+            break;
+        }
+    }
+    EventBits_t bits = xEventGroup->bits;
+    host_unlock();
+    return bits;
+}
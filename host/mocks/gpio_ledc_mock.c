@@ -0,0 +1,166 @@
+#include "driver/gpio.h"
+#include "driver/ledc.h"
+#include "host_hal.h"
+#include "host_kernel.h"
+
+/*
+ * GPIO: đầu vào đọc mức do host_gpio_set_level() đặt (mặc định 1, như có
+ * kéo lên). LEDC: duty chỉ có hiệu lực sau ledc_update_duty() như phần cứng.
+ */
+
+static uint8_t s_level[GPIO_NUM_MAX];
+static bool s_level_set[GPIO_NUM_MAX];
+
+static uint32_t s_timer_freq[LEDC_TIMER_COUNT];
+static uint32_t s_duty_pending[LEDC_CHANNEL_COUNT];
+static uint32_t s_duty[LEDC_CHANNEL_COUNT];
+
+static bool gpio_valid(int gpio_num)
+{
+    return gpio_num >= 0 && gpio_num < GPIO_NUM_MAX;
+}
+
+void host_gpio_set_level(int gpio_num, int level)
+{
+    if (gpio_valid(gpio_num)) {
+        host_critical_enter();
+        s_level[gpio_num] = (level != 0);
+        s_level_set[gpio_num] = true;
+        host_critical_exit();
+    }
+}
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode)
+{
+    (void)mode;
+    return gpio_valid(gpio_num) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_set_pull_mode(gpio_num_t gpio_num, gpio_pull_mode_t pull)
+{
+    (void)pull;
+    return gpio_valid(gpio_num) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    if (!gpio_valid(gpio_num)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    host_gpio_set_level(gpio_num, (int)level);
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    if (!gpio_valid(gpio_num)) {
+        return 0;
+    }
+
+    host_critical_enter();
+    int level = s_level_set[gpio_num] ? s_level[gpio_num] : 1;
+    host_critical_exit();
+    return level;
+}
+
+// ==== LEDC ====
+
+esp_err_t ledc_timer_config(const ledc_timer_config_t *timer_conf)
+{
+    if (timer_conf == NULL || timer_conf->timer_num >= LEDC_TIMER_COUNT || timer_conf->freq_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    host_critical_enter();
+    s_timer_freq[timer_conf->timer_num] = timer_conf->freq_hz;
+    host_critical_exit();
+    return ESP_OK;
+}
+
+esp_err_t ledc_channel_config(const ledc_channel_config_t *ledc_conf)
+{
+    if (ledc_conf == NULL || ledc_conf->channel >= LEDC_CHANNEL_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    host_critical_enter();
+    s_duty_pending[ledc_conf->channel] = ledc_conf->duty;
+    s_duty[ledc_conf->channel] = ledc_conf->duty;
+    host_critical_exit();
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_freq(ledc_mode_t speed_mode, ledc_timer_t timer_num, uint32_t freq_hz)
+{
+    (void)speed_mode;
+    if (timer_num >= LEDC_TIMER_COUNT || freq_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    host_critical_enter();
+    s_timer_freq[timer_num] = freq_hz;
+    host_critical_exit();
+    return ESP_OK;
+}
+
+uint32_t ledc_get_freq(ledc_mode_t speed_mode, ledc_timer_t timer_num)
+{
+    (void)speed_mode;
+    return (timer_num < LEDC_TIMER_COUNT) ? host_ledc_get_freq(timer_num) : 0;
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t speed_mode, ledc_channel_t channel, uint32_t duty)
+{
+    (void)speed_mode;
+    if (channel >= LEDC_CHANNEL_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    host_critical_enter();
+    s_duty_pending[channel] = duty;
+    host_critical_exit();
+    return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t speed_mode, ledc_channel_t channel)
+{
+    (void)speed_mode;
+    if (channel >= LEDC_CHANNEL_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    host_critical_enter();
+    s_duty[channel] = s_duty_pending[channel];
+    host_critical_exit();
+    return ESP_OK;
+}
+
+uint32_t ledc_get_duty(ledc_mode_t speed_mode, ledc_channel_t channel)
+{
+    (void)speed_mode;
+    return (channel < LEDC_CHANNEL_COUNT) ? host_ledc_get_duty(channel) : 0;
+}
+
+uint32_t host_ledc_get_duty(int channel)
+{
+    if (channel < 0 || channel >= LEDC_CHANNEL_COUNT) {
+        return 0;
+    }
+
+    host_critical_enter();
+    uint32_t duty = s_duty[channel];
+    host_critical_exit();
+    return duty;
+}
+
+uint32_t host_ledc_get_freq(int timer)
+{
+    if (timer < 0 || timer >= LEDC_TIMER_COUNT) {
+        return 0;
+    }
+
+    host_critical_enter();
+    uint32_t freq = s_timer_freq[timer];
+    host_critical_exit();
+    return freq;
+}
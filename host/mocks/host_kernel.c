@@ -0,0 +1,462 @@
+#include "host_kernel.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include "host_hal.h"
+
+static pthread_mutex_t s_lock;
+static pthread_cond_t s_cond;               // Mọi thay đổi trạng thái đều broadcast
+static pthread_cond_t s_idle_cond;          // Đồng hồ ảo: lượt chạy được nhả
+static pthread_mutex_t s_critical;          // Đệ quy, cho portENTER_CRITICAL
+
+// Thời điểm app_main trên ESP32 (sau bootloader và khởi động IDF), để các mốc
+// thời gian của firmware không bằng 0 - boot_timeline coi 0 là "chưa đến"
+#define HOST_CLOCK_START_US 50000
+
+static int64_t s_start_us;                  // CLOCK_MONOTONIC lúc khởi động
+static host_clock_mode_t s_mode = HOST_CLOCK_REALTIME;
+static int64_t s_virtual_now = HOST_CLOCK_START_US;
+
+struct host_thread {
+    uint32_t priority;
+    uint32_t number;
+    int64_t deadline_us;                    // Thời hạn chờ hiện tại (đồng hồ ảo)
+    bool waiting;                           // Đang chờ trong host_wait()
+    bool woken;                             // Cần được chạy lại để kiểm tra điều kiện
+    pthread_cond_t turn;                    // Báo khi được giao lượt chạy
+    struct host_thread *next;
+};
+
+// Đồng hồ ảo: mọi task còn sống và task đang giữ lượt chạy
+static host_thread_t *s_threads = NULL;
+static host_thread_t *s_running = NULL;
+
+static host_work_t *s_work_head = NULL;
+static uint64_t s_work_seq = 0;
+static bool s_service_started = false;
+
+static __thread host_thread_t *t_self = NULL;
+
+static int64_t monotonic_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+__attribute__((constructor))
+static void host_kernel_init(void)
+{
+    pthread_mutexattr_t mattr;
+    pthread_mutexattr_init(&mattr);
+    pthread_mutexattr_settype(&mattr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&s_critical, &mattr);
+    pthread_mutexattr_destroy(&mattr);
+
+    pthread_mutex_init(&s_lock, NULL);
+
+    pthread_condattr_t cattr;
+    pthread_condattr_init(&cattr);
+    pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+    pthread_cond_init(&s_cond, &cattr);
+    pthread_cond_init(&s_idle_cond, &cattr);
+    pthread_condattr_destroy(&cattr);
+
+    s_start_us = monotonic_us();
+}
+
+void host_critical_enter(void)
+{
+    pthread_mutex_lock(&s_critical);
+}
+
+void host_critical_exit(void)
+{
+    pthread_mutex_unlock(&s_critical);
+}
+
+void host_lock(void)
+{
+    pthread_mutex_lock(&s_lock);
+}
+
+void host_unlock(void)
+{
+    pthread_mutex_unlock(&s_lock);
+}
+
+void host_wake_all(void)
+{
+    for (host_thread_t *t = s_threads; t != NULL; t = t->next) {
+        if (t->waiting) {
+            t->woken = true;
+        }
+    }
+    pthread_cond_broadcast(&s_cond);
+}
+
+bool host_clock_is_virtual(void)
+{
+    return s_mode == HOST_CLOCK_VIRTUAL;
+}
+
+int64_t host_now_us(void)
+{
+    if (s_mode == HOST_CLOCK_VIRTUAL) {
+        return __atomic_load_n(&s_virtual_now, __ATOMIC_ACQUIRE);
+    }
+    return monotonic_us() - s_start_us + HOST_CLOCK_START_US;
+}
+
+void host_clock_set_mode(host_clock_mode_t mode)
+{
+    host_lock();
+    s_mode = mode;
+    s_virtual_now = HOST_CLOCK_START_US;
+    host_unlock();
+}
+
+int64_t host_clock_now_us(void)
+{
+    return host_now_us();
+}
+
+// ==== Luồng task ====
+
+host_thread_t *host_thread_register_locked(uint32_t priority, uint32_t number)
+{
+    host_thread_t *thread = calloc(1, sizeof(host_thread_t));
+    if (thread == NULL) {
+        return NULL;
+    }
+
+    // Task mới coi như vừa được đánh thức: chạy ở lượt kế tiếp
+    thread->priority = priority;
+    thread->number = number;
+    thread->deadline_us = HOST_WAIT_FOREVER;
+    thread->waiting = true;
+    thread->woken = true;
+    pthread_cond_init(&thread->turn, NULL);
+    thread->next = s_threads;
+    s_threads = thread;
+    return thread;
+}
+
+/**
+ * @brief Nhả lượt chạy để luồng điều khiển chọn task kế tiếp (giữ khóa)
+ */
+static void release_turn_locked(void)
+{
+    if (s_running == t_self) {
+        s_running = NULL;
+        pthread_cond_broadcast(&s_idle_cond);
+    }
+}
+
+/**
+ * @brief Chờ tới khi được giao lượt chạy (giữ khóa)
+ */
+static void wait_turn_locked(void)
+{
+    while (s_running != t_self) {
+        pthread_cond_wait(&t_self->turn, &s_lock);
+    }
+}
+
+void host_thread_start(host_thread_t *thread)
+{
+    t_self = thread;
+    if (s_mode == HOST_CLOCK_VIRTUAL) {
+        host_lock();
+        wait_turn_locked();
+        thread->waiting = false;
+        host_unlock();
+    }
+}
+
+void host_thread_exit_locked(host_thread_t *thread)
+{
+    for (host_thread_t **pp = &s_threads; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == thread) {
+            *pp = thread->next;
+            break;
+        }
+    }
+    if (s_running == thread) {
+        s_running = NULL;
+        pthread_cond_broadcast(&s_idle_cond);
+    }
+    if (t_self == thread) {
+        t_self = NULL;
+    }
+    pthread_cond_destroy(&thread->turn);
+    free(thread);
+}
+
+/**
+ * @brief Đồng hồ ảo: lần lượt cho các task được đánh thức chạy tới khi không còn task nào
+ */
+static void run_tasks_locked(void)
+{
+    while (1) {
+        while (s_running != NULL) {
+            pthread_cond_wait(&s_idle_cond, &s_lock);
+        }
+
+        host_thread_t *next = NULL;
+        for (host_thread_t *t = s_threads; t != NULL; t = t->next) {
+            bool due = t->woken || t->deadline_us <= s_virtual_now;
+            if (!t->waiting || !due) {
+                continue;
+            }
+            if (next == NULL || t->priority > next->priority ||
+                (t->priority == next->priority && t->number < next->number)) {
+                next = t;
+            }
+        }
+        if (next == NULL) {
+            return;
+        }
+
+        next->woken = false;
+        s_running = next;
+        pthread_cond_signal(&next->turn);
+    }
+}
+
+// ==== Hàng đợi công việc (giữ khóa) ====
+
+static void work_insert_locked(host_work_t *work)
+{
+    host_work_t **pp = &s_work_head;
+    while (*pp != NULL && (*pp)->when_us <= work->when_us) {
+        pp = &(*pp)->next;
+    }
+    work->next = *pp;
+    *pp = work;
+}
+
+static bool work_remove_locked(host_work_t *work)
+{
+    for (host_work_t **pp = &s_work_head; *pp != NULL; pp = &(*pp)->next) {
+        if (*pp == work) {
+            *pp = work->next;
+            work->next = NULL;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Lấy công việc đầu hàng và chạy nó với khóa đã nhả
+ */
+static void work_run_head_locked(void)
+{
+    host_work_t *work = s_work_head;
+    s_work_head = work->next;
+    work->next = NULL;
+    work->armed = false;
+
+    host_work_fn_t fn = work->fn;
+    void *arg = work->arg;
+    bool owned = work->owned;
+
+    host_unlock();
+    fn(arg);
+    if (owned) {
+        free(work);
+    }
+    host_lock();
+}
+
+/**
+ * @brief Đồng hồ ảo: thời điểm sớm nhất có việc xảy ra (công việc hoặc task hết hạn chờ)
+ */
+static int64_t next_event_locked(int64_t limit_us)
+{
+    int64_t next = limit_us;
+
+    if (s_work_head != NULL && s_work_head->when_us < next) {
+        next = s_work_head->when_us;
+    }
+    for (host_thread_t *t = s_threads; t != NULL; t = t->next) {
+        if (t->waiting && t->deadline_us > s_virtual_now && t->deadline_us < next) {
+            next = t->deadline_us;
+        }
+    }
+    return next;
+}
+
+/**
+ * @brief Đồng hồ ảo: tiến tới target theo từng sự kiện
+ *
+ * Ở mỗi thời điểm: cho các task chạy hết, rồi chạy công việc đến hạn, rồi
+ * mới tiến tới sự kiện kế tiếp, nên mọi lần chạy cho cùng một thứ tự.
+ */
+static void virtual_advance_locked(int64_t target_us)
+{
+    while (1) {
+        run_tasks_locked();
+        if (s_work_head != NULL && s_work_head->when_us <= s_virtual_now) {
+            work_run_head_locked();
+            continue;
+        }
+        if (s_virtual_now >= target_us) {
+            break;
+        }
+        __atomic_store_n(&s_virtual_now, next_event_locked(target_us), __ATOMIC_RELEASE);
+    }
+}
+
+static void timespec_from_us(struct timespec *ts, int64_t deadline_us)
+{
+    int64_t abs_us = s_start_us + deadline_us;
+    ts->tv_sec = abs_us / 1000000;
+    ts->tv_nsec = (abs_us % 1000000) * 1000;
+}
+
+static void *service_main(void *arg)
+{
+    (void)arg;
+    host_lock();
+    while (1) {
+        if (s_work_head == NULL) {
+            pthread_cond_wait(&s_cond, &s_lock);
+            continue;
+        }
+        if (host_now_us() < s_work_head->when_us) {
+            struct timespec ts;
+            timespec_from_us(&ts, s_work_head->when_us);
+            pthread_cond_timedwait(&s_cond, &s_lock, &ts);
+            continue;
+        }
+        work_run_head_locked();
+    }
+    return NULL;
+}
+
+static void service_start_locked(void)
+{
+    if (s_service_started || s_mode != HOST_CLOCK_REALTIME) {
+        return;
+    }
+
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (pthread_create(&thread, &attr, service_main, NULL) == 0) {
+        s_service_started = true;
+    }
+    pthread_attr_destroy(&attr);
+}
+
+void host_work_schedule(host_work_t *work, int64_t when_us)
+{
+    host_lock();
+    if (work->armed) {
+        work_remove_locked(work);
+    }
+    work->when_us = when_us;
+    work->seq = s_work_seq++;
+    work->armed = true;
+    work_insert_locked(work);
+    service_start_locked();
+    pthread_cond_broadcast(&s_cond);
+    host_unlock();
+}
+
+bool host_work_cancel(host_work_t *work)
+{
+    host_lock();
+    bool removed = work->armed && work_remove_locked(work);
+    work->armed = false;
+    host_unlock();
+    return removed;
+}
+
+int host_post(host_work_fn_t fn, void *arg, int64_t delay_us)
+{
+    host_work_t *work = calloc(1, sizeof(host_work_t));
+    if (work == NULL) {
+        return -1;
+    }
+
+    work->fn = fn;
+    work->arg = arg;
+    work->owned = true;
+    host_work_schedule(work, host_now_us() + (delay_us > 0 ? delay_us : 0));
+    return 0;
+}
+
+// ==== Chờ ====
+
+int64_t host_deadline_from_ticks(TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY) {
+        return HOST_WAIT_FOREVER;
+    }
+    return host_now_us() + (int64_t)ticks * (1000000 / configTICK_RATE_HZ);
+}
+
+int host_wait(int64_t deadline_us)
+{
+    if (host_now_us() >= deadline_us) {
+        return -1;
+    }
+
+    if (s_mode == HOST_CLOCK_VIRTUAL && t_self != NULL) {
+        // Nhả lượt chạy, chờ được đánh thức hoặc tới thời hạn
+        t_self->deadline_us = deadline_us;
+        t_self->waiting = true;
+        t_self->woken = false;
+        release_turn_locked();
+        wait_turn_locked();
+        t_self->waiting = false;
+        t_self->deadline_us = HOST_WAIT_FOREVER;
+        return 0;
+    }
+
+    if (s_mode == HOST_CLOCK_VIRTUAL) {
+        // Luồng điều khiển: cho thời gian tiến tới sự kiện kế tiếp hoặc thời hạn
+        run_tasks_locked();
+        int64_t step = next_event_locked(deadline_us);
+        if (step == HOST_WAIT_FOREVER) {
+            pthread_cond_wait(&s_cond, &s_lock);
+        } else {
+            virtual_advance_locked(step);
+        }
+        return 0;
+    }
+
+    if (deadline_us == HOST_WAIT_FOREVER) {
+        pthread_cond_wait(&s_cond, &s_lock);
+    } else {
+        struct timespec ts;
+        timespec_from_us(&ts, deadline_us);
+        pthread_cond_timedwait(&s_cond, &s_lock, &ts);
+    }
+    return 0;
+}
+
+void host_clock_advance_us(int64_t delta_us)
+{
+    if (delta_us < 0) {
+        return;
+    }
+
+    if (s_mode == HOST_CLOCK_VIRTUAL) {
+        host_lock();
+        virtual_advance_locked(s_virtual_now + delta_us);
+        host_unlock();
+        return;
+    }
+
+    struct timespec ts = {
+        .tv_sec = delta_us / 1000000,
+        .tv_nsec = (delta_us % 1000000) * 1000,
+    };
+    while (nanosleep(&ts, &ts) != 0) {
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef HOST_KERNEL_H
+#define HOST_KERNEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+
+/*
+ * Lõi dùng chung của các mock: đồng hồ, một khóa + condition variable cho mọi
+ * đối tượng chờ được, và hàng đợi công việc theo thời điểm (timer, sự kiện
+ * WiFi/MQTT). Chỉ dùng bên trong host/mocks.
+ */
+
+#define HOST_WAIT_FOREVER INT64_MAX
+
+typedef void (*host_work_fn_t)(void *arg);
+
+// Một công việc hẹn giờ; chủ sở hữu giữ bộ nhớ trừ khi tạo bằng host_post()
+typedef struct host_work {
+    host_work_fn_t fn;
+    void *arg;
+    int64_t when_us;
+    uint64_t seq;               // Cùng thời điểm: chạy theo thứ tự hẹn
+    bool armed;
+    bool owned;                 // Được giải phóng sau khi chạy
+    struct host_work *next;
+} host_work_t;
+
+void host_lock(void);
+void host_unlock(void);
+
+/**
+ * @brief Đánh thức mọi luồng đang chờ để kiểm tra lại điều kiện (giữ khóa)
+ */
+void host_wake_all(void);
+
+/**
+ * @brief Chờ tới khi được đánh thức hoặc tới thời hạn (giữ khóa)
+ *
+ * Người gọi kiểm tra lại điều kiện sau mỗi lần trả về 0. Đồng hồ ảo: luồng
+ * không phải task tự cho đồng hồ tiến tới công việc kế tiếp hoặc thời hạn.
+ *
+ * @param deadline_us Thời hạn (us) hoặc HOST_WAIT_FOREVER
+ * @return 0 nếu cần kiểm tra lại điều kiện, -1 nếu đã quá thời hạn
+ */
+int host_wait(int64_t deadline_us);
+
+/**
+ * @brief Thời hạn tuyệt đối từ số tick FreeRTOS (portMAX_DELAY: chờ mãi)
+ */
+int64_t host_deadline_from_ticks(TickType_t ticks);
+
+int64_t host_now_us(void);
+bool host_clock_is_virtual(void);
+
+/*
+ * Luồng của task FreeRTOS. Với đồng hồ ảo chỉ một task chạy tại một thời
+ * điểm: task giữ lượt tới khi chờ trong host_wait() hoặc kết thúc, lượt kế
+ * tiếp dành cho task được đánh thức có ưu tiên cao nhất (cùng ưu tiên: task
+ * tạo trước). Thời gian chỉ tiến khi không task nào chạy được.
+ */
+typedef struct host_thread host_thread_t;
+
+/**
+ * @brief Đăng ký task mới (giữ khóa, gọi trước khi tạo pthread)
+ */
+host_thread_t *host_thread_register_locked(uint32_t priority, uint32_t number);
+
+/**
+ * @brief Gọi đầu tiên trong pthread của task: chờ tới lượt chạy
+ */
+void host_thread_start(host_thread_t *thread);
+
+/**
+ * @brief Gọi khi task kết thúc (giữ khóa): hủy đăng ký và nhả lượt chạy
+ */
+void host_thread_exit_locked(host_thread_t *thread);
+
+// Các hàm sau tự lấy khóa
+void host_work_schedule(host_work_t *work, int64_t when_us);
+bool host_work_cancel(host_work_t *work);
+
+/**
+ * @brief Chạy fn(arg) sau delay_us trên luồng dịch vụ (hoặc khi đồng hồ ảo tới)
+ * @return 0 nếu thành công, -1 nếu hết bộ nhớ
+ */
+int host_post(host_work_fn_t fn, void *arg, int64_t delay_us);
+
+// Liên kết giữa các mock
+int host_task_core_id(void);
+void host_set_core_override(int core);
+bool host_wifi_is_up(void);
+void host_mqtt_on_network_down(void);
+void host_tick_hooks_start(void);
+void host_adc_set_seed(uint32_t seed);
+
+#endif // HOST_KERNEL_H
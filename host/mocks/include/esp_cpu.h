@@ -0,0 +1,18 @@
+#ifndef HOST_ESP_CPU_H
+#define HOST_ESP_CPU_H
+
+#include <stdint.h>
+
+typedef uint32_t esp_cpu_cycle_count_t;
+
+/**
+ * @brief Bộ đếm chu kỳ giả lập: đồng hồ host nhân CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+ */
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count(void);
+
+/**
+ * @brief Core của task hiện tại (task không ghim: theo số thứ tự task)
+ */
+int esp_cpu_get_core_id(void);
+
+#endif // HOST_ESP_CPU_H
@@ -0,0 +1,12 @@
+#ifndef HOST_ESP_FREERTOS_HOOKS_H
+#define HOST_ESP_FREERTOS_HOOKS_H
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+typedef void (*esp_freertos_tick_cb_t)(void);
+
+esp_err_t esp_register_freertos_tick_hook_for_cpu(esp_freertos_tick_cb_t new_tick_cb, UBaseType_t cpuid);
+void esp_deregister_freertos_tick_hook_for_cpu(esp_freertos_tick_cb_t old_tick_cb, UBaseType_t cpuid);
+
+#endif // HOST_ESP_FREERTOS_HOOKS_H
@@ -0,0 +1,87 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <sched.h>
+#include "sdkconfig.h"
+#include "esp_err.h"
+
+/*
+ * API FreeRTOS (bản ESP-IDF SMP) trên POSIX threads cho bản build host.
+ *
+ * Mỗi task là một pthread, queue/semaphore/event group/notification được
+ * dựng trên một mutex + condition variable chung. Thời gian chờ tính theo
+ * đồng hồ host (thật hoặc ảo, xem host_hal.h), không có lập lịch theo ưu tiên.
+ */
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t StackType_t;
+
+#define pdTRUE ((BaseType_t)1)
+#define pdFALSE ((BaseType_t)0)
+#define pdPASS pdTRUE
+#define pdFAIL pdFALSE
+#define errQUEUE_FULL ((BaseType_t)0)
+#define errQUEUE_EMPTY ((BaseType_t)0)
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ CONFIG_FREERTOS_HZ
+#define portTICK_PERIOD_MS ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(xTimeInMs) ((TickType_t)(((uint64_t)(xTimeInMs) * configTICK_RATE_HZ) / 1000U))
+#define pdTICKS_TO_MS(xTicks) ((TickType_t)(((uint64_t)(xTicks) * 1000U) / configTICK_RATE_HZ))
+
+#define configMAX_PRIORITIES 25
+#define configMAX_TASK_NAME_LEN CONFIG_FREERTOS_MAX_TASK_NAME_LEN
+#define configNUMBER_OF_CORES CONFIG_FREERTOS_NUMBER_OF_CORES
+#define portNUM_PROCESSORS configNUMBER_OF_CORES
+#define tskNO_AFFINITY ((BaseType_t)0x7FFFFFFF)
+
+#define configASSERT(x) assert(x)
+
+#define BIT0 0x00000001
+#define BIT1 0x00000002
+#define BIT2 0x00000004
+#define BIT3 0x00000008
+#define BIT4 0x00000010
+#define BIT5 0x00000020
+#define BIT6 0x00000040
+#define BIT7 0x00000080
+#define BIT8 0x00000100
+#define BIT9 0x00000200
+#define BIT10 0x00000400
+#define BIT11 0x00000800
+
+// Critical section: một khóa đệ quy chung cho mọi spinlock (không có ngắt trên host)
+typedef struct {
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED { 0, 0 }
+
+void host_critical_enter(void);
+void host_critical_exit(void);
+
+#define portENTER_CRITICAL(mux) do { (void)(mux); host_critical_enter(); } while (0)
+#define portEXIT_CRITICAL(mux) do { (void)(mux); host_critical_exit(); } while (0)
+#define portENTER_CRITICAL_ISR(mux) portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux) portEXIT_CRITICAL(mux)
+#define portENTER_CRITICAL_SAFE(mux) portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_SAFE(mux) portEXIT_CRITICAL(mux)
+#define taskENTER_CRITICAL(mux) portENTER_CRITICAL(mux)
+#define taskEXIT_CRITICAL(mux) portEXIT_CRITICAL(mux)
+
+// "Che ngắt" trên host là vào critical section chung
+#define portSET_INTERRUPT_MASK_FROM_ISR() (host_critical_enter(), (UBaseType_t)0)
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(state) do { (void)(state); host_critical_exit(); } while (0)
+
+#define portYIELD_FROM_ISR(x) do { (void)(x); } while (0)
+#define portYIELD() sched_yield()
+#define taskYIELD() portYIELD()
+
+#endif // HOST_FREERTOS_H
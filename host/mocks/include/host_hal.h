@@ -0,0 +1,187 @@
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Điều khiển phần cứng giả lập của bản build host: đồng hồ, đầu vào cảm
+ * biến, đầu ra còi, WiFi và broker MQTT loopback.
+ *
+ * Đồng hồ có hai chế độ:
+ *   - HOST_CLOCK_REALTIME (mặc định): theo CLOCK_MONOTONIC, timer/sự kiện
+ *     chạy trên một luồng dịch vụ riêng; dùng khi chạy cả firmware.
+ *   - HOST_CLOCK_VIRTUAL: thời gian chỉ tiến khi gọi host_clock_advance_us()
+ *     hoặc khi luồng không phải task (luồng điều khiển test) gọi một hàm chờ
+ *     có thời hạn (vTaskDelay, xQueueReceive...). Timer, tick hook và sự kiện
+ *     WiFi/MQTT đến hạn được chạy ngay trong luồng gọi, theo đúng thứ tự thời
+ *     gian, nên kết quả lặp lại được giữa các lần chạy.
+ * Cả hai chế độ bắt đầu từ 50 ms như lúc app_main chạy trên ESP32.
+ * Chọn chế độ trước khi tạo task hay timer nào.
+ */
+
+typedef enum {
+    HOST_CLOCK_REALTIME = 0,
+    HOST_CLOCK_VIRTUAL,
+} host_clock_mode_t;
+
+/**
+ * @brief Chọn chế độ đồng hồ (gọi trước mọi API khác)
+ */
+void host_clock_set_mode(host_clock_mode_t mode);
+
+/**
+ * @brief Thời gian hiện tại (us, bằng esp_timer_get_time())
+ */
+int64_t host_clock_now_us(void);
+
+/**
+ * @brief Cho đồng hồ ảo tiến thêm, chạy các timer/sự kiện đến hạn theo thứ tự
+ *
+ * Ở chế độ REALTIME hàm chỉ ngủ trong khoảng thời gian đó.
+ *
+ * @param delta_us Khoảng thời gian (us)
+ */
+void host_clock_advance_us(int64_t delta_us);
+
+// ==== Cảm biến ====
+
+/**
+ * @brief Đặt giá trị raw (0-4095) mà ADC giả lập trả về cho một kênh
+ */
+void host_adc_set_raw(uint8_t channel, uint16_t raw);
+
+/**
+ * @brief Thêm nhiễu đều trong [-amplitude, +amplitude] vào mẫu của một kênh
+ *
+ * Nhiễu lấy từ bộ sinh số giả ngẫu nhiên có seed cố định (host_random_seed()).
+ */
+void host_adc_set_noise(uint8_t channel, uint16_t amplitude);
+
+/**
+ * @brief Số frame ADC đã được đọc và số frame bị bỏ do ring buffer đầy
+ */
+void host_adc_get_counts(uint32_t *frames_read, uint32_t *frames_dropped);
+
+/**
+ * @brief Đặt mức logic của một chân GPIO đầu vào (mặc định 1: kéo lên)
+ */
+void host_gpio_set_level(int gpio_num, int level);
+
+/**
+ * @brief Duty hiện tại của một kênh LEDC (0 nếu còi tắt)
+ */
+uint32_t host_ledc_get_duty(int channel);
+
+/**
+ * @brief Tần số hiện tại của một timer LEDC (Hz)
+ */
+uint32_t host_ledc_get_freq(int timer);
+
+// ==== Mạng ====
+
+/**
+ * @brief Bật/tắt AP giả; tắt khi đang kết nối sẽ gây STA_DISCONNECTED
+ */
+void host_wifi_set_ap_available(bool available);
+
+/**
+ * @brief Thời gian từ esp_wifi_connect() tới khi có IP (ms)
+ * @param fast_ms Khi đã có BSSID/kênh (kết nối nhanh + DHCP)
+ * @param full_ms Khi phải quét toàn bộ kênh + DHCP
+ */
+void host_wifi_set_connect_delay_ms(uint32_t fast_ms, uint32_t full_ms);
+
+/**
+ * @brief IP mà DHCP server giả cấp từ lần kết nối tới (ví dụ lease cũ đã hết hạn)
+ */
+void host_wifi_set_dhcp_ip(uint32_t ip);
+
+/**
+ * @brief Bật/tắt broker giả; tắt khi đang kết nối sẽ gây MQTT_EVENT_DISCONNECTED
+ */
+void host_mqtt_set_broker_available(bool available);
+
+/**
+ * @brief Thời gian bắt tay tới broker và thời gian broker xác nhận QoS > 0 (ms)
+ */
+void host_mqtt_set_delays_ms(uint32_t connect_ms, uint32_t ack_ms);
+
+/**
+ * @brief Giới hạn buffer nhận của client khi chia fragment (giả lập buffer nhỏ hơn
+ *        buffer.size của firmware), 0 = dùng buffer.size
+ */
+void host_mqtt_set_fragment_size(int bytes);
+
+/**
+ * @brief Callback cho mỗi message firmware publish thành công
+ *
+ * Gọi trong luồng của người publish, không được chặn.
+ */
+typedef void (*host_mqtt_publish_cb_t)(const char *topic, const uint8_t *data, int len,
+                                       int qos, bool retain, void *ctx);
+
+void host_mqtt_set_publish_hook(host_mqtt_publish_cb_t cb, void *ctx);
+
+/**
+ * @brief Gửi một message từ "broker" tới client (ví dụ lệnh trên fire_system/control)
+ * @return 0 nếu client đang kết nối và đã subscribe topic, -1 nếu không
+ */
+int host_mqtt_inject(const char *topic, const char *data, int len);
+
+typedef struct {
+    uint32_t connects;          // Số lần kết nối tới broker thành công
+    uint32_t published;         // Số message firmware đã publish
+    uint32_t acked;             // Số message QoS > 0 đã được xác nhận
+    uint32_t delivered;         // Số message broker gửi tới client
+    int last_msg_id;            // Message ID của lần publish QoS > 0 gần nhất
+} host_mqtt_stats_t;
+
+void host_mqtt_get_stats(host_mqtt_stats_t *stats);
+
+// ==== Khác ====
+
+/**
+ * @brief Seed cho esp_random() và nhiễu ADC (mặc định cố định)
+ */
+void host_random_seed(uint32_t seed);
+
+/**
+ * @brief Mức log tối đa được in (mặc định ESP_LOG_INFO)
+ */
+void host_log_set_level(int level);
+
+/**
+ * @brief Xóa toàn bộ NVS và các phân vùng flash giả (cũng khôi phục nguồn)
+ */
+void host_nvs_reset(void);
+
+// ==== Flash ====
+
+/**
+ * @brief Mất điện sau khi phân vùng flash giả được ghi/xóa thêm n byte
+ *
+ * Thao tác đang chạy chỉ ghi/xóa phần nằm trong n byte (từ đầu vùng) rồi trả
+ * về ESP_FAIL, mọi thao tác ghi/xóa sau đó cũng lỗi cho tới khi
+ * host_flash_power_restore(). Đọc vẫn được, để kiểm tra trạng thái flash
+ * như lúc khởi động lại.
+ */
+void host_flash_power_loss_after(uint32_t bytes);
+
+/**
+ * @brief Bỏ giới hạn của host_flash_power_loss_after()
+ */
+void host_flash_power_restore(void);
+
+/**
+ * @brief Tổng số byte đã ghi/xóa trên các phân vùng flash giả
+ */
+uint32_t host_flash_programmed_bytes(void);
+
+/**
+ * @brief Đảo các bit xor_mask của một byte trong phân vùng (lỗi dữ liệu flash)
+ * @return 0 nếu thành công, -1 nếu không có phân vùng hoặc offset ngoài phạm vi
+ */
+int host_flash_corrupt(const char *label, uint32_t offset, uint8_t xor_mask);
+
+#endif // HOST_HAL_H
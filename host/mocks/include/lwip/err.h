@@ -0,0 +1,4 @@
+#ifndef HOST_LWIP_ERR_H
+#define HOST_LWIP_ERR_H
+
+#endif // HOST_LWIP_ERR_H
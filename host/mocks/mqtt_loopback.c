@@ -0,0 +1,502 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mqtt_client.h"
+#include "host_hal.h"
+#include "host_kernel.h"
+
+/*
+ * Client MQTT loopback. Một client duy nhất; sự kiện được post qua
+ * host_post() nên chạy tuần tự trên luồng dịch vụ như task của esp-mqtt.
+ * Số thế hệ tăng mỗi khi mất kết nối/stop để bỏ các xác nhận còn treo.
+ */
+
+#define HOST_MQTT_MAX_SUBS 8
+#define HOST_MQTT_TOPIC_LEN 128
+#define HOST_MQTT_DEFAULT_BUFFER 1024
+#define HOST_MQTT_PUBLISH_HEADER_LEN 9   // Header cố định (tối đa 5) + độ dài topic (2) + packet id (2)
+
+typedef struct {
+    char topic[HOST_MQTT_TOPIC_LEN];
+    int qos;
+} host_mqtt_sub_t;
+
+struct esp_mqtt_client {
+    esp_event_handler_t handler;
+    void *handler_arg;
+    int buffer_size;
+    bool started;
+    bool connected;
+    uint32_t gen;
+    int next_msg_id;
+    host_mqtt_sub_t subs[HOST_MQTT_MAX_SUBS];
+    int num_subs;
+};
+
+typedef struct {
+    esp_mqtt_client_handle_t client;
+    uint32_t gen;
+    esp_mqtt_event_t event;
+    char *topic;
+    char *data;
+} host_mqtt_post_t;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct esp_mqtt_client *s_client = NULL;
+static bool s_broker_available = true;
+static uint32_t s_connect_delay_ms = 50;
+static uint32_t s_ack_delay_ms = 20;
+static host_mqtt_publish_cb_t s_publish_hook = NULL;
+static void *s_publish_ctx = NULL;
+static host_mqtt_stats_t s_stats;
+static int s_fragment_size = 0;
+
+// ==== Sự kiện ====
+
+static void event_dispatch(void *arg)
+{
+    host_mqtt_post_t *post = arg;
+    esp_mqtt_client_handle_t client = post->client;
+
+    pthread_mutex_lock(&s_lock);
+    // Sự kiện của phiên đã kết thúc (trừ chính DISCONNECTED/ERROR) bị bỏ
+    bool stale = post->gen != client->gen &&
+                 post->event.event_id != MQTT_EVENT_DISCONNECTED &&
+                 post->event.event_id != MQTT_EVENT_ERROR;
+    if (!stale && post->event.event_id == MQTT_EVENT_PUBLISHED) {
+        s_stats.acked++;
+    }
+    esp_event_handler_t handler = client->handler;
+    void *handler_arg = client->handler_arg;
+    pthread_mutex_unlock(&s_lock);
+
+    if (!stale && handler != NULL) {
+        handler(handler_arg, "MQTT_EVENTS", post->event.event_id, &post->event);
+    }
+    free(post->topic);
+    free(post->data);
+    free(post);
+}
+
+/**
+ * @brief Post một sự kiện (giữ s_lock); topic/data được sao chép
+ */
+static void post_event_locked(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t id, int msg_id,
+                              const char *topic, int topic_len, const char *data, int data_len,
+                              int total_len, int offset, int64_t delay_us)
+{
+    host_mqtt_post_t *post = calloc(1, sizeof(host_mqtt_post_t));
+    if (post == NULL) {
+        return;
+    }
+    post->client = client;
+    post->gen = client->gen;
+
+    if (topic_len > 0) {
+        post->topic = malloc(topic_len);
+        if (post->topic != NULL) {
+            memcpy(post->topic, topic, topic_len);
+        }
+    }
+    if (data_len > 0) {
+        post->data = malloc(data_len);
+        if (post->data != NULL) {
+            memcpy(post->data, data, data_len);
+        }
+    }
+
+    esp_mqtt_event_t *event = &post->event;
+    event->event_id = id;
+    event->client = client;
+    event->msg_id = msg_id;
+    event->topic = post->topic;
+    event->topic_len = (post->topic != NULL) ? topic_len : 0;
+    event->data = post->data;
+    event->data_len = (post->data != NULL) ? data_len : 0;
+    event->total_data_len = total_len;
+    event->current_data_offset = offset;
+    event->qos = 1;
+
+    if (host_post(event_dispatch, post, delay_us) != 0) {
+        free(post->topic);
+        free(post->data);
+        free(post);
+    }
+}
+
+static void post_simple_locked(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t id,
+                               int msg_id, int64_t delay_us)
+{
+    post_event_locked(client, id, msg_id, NULL, 0, NULL, 0, 0, 0, delay_us);
+}
+
+/**
+ * @brief Gửi một message tới client, chia fragment theo buffer như esp-mqtt (giữ s_lock)
+ */
+static void deliver_locked(esp_mqtt_client_handle_t client, const char *topic, const char *data, int len)
+{
+    int topic_len = (int)strlen(topic);
+    int offset = 0;
+
+    s_stats.delivered++;
+    do {
+        // Fragment đầu dùng chung buffer với header và topic của gói PUBLISH
+        int room = client->buffer_size;
+        if (s_fragment_size > 0 && s_fragment_size < room) {
+            room = s_fragment_size;
+        }
+        if (offset == 0) {
+            room -= HOST_MQTT_PUBLISH_HEADER_LEN + topic_len;
+            if (room < 1) {
+                room = 1;
+            }
+        }
+        int chunk = len - offset;
+        if (chunk > room) {
+            chunk = room;
+        }
+        // Chỉ fragment đầu mang topic
+        post_event_locked(client, MQTT_EVENT_DATA, 0, offset == 0 ? topic : NULL, offset == 0 ? topic_len : 0,
+                          data + offset, chunk, len, offset, 0);
+        offset += chunk;
+    } while (offset < len);
+}
+
+static bool topic_matches(const char *filter, const char *topic)
+{
+    while (*filter != '\0') {
+        if (*filter == '#') {
+            return true;
+        }
+        if (*filter == '+') {
+            while (*topic != '\0' && *topic != '/') {
+                topic++;
+            }
+            filter++;
+            continue;
+        }
+        if (*filter != *topic) {
+            return false;
+        }
+        filter++;
+        topic++;
+    }
+    return *topic == '\0';
+}
+
+static bool subscribed_locked(esp_mqtt_client_handle_t client, const char *topic)
+{
+    for (int i = 0; i < client->num_subs; i++) {
+        if (topic_matches(client->subs[i].topic, topic)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Mất kết nối tới broker (giữ s_lock)
+ */
+static void connection_lost_locked(esp_mqtt_client_handle_t client)
+{
+    if (!client->connected) {
+        return;
+    }
+    client->connected = false;
+    client->gen++;
+    client->num_subs = 0;
+    post_simple_locked(client, MQTT_EVENT_DISCONNECTED, 0, 0);
+}
+
+static void connect_attempt(void *arg)
+{
+    host_mqtt_post_t *attempt = arg;
+    esp_mqtt_client_handle_t client = attempt->client;
+
+    bool network_up = host_wifi_is_up();
+
+    pthread_mutex_lock(&s_lock);
+    if (attempt->gen == client->gen && client->started && !client->connected) {
+        if (network_up && s_broker_available) {
+            client->connected = true;
+            s_stats.connects++;
+            post_simple_locked(client, MQTT_EVENT_CONNECTED, 0, 0);
+        } else {
+            // Không tự kết nối lại (disable_auto_reconnect): báo lỗi rồi ngắt
+            post_simple_locked(client, MQTT_EVENT_ERROR, 0, 0);
+            post_simple_locked(client, MQTT_EVENT_DISCONNECTED, 0, 0);
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    free(attempt);
+}
+
+// ==== Điều khiển từ host ====
+
+void host_mqtt_set_broker_available(bool available)
+{
+    pthread_mutex_lock(&s_lock);
+    s_broker_available = available;
+    if (!available && s_client != NULL) {
+        connection_lost_locked(s_client);
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+void host_mqtt_on_network_down(void)
+{
+    pthread_mutex_lock(&s_lock);
+    if (s_client != NULL) {
+        connection_lost_locked(s_client);
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+void host_mqtt_set_delays_ms(uint32_t connect_ms, uint32_t ack_ms)
+{
+    pthread_mutex_lock(&s_lock);
+    s_connect_delay_ms = connect_ms;
+    s_ack_delay_ms = ack_ms;
+    pthread_mutex_unlock(&s_lock);
+}
+
+void host_mqtt_set_fragment_size(int bytes)
+{
+    pthread_mutex_lock(&s_lock);
+    s_fragment_size = bytes;
+    pthread_mutex_unlock(&s_lock);
+}
+
+void host_mqtt_set_publish_hook(host_mqtt_publish_cb_t cb, void *ctx)
+{
+    pthread_mutex_lock(&s_lock);
+    s_publish_hook = cb;
+    s_publish_ctx = ctx;
+    pthread_mutex_unlock(&s_lock);
+}
+
+int host_mqtt_inject(const char *topic, const char *data, int len)
+{
+    if (topic == NULL || data == NULL || len < 0) {
+        return -1;
+    }
+
+    int ret = -1;
+    pthread_mutex_lock(&s_lock);
+    if (s_client != NULL && s_client->connected && subscribed_locked(s_client, topic)) {
+        deliver_locked(s_client, topic, data, len);
+        ret = 0;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ret;
+}
+
+void host_mqtt_get_stats(host_mqtt_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    *stats = s_stats;
+    pthread_mutex_unlock(&s_lock);
+}
+
+// ==== API esp-mqtt ====
+
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t *config)
+{
+    if (config == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    if (s_client != NULL) {
+        pthread_mutex_unlock(&s_lock);
+        return NULL;
+    }
+    s_client = calloc(1, sizeof(struct esp_mqtt_client));
+    if (s_client != NULL) {
+        s_client->buffer_size = (config->buffer.size > 0) ? config->buffer.size : HOST_MQTT_DEFAULT_BUFFER;
+        s_client->next_msg_id = 1;
+    }
+    esp_mqtt_client_handle_t client = s_client;
+    pthread_mutex_unlock(&s_lock);
+    return client;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t event_handler, void *event_handler_arg)
+{
+    if (client == NULL || event_handler == NULL || event != MQTT_EVENT_ANY) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    client->handler = event_handler;
+    client->handler_arg = event_handler_arg;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client)
+{
+    if (client == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    host_mqtt_post_t *attempt = calloc(1, sizeof(host_mqtt_post_t));
+    if (attempt == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    if (client->started) {
+        pthread_mutex_unlock(&s_lock);
+        free(attempt);
+        return ESP_FAIL;
+    }
+    client->started = true;
+    client->gen++;
+    attempt->client = client;
+    attempt->gen = client->gen;
+    int64_t delay_us = (int64_t)s_connect_delay_ms * 1000;
+    pthread_mutex_unlock(&s_lock);
+
+    if (host_post(connect_attempt, attempt, delay_us) != 0) {
+        free(attempt);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t client)
+{
+    if (client == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    if (!client->started) {
+        pthread_mutex_unlock(&s_lock);
+        return ESP_FAIL;
+    }
+    // Như esp-mqtt: stop không sinh MQTT_EVENT_DISCONNECTED
+    client->started = false;
+    client->connected = false;
+    client->num_subs = 0;
+    client->gen++;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client)
+{
+    if (client == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_mqtt_client_stop(client);
+    pthread_mutex_lock(&s_lock);
+    // Sự kiện còn treo giữ con trỏ client: chỉ tách khỏi loopback, không giải phóng
+    client->handler = NULL;
+    s_client = NULL;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+static int next_msg_id_locked(esp_mqtt_client_handle_t client)
+{
+    int id = client->next_msg_id;
+    client->next_msg_id = (id >= 0xFFFF) ? 1 : id + 1;
+    return id;
+}
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client, const char *topic, int qos)
+{
+    if (client == NULL || topic == NULL || strlen(topic) >= HOST_MQTT_TOPIC_LEN) {
+        return -1;
+    }
+
+    int msg_id = -1;
+    pthread_mutex_lock(&s_lock);
+    if (client->connected) {
+        int slot = -1;
+        for (int i = 0; i < client->num_subs; i++) {
+            if (strcmp(client->subs[i].topic, topic) == 0) {
+                slot = i;
+            }
+        }
+        if (slot < 0 && client->num_subs < HOST_MQTT_MAX_SUBS) {
+            slot = client->num_subs++;
+            strcpy(client->subs[slot].topic, topic);
+        }
+        if (slot >= 0) {
+            client->subs[slot].qos = qos;
+            msg_id = next_msg_id_locked(client);
+            post_simple_locked(client, MQTT_EVENT_SUBSCRIBED, msg_id, (int64_t)s_ack_delay_ms * 1000);
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return msg_id;
+}
+
+int esp_mqtt_client_unsubscribe(esp_mqtt_client_handle_t client, const char *topic)
+{
+    if (client == NULL || topic == NULL) {
+        return -1;
+    }
+
+    int msg_id = -1;
+    pthread_mutex_lock(&s_lock);
+    if (client->connected) {
+        for (int i = 0; i < client->num_subs; i++) {
+            if (strcmp(client->subs[i].topic, topic) == 0) {
+                client->subs[i] = client->subs[--client->num_subs];
+                break;
+            }
+        }
+        msg_id = next_msg_id_locked(client);
+        post_simple_locked(client, MQTT_EVENT_UNSUBSCRIBED, msg_id, (int64_t)s_ack_delay_ms * 1000);
+    }
+    pthread_mutex_unlock(&s_lock);
+    return msg_id;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char *topic, const char *data,
+                            int len, int qos, int retain)
+{
+    if (client == NULL || topic == NULL) {
+        return -1;
+    }
+    if (data == NULL) {
+        len = 0;
+    } else if (len <= 0) {
+        len = (int)strlen(data);
+    }
+
+    pthread_mutex_lock(&s_lock);
+    if (!client->connected) {
+        pthread_mutex_unlock(&s_lock);
+        return -1;
+    }
+
+    int msg_id = 0;
+    if (qos > 0) {
+        msg_id = next_msg_id_locked(client);
+        s_stats.last_msg_id = msg_id;
+        post_simple_locked(client, MQTT_EVENT_PUBLISHED, msg_id, (int64_t)s_ack_delay_ms * 1000);
+    }
+    s_stats.published++;
+    if (subscribed_locked(client, topic)) {
+        deliver_locked(client, topic, data, len);
+    }
+    host_mqtt_publish_cb_t hook = s_publish_hook;
+    void *ctx = s_publish_ctx;
+    pthread_mutex_unlock(&s_lock);
+
+    if (hook != NULL) {
+        hook(topic, (const uint8_t *)data, len, qos, retain != 0, ctx);
+    }
+    return msg_id;
+}
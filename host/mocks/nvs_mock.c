@@ -0,0 +1,375 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "esp_partition.h"
+#include "host_hal.h"
+
+/*
+ * NVS và các phân vùng data của partitions.csv, giữ trong RAM. Phân vùng có
+ * thể giả lập mất điện giữa lúc ghi/xóa và lỗi bit (host_flash_*).
+ */
+
+#define HOST_NVS_MAX_ENTRIES 32
+#define HOST_NVS_MAX_HANDLES 8
+#define HOST_NVS_NAME_LEN 16            // Như NVS: tối đa 15 ký tự
+#define HOST_FLASH_SECTOR_SIZE 4096
+
+typedef struct {
+    char ns[HOST_NVS_NAME_LEN];
+    char key[HOST_NVS_NAME_LEN];
+    uint8_t *data;
+    size_t len;
+} host_nvs_entry_t;
+
+typedef struct {
+    bool used;
+    char ns[HOST_NVS_NAME_LEN];
+    nvs_open_mode_t mode;
+} host_nvs_handle_t;
+
+typedef struct {
+    esp_partition_t part;
+    uint8_t *flash;
+} host_partition_t;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool s_nvs_initialized = false;
+static host_nvs_entry_t s_entries[HOST_NVS_MAX_ENTRIES];
+static host_nvs_handle_t s_handles[HOST_NVS_MAX_HANDLES];   // Handle = chỉ số + 1
+
+// Theo partitions.csv
+static host_partition_t s_partitions[] = {
+    { .part = { ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)0x40, 0x110000, 64 * 1024,
+                HOST_FLASH_SECTOR_SIZE, "saf_alert", false } },
+    { .part = { ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)0x41, 0x120000, 256 * 1024,
+                HOST_FLASH_SECTOR_SIZE, "saf_data", false } },
+};
+
+#define HOST_PARTITION_COUNT (sizeof(s_partitions) / sizeof(s_partitions[0]))
+
+// Mất điện giả lập: số byte còn được ghi/xóa, UINT32_MAX nếu không giới hạn
+static uint32_t s_power_budget = UINT32_MAX;
+static uint32_t s_programmed_bytes;
+
+static void nvs_clear_locked(void)
+{
+    for (int i = 0; i < HOST_NVS_MAX_ENTRIES; i++) {
+        free(s_entries[i].data);
+    }
+    memset(s_entries, 0, sizeof(s_entries));
+}
+
+void host_nvs_reset(void)
+{
+    pthread_mutex_lock(&s_lock);
+    nvs_clear_locked();
+    s_power_budget = UINT32_MAX;
+    for (size_t i = 0; i < HOST_PARTITION_COUNT; i++) {
+        if (s_partitions[i].flash != NULL) {
+            memset(s_partitions[i].flash, 0xFF, s_partitions[i].part.size);
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+esp_err_t nvs_flash_init(void)
+{
+    pthread_mutex_lock(&s_lock);
+    s_nvs_initialized = true;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    pthread_mutex_lock(&s_lock);
+    nvs_clear_locked();
+    s_nvs_initialized = false;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+static host_nvs_handle_t *handle_get_locked(nvs_handle_t handle)
+{
+    if (handle == 0 || handle > HOST_NVS_MAX_HANDLES || !s_handles[handle - 1].used) {
+        return NULL;
+    }
+    return &s_handles[handle - 1];
+}
+
+static host_nvs_entry_t *entry_find_locked(const char *ns, const char *key)
+{
+    for (int i = 0; i < HOST_NVS_MAX_ENTRIES; i++) {
+        host_nvs_entry_t *e = &s_entries[i];
+        if (e->data != NULL && strcmp(e->ns, ns) == 0 && (key == NULL || strcmp(e->key, key) == 0)) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+esp_err_t nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    if (namespace_name == NULL || out_handle == NULL || strlen(namespace_name) >= HOST_NVS_NAME_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    pthread_mutex_lock(&s_lock);
+    if (!s_nvs_initialized) {
+        ret = ESP_ERR_NVS_NOT_INITIALIZED;
+    } else if (open_mode == NVS_READONLY && entry_find_locked(namespace_name, NULL) == NULL) {
+        // Namespace chưa từng được ghi
+        ret = ESP_ERR_NVS_NOT_FOUND;
+    } else {
+        for (int i = 0; i < HOST_NVS_MAX_HANDLES; i++) {
+            if (!s_handles[i].used) {
+                s_handles[i].used = true;
+                s_handles[i].mode = open_mode;
+                strcpy(s_handles[i].ns, namespace_name);
+                *out_handle = (nvs_handle_t)(i + 1);
+                ret = ESP_OK;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ret;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    if (key == NULL || length == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_OK;
+    pthread_mutex_lock(&s_lock);
+    host_nvs_handle_t *h = handle_get_locked(handle);
+    host_nvs_entry_t *e = (h != NULL) ? entry_find_locked(h->ns, key) : NULL;
+    if (h == NULL) {
+        ret = ESP_ERR_INVALID_ARG;
+    } else if (e == NULL) {
+        ret = ESP_ERR_NVS_NOT_FOUND;
+    } else if (out_value == NULL) {
+        *length = e->len;
+    } else if (*length < e->len) {
+        ret = ESP_ERR_NVS_INVALID_LENGTH;
+    } else {
+        memcpy(out_value, e->data, e->len);
+        *length = e->len;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ret;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    if (key == NULL || value == NULL || strlen(key) >= HOST_NVS_NAME_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t *copy = malloc(length > 0 ? length : 1);
+    if (copy == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(copy, value, length);
+
+    esp_err_t ret = ESP_OK;
+    pthread_mutex_lock(&s_lock);
+    host_nvs_handle_t *h = handle_get_locked(handle);
+    if (h == NULL || h->mode != NVS_READWRITE) {
+        ret = ESP_ERR_INVALID_ARG;
+    } else {
+        host_nvs_entry_t *e = entry_find_locked(h->ns, key);
+        for (int i = 0; e == NULL && i < HOST_NVS_MAX_ENTRIES; i++) {
+            if (s_entries[i].data == NULL) {
+                e = &s_entries[i];
+                strcpy(e->ns, h->ns);
+                strcpy(e->key, key);
+            }
+        }
+        if (e == NULL) {
+            ret = ESP_ERR_NVS_NO_FREE_PAGES;
+        } else {
+            free(e->data);
+            e->data = copy;
+            e->len = length;
+            copy = NULL;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+
+    free(copy);
+    return ret;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    if (key == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_OK;
+    pthread_mutex_lock(&s_lock);
+    host_nvs_handle_t *h = handle_get_locked(handle);
+    host_nvs_entry_t *e = (h != NULL) ? entry_find_locked(h->ns, key) : NULL;
+    if (h == NULL || h->mode != NVS_READWRITE) {
+        ret = ESP_ERR_INVALID_ARG;
+    } else if (e == NULL) {
+        ret = ESP_ERR_NVS_NOT_FOUND;
+    } else {
+        free(e->data);
+        memset(e, 0, sizeof(host_nvs_entry_t));
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ret;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    pthread_mutex_lock(&s_lock);
+    esp_err_t ret = (handle_get_locked(handle) != NULL) ? ESP_OK : ESP_ERR_INVALID_ARG;
+    pthread_mutex_unlock(&s_lock);
+    return ret;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    pthread_mutex_lock(&s_lock);
+    host_nvs_handle_t *h = handle_get_locked(handle);
+    if (h != NULL) {
+        h->used = false;
+    }
+    pthread_mutex_unlock(&s_lock);
+}
+
+// ==== Phân vùng ====
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char *label)
+{
+    for (size_t i = 0; i < HOST_PARTITION_COUNT; i++) {
+        host_partition_t *p = &s_partitions[i];
+        if (p->part.type != type ||
+            (subtype != ESP_PARTITION_SUBTYPE_ANY && p->part.subtype != subtype) ||
+            (label != NULL && strcmp(p->part.label, label) != 0)) {
+            continue;
+        }
+
+        pthread_mutex_lock(&s_lock);
+        if (p->flash == NULL) {
+            p->flash = malloc(p->part.size);
+            if (p->flash != NULL) {
+                memset(p->flash, 0xFF, p->part.size);
+            }
+        }
+        pthread_mutex_unlock(&s_lock);
+        return (p->flash != NULL) ? &p->part : NULL;
+    }
+    return NULL;
+}
+
+static host_partition_t *partition_get(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    if (partition == NULL || offset > partition->size || size > partition->size - offset) {
+        return NULL;
+    }
+    host_partition_t *p = (host_partition_t *)partition;
+    return (p->flash != NULL) ? p : NULL;
+}
+
+/**
+ * @brief Lấy phần được phép ghi/xóa của một thao tác size byte theo ngân sách mất điện
+ */
+static size_t power_take_locked(size_t size)
+{
+    size_t n = (s_power_budget == UINT32_MAX || size <= s_power_budget) ? size : s_power_budget;
+    if (s_power_budget != UINT32_MAX) {
+        s_power_budget -= (uint32_t)n;
+    }
+    s_programmed_bytes += (uint32_t)n;
+    return n;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    host_partition_t *p = partition_get(partition, src_offset, size);
+    if (p == NULL || dst == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    memcpy(dst, p->flash + src_offset, size);
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+    host_partition_t *p = partition_get(partition, dst_offset, size);
+    if (p == NULL || src == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // NOR flash: ghi chỉ kéo bit 1 xuống 0
+    const uint8_t *in = src;
+    pthread_mutex_lock(&s_lock);
+    size_t n = power_take_locked(size);
+    for (size_t i = 0; i < n; i++) {
+        p->flash[dst_offset + i] &= in[i];
+    }
+    pthread_mutex_unlock(&s_lock);
+    return (n == size) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    host_partition_t *p = partition_get(partition, offset, size);
+    if (p == NULL || offset % partition->erase_size != 0 || size % partition->erase_size != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    size_t n = power_take_locked(size);
+    memset(p->flash + offset, 0xFF, n);
+    pthread_mutex_unlock(&s_lock);
+    return (n == size) ? ESP_OK : ESP_FAIL;
+}
+
+void host_flash_power_loss_after(uint32_t bytes)
+{
+    pthread_mutex_lock(&s_lock);
+    s_power_budget = bytes;
+    pthread_mutex_unlock(&s_lock);
+}
+
+void host_flash_power_restore(void)
+{
+    host_flash_power_loss_after(UINT32_MAX);
+}
+
+uint32_t host_flash_programmed_bytes(void)
+{
+    pthread_mutex_lock(&s_lock);
+    uint32_t bytes = s_programmed_bytes;
+    pthread_mutex_unlock(&s_lock);
+    return bytes;
+}
+
+int host_flash_corrupt(const char *label, uint32_t offset, uint8_t xor_mask)
+{
+    int ret = -1;
+    pthread_mutex_lock(&s_lock);
+    for (size_t i = 0; i < HOST_PARTITION_COUNT; i++) {
+        host_partition_t *p = &s_partitions[i];
+        if (strcmp(p->part.label, label) == 0 && p->flash != NULL && offset < p->part.size) {
+            p->flash[offset] ^= xor_mask;
+            ret = 0;
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ret;
+}
@@ -0,0 +1,524 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+#include "host_hal.h"
+#include "host_kernel.h"
+
+/*
+ * Event loop mặc định, netif station và WiFi station giả lập.
+ *
+ * Sự kiện được chuyển qua host_post() nên handler chạy tuần tự theo thứ tự
+ * post trên luồng dịch vụ. Kết nối hoàn tất sau một khoảng trễ (nhanh khi
+ * đã có BSSID/kênh, chậm khi quét toàn bộ) nếu AP giả đang có; mỗi lần
+ * connect/disconnect tăng số thế hệ để hủy lần kết nối đang dở.
+ */
+
+ESP_EVENT_DEFINE_BASE(WIFI_EVENT);
+ESP_EVENT_DEFINE_BASE(IP_EVENT);
+
+#define HOST_EVENT_MAX_HANDLERS 16
+#define HOST_WIFI_DHCP_IP ESP_IP4TOADDR(192, 168, 1, 50)
+#define HOST_WIFI_NETMASK ESP_IP4TOADDR(255, 255, 255, 0)
+#define HOST_WIFI_GATEWAY ESP_IP4TOADDR(192, 168, 1, 1)
+#define HOST_WIFI_CHANNEL 6
+#define HOST_WIFI_RSSI -55
+
+typedef struct {
+    esp_event_base_t base;
+    int32_t id;
+    esp_event_handler_t handler;
+    void *arg;
+} host_event_handler_t;
+
+typedef struct {
+    esp_event_base_t base;
+    int32_t id;
+    size_t size;
+    uint8_t data[];
+} host_event_t;
+
+struct esp_netif_obj {
+    esp_netif_ip_info_t ip_info;
+    esp_netif_dns_info_t dns;
+    bool dhcpc_running;
+};
+
+typedef struct {
+    uint32_t gen;
+} host_wifi_attempt_t;
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static host_event_handler_t s_handlers[HOST_EVENT_MAX_HANDLERS];
+static int s_handler_count = 0;
+static bool s_loop_created = false;
+
+static struct esp_netif_obj s_sta_netif;
+static bool s_netif_created = false;
+
+static const uint8_t s_ap_bssid[6] = { 0x24, 0x0a, 0xc4, 0x12, 0x34, 0x56 };
+static bool s_wifi_initialized = false;
+static bool s_wifi_started = false;
+static bool s_wifi_connected = false;
+static bool s_wifi_connecting = false;
+static uint32_t s_wifi_gen = 0;
+static wifi_config_t s_wifi_config;
+static bool s_ap_available = true;
+static uint32_t s_fast_delay_ms = 80;
+static uint32_t s_full_delay_ms = 1200;
+static uint32_t s_dhcp_ip = HOST_WIFI_DHCP_IP;
+
+// ==== Event loop ====
+
+static void event_dispatch(void *arg)
+{
+    host_event_t *ev = arg;
+    host_event_handler_t handlers[HOST_EVENT_MAX_HANDLERS];
+
+    pthread_mutex_lock(&s_lock);
+    int count = s_handler_count;
+    memcpy(handlers, s_handlers, sizeof(handlers));
+    pthread_mutex_unlock(&s_lock);
+
+    for (int i = 0; i < count; i++) {
+        bool base_match = handlers[i].base == ESP_EVENT_ANY_BASE || handlers[i].base == ev->base;
+        bool id_match = handlers[i].id == ESP_EVENT_ANY_ID || handlers[i].id == ev->id;
+        if (base_match && id_match) {
+            handlers[i].handler(handlers[i].arg, ev->base, ev->id, ev->size > 0 ? ev->data : NULL);
+        }
+    }
+    free(ev);
+}
+
+esp_err_t esp_event_loop_create_default(void)
+{
+    pthread_mutex_lock(&s_lock);
+    bool created = s_loop_created;
+    s_loop_created = true;
+    pthread_mutex_unlock(&s_lock);
+    return created ? ESP_ERR_INVALID_STATE : ESP_OK;
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t event_base, int32_t event_id,
+                                     esp_event_handler_t event_handler, void *event_handler_arg)
+{
+    if (event_handler == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_ERR_NO_MEM;
+    pthread_mutex_lock(&s_lock);
+    if (s_handler_count < HOST_EVENT_MAX_HANDLERS) {
+        s_handlers[s_handler_count++] = (host_event_handler_t) {
+            .base = event_base,
+            .id = event_id,
+            .handler = event_handler,
+            .arg = event_handler_arg,
+        };
+        ret = ESP_OK;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ret;
+}
+
+esp_err_t esp_event_handler_instance_register(esp_event_base_t event_base, int32_t event_id,
+                                              esp_event_handler_t event_handler, void *event_handler_arg,
+                                              esp_event_handler_instance_t *instance)
+{
+    esp_err_t ret = esp_event_handler_register(event_base, event_id, event_handler, event_handler_arg);
+    if (ret == ESP_OK && instance != NULL) {
+        *instance = (esp_event_handler_instance_t)event_handler;
+    }
+    return ret;
+}
+
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id, const void *event_data,
+                         size_t event_data_size, uint32_t ticks_to_wait)
+{
+    (void)ticks_to_wait;
+
+    host_event_t *ev = malloc(sizeof(host_event_t) + event_data_size);
+    if (ev == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ev->base = event_base;
+    ev->id = event_id;
+    ev->size = event_data_size;
+    if (event_data_size > 0) {
+        memcpy(ev->data, event_data, event_data_size);
+    }
+
+    if (host_post(event_dispatch, ev, 0) != 0) {
+        free(ev);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+// ==== Netif ====
+
+esp_err_t esp_netif_init(void)
+{
+    return ESP_OK;
+}
+
+esp_netif_t *esp_netif_create_default_wifi_sta(void)
+{
+    pthread_mutex_lock(&s_lock);
+    memset(&s_sta_netif, 0, sizeof(s_sta_netif));
+    s_sta_netif.dhcpc_running = true;
+    s_netif_created = true;
+    pthread_mutex_unlock(&s_lock);
+    return &s_sta_netif;
+}
+
+esp_netif_t *esp_netif_get_handle_from_ifkey(const char *if_key)
+{
+    if (if_key == NULL || strcmp(if_key, "WIFI_STA_DEF") != 0 || !s_netif_created) {
+        return NULL;
+    }
+    return &s_sta_netif;
+}
+
+esp_err_t esp_netif_get_ip_info(esp_netif_t *esp_netif, esp_netif_ip_info_t *ip_info)
+{
+    if (esp_netif == NULL || ip_info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    *ip_info = esp_netif->ip_info;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_set_ip_info(esp_netif_t *esp_netif, const esp_netif_ip_info_t *ip_info)
+{
+    if (esp_netif == NULL || ip_info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_OK;
+    pthread_mutex_lock(&s_lock);
+    if (esp_netif->dhcpc_running) {
+        // Như esp_netif: phải dừng DHCP client trước khi đặt IP tĩnh
+        ret = ESP_ERR_INVALID_STATE;
+    } else {
+        esp_netif->ip_info = *ip_info;
+    }
+    pthread_mutex_unlock(&s_lock);
+    return ret;
+}
+
+esp_err_t esp_netif_dhcpc_start(esp_netif_t *esp_netif)
+{
+    if (esp_netif == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    esp_netif->dhcpc_running = true;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_dhcpc_stop(esp_netif_t *esp_netif)
+{
+    if (esp_netif == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    esp_netif->dhcpc_running = false;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_get_dns_info(esp_netif_t *esp_netif, esp_netif_dns_type_t type,
+                                 esp_netif_dns_info_t *dns)
+{
+    if (esp_netif == NULL || dns == NULL || type != ESP_NETIF_DNS_MAIN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    *dns = esp_netif->dns;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_set_dns_info(esp_netif_t *esp_netif, esp_netif_dns_type_t type,
+                                 esp_netif_dns_info_t *dns)
+{
+    if (esp_netif == NULL || dns == NULL || type != ESP_NETIF_DNS_MAIN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    esp_netif->dns = *dns;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+// ==== WiFi ====
+
+void host_wifi_set_connect_delay_ms(uint32_t fast_ms, uint32_t full_ms)
+{
+    pthread_mutex_lock(&s_lock);
+    s_fast_delay_ms = fast_ms;
+    s_full_delay_ms = full_ms;
+    pthread_mutex_unlock(&s_lock);
+}
+
+void host_wifi_set_dhcp_ip(uint32_t ip)
+{
+    pthread_mutex_lock(&s_lock);
+    s_dhcp_ip = ip;
+    pthread_mutex_unlock(&s_lock);
+}
+
+bool host_wifi_is_up(void)
+{
+    pthread_mutex_lock(&s_lock);
+    bool up = s_wifi_connected;
+    pthread_mutex_unlock(&s_lock);
+    return up;
+}
+
+static void post_disconnected(uint8_t reason)
+{
+    wifi_event_sta_disconnected_t event = {0};
+    memcpy(event.ssid, s_wifi_config.sta.ssid, sizeof(event.ssid));
+    event.ssid_len = (uint8_t)strnlen((const char *)s_wifi_config.sta.ssid, sizeof(event.ssid));
+    memcpy(event.bssid, s_ap_bssid, sizeof(event.bssid));
+    event.reason = reason;
+    esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_DISCONNECTED, &event, sizeof(event), 0);
+}
+
+/**
+ * @brief Rớt liên kết đang có hoặc hủy lần kết nối đang dở (giữ s_lock)
+ * @return true nếu có sự kiện STA_DISCONNECTED cần post
+ */
+static bool link_down_locked(void)
+{
+    bool had_link = s_wifi_connected || s_wifi_connecting;
+
+    s_wifi_gen++;
+    s_wifi_connecting = false;
+    if (s_wifi_connected) {
+        s_wifi_connected = false;
+        if (s_sta_netif.dhcpc_running) {
+            memset(&s_sta_netif.ip_info, 0, sizeof(s_sta_netif.ip_info));
+        }
+    }
+    return had_link;
+}
+
+static void connect_done(void *arg)
+{
+    host_wifi_attempt_t *attempt = arg;
+
+    pthread_mutex_lock(&s_lock);
+    bool current = (attempt->gen == s_wifi_gen) && s_wifi_connecting;
+    bool ok = current && s_ap_available;
+    ip_event_got_ip_t got_ip = {0};
+    if (current) {
+        s_wifi_connecting = false;
+    }
+    if (ok) {
+        s_wifi_connected = true;
+        if (s_sta_netif.dhcpc_running) {
+            s_sta_netif.ip_info.ip.addr = s_dhcp_ip;
+            s_sta_netif.ip_info.netmask.addr = HOST_WIFI_NETMASK;
+            s_sta_netif.ip_info.gw.addr = HOST_WIFI_GATEWAY;
+            s_sta_netif.dns.ip.u_addr.ip4.addr = HOST_WIFI_GATEWAY;
+        }
+        got_ip.esp_netif = &s_sta_netif;
+        got_ip.ip_info = s_sta_netif.ip_info;
+        got_ip.ip_changed = true;
+    }
+    pthread_mutex_unlock(&s_lock);
+    free(attempt);
+
+    if (ok) {
+        wifi_event_sta_connected_t connected = {0};
+        memcpy(connected.ssid, s_wifi_config.sta.ssid, sizeof(connected.ssid));
+        memcpy(connected.bssid, s_ap_bssid, sizeof(connected.bssid));
+        connected.channel = HOST_WIFI_CHANNEL;
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_CONNECTED, &connected, sizeof(connected), 0);
+        esp_event_post(IP_EVENT, IP_EVENT_STA_GOT_IP, &got_ip, sizeof(got_ip), 0);
+    } else if (current) {
+        post_disconnected(WIFI_REASON_NO_AP_FOUND);
+    }
+}
+
+void host_wifi_set_ap_available(bool available)
+{
+    pthread_mutex_lock(&s_lock);
+    s_ap_available = available;
+    bool lost = !available && s_wifi_connected;
+    if (lost) {
+        link_down_locked();
+    }
+    pthread_mutex_unlock(&s_lock);
+
+    if (lost) {
+        host_mqtt_on_network_down();
+        post_disconnected(WIFI_REASON_BEACON_TIMEOUT);
+    }
+}
+
+esp_err_t esp_wifi_init(const wifi_init_config_t *config)
+{
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    s_wifi_initialized = true;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_set_mode(wifi_mode_t mode)
+{
+    if (!s_wifi_initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    return (mode == WIFI_MODE_STA) ? ESP_OK : ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_wifi_set_config(wifi_interface_t interface, wifi_config_t *conf)
+{
+    if (!s_wifi_initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    if (interface != WIFI_IF_STA || conf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    s_wifi_config = *conf;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_config(wifi_interface_t interface, wifi_config_t *conf)
+{
+    if (!s_wifi_initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    if (interface != WIFI_IF_STA || conf == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    *conf = s_wifi_config;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_start(void)
+{
+    if (!s_wifi_initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    bool was_started = s_wifi_started;
+    s_wifi_started = true;
+    pthread_mutex_unlock(&s_lock);
+
+    if (!was_started) {
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_START, NULL, 0, 0);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_stop(void)
+{
+    if (!s_wifi_initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    bool had_link = link_down_locked();
+    bool was_started = s_wifi_started;
+    s_wifi_started = false;
+    pthread_mutex_unlock(&s_lock);
+
+    if (had_link) {
+        host_mqtt_on_network_down();
+        post_disconnected(WIFI_REASON_ASSOC_LEAVE);
+    }
+    if (was_started) {
+        esp_event_post(WIFI_EVENT, WIFI_EVENT_STA_STOP, NULL, 0, 0);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_connect(void)
+{
+    pthread_mutex_lock(&s_lock);
+    if (!s_wifi_started) {
+        pthread_mutex_unlock(&s_lock);
+        return ESP_ERR_WIFI_NOT_STARTED;
+    }
+
+    host_wifi_attempt_t *attempt = malloc(sizeof(host_wifi_attempt_t));
+    if (attempt == NULL) {
+        pthread_mutex_unlock(&s_lock);
+        return ESP_ERR_NO_MEM;
+    }
+    attempt->gen = ++s_wifi_gen;
+    s_wifi_connecting = true;
+    uint32_t delay_ms = s_wifi_config.sta.bssid_set ? s_fast_delay_ms : s_full_delay_ms;
+    pthread_mutex_unlock(&s_lock);
+
+    if (host_post(connect_done, attempt, (int64_t)delay_ms * 1000) != 0) {
+        free(attempt);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_disconnect(void)
+{
+    if (!s_wifi_initialized) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    bool had_link = link_down_locked();
+    pthread_mutex_unlock(&s_lock);
+
+    if (had_link) {
+        host_mqtt_on_network_down();
+        post_disconnected(WIFI_REASON_ASSOC_LEAVE);
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap_info)
+{
+    if (ap_info == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    pthread_mutex_lock(&s_lock);
+    if (!s_wifi_connected) {
+        pthread_mutex_unlock(&s_lock);
+        return ESP_ERR_WIFI_CONN;
+    }
+    memset(ap_info, 0, sizeof(wifi_ap_record_t));
+    memcpy(ap_info->bssid, s_ap_bssid, sizeof(ap_info->bssid));
+    memcpy(ap_info->ssid, s_wifi_config.sta.ssid, sizeof(s_wifi_config.sta.ssid));
+    ap_info->primary = HOST_WIFI_CHANNEL;
+    ap_info->rssi = HOST_WIFI_RSSI;
+    ap_info->authmode = s_wifi_config.sta.threshold.authmode;
+    pthread_mutex_unlock(&s_lock);
+    return ESP_OK;
+}
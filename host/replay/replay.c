@@ -0,0 +1,86 @@
+#include "replay.h"
+#include <string.h>
+
+static sensor_status_t s_status;
+
+int replay_run(const replay_trace_t *trace, uint32_t period_ms, replay_result_t *result)
+{
+    if (trace == NULL || result == NULL || period_ms == 0 || trace->count == 0) {
+        return -1;
+    }
+
+    memset(result, 0, sizeof(*result));
+
+    // Bộ lọc, debounce, lịch sử và ROR về trạng thái như lúc khởi động
+    if (sensor_system_init(&s_status) != 0) {
+        return -1;
+    }
+
+    const uint8_t count = sensor_count();
+    const uint32_t start = trace->time_ms[0];
+    const uint32_t end = trace->time_ms[trace->count - 1];
+    const bool has_fire = (trace->fire_at_ms >= 0);
+    const uint32_t fire_at = has_fire ? (uint32_t)trace->fire_at_ms : 0;
+
+    result->duration_ms = end - start;
+    result->has_fire = has_fire;
+    if (!has_fire) {
+        result->quiet_ms = result->duration_ms;
+    } else if (fire_at > start) {
+        result->quiet_ms = ((fire_at < end) ? fire_at : end) - start;
+    }
+
+    uint32_t row = 0;
+    for (uint64_t t = start; t <= end; t += period_ms) {
+        // Dòng mới nhất tại thời điểm chu kỳ (giữ giá trị giữa hai dòng)
+        while (row + 1 < trace->count && trace->time_ms[row + 1] <= t) {
+            row++;
+        }
+        const uint16_t *values = &trace->raw[(size_t)row * trace->columns];
+
+        s_status.last_read_time = (uint32_t)t;
+        for (uint8_t i = 0; i < count; i++) {
+            int8_t column = trace->sensor_column[i];
+            sensor_process_sample(&s_status, i, (column >= 0) ? values[column] : 0);
+        }
+        bool changed = sensor_evaluate(&s_status);
+        result->cycles++;
+
+        if (!has_fire || t < fire_at) {
+            if (s_status.fire_detected) {
+                result->alarm_ms += period_ms;
+                if (changed) {
+                    result->false_alarms++;
+                }
+            }
+        } else if (!result->detected && s_status.fire_detected) {
+            result->detected = true;
+            result->time_to_detect_ms = (uint32_t)(t - fire_at);
+        }
+    }
+
+    return 0;
+}
+
+double replay_false_alarms_per_h(const replay_result_t *result)
+{
+    return (result->quiet_ms > 0) ? result->false_alarms / (result->quiet_ms / 3.6e6) : 0.0;
+}
+
+uint32_t replay_check(const replay_result_t *result, const replay_limits_t *limits)
+{
+    uint32_t failures = 0;
+
+    if (result->has_fire && limits->max_time_to_detect_ms >= 0) {
+        if (!result->detected) {
+            failures |= REPLAY_FAIL_MISSED;
+        } else if (result->time_to_detect_ms > (uint32_t)limits->max_time_to_detect_ms) {
+            failures |= REPLAY_FAIL_TIME_TO_DETECT;
+        }
+    }
+    if (limits->max_false_alarms_per_h >= 0 &&
+        replay_false_alarms_per_h(result) > limits->max_false_alarms_per_h) {
+        failures |= REPLAY_FAIL_FALSE_ALARMS;
+    }
+    return failures;
+}
@@ -0,0 +1,54 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "replay_trace.h"
+
+/*
+ * Phát lại trace qua đúng mã xử lý của firmware: mỗi chu kỳ đọc
+ * (SENSOR_READ_PERIOD_MS) lấy dòng gần nhất có time_ms <= thời điểm chu kỳ
+ * (giá trị trung bình của chu kỳ như sensor_task nhận từ ADC), đưa từng giá trị vào
+ * sensor_process_sample() rồi sensor_evaluate(). Không có task hay timer:
+ * trace được phát nhanh nhất có thể.
+ */
+
+typedef struct {
+    uint32_t cycles;                // Số chu kỳ đọc đã phát
+    uint32_t duration_ms;           // Thời lượng trace
+    uint32_t quiet_ms;              // Thời gian không cháy (trước fire_at_ms hoặc cả trace)
+    uint32_t false_alarms;          // Số lần báo cháy (cạnh lên) trong thời gian không cháy
+    uint32_t alarm_ms;              // Tổng thời gian báo cháy trong thời gian không cháy
+    bool has_fire;                  // Trace có fire_at_ms
+    bool detected;                  // Phát hiện cháy sau fire_at_ms
+    uint32_t time_to_detect_ms;     // fire_at_ms -> chu kỳ đầu tiên fire_detected (khi detected)
+} replay_result_t;
+
+// Các giới hạn bị vượt (kết quả replay_check())
+#define REPLAY_FAIL_MISSED          (1 << 0)    // Trace cháy có giới hạn thời gian nhưng không phát hiện
+#define REPLAY_FAIL_TIME_TO_DETECT  (1 << 1)    // Phát hiện chậm hơn max_time_to_detect_ms
+#define REPLAY_FAIL_FALSE_ALARMS    (1 << 2)    // Báo sai nhiều hơn max_false_alarms_per_h
+
+/**
+ * @brief Phát lại một trace từ trạng thái cảm biến mới khởi tạo
+ * @param trace Trace đã đọc
+ * @param period_ms Chu kỳ đọc (thường SENSOR_READ_PERIOD_MS)
+ * @param result Kết quả
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int replay_run(const replay_trace_t *trace, uint32_t period_ms, replay_result_t *result);
+
+/**
+ * @brief Số lần báo sai mỗi giờ trong thời gian không cháy của một trace
+ */
+double replay_false_alarms_per_h(const replay_result_t *result);
+
+/**
+ * @brief So kết quả với giới hạn mong đợi
+ * @param result Kết quả replay_run()
+ * @param limits Giới hạn (trường âm được bỏ qua)
+ * @return 0 nếu đạt, tổ hợp REPLAY_FAIL_* nếu không
+ */
+uint32_t replay_check(const replay_result_t *result, const replay_limits_t *limits);
+
+#endif // REPLAY_H
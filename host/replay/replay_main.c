@@ -0,0 +1,445 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "esp_log.h"
+#include "host_hal.h"
+#include "replay.h"
+
+/*
+ * Phát lại bộ trace cảm biến qua mã xử lý/phát hiện của firmware và báo:
+ *   - trace cháy (có fire_at_ms): có phát hiện không, thời gian tới khi phát hiện
+ *   - thời gian không cháy (trace gây nhiễu + đoạn trước fire_at_ms): số lần
+ *     báo cháy sai mỗi giờ
+ *   - trace không đạt giới hạn mong đợi (khai báo trong trace, hoặc
+ *     --max-ttd-s/--max-fa-per-h cho trace không khai báo)
+ *
+ *   fire_system_replay [--format text|csv|json] [--period-ms N] [--summary]
+ *                      [--max-ttd-s S] [--max-fa-per-h N] [--to-binary DIR] PATH...
+ *
+ * PATH là file trace (.csv hoặc .bin) hoặc thư mục (quét đệ quy).
+ * Mã thoát: 0 đạt, 1 lỗi đọc/phát lại trace, 2 sai tham số, 3 có trace
+ * không đạt giới hạn.
+ */
+
+#define REPLAY_EXIT_LOAD_FAILED 1
+#define REPLAY_EXIT_USAGE 2
+#define REPLAY_EXIT_REGRESSION 3
+
+typedef enum {
+    REPLAY_FORMAT_TEXT = 0,
+    REPLAY_FORMAT_CSV,
+    REPLAY_FORMAT_JSON,
+} replay_format_t;
+
+typedef struct {
+    replay_format_t format;
+    uint32_t period_ms;
+    bool summary_only;
+    const char *binary_dir;             // Chỉ đổi sang nhị phân, không phát lại
+    replay_limits_t default_limits;     // Cho trace không khai báo giới hạn
+} replay_options_t;
+
+typedef struct {
+    char **paths;
+    size_t count;
+    size_t capacity;
+} path_list_t;
+
+typedef struct {
+    uint32_t traces;
+    uint32_t failed;
+    uint32_t fire_traces;
+    uint32_t detected;
+    uint64_t cycles;
+    uint64_t duration_ms;
+    uint64_t quiet_ms;
+    uint64_t alarm_ms;
+    uint32_t false_alarms;
+    uint32_t checked;                   // Trace có ít nhất một giới hạn
+    uint32_t regressions;               // Trace không đạt giới hạn
+    uint32_t *ttd_ms;                   // Thời gian tới khi phát hiện của các trace cháy đã phát hiện
+} replay_summary_t;
+
+// ==== Danh sách file ====
+
+static bool has_trace_suffix(const char *name)
+{
+    const char *dot = strrchr(name, '.');
+    return dot != NULL && (strcmp(dot, ".csv") == 0 || strcmp(dot, ".bin") == 0);
+}
+
+static int path_list_add(path_list_t *list, const char *path)
+{
+    if (list->count == list->capacity) {
+        size_t cap = list->capacity ? list->capacity * 2 : 64;
+        char **paths = realloc(list->paths, cap * sizeof(char *));
+        if (paths == NULL) {
+            return -1;
+        }
+        list->paths = paths;
+        list->capacity = cap;
+    }
+    list->paths[list->count] = strdup(path);
+    return (list->paths[list->count++] != NULL) ? 0 : -1;
+}
+
+static int collect(path_list_t *list, const char *path, bool top_level)
+{
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        perror(path);
+        return -1;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        // File chỉ định trực tiếp được đọc bất kể phần mở rộng
+        return (top_level || has_trace_suffix(path)) ? path_list_add(list, path) : 0;
+    }
+
+    DIR *dir = opendir(path);
+    if (dir == NULL) {
+        perror(path);
+        return -1;
+    }
+    int ret = 0;
+    struct dirent *entry;
+    while (ret == 0 && (entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        size_t len = strlen(path) + strlen(entry->d_name) + 2;
+        char *child = malloc(len);
+        if (child == NULL) {
+            ret = -1;
+            break;
+        }
+        snprintf(child, len, "%s/%s", path, entry->d_name);
+        ret = collect(list, child, false);
+        free(child);
+    }
+    closedir(dir);
+    return ret;
+}
+
+static int compare_path(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// ==== Báo cáo ====
+
+/**
+ * @brief Tên các giới hạn bị vượt, "pass" nếu đạt
+ */
+static const char *failure_text(uint32_t failures, char *buf, size_t size)
+{
+    static const char *const names[] = { "missed", "time_to_detect", "false_alarms" };
+
+    if (failures == 0) {
+        return "pass";
+    }
+    size_t n = 0;
+    buf[0] = '\0';
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (failures & (1u << i)) {
+            n += snprintf(buf + n, size - n, "%s%s", (n > 0) ? "+" : "", names[i]);
+            if (n >= size) {
+                break;
+            }
+        }
+    }
+    return buf;
+}
+
+static void print_trace(const replay_options_t *opt, const char *path, const replay_result_t *r,
+                        uint32_t failures, bool first)
+{
+    char failed[48];
+    const char *check = failure_text(failures, failed, sizeof(failed));
+
+    if (opt->summary_only) {
+        // Trace không đạt vẫn được nêu tên
+        if (failures != 0) {
+            fprintf(stderr, "FAIL %s (%s)\n", path, check);
+        }
+        return;
+    }
+
+    switch (opt->format) {
+    case REPLAY_FORMAT_CSV:
+        if (first) {
+            printf("trace,kind,duration_s,cycles,detected,time_to_detect_s,quiet_h,false_alarms,alarm_s,check\n");
+        }
+        printf("%s,%s,%.1f,%lu,%d,%.1f,%.4f,%lu,%.1f,%s\n",
+               path, r->has_fire ? "fire" : "nuisance", r->duration_ms / 1e3, (unsigned long)r->cycles,
+               r->detected, r->detected ? r->time_to_detect_ms / 1e3 : -1.0,
+               r->quiet_ms / 3.6e6, (unsigned long)r->false_alarms, r->alarm_ms / 1e3, check);
+        break;
+    case REPLAY_FORMAT_JSON:
+        printf("%s{\"trace\":\"%s\",\"kind\":\"%s\",\"duration_s\":%.1f,\"cycles\":%lu,\"detected\":%s,"
+               "\"time_to_detect_s\":%.1f,\"quiet_h\":%.4f,\"false_alarms\":%lu,\"alarm_s\":%.1f,"
+               "\"check\":\"%s\"}",
+               first ? "" : ",", path, r->has_fire ? "fire" : "nuisance", r->duration_ms / 1e3,
+               (unsigned long)r->cycles, r->detected ? "true" : "false",
+               r->detected ? r->time_to_detect_ms / 1e3 : -1.0,
+               r->quiet_ms / 3.6e6, (unsigned long)r->false_alarms, r->alarm_ms / 1e3, check);
+        break;
+    default:
+        if (r->has_fire) {
+            if (r->detected) {
+                printf("%-40s fire      detected after %7.1f s", path, r->time_to_detect_ms / 1e3);
+            } else {
+                printf("%-40s fire      MISSED                 ", path);
+            }
+        } else {
+            printf("%-40s nuisance                         ", path);
+        }
+        printf("  %8.2f h  false alarms %lu", r->duration_ms / 3.6e6, (unsigned long)r->false_alarms);
+        if (failures != 0) {
+            printf("  FAIL (%s)", check);
+        }
+        printf("\n");
+        break;
+    }
+}
+
+static void print_summary(const replay_options_t *opt, replay_summary_t *s, double wall_s)
+{
+    double quiet_h = s->quiet_ms / 3.6e6;
+    double fp_per_hour = (quiet_h > 0) ? s->false_alarms / quiet_h : 0.0;
+    double replay_speed = (wall_s > 0) ? (s->duration_ms / 1e3) / wall_s : 0.0;
+    double ttd_median = -1.0;
+    double ttd_p90 = -1.0;
+    double ttd_max = -1.0;
+
+    if (s->detected > 0) {
+        qsort(s->ttd_ms, s->detected, sizeof(uint32_t), compare_u32);
+        ttd_median = s->ttd_ms[(s->detected - 1) / 2] / 1e3;
+        ttd_p90 = s->ttd_ms[(s->detected * 90 + 99) / 100 - 1] / 1e3;
+        ttd_max = s->ttd_ms[s->detected - 1] / 1e3;
+    }
+
+    // CSV chỉ chứa dòng từng trace; tóm tắt ra stderr
+    FILE *out = (opt->format == REPLAY_FORMAT_CSV) ? stderr : stdout;
+
+    if (opt->format == REPLAY_FORMAT_JSON) {
+        printf("%s\"summary\":{\"traces\":%lu,\"failed\":%lu,\"fire_traces\":%lu,\"detected\":%lu,"
+               "\"ttd_median_s\":%.1f,\"ttd_p90_s\":%.1f,\"ttd_max_s\":%.1f,\"quiet_h\":%.3f,"
+               "\"false_alarms\":%lu,\"false_alarms_per_h\":%.4f,\"alarm_s\":%.1f,"
+               "\"checked\":%lu,\"regressions\":%lu,"
+               "\"replayed_h\":%.3f,\"cycles\":%llu,\"wall_s\":%.3f,\"speedup\":%.0f}}\n",
+               opt->summary_only ? "{" : "],", (unsigned long)s->traces, (unsigned long)s->failed,
+               (unsigned long)s->fire_traces, (unsigned long)s->detected,
+               ttd_median, ttd_p90, ttd_max, quiet_h, (unsigned long)s->false_alarms, fp_per_hour,
+               s->alarm_ms / 1e3, (unsigned long)s->checked, (unsigned long)s->regressions,
+               s->duration_ms / 3.6e6, (unsigned long long)s->cycles, wall_s, replay_speed);
+        return;
+    }
+
+    fprintf(out, "\nTraces: %lu replayed, %lu failed to load\n", (unsigned long)s->traces, (unsigned long)s->failed);
+    fprintf(out, "Fire: %lu/%lu detected", (unsigned long)s->detected, (unsigned long)s->fire_traces);
+    if (s->detected > 0) {
+        fprintf(out, ", time to detect median %.1f s, p90 %.1f s, max %.1f s", ttd_median, ttd_p90, ttd_max);
+    }
+    fprintf(out, "\nNo-fire time: %.2f h, %lu false alarms (%.4f per hour), %.1f s in alarm\n",
+            quiet_h, (unsigned long)s->false_alarms, fp_per_hour, s->alarm_ms / 1e3);
+    fprintf(out, "Expectations: %lu traces checked, %lu failed%s\n", (unsigned long)s->checked,
+            (unsigned long)s->regressions, (s->regressions > 0) ? " - FAIL" : "");
+    fprintf(out, "Replayed %.2f h (%llu cycles) in %.3f s, %.0fx real time\n",
+            s->duration_ms / 3.6e6, (unsigned long long)s->cycles, wall_s, replay_speed);
+}
+
+// ==== Chương trình ====
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "Usage: %s [--format text|csv|json] [--period-ms N] [--summary] [--max-ttd-s S]\n"
+            "          [--max-fa-per-h N] [--to-binary DIR] PATH...\n"
+            "  PATH             trace file (.csv or .bin) or directory scanned recursively\n"
+            "  --format F       per-trace output format (default text)\n"
+            "  --period-ms N    read cycle period (default %d, as sensor_task)\n"
+            "  --summary        print only the corpus summary (and failing traces)\n"
+            "  --max-ttd-s S    fail fire traces detected later than S s or missed\n"
+            "  --max-fa-per-h N fail traces with more than N false alarms per no-fire hour\n"
+            "                   (both only for traces that do not declare their own limit)\n"
+            "  --to-binary DIR  convert traces to binary files in DIR instead of replaying\n"
+            "Exit status: 0 pass, 1 trace load/replay error, 2 usage, 3 limit exceeded\n",
+            prog, SENSOR_READ_PERIOD_MS);
+}
+
+static int parse_options(int argc, char **argv, replay_options_t *opt, path_list_t *paths)
+{
+    opt->format = REPLAY_FORMAT_TEXT;
+    opt->period_ms = SENSOR_READ_PERIOD_MS;
+    opt->summary_only = false;
+    opt->binary_dir = NULL;
+    opt->default_limits.max_time_to_detect_ms = REPLAY_NO_LIMIT;
+    opt->default_limits.max_false_alarms_per_h = REPLAY_NO_LIMIT;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        bool has_value = (i + 1 < argc);
+
+        if (strcmp(arg, "--summary") == 0) {
+            opt->summary_only = true;
+        } else if (strcmp(arg, "--format") == 0 && has_value) {
+            const char *name = argv[++i];
+            if (strcmp(name, "text") == 0) {
+                opt->format = REPLAY_FORMAT_TEXT;
+            } else if (strcmp(name, "csv") == 0) {
+                opt->format = REPLAY_FORMAT_CSV;
+            } else if (strcmp(name, "json") == 0) {
+                opt->format = REPLAY_FORMAT_JSON;
+            } else {
+                return -1;
+            }
+        } else if (strcmp(arg, "--period-ms") == 0 && has_value) {
+            opt->period_ms = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(arg, "--max-ttd-s") == 0 && has_value) {
+            opt->default_limits.max_time_to_detect_ms = (int32_t)(atof(argv[++i]) * 1000.0);
+        } else if (strcmp(arg, "--max-fa-per-h") == 0 && has_value) {
+            opt->default_limits.max_false_alarms_per_h = atof(argv[++i]);
+        } else if (strcmp(arg, "--to-binary") == 0 && has_value) {
+            opt->binary_dir = argv[++i];
+        } else if (arg[0] == '-') {
+            return -1;
+        } else if (collect(paths, arg, true) != 0) {
+            return -1;
+        }
+    }
+    return (paths->count > 0 && opt->period_ms > 0) ? 0 : -1;
+}
+
+static int convert(const char *path, const replay_trace_t *trace, const char *dir)
+{
+    const char *base = strrchr(path, '/');
+    base = (base != NULL) ? base + 1 : path;
+    const char *dot = strrchr(base, '.');
+    int stem = (dot != NULL) ? (int)(dot - base) : (int)strlen(base);
+
+    char out[4096];
+    snprintf(out, sizeof(out), "%s/%.*s.bin", dir, stem, base);
+    if (replay_trace_save_binary(out, trace) != 0) {
+        return -1;
+    }
+    printf("%s -> %s (%lu rows)\n", path, out, (unsigned long)trace->count);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    replay_options_t opt;
+    path_list_t paths = {0};
+
+    if (parse_options(argc, argv, &opt, &paths) != 0) {
+        usage(argv[0]);
+        return REPLAY_EXIT_USAGE;
+    }
+    qsort(paths.paths, paths.count, sizeof(char *), compare_path);
+
+    // Log khởi tạo cảm biến của mỗi trace không được lẫn vào kết quả
+    host_log_set_level(ESP_LOG_ERROR);
+
+    replay_summary_t summary = {0};
+    summary.ttd_ms = calloc(paths.count, sizeof(uint32_t));
+    if (summary.ttd_ms == NULL) {
+        return 1;
+    }
+
+    if (opt.format == REPLAY_FORMAT_JSON && !opt.summary_only && opt.binary_dir == NULL) {
+        printf("{\"period_ms\":%lu,\"traces\":[", (unsigned long)opt.period_ms);
+    }
+
+    struct timespec t0;
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    for (size_t i = 0; i < paths.count; i++) {
+        const char *path = paths.paths[i];
+        replay_trace_t trace;
+        if (replay_trace_load(path, &trace) != 0) {
+            summary.failed++;
+            continue;
+        }
+
+        if (opt.binary_dir != NULL) {
+            if (convert(path, &trace, opt.binary_dir) != 0) {
+                summary.failed++;
+            }
+            replay_trace_free(&trace);
+            continue;
+        }
+
+        // Giới hạn của trace được ưu tiên, còn lại lấy từ dòng lệnh
+        replay_limits_t limits = trace.limits;
+        if (limits.max_time_to_detect_ms < 0) {
+            limits.max_time_to_detect_ms = opt.default_limits.max_time_to_detect_ms;
+        }
+        if (limits.max_false_alarms_per_h < 0) {
+            limits.max_false_alarms_per_h = opt.default_limits.max_false_alarms_per_h;
+        }
+
+        replay_result_t result;
+        int ret = replay_run(&trace, opt.period_ms, &result);
+        replay_trace_free(&trace);
+        if (ret != 0) {
+            fprintf(stderr, "%s: replay failed\n", path);
+            summary.failed++;
+            continue;
+        }
+
+        uint32_t failures = replay_check(&result, &limits);
+        print_trace(&opt, path, &result, failures, summary.traces == 0);
+        summary.traces++;
+        if ((result.has_fire && limits.max_time_to_detect_ms >= 0) || limits.max_false_alarms_per_h >= 0) {
+            summary.checked++;
+        }
+        if (failures != 0) {
+            summary.regressions++;
+        }
+        summary.cycles += result.cycles;
+        summary.duration_ms += result.duration_ms;
+        summary.quiet_ms += result.quiet_ms;
+        summary.alarm_ms += result.alarm_ms;
+        summary.false_alarms += result.false_alarms;
+        if (result.has_fire) {
+            summary.fire_traces++;
+            if (result.detected) {
+                summary.ttd_ms[summary.detected++] = result.time_to_detect_ms;
+            }
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double wall_s = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    if (opt.binary_dir == NULL) {
+        print_summary(&opt, &summary, wall_s);
+    }
+    fflush(stdout);
+
+    int status = 0;
+    if (summary.failed > 0) {
+        status = REPLAY_EXIT_LOAD_FAILED;
+    } else if (summary.regressions > 0) {
+        status = REPLAY_EXIT_REGRESSION;
+    }
+    for (size_t i = 0; i < paths.count; i++) {
+        free(paths.paths[i]);
+    }
+    free(paths.paths);
+    free(summary.ttd_ms);
+
+    // Luồng dịch vụ của mock có thể đang chạy: kết thúc cả tiến trình
+    _Exit(status);
+}
@@ -0,0 +1,323 @@
+#include "replay_trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_RAW_MAX 4095
+#define REPLAY_HEADER_V1_LEN 16
+#define REPLAY_HEADER_LEN 24
+
+static int grow(replay_trace_t *trace, uint32_t *capacity)
+{
+    uint32_t cap = (*capacity > 0) ? *capacity * 2 : 4096;
+    uint32_t *time_ms = realloc(trace->time_ms, (size_t)cap * sizeof(uint32_t));
+    if (time_ms == NULL) {
+        return -1;
+    }
+    trace->time_ms = time_ms;
+
+    uint16_t *raw = realloc(trace->raw, (size_t)cap * trace->columns * sizeof(uint16_t));
+    if (raw == NULL) {
+        return -1;
+    }
+    trace->raw = raw;
+
+    *capacity = cap;
+    return 0;
+}
+
+/**
+ * @brief Ghép cột với registry cảm biến theo tên
+ */
+static void map_columns(replay_trace_t *trace, const char *path)
+{
+    bool used[SENSOR_MAX_COUNT] = {false};
+
+    for (uint8_t i = 0; i < SENSOR_MAX_COUNT; i++) {
+        trace->sensor_column[i] = -1;
+    }
+    for (uint8_t i = 0; i < sensor_count(); i++) {
+        for (uint8_t c = 0; c < trace->columns; c++) {
+            if (strcmp(trace->column_name[c], sensor_get_desc(i)->name) == 0) {
+                trace->sensor_column[i] = (int8_t)c;
+                used[c] = true;
+                break;
+            }
+        }
+    }
+    for (uint8_t c = 0; c < trace->columns; c++) {
+        if (!used[c]) {
+            fprintf(stderr, "%s: column '%s' matches no sensor, ignored\n", path, trace->column_name[c]);
+        }
+    }
+}
+
+static int parse_csv_header(replay_trace_t *trace, char *line, const char *path)
+{
+    char *save = NULL;
+    char *token = strtok_r(line, ",\r\n", &save);
+    if (token == NULL || (strcmp(token, "time_ms") != 0)) {
+        fprintf(stderr, "%s: first column must be time_ms\n", path);
+        return -1;
+    }
+
+    while ((token = strtok_r(NULL, ",\r\n", &save)) != NULL) {
+        while (*token == ' ') {
+            token++;
+        }
+        if (trace->columns >= SENSOR_MAX_COUNT || strlen(token) >= REPLAY_TRACE_NAME_LEN) {
+            fprintf(stderr, "%s: too many columns or column name too long\n", path);
+            return -1;
+        }
+        strcpy(trace->column_name[trace->columns++], token);
+    }
+    return (trace->columns > 0) ? 0 : -1;
+}
+
+static int load_csv(FILE *f, const char *path, replay_trace_t *trace)
+{
+    char *line = NULL;
+    size_t line_cap = 0;
+    uint32_t capacity = 0;
+    uint32_t line_no = 0;
+    bool have_header = false;
+    int ret = -1;
+
+    while (getline(&line, &line_cap, f) >= 0) {
+        line_no++;
+        if (line[0] == '#') {
+            const char *value;
+            if ((value = strstr(line, "fire_at_ms=")) != NULL) {
+                trace->fire_at_ms = (int32_t)strtol(value + strlen("fire_at_ms="), NULL, 10);
+            } else if ((value = strstr(line, "max_time_to_detect_ms=")) != NULL) {
+                trace->limits.max_time_to_detect_ms =
+                    (int32_t)strtol(value + strlen("max_time_to_detect_ms="), NULL, 10);
+            } else if ((value = strstr(line, "max_false_alarms_per_h=")) != NULL) {
+                trace->limits.max_false_alarms_per_h = strtod(value + strlen("max_false_alarms_per_h="), NULL);
+            }
+            continue;
+        }
+        if (line[0] == '\n' || line[0] == '\r' || line[0] == '\0') {
+            continue;
+        }
+        if (!have_header) {
+            if (parse_csv_header(trace, line, path) != 0) {
+                goto out;
+            }
+            have_header = true;
+            continue;
+        }
+
+        if (trace->count == capacity && grow(trace, &capacity) != 0) {
+            fprintf(stderr, "%s: out of memory\n", path);
+            goto out;
+        }
+
+        char *p = line;
+        char *end = NULL;
+        unsigned long t = strtoul(p, &end, 10);
+        if (end == p || (trace->count > 0 && t < trace->time_ms[trace->count - 1])) {
+            fprintf(stderr, "%s:%lu: bad or decreasing time\n", path, (unsigned long)line_no);
+            goto out;
+        }
+        trace->time_ms[trace->count] = (uint32_t)t;
+
+        uint16_t *row = &trace->raw[(size_t)trace->count * trace->columns];
+        for (uint8_t c = 0; c < trace->columns; c++) {
+            p = end;
+            if (*p != ',') {
+                fprintf(stderr, "%s:%lu: expected %u values\n", path, (unsigned long)line_no, trace->columns);
+                goto out;
+            }
+            p++;
+            unsigned long v = strtoul(p, &end, 10);
+            if (end == p || v > REPLAY_RAW_MAX) {
+                fprintf(stderr, "%s:%lu: raw value must be 0-%d\n", path, (unsigned long)line_no, REPLAY_RAW_MAX);
+                goto out;
+            }
+            row[c] = (uint16_t)v;
+        }
+        trace->count++;
+    }
+
+    if (!have_header) {
+        fprintf(stderr, "%s: missing header\n", path);
+        goto out;
+    }
+    ret = 0;
+
+out:
+    free(line);
+    return ret;
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static int load_binary(FILE *f, const char *path, replay_trace_t *trace)
+{
+    // Version 1 không có các trường giới hạn
+    uint8_t header[REPLAY_HEADER_LEN];
+    bool ok = (fread(header, 1, REPLAY_HEADER_V1_LEN, f) == REPLAY_HEADER_V1_LEN &&
+               header[4] >= 1 && header[4] <= REPLAY_TRACE_VERSION &&
+               header[5] > 0 && header[5] <= SENSOR_MAX_COUNT);
+    if (ok && header[4] >= 2) {
+        size_t rest = REPLAY_HEADER_LEN - REPLAY_HEADER_V1_LEN;
+        ok = (fread(&header[REPLAY_HEADER_V1_LEN], 1, rest, f) == rest);
+    }
+    if (!ok) {
+        fprintf(stderr, "%s: bad binary trace header\n", path);
+        return -1;
+    }
+
+    trace->columns = header[5];
+    trace->fire_at_ms = (int32_t)get_u32(&header[8]);
+    uint32_t count = get_u32(&header[12]);
+    if (header[4] >= 2) {
+        int32_t fa_milli = (int32_t)get_u32(&header[20]);
+        trace->limits.max_time_to_detect_ms = (int32_t)get_u32(&header[16]);
+        trace->limits.max_false_alarms_per_h = (fa_milli >= 0) ? fa_milli / 1000.0 : REPLAY_NO_LIMIT;
+    }
+
+    for (uint8_t c = 0; c < trace->columns; c++) {
+        if (fread(trace->column_name[c], 1, REPLAY_TRACE_NAME_LEN, f) != REPLAY_TRACE_NAME_LEN) {
+            fprintf(stderr, "%s: truncated column names\n", path);
+            return -1;
+        }
+        trace->column_name[c][REPLAY_TRACE_NAME_LEN - 1] = '\0';
+    }
+
+    // Đọc cả khối dòng một lần rồi giải mã
+    size_t row_len = 4 + 2 * (size_t)trace->columns;
+    uint8_t *rows = malloc(row_len * (count > 0 ? count : 1));
+    trace->time_ms = malloc(sizeof(uint32_t) * (count > 0 ? count : 1));
+    trace->raw = malloc(sizeof(uint16_t) * trace->columns * (count > 0 ? count : 1));
+    if (rows == NULL || trace->time_ms == NULL || trace->raw == NULL) {
+        fprintf(stderr, "%s: out of memory\n", path);
+        free(rows);
+        return -1;
+    }
+    if (fread(rows, row_len, count, f) != count) {
+        fprintf(stderr, "%s: truncated (expected %lu rows)\n", path, (unsigned long)count);
+        free(rows);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        const uint8_t *p = rows + i * row_len;
+        trace->time_ms[i] = get_u32(p);
+        if (i > 0 && trace->time_ms[i] < trace->time_ms[i - 1]) {
+            fprintf(stderr, "%s: row %lu: decreasing time\n", path, (unsigned long)i);
+            free(rows);
+            return -1;
+        }
+        for (uint8_t c = 0; c < trace->columns; c++) {
+            uint16_t v = (uint16_t)(p[4 + 2 * c] | (p[5 + 2 * c] << 8));
+            trace->raw[(size_t)i * trace->columns + c] = (v > REPLAY_RAW_MAX) ? REPLAY_RAW_MAX : v;
+        }
+    }
+    trace->count = count;
+
+    free(rows);
+    return 0;
+}
+
+int replay_trace_load(const char *path, replay_trace_t *trace)
+{
+    memset(trace, 0, sizeof(*trace));
+    trace->fire_at_ms = REPLAY_NO_FIRE;
+    trace->limits.max_time_to_detect_ms = REPLAY_NO_LIMIT;
+    trace->limits.max_false_alarms_per_h = REPLAY_NO_LIMIT;
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    char magic[4];
+    bool binary = (fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+                   memcmp(magic, REPLAY_TRACE_MAGIC, sizeof(magic)) == 0);
+    rewind(f);
+
+    int ret = binary ? load_binary(f, path, trace) : load_csv(f, path, trace);
+    fclose(f);
+
+    if (ret == 0 && trace->count == 0) {
+        fprintf(stderr, "%s: no samples\n", path);
+        ret = -1;
+    }
+    if (ret != 0) {
+        replay_trace_free(trace);
+        return -1;
+    }
+
+    map_columns(trace, path);
+    return 0;
+}
+
+int replay_trace_save_binary(const char *path, const replay_trace_t *trace)
+{
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+
+    uint8_t header[REPLAY_HEADER_LEN] = {0};
+    memcpy(header, REPLAY_TRACE_MAGIC, 4);
+    header[4] = REPLAY_TRACE_VERSION;
+    header[5] = trace->columns;
+    put_u32(&header[8], (uint32_t)trace->fire_at_ms);
+    put_u32(&header[12], trace->count);
+    put_u32(&header[16], (uint32_t)trace->limits.max_time_to_detect_ms);
+    put_u32(&header[20], (uint32_t)((trace->limits.max_false_alarms_per_h >= 0) ?
+                                    (int32_t)(trace->limits.max_false_alarms_per_h * 1000.0 + 0.5) : REPLAY_NO_LIMIT));
+
+    bool ok = (fwrite(header, 1, sizeof(header), f) == sizeof(header));
+    for (uint8_t c = 0; ok && c < trace->columns; c++) {
+        char name[REPLAY_TRACE_NAME_LEN] = {0};
+        strncpy(name, trace->column_name[c], REPLAY_TRACE_NAME_LEN - 1);
+        ok = (fwrite(name, 1, sizeof(name), f) == sizeof(name));
+    }
+
+    uint8_t row[4 + 2 * SENSOR_MAX_COUNT];
+    size_t row_len = 4 + 2 * (size_t)trace->columns;
+    for (uint32_t i = 0; ok && i < trace->count; i++) {
+        put_u32(row, trace->time_ms[i]);
+        for (uint8_t c = 0; c < trace->columns; c++) {
+            uint16_t v = trace->raw[(size_t)i * trace->columns + c];
+            row[4 + 2 * c] = (uint8_t)v;
+            row[5 + 2 * c] = (uint8_t)(v >> 8);
+        }
+        ok = (fwrite(row, 1, row_len, f) == row_len);
+    }
+
+    if (fclose(f) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        fprintf(stderr, "%s: write failed\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+void replay_trace_free(replay_trace_t *trace)
+{
+    free(trace->time_ms);
+    free(trace->raw);
+    trace->time_ms = NULL;
+    trace->raw = NULL;
+    trace->count = 0;
+}
@@ -0,0 +1,73 @@
+#ifndef REPLAY_TRACE_H
+#define REPLAY_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sensor/sensor.h"
+
+/*
+ * Trace cảm biến đã ghi, mỗi dòng là giá trị raw (0-4095) của các cảm biến
+ * tại một thời điểm, đúng giá trị sensor_read() đưa vào
+ * sensor_process_sample(): trung bình channel ADC với cảm biến analog,
+ * 0 / 4095 với cảm biến digital (4095 = kích hoạt).
+ *
+ * CSV:
+ *   # fire_at_ms=120000            (tùy chọn: thời điểm bắt đầu cháy, không có = trace gây nhiễu)
+ *   # max_time_to_detect_ms=60000  (tùy chọn: giới hạn thời gian tới khi phát hiện)
+ *   # max_false_alarms_per_h=0     (tùy chọn: giới hạn số lần báo sai mỗi giờ không cháy)
+ *   time_ms,smoke,temperature,ir_flame,gas
+ *   0,610,1200,0,590
+ *   500,605,1201,0,594
+ *   ...
+ * Cột được khớp với registry theo tên; cảm biến không có cột nhận giá trị 0.
+ *
+ * Nhị phân (little-endian), đọc nhanh hơn nhiều với bộ trace lớn:
+ *   header  "FSTR", u8 version (2), u8 số cột, u16 0, i32 fire_at_ms (-1: không cháy), u32 số dòng,
+ *           i32 max_time_to_detect_ms (-1), i32 max_false_alarms_per_h x 1000 (-1)
+ *           (version 1: 16 bytes, không có hai trường giới hạn)
+ *   tên cột số cột x 16 bytes (NUL ở cuối)
+ *   dòng    u32 time_ms, số cột x u16 raw
+ */
+
+#define REPLAY_TRACE_MAGIC "FSTR"
+#define REPLAY_TRACE_VERSION 2
+#define REPLAY_TRACE_NAME_LEN 16
+#define REPLAY_NO_FIRE (-1)
+#define REPLAY_NO_LIMIT (-1)
+
+/**
+ * @brief Kết quả mong đợi của một trace (REPLAY_NO_LIMIT / âm: không kiểm tra)
+ */
+typedef struct {
+    int32_t max_time_to_detect_ms;              // Trace cháy phải được phát hiện trong khoảng này
+    double max_false_alarms_per_h;              // Số lần báo sai mỗi giờ không cháy
+} replay_limits_t;
+
+typedef struct {
+    uint8_t columns;                            // Số cột giá trị
+    char column_name[SENSOR_MAX_COUNT][REPLAY_TRACE_NAME_LEN];
+    int8_t sensor_column[SENSOR_MAX_COUNT];     // Cột của cảm biến registry[i], -1 nếu không có
+    int32_t fire_at_ms;                         // REPLAY_NO_FIRE với trace gây nhiễu
+    replay_limits_t limits;                     // Khai báo trong trace
+    uint32_t count;                             // Số dòng
+    uint32_t *time_ms;                          // count phần tử, tăng dần
+    uint16_t *raw;                              // count x columns phần tử
+} replay_trace_t;
+
+/**
+ * @brief Đọc trace CSV hoặc nhị phân (nhận dạng theo magic)
+ * @param path Đường dẫn file
+ * @param trace Trace đầu ra (giải phóng bằng replay_trace_free())
+ * @return 0 nếu thành công, -1 nếu lỗi (đã in lý do ra stderr)
+ */
+int replay_trace_load(const char *path, replay_trace_t *trace);
+
+/**
+ * @brief Ghi trace dạng nhị phân
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int replay_trace_save_binary(const char *path, const replay_trace_t *trace);
+
+void replay_trace_free(replay_trace_t *trace);
+
+#endif // REPLAY_TRACE_H
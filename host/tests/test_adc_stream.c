@@ -0,0 +1,156 @@
+#include <stdlib.h>
+#include "test_check.h"
+#include "esp_log.h"
+#include "hal/adc_types.h"
+#include "host_hal.h"
+#include "adc_stream/adc_stream.h"
+
+/*
+ * adc_stream_demux(): thứ tự mẫu và tách kênh với buffer TYPE1 dựng tay (đủ
+ * 8 kênh, kênh lạ, độ dài lẻ/quá frame). adc_stream_read_frame() với DMA
+ * giả lập: mọi frame trong chu kỳ được cộng dồn, trung bình phủ cả chu kỳ.
+ */
+
+static uint32_t put_result(uint8_t *buf, uint32_t n, uint8_t channel, uint16_t value)
+{
+    uint16_t word = (uint16_t)((channel << 12) | (value & 0x0FFF));
+    buf[n * 2] = (uint8_t)word;
+    buf[n * 2 + 1] = (uint8_t)(word >> 8);
+    return n + 1;
+}
+
+static void test_demux_order_all_channels(void)
+{
+    uint8_t buf[ADC_STREAM_FRAME_BYTES];
+    adc_stream_frame_t frame = { .num_channels = ADC_STREAM_MAX_CHANNELS };
+
+    // Pattern đảo thứ tự: slot i là channel 7 - i
+    for (uint8_t i = 0; i < ADC_STREAM_MAX_CHANNELS; i++) {
+        frame.channel[i] = (uint8_t)(ADC_STREAM_MAX_CHANNELS - 1 - i);
+    }
+    uint32_t n = 0;
+    for (uint16_t round = 0; round < ADC_STREAM_FRAME_RESULTS / ADC_STREAM_MAX_CHANNELS; round++) {
+        for (uint8_t i = 0; i < ADC_STREAM_MAX_CHANNELS; i++) {
+            uint8_t channel = frame.channel[i];
+            n = put_result(buf, n, channel, (uint16_t)(channel * 100 + round));
+        }
+    }
+
+    CHECK_EQ(adc_stream_demux(buf, sizeof(buf), &frame), ADC_STREAM_FRAME_RESULTS);
+    uint32_t per_slot = ADC_STREAM_FRAME_RESULTS / ADC_STREAM_MAX_CHANNELS;
+    for (uint8_t slot = 0; slot < ADC_STREAM_MAX_CHANNELS; slot++) {
+        uint8_t channel = frame.channel[slot];
+        CHECK_EQ(adc_stream_slot(&frame, channel), slot);
+        CHECK_EQ(frame.count[slot], per_slot);
+        for (uint32_t k = 0; k < per_slot; k++) {
+            CHECK_EQ(frame.samples[slot][k], channel * 100 + k);
+        }
+        uint16_t mean = 0;
+        CHECK_EQ(adc_stream_channel_mean(&frame, channel, &mean), 0);
+        CHECK_EQ(mean, channel * 100 + (per_slot - 1) / 2);
+    }
+}
+
+static void test_demux_invalid_and_length(void)
+{
+    uint8_t buf[ADC_STREAM_FRAME_BYTES + 8];
+    adc_stream_frame_t frame = { .num_channels = 3, .channel = { ADC_CHANNEL_6, ADC_CHANNEL_7, ADC_CHANNEL_5 } };
+
+    // Kênh 9 không có trong pattern; lần dùng frame trước không để lại tổng cũ
+    uint32_t n = 0;
+    n = put_result(buf, n, ADC_CHANNEL_5, 500);
+    n = put_result(buf, n, 9, 4000);
+    n = put_result(buf, n, ADC_CHANNEL_6, 600);
+    n = put_result(buf, n, ADC_CHANNEL_5, 502);
+    CHECK_EQ(adc_stream_demux(buf, n * 2, &frame), 3);
+    CHECK_EQ(adc_stream_demux(buf, n * 2, &frame), 3);
+    CHECK_EQ(frame.count[0], 1);
+    CHECK_EQ(frame.count[1], 0);
+    CHECK_EQ(frame.count[2], 2);
+    CHECK_EQ(frame.samples[2][0], 500);
+    CHECK_EQ(frame.samples[2][1], 502);
+
+    uint16_t mean = 0;
+    CHECK_EQ(adc_stream_channel_mean(&frame, ADC_CHANNEL_5, &mean), 0);
+    CHECK_EQ(mean, 501);
+    CHECK_EQ(adc_stream_channel_mean(&frame, ADC_CHANNEL_7, &mean), -1);
+    CHECK_EQ(adc_stream_channel_mean(&frame, ADC_CHANNEL_0, &mean), -1);
+
+    // Byte lẻ cuối bị bỏ, phần vượt một frame bị cắt
+    CHECK_EQ(adc_stream_demux(buf, n * 2 - 1, &frame), 2);
+    n = 0;
+    while (n < sizeof(buf) / 2) {
+        n = put_result(buf, n, ADC_CHANNEL_6, 1);
+    }
+    CHECK_EQ(adc_stream_demux(buf, sizeof(buf), &frame), ADC_STREAM_FRAME_RESULTS);
+    CHECK_EQ(frame.count[0], ADC_STREAM_FRAME_RESULTS);
+
+    CHECK_EQ(adc_stream_demux(NULL, 0, &frame), -1);
+    frame.num_channels = ADC_STREAM_MAX_CHANNELS + 1;
+    CHECK_EQ(adc_stream_demux(buf, sizeof(buf), &frame), -1);
+}
+
+static void test_read_whole_cycle(void)
+{
+    const uint8_t channels[] = { ADC_CHANNEL_6, ADC_CHANNEL_7, ADC_CHANNEL_5 };
+    const uint32_t frames_per_cycle = 500000 / (ADC_STREAM_FRAME_RESULTS * 1000000 / ADC_STREAM_SAMPLE_FREQ_HZ);
+    adc_stream_frame_t frame;
+    adc_stream_stats_t stats;
+    uint16_t mean = 0;
+
+    host_adc_set_raw(ADC_CHANNEL_6, 1000);
+    host_adc_set_raw(ADC_CHANNEL_7, 2000);
+    host_adc_set_raw(ADC_CHANNEL_5, 3000);
+    CHECK_EQ(adc_stream_init(channels, 3), 0);
+    CHECK_EQ(adc_stream_init(channels, 3), -1);
+    CHECK_EQ(adc_stream_start(), 0);
+
+    // Chu kỳ 500 ms: mọi frame hoàn tất đều được tính
+    host_clock_advance_us(500000);
+    CHECK_EQ(adc_stream_read_frame(&frame, 0), 0);
+    adc_stream_get_stats(&stats);
+    CHECK_EQ(stats.reads, 1);
+    CHECK_EQ(stats.frames, frames_per_cycle);
+    CHECK_EQ(stats.samples, frames_per_cycle * ADC_STREAM_FRAME_RESULTS);
+    CHECK_EQ(stats.invalid_samples, 0);
+    CHECK_EQ(frame.count[0] + frame.count[1] + frame.count[2], frames_per_cycle * ADC_STREAM_FRAME_RESULTS);
+    CHECK_EQ(adc_stream_channel_mean(&frame, ADC_CHANNEL_6, &mean), 0);
+    CHECK_EQ(mean, 1000);
+    CHECK_EQ(adc_stream_channel_mean(&frame, ADC_CHANNEL_5, &mean), 0);
+    CHECK_EQ(mean, 3000);
+
+    // Giá trị đổi giữa chu kỳ: trung bình của cả chu kỳ, không phải frame cuối
+    host_adc_set_raw(ADC_CHANNEL_6, 3000);
+    host_clock_advance_us(250000);
+    host_adc_set_raw(ADC_CHANNEL_6, 1000);
+    host_clock_advance_us(250000);
+    CHECK_EQ(adc_stream_read_frame(&frame, 0), 0);
+    CHECK_EQ(adc_stream_channel_mean(&frame, ADC_CHANNEL_6, &mean), 0);
+    CHECK(mean > 1950 && mean < 2050);
+    CHECK_EQ(adc_stream_channel_mean(&frame, ADC_CHANNEL_7, &mean), 0);
+    CHECK_EQ(mean, 2000);
+
+    // Không có frame mới: hết thời gian chờ
+    CHECK_EQ(adc_stream_stop(), 0);
+    host_clock_advance_us(100000);
+    CHECK_EQ(adc_stream_read_frame(&frame, 20), -1);
+
+    uint32_t read = 0;
+    uint32_t dropped = 0;
+    host_adc_get_counts(&read, &dropped);
+    CHECK_EQ(dropped, 0);
+    adc_stream_get_stats(&stats);
+    CHECK_EQ(stats.frames, read);
+}
+
+int main(void)
+{
+    host_clock_set_mode(HOST_CLOCK_VIRTUAL);
+    host_log_set_level(ESP_LOG_ERROR);
+
+    test_demux_order_all_channels();
+    test_demux_invalid_and_length();
+    test_read_whole_cycle();
+
+    _Exit(test_result());
+}
@@ -0,0 +1,64 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Kiểm tra tối giản cho các test host: mỗi test là một chương trình, lỗi
+ * được in kèm file:dòng và chương trình trả về mã khác 0 (CTest coi là fail).
+ *
+ *   CHECK(cond);
+ *   CHECK_EQ(actual, expected);
+ *   CHECK_STR_EQ(actual, expected);
+ *   return test_result();
+ */
+
+static int s_test_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            s_test_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    do { \
+        long long a_ = (long long)(actual); \
+        long long e_ = (long long)(expected); \
+        if (a_ != e_) { \
+            fprintf(stderr, "%s:%d: %s == %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_); \
+            s_test_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_STR_EQ(actual, expected) \
+    do { \
+        const char *a_ = (actual); \
+        const char *e_ = (expected); \
+        if (strcmp(a_, e_) != 0) { \
+            fprintf(stderr, "%s:%d: %s\n  got:      %s\n  expected: %s\n", __FILE__, __LINE__, #actual, a_, e_); \
+            s_test_failures++; \
+        } \
+    } while (0)
+
+/**
+ * @brief In kết quả và trả về mã thoát của test
+ */
+static inline int test_result(void)
+{
+    if (s_test_failures > 0) {
+        fflush(stdout);
+        fprintf(stderr, "%d check(s) failed\n", s_test_failures);
+        return 1;
+    }
+    printf("OK\n");
+    // Test kết thúc bằng _Exit(): stdio không tự xả
+    fflush(stdout);
+    return 0;
+}
+
+#endif // TEST_CHECK_H
@@ -0,0 +1,346 @@
+#include <stdlib.h>
+#include "test_check.h"
+#include "esp_log.h"
+#include "host_hal.h"
+#include "conn_supervisor/conn_supervisor.h"
+
+/*
+ * Máy trạng thái của conn_supervisor với link giả, thời gian truyền thẳng
+ * vào conn_supervisor_step() từng ms: jitter lần đầu nằm trong
+ * [0, start_jitter_ms] và rải đều theo seed, backoff gấp đôi trong
+ * [cap/2, cap] tới backoff_max_ms, hết thời gian kết nối, thành công thì
+ * reset backoff, đo thời gian mất kết nối, phát hiện treo có và không có bộ
+ * đếm tx, link MQTT theo link WiFi.
+ */
+
+#define MIN_MS 500
+#define MAX_MS 8000
+#define JITTER_MS 1000
+#define TIMEOUT_MS 2000
+#define STALL_MS 30000
+#define SEEDS 200
+
+// Link giả: trạng thái do test đặt, connect chuyển sang connect_result
+typedef struct {
+    conn_link_status_t status;
+    conn_link_status_t connect_result;
+    int connect_ret;
+    uint32_t connects;
+    uint32_t disconnects;
+    uint32_t rx;
+    uint32_t tx;
+} fake_link_t;
+
+static fake_link_t s_wifi;
+static fake_link_t s_mqtt;
+static uint32_t s_now;
+
+static int fake_connect(void *ctx)
+{
+    fake_link_t *f = ctx;
+    f->connects++;
+    if (f->connect_ret == 0) {
+        f->status = f->connect_result;
+    }
+    return f->connect_ret;
+}
+
+static void fake_disconnect(void *ctx)
+{
+    fake_link_t *f = ctx;
+    f->disconnects++;
+    f->status = CONN_LINK_STATUS_DOWN;
+}
+
+static conn_link_status_t fake_poll(void *ctx)
+{
+    return ((fake_link_t *)ctx)->status;
+}
+
+static uint32_t fake_rx(void *ctx)
+{
+    return ((fake_link_t *)ctx)->rx;
+}
+
+static uint32_t fake_tx(void *ctx)
+{
+    return ((fake_link_t *)ctx)->tx;
+}
+
+static const conn_policy_t s_policy = {
+    .backoff_min_ms = MIN_MS,
+    .backoff_max_ms = MAX_MS,
+    .start_jitter_ms = JITTER_MS,
+    .connect_timeout_ms = TIMEOUT_MS,
+    .stall_timeout_ms = STALL_MS,
+};
+
+/**
+ * @brief Bộ giám sát mới với link WiFi, và link MQTT phụ thuộc nếu with_mqtt
+ */
+static void setup(uint32_t seed, bool with_mqtt, bool mqtt_tx)
+{
+    conn_supervisor_init(seed);
+    memset(&s_wifi, 0, sizeof(s_wifi));
+    memset(&s_mqtt, 0, sizeof(s_mqtt));
+    s_wifi.connect_result = CONN_LINK_STATUS_PENDING;
+    s_mqtt.connect_result = CONN_LINK_STATUS_PENDING;
+    s_now = 0;
+
+    conn_policy_t wifi_policy = s_policy;
+    wifi_policy.stall_timeout_ms = 0;
+    conn_link_ops_t ops = { fake_connect, fake_disconnect, fake_poll, NULL, NULL, &s_wifi };
+    CHECK_EQ(conn_supervisor_add(CONN_LINK_WIFI, &ops, &wifi_policy, CONN_LINK_COUNT), 0);
+    if (with_mqtt) {
+        conn_link_ops_t mqtt_ops = { fake_connect, fake_disconnect, fake_poll, fake_rx,
+                                     mqtt_tx ? fake_tx : NULL, &s_mqtt };
+        CHECK_EQ(conn_supervisor_add(CONN_LINK_MQTT, &mqtt_ops, &s_policy, CONN_LINK_WIFI), 0);
+    }
+}
+
+static void step_ms(uint32_t ms)
+{
+    for (uint32_t i = 0; i < ms; i++) {
+        conn_supervisor_step(s_now++);
+    }
+}
+
+static conn_link_stats_t stats_of(conn_link_t link)
+{
+    conn_link_stats_t stats;
+    conn_supervisor_get_stats(link, &stats);
+    return stats;
+}
+
+/**
+ * @brief Chạy tới lần gọi connect kế tiếp của link giả
+ * @return Thời điểm của bước đã gọi connect (ms), UINT32_MAX nếu quá limit_ms
+ */
+static uint32_t run_to_connect(fake_link_t *f, uint32_t limit_ms)
+{
+    uint32_t start = s_now;
+    uint32_t connects = f->connects;
+    while (f->connects == connects) {
+        if (s_now - start > limit_ms) {
+            return UINT32_MAX;
+        }
+        step_ms(1);
+    }
+    return s_now - 1;
+}
+
+static void test_start_jitter(void)
+{
+    uint32_t lo = UINT32_MAX;
+    uint32_t hi = 0;
+    uint32_t sum = 0;
+
+    for (uint32_t seed = 1; seed <= SEEDS; seed++) {
+        // IDLE -> BACKOFF ở bước 0, connect sớm nhất ở bước kế tiếp
+        setup(seed, false, false);
+        uint32_t at = run_to_connect(&s_wifi, JITTER_MS + 1);
+        uint32_t wait = stats_of(CONN_LINK_WIFI).backoff_last_ms;
+        CHECK(wait <= JITTER_MS);
+        CHECK_EQ(at, (wait > 0) ? wait : 1);
+        CHECK_EQ(stats_of(CONN_LINK_WIFI).state, CONN_STATE_CONNECTING);
+        lo = (wait < lo) ? wait : lo;
+        hi = (wait > hi) ? wait : hi;
+        sum += wait;
+    }
+
+    // Các thiết bị khởi động cùng lúc không kết nối cùng lúc
+    CHECK(lo < JITTER_MS / 10);
+    CHECK(hi > JITTER_MS * 9 / 10);
+    CHECK(sum / SEEDS > JITTER_MS * 4 / 10 && sum / SEEDS < JITTER_MS * 6 / 10);
+
+    // Cùng seed thì cùng thời điểm
+    setup(42, false, false);
+    uint32_t first = run_to_connect(&s_wifi, JITTER_MS + 1);
+    setup(42, false, false);
+    CHECK_EQ(run_to_connect(&s_wifi, JITTER_MS + 1), first);
+}
+
+static void test_backoff(void)
+{
+    for (uint32_t seed = 1; seed <= 20; seed++) {
+        setup(seed, false, false);
+        s_wifi.connect_result = CONN_LINK_STATUS_DOWN;
+        CHECK(run_to_connect(&s_wifi, JITTER_MS + 1) != UINT32_MAX);
+
+        // Lần thử thất bại thứ k: chờ trong [cap/2, cap], cap = min(MIN_MS << k, MAX_MS)
+        for (uint32_t k = 1; k <= 8; k++) {
+            uint32_t cap = (MIN_MS << k < MAX_MS) ? MIN_MS << k : MAX_MS;
+            // Thất bại được phát hiện ở bước kế tiếp sau connect
+            step_ms(1);
+            uint32_t failed_at = s_now - 1;
+            CHECK_EQ(stats_of(CONN_LINK_WIFI).state, CONN_STATE_BACKOFF);
+            uint32_t backoff = stats_of(CONN_LINK_WIFI).backoff_last_ms;
+            CHECK(backoff >= cap / 2 && backoff <= cap);
+            CHECK_EQ(run_to_connect(&s_wifi, MAX_MS + 1), failed_at + backoff);
+        }
+        CHECK_EQ(stats_of(CONN_LINK_WIFI).failures, 8);
+        CHECK_EQ(stats_of(CONN_LINK_WIFI).attempts, 9);
+        CHECK_EQ(stats_of(CONN_LINK_WIFI).connects, 0);
+    }
+
+    // connect() lỗi ngay: thất bại trong cùng bước, không chờ hết thời gian
+    setup(7, false, false);
+    s_wifi.connect_ret = -1;
+    run_to_connect(&s_wifi, JITTER_MS + 1);
+    CHECK_EQ(stats_of(CONN_LINK_WIFI).state, CONN_STATE_BACKOFF);
+    CHECK_EQ(stats_of(CONN_LINK_WIFI).failures, 1);
+    CHECK_EQ(s_wifi.disconnects, 0);
+}
+
+static void test_timeout_and_recovery(void)
+{
+    setup(3, false, false);
+
+    // Kẹt ở PENDING: hủy sau đúng connect_timeout_ms
+    CHECK(run_to_connect(&s_wifi, JITTER_MS + 1) != UINT32_MAX);
+    step_ms(TIMEOUT_MS - 1);
+    CHECK_EQ(s_wifi.disconnects, 0);
+    step_ms(1);
+    CHECK_EQ(s_wifi.disconnects, 1);
+    CHECK_EQ(stats_of(CONN_LINK_WIFI).failures, 1);
+    CHECK_EQ(stats_of(CONN_LINK_WIFI).state, CONN_STATE_BACKOFF);
+
+    // Lần sau thành công
+    s_wifi.connect_result = CONN_LINK_STATUS_UP;
+    CHECK(run_to_connect(&s_wifi, 2 * MIN_MS + 1) != UINT32_MAX);
+    step_ms(1);
+    CHECK_EQ(stats_of(CONN_LINK_WIFI).state, CONN_STATE_UP);
+    CHECK_EQ(stats_of(CONN_LINK_WIFI).connects, 1);
+    CHECK_EQ(stats_of(CONN_LINK_WIFI).reconnects, 0);
+    CHECK_EQ(stats_of(CONN_LINK_WIFI).down_total_ms, 0);
+
+    // Mất kết nối: backoff bắt đầu lại từ [MIN_MS/2, MIN_MS]
+    step_ms(5000);
+    s_wifi.status = CONN_LINK_STATUS_DOWN;
+    uint32_t lost_at = s_now;
+    step_ms(1);
+    CHECK_EQ(stats_of(CONN_LINK_WIFI).drops, 1);
+    CHECK_EQ(s_wifi.disconnects, 2);
+    uint32_t backoff = stats_of(CONN_LINK_WIFI).backoff_last_ms;
+    CHECK(backoff >= MIN_MS / 2 && backoff <= MIN_MS);
+
+    // Thời gian mất kết nối đang diễn ra được cộng khi đọc thống kê
+    step_ms(100);
+    CHECK_EQ(stats_of(CONN_LINK_WIFI).down_total_ms, s_now - 1 - lost_at);
+
+    CHECK_EQ(run_to_connect(&s_wifi, MIN_MS + 1), lost_at + backoff);
+    step_ms(1);
+    conn_link_stats_t stats = stats_of(CONN_LINK_WIFI);
+    CHECK_EQ(stats.state, CONN_STATE_UP);
+    CHECK_EQ(stats.reconnects, 1);
+    CHECK_EQ(stats.reconnect_last_ms, s_now - 1 - lost_at);
+    CHECK_EQ(stats.reconnect_max_ms, stats.reconnect_last_ms);
+    CHECK_EQ(stats.down_total_ms, stats.reconnect_last_ms);
+
+    // Tầng dưới tự lên lại trong lúc chờ: UP ngay, không gọi connect
+    s_wifi.status = CONN_LINK_STATUS_DOWN;
+    step_ms(1);
+    s_wifi.status = CONN_LINK_STATUS_UP;
+    uint32_t connects = s_wifi.connects;
+    step_ms(1);
+    CHECK_EQ(stats_of(CONN_LINK_WIFI).state, CONN_STATE_UP);
+    CHECK_EQ(stats_of(CONN_LINK_WIFI).reconnects, 2);
+    CHECK_EQ(s_wifi.connects, connects);
+}
+
+/**
+ * @brief Đưa cả hai link lên UP
+ */
+static void bring_up(void)
+{
+    s_wifi.connect_result = CONN_LINK_STATUS_UP;
+    s_mqtt.connect_result = CONN_LINK_STATUS_UP;
+    for (uint32_t t = 0; t < 2 * JITTER_MS + 10 && stats_of(CONN_LINK_MQTT).state != CONN_STATE_UP; t++) {
+        step_ms(1);
+    }
+    CHECK_EQ(stats_of(CONN_LINK_WIFI).state, CONN_STATE_UP);
+    CHECK_EQ(stats_of(CONN_LINK_MQTT).state, CONN_STATE_UP);
+}
+
+static void test_dependency(void)
+{
+    setup(5, true, true);
+
+    // MQTT chờ ở IDLE tới khi WiFi UP
+    step_ms(JITTER_MS + 1);
+    CHECK_EQ(stats_of(CONN_LINK_WIFI).state, CONN_STATE_CONNECTING);
+    CHECK_EQ(stats_of(CONN_LINK_MQTT).state, CONN_STATE_IDLE);
+    CHECK_EQ(s_mqtt.connects, 0);
+    s_wifi.status = CONN_LINK_STATUS_UP;
+    bring_up();
+    CHECK_EQ(s_mqtt.connects, 1);
+
+    // Mất WiFi: MQTT bị ngắt cùng bước và về IDLE
+    s_wifi.status = CONN_LINK_STATUS_DOWN;
+    step_ms(1);
+    CHECK_EQ(stats_of(CONN_LINK_MQTT).state, CONN_STATE_IDLE);
+    CHECK_EQ(stats_of(CONN_LINK_MQTT).drops, 1);
+    CHECK_EQ(s_mqtt.disconnects, 1);
+
+    // WiFi lên lại thì MQTT kết nối lại
+    bring_up();
+    CHECK_EQ(stats_of(CONN_LINK_MQTT).reconnects, 1);
+    CHECK_EQ(stats_of(CONN_LINK_WIFI).reconnects, 1);
+}
+
+static void test_stall(void)
+{
+    // Có bộ đếm tx: không gửi gì thì im lặng không phải treo
+    setup(9, true, true);
+    bring_up();
+    step_ms(3 * STALL_MS);
+    CHECK_EQ(stats_of(CONN_LINK_MQTT).stalls, 0);
+
+    // Gửi gói cần phản hồi, có phản hồi trước hạn
+    s_mqtt.tx++;
+    step_ms(STALL_MS - 1);
+    s_mqtt.rx++;
+    step_ms(STALL_MS);
+    CHECK_EQ(stats_of(CONN_LINK_MQTT).stalls, 0);
+
+    // Không có phản hồi: treo đúng sau STALL_MS kể từ gói đầu chưa được phản hồi
+    s_mqtt.tx++;
+    step_ms(1);
+    s_mqtt.tx++;
+    step_ms(STALL_MS - 1);
+    CHECK_EQ(stats_of(CONN_LINK_MQTT).stalls, 0);
+    step_ms(1);
+    conn_link_stats_t stats = stats_of(CONN_LINK_MQTT);
+    CHECK_EQ(stats.stalls, 1);
+    CHECK_EQ(stats.drops, 1);
+    CHECK_EQ(stats.state, CONN_STATE_BACKOFF);
+    CHECK_EQ(s_mqtt.disconnects, 1);
+    CHECK_EQ(stats_of(CONN_LINK_WIFI).state, CONN_STATE_UP);
+
+    // Kết nối lại rồi hoạt động bình thường
+    bring_up();
+    CHECK_EQ(stats_of(CONN_LINK_MQTT).reconnects, 1);
+
+    // Không có bộ đếm tx: không nhận gì trong STALL_MS là treo
+    setup(11, true, false);
+    bring_up();
+    step_ms(STALL_MS - 10);
+    s_mqtt.rx++;
+    step_ms(STALL_MS - 1);
+    CHECK_EQ(stats_of(CONN_LINK_MQTT).stalls, 0);
+    step_ms(10);
+    CHECK_EQ(stats_of(CONN_LINK_MQTT).stalls, 1);
+}
+
+int main(void)
+{
+    host_log_set_level(ESP_LOG_NONE);
+
+    test_start_jitter();
+    test_backoff();
+    test_timeout_and_recovery();
+    test_dependency();
+    test_stall();
+
+    _Exit(test_result());
+}
@@ -0,0 +1,162 @@
+#include <stdlib.h>
+#include "test_check.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/ledc.h"
+#include "hal/adc_types.h"
+#include "host_hal.h"
+#include "boot_timeline/boot_timeline.h"
+
+/*
+ * Kịch bản firmware đầy đủ (app_main) trên đồng hồ ảo: khởi động, kết nối,
+ * cháy ở 8 s, dập ở 14 s. Kiểm tra mốc khởi động, còi và bản tin cảnh báo.
+ * Sau đó gửi lệnh điều khiển qua broker: lệnh gửi trong lúc test_alarm đang
+ * kêu được xử lý ngay, còi tự tắt sau TEST_ALARM_DURATION_MS.
+ */
+
+#define FIRE_AT_US   8000000
+#define CLEAR_AT_US 14000000
+#define END_US      20000000
+#define STEP_US        50000
+#define COMMAND_WINDOW_US 300000            // Lệnh phải có hiệu lực trong khoảng này
+#define TEST_ALARM_US 3000000               // TEST_ALARM_DURATION_MS của main.c
+
+#define AMBIENT_RAW 600
+#define FIRE_RAW 3800
+
+extern void app_main(void);
+
+static uint32_t s_alerts;
+static int64_t s_first_alert_us = -1;
+static uint32_t s_diags;
+
+static void main_task(void *arg)
+{
+    (void)arg;
+    app_main();
+    vTaskDelete(NULL);
+}
+
+static void on_publish(const char *topic, const uint8_t *data, int len, int qos, bool retain, void *ctx)
+{
+    (void)data;
+    (void)len;
+    (void)retain;
+    (void)ctx;
+
+    if (strncmp(topic, "fire_system/alert", strlen("fire_system/alert")) == 0) {
+        CHECK(qos >= 1);
+        if (s_alerts++ == 0) {
+            s_first_alert_us = host_clock_now_us();
+        }
+    } else if (strcmp(topic, "fire_system/diag") == 0) {
+        s_diags++;
+    }
+}
+
+static void set_sensors(uint16_t raw)
+{
+    host_adc_set_raw(ADC_CHANNEL_6, raw);
+    host_adc_set_raw(ADC_CHANNEL_5, raw);
+}
+
+/**
+ * @brief Cho đồng hồ tiến tới until_us, trả về duty còi lớn nhất trong khoảng đó
+ */
+static uint32_t run_until(int64_t until_us)
+{
+    uint32_t max_duty = 0;
+    while (host_clock_now_us() < until_us) {
+        host_clock_advance_us(STEP_US);
+        uint32_t duty = host_ledc_get_duty(LEDC_CHANNEL_0);
+        if (duty > max_duty) {
+            max_duty = duty;
+        }
+    }
+    return max_duty;
+}
+
+static void send_command(const char *name)
+{
+    char payload[64];
+    int len = snprintf(payload, sizeof(payload), "{\"command\":\"%s\"}", name);
+    CHECK_EQ(host_mqtt_inject("fire_system/control", payload, len), 0);
+}
+
+/**
+ * @brief Lệnh trong lúc test_alarm đang kêu không phải chờ hết thời gian còi
+ */
+static void check_commands_during_test_alarm(void)
+{
+    // buzzer_off ngay sau test_alarm: còi tắt trong vòng một cửa sổ, không đợi 3 s
+    send_command("test_alarm");
+    CHECK(run_until(host_clock_now_us() + COMMAND_WINDOW_US) > 0);
+    send_command("buzzer_off");
+    run_until(host_clock_now_us() + COMMAND_WINDOW_US);
+    CHECK_EQ(run_until(host_clock_now_us() + COMMAND_WINDOW_US), 0);
+
+    // Timer của test_alarm đã bị thay thế không bật lại còi
+    CHECK_EQ(run_until(host_clock_now_us() + TEST_ALARM_US), 0);
+
+    // trace_report được trả lời ngay khi còi test vẫn kêu, còi tự tắt sau 3 s
+    int64_t start_us = host_clock_now_us();
+    send_command("test_alarm");
+    run_until(start_us + COMMAND_WINDOW_US);
+    uint32_t diags = s_diags;
+    send_command("trace_report");
+    CHECK(run_until(start_us + 2 * COMMAND_WINDOW_US) > 0);
+    CHECK_EQ(s_diags, diags + 1);
+    CHECK(run_until(start_us + TEST_ALARM_US - COMMAND_WINDOW_US) > 0);
+    run_until(start_us + TEST_ALARM_US + COMMAND_WINDOW_US);
+    CHECK_EQ(run_until(start_us + TEST_ALARM_US + 2 * COMMAND_WINDOW_US), 0);
+}
+
+int main(void)
+{
+    host_clock_set_mode(HOST_CLOCK_VIRTUAL);
+    host_log_set_level(1);
+    host_random_seed(1);
+    host_mqtt_set_publish_hook(on_publish, NULL);
+    set_sensors(AMBIENT_RAW);
+    host_adc_set_raw(ADC_CHANNEL_7, AMBIENT_RAW);
+
+    if (xTaskCreatePinnedToCore(main_task, "main", 3584, NULL, 1, NULL, 0) != pdPASS) {
+        fprintf(stderr, "Failed to start main task\n");
+        return 1;
+    }
+
+    // Khởi động: mọi mốc đều đạt, khác 0 và theo thứ tự
+    CHECK_EQ(run_until(FIRE_AT_US), 0);
+    int64_t prev_us = 0;
+    for (int stage = 0; stage < BOOT_STAGE_COUNT; stage++) {
+        int64_t t = boot_timeline_get_us((boot_stage_t)stage);
+        CHECK(t > 0);
+        CHECK(t >= prev_us);
+        prev_us = t;
+    }
+    host_mqtt_stats_t mqtt;
+    host_mqtt_get_stats(&mqtt);
+    CHECK_EQ(mqtt.connects, 1);
+    CHECK_EQ(s_alerts, 0);
+
+    // Cháy: còi kêu, cảnh báo được gửi trong vòng 2 s (lọc + debounce ở chu kỳ 500 ms)
+    set_sensors(FIRE_RAW);
+    CHECK(run_until(CLEAR_AT_US) > 0);
+    CHECK(s_alerts > 0);
+    printf("first alert %.3f s after fire\n", (s_first_alert_us - FIRE_AT_US) / 1e6);
+    CHECK(s_first_alert_us >= FIRE_AT_US && s_first_alert_us < FIRE_AT_US + 2000000);
+
+    // Dập: còi tắt
+    set_sensors(AMBIENT_RAW);
+    run_until(CLEAR_AT_US + 2000000);
+    CHECK_EQ(run_until(END_US), 0);
+
+    check_commands_during_test_alarm();
+
+    host_mqtt_get_stats(&mqtt);
+    CHECK_EQ(mqtt.connects, 1);
+    CHECK(mqtt.acked > 0);
+
+    // Các task vẫn đang chạy: kết thúc cả tiến trình
+    _Exit(test_result());
+}
@@ -0,0 +1,306 @@
+#include <stdlib.h>
+#include <string.h>
+#include "test_check.h"
+#include "esp_log.h"
+#include "host_hal.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "wifi/wifi.h"
+#include "mqtt/mqtt.h"
+#include "mqtt_egress/mqtt_egress.h"
+#include "store_forward/store_forward.h"
+
+/*
+ * mqtt_egress: hàng đợi telemetry đầy thì bỏ bản cũ nhất ngay trong task
+ * gọi, không ghi flash; cảnh báo không bao giờ bị bỏ khi còn chỗ trong vùng
+ * tràn; khi mất kết nối chỉ task egress chuyển message sang
+ * store-and-forward, đúng thứ tự. Qua broker loopback với độ trễ xác nhận
+ * khác nhau: độ trễ cảnh báo đo được khớp độ trễ của broker kể cả khi có
+ * telemetry cùng lúc, và PUBCOMP tới trước khi publish() trả về không bị
+ * các PUBACK telemetry tới cùng lúc đẩy mất. Cảnh báo gửi lại từ flash được
+ * theo dõi như cảnh báo mới và chỉ rời flash khi broker xác nhận.
+ */
+
+#define STEP_US 10000
+#define CONNECT_TIMEOUT_US 5000000
+#define SLOW_ACK_MS 10000                   // Lâu hơn MQTT_EGRESS_ALERT_ACK_TIMEOUT_MS
+#define EARLY_TELEMETRY 8                   // PUBACK tới cùng lúc với PUBCOMP của cảnh báo
+#define ALERTS (MQTT_EGRESS_ALERT_DEPTH + MQTT_EGRESS_ALERT_OVERFLOW_DEPTH)
+#define REPLAY_ACK_MS 100
+
+static wifi_manager_t s_wifi;
+static mqtt_config_t s_mqtt;
+static int s_telemetry_ids[EARLY_TELEMETRY];
+static int s_num_telemetry_ids;
+static int s_alert_publishes;
+
+static void enqueue_id(mqtt_egress_topic_t topic, uint32_t id)
+{
+    CHECK_EQ(mqtt_egress_enqueue(topic, (const uint8_t *)&id, sizeof(id)), 0);
+}
+
+/**
+ * @brief Lấy hết bản ghi của một log, so với id first..last
+ */
+static void expect_spilled(saf_log_id_t expected_log, uint8_t topic, uint32_t first, uint32_t last)
+{
+    uint8_t buf[SAF_RECORD_MAX_LEN];
+    saf_log_id_t log;
+    uint8_t kind;
+    uint16_t len;
+
+    for (uint32_t id = first; id <= last; id++) {
+        CHECK_EQ(saf_peek(&log, &kind, buf, sizeof(buf), &len), 0);
+        CHECK_EQ(log, expected_log);
+        CHECK_EQ(kind, topic);
+        CHECK_EQ(len, sizeof(id));
+        uint32_t got;
+        memcpy(&got, buf, sizeof(got));
+        CHECK_EQ(got, id);
+        CHECK_EQ(saf_pop(log), 0);
+    }
+    CHECK_EQ(saf_pending(expected_log), 0);
+}
+
+static void test_overflow_offline(void)
+{
+    mqtt_egress_stats_t stats;
+
+    host_nvs_reset();
+    CHECK_EQ(saf_init(), 0);
+    CHECK_EQ(mqtt_init(&s_mqtt, "mqtt://broker.local", NULL, NULL, "test", false), 0);
+    CHECK_EQ(mqtt_egress_init(&s_mqtt), 0);
+
+    // Task egress chưa chạy: vượt độ sâu hàng đợi, telemetry cũ nhất bị thay, không ghi flash
+    uint32_t flash_before = host_flash_programmed_bytes();
+    for (uint32_t id = 1; id <= MQTT_EGRESS_TELEMETRY_DEPTH + 2; id++) {
+        enqueue_id(MQTT_EGRESS_TOPIC_SENSOR_DATA_BIN, id);
+    }
+    // Cảnh báo vượt độ sâu hàng đợi vào vùng tràn, không bản nào bị bỏ
+    for (uint32_t id = 1; id <= ALERTS; id++) {
+        enqueue_id(MQTT_EGRESS_TOPIC_ALERT_BIN, id);
+    }
+    CHECK_EQ(host_flash_programmed_bytes(), flash_before);
+
+    mqtt_egress_get_stats(MQTT_EGRESS_TELEMETRY, &stats);
+    CHECK_EQ(stats.enqueued, MQTT_EGRESS_TELEMETRY_DEPTH + 2);
+    CHECK_EQ(stats.dropped, 2);
+    CHECK_EQ(stats.spilled, 0);
+    mqtt_egress_get_stats(MQTT_EGRESS_ALERT, &stats);
+    CHECK_EQ(stats.enqueued, ALERTS);
+    CHECK_EQ(stats.dropped, 0);
+    CHECK_EQ(saf_pending(SAF_LOG_ALERT) + saf_pending(SAF_LOG_TELEMETRY), 0);
+
+    // Cả vùng tràn đầy: chỉ bản mới bị từ chối, không bản cũ nào bị thay
+    uint32_t extra = ALERTS + 1;
+    CHECK_EQ(mqtt_egress_enqueue(MQTT_EGRESS_TOPIC_ALERT_BIN, (const uint8_t *)&extra, sizeof(extra)), -1);
+    mqtt_egress_get_stats(MQTT_EGRESS_ALERT, &stats);
+    CHECK_EQ(stats.dropped, 1);
+
+    // Không có kết nối: task egress lưu các bản còn lại theo thứ tự
+    CHECK(xTaskCreate(mqtt_egress_task, "mqtt_egress_task", 4096, NULL, 5, NULL) == pdPASS);
+    host_clock_advance_us(MQTT_EGRESS_DRAIN_INTERVAL_MS * 1000);
+
+    mqtt_egress_get_stats(MQTT_EGRESS_ALERT, &stats);
+    CHECK_EQ(stats.spilled, ALERTS);
+    mqtt_egress_get_stats(MQTT_EGRESS_TELEMETRY, &stats);
+    CHECK_EQ(stats.spilled, MQTT_EGRESS_TELEMETRY_DEPTH);
+    CHECK_EQ(saf_pending(SAF_LOG_ALERT), ALERTS);
+    CHECK_EQ(saf_pending(SAF_LOG_TELEMETRY), MQTT_EGRESS_TELEMETRY_DEPTH);
+    expect_spilled(SAF_LOG_ALERT, MQTT_EGRESS_TOPIC_ALERT_BIN, 1, ALERTS);
+    expect_spilled(SAF_LOG_TELEMETRY, MQTT_EGRESS_TOPIC_SENSOR_DATA_BIN, 3, MQTT_EGRESS_TELEMETRY_DEPTH + 2);
+}
+
+static void run_for(int64_t us)
+{
+    for (int64_t t = 0; t < us; t += STEP_US) {
+        host_clock_advance_us(STEP_US);
+    }
+}
+
+static bool wait_until(bool (*ready)(void))
+{
+    for (int64_t t = 0; t < CONNECT_TIMEOUT_US && !ready(); t += STEP_US) {
+        host_clock_advance_us(STEP_US);
+    }
+    return ready();
+}
+
+static bool wifi_up(void)
+{
+    return wifi_is_connected(&s_wifi);
+}
+
+static bool mqtt_up(void)
+{
+    return mqtt_is_connected(&s_mqtt);
+}
+
+static void test_broker_latency(void)
+{
+    const uint32_t ack_ms[] = { 20, 80, 300 };
+    telemetry_alert_stats_t alert;
+    mqtt_egress_stats_t stats;
+
+    CHECK_EQ(wifi_init(&s_wifi, "test", "password"), 0);
+    CHECK_EQ(wifi_start_connect(&s_wifi), 0);
+    CHECK(wait_until(wifi_up));
+    CHECK_EQ(mqtt_connect(&s_mqtt), 0);
+    CHECK(wait_until(mqtt_up));
+
+    // Mỗi cảnh báo đi cùng một hàng đợi telemetry đầy: cảnh báo vẫn publish trước
+    for (size_t k = 0; k < sizeof(ack_ms) / sizeof(ack_ms[0]); k++) {
+        host_mqtt_set_delays_ms(50, ack_ms[k]);
+        for (uint32_t id = 0; id < MQTT_EGRESS_TELEMETRY_DEPTH; id++) {
+            enqueue_id(MQTT_EGRESS_TOPIC_SENSOR_DATA_BIN, 100 + id);
+        }
+        enqueue_id(MQTT_EGRESS_TOPIC_ALERT_BIN, 100 + (uint32_t)k);
+        run_for((int64_t)ack_ms[k] * 1000 + 2 * STEP_US);
+
+        mqtt_egress_get_alert_stats(&alert);
+        CHECK_EQ(alert.confirmed, k + 1);
+        CHECK_EQ(alert.tracked, 0);
+        CHECK(alert.latency.last_us >= ack_ms[k] * 1000);
+        CHECK(alert.latency.last_us < ack_ms[k] * 1000 + STEP_US);
+        CHECK(alert.ack_max_us >= ack_ms[k] * 1000);
+        CHECK(alert.publish_max_us < STEP_US);
+    }
+    CHECK_EQ(alert.retransmits, 0);
+    CHECK_EQ(alert.latency.count, 3);
+    // Bucket i chứa mẫu < 1 ms << i: 20 ms, 80 ms, 300 ms
+    CHECK_EQ(alert.latency.bucket[5], 1);
+    CHECK_EQ(alert.latency.bucket[7], 1);
+    CHECK_EQ(alert.latency.bucket[9], 1);
+    mqtt_egress_get_stats(MQTT_EGRESS_TELEMETRY, &stats);
+    CHECK_EQ(stats.sent, 3 * MQTT_EGRESS_TELEMETRY_DEPTH);
+}
+
+/**
+ * @brief Giả lập PUBCOMP của cảnh báo cùng loạt PUBACK telemetry tới trước khi publish() trả về
+ */
+static void on_publish(const char *topic, const uint8_t *data, int len, int qos, bool retain, void *ctx)
+{
+    (void)data;
+    (void)len;
+    (void)qos;
+    (void)retain;
+    (void)ctx;
+    host_mqtt_stats_t mqtt;
+
+    host_mqtt_get_stats(&mqtt);
+    if (strcmp(topic, "fire_system/sensor/data/bin") == 0 && s_num_telemetry_ids < EARLY_TELEMETRY) {
+        s_telemetry_ids[s_num_telemetry_ids++] = mqtt.last_msg_id;
+    } else if (strcmp(topic, "fire_system/alert/bin") == 0) {
+        mqtt_egress_on_published(mqtt.last_msg_id);
+        for (int i = 0; i < s_num_telemetry_ids; i++) {
+            mqtt_egress_on_published(s_telemetry_ids[i]);
+        }
+    }
+}
+
+static void test_early_ack(void)
+{
+    telemetry_alert_stats_t before;
+    telemetry_alert_stats_t alert;
+
+    // Broker chậm: mọi xác nhận thật tới sau hạn gửi lại cảnh báo
+    host_mqtt_set_delays_ms(50, SLOW_ACK_MS);
+    host_mqtt_set_publish_hook(on_publish, NULL);
+    for (uint32_t id = 0; id < EARLY_TELEMETRY; id++) {
+        enqueue_id(MQTT_EGRESS_TOPIC_SENSOR_DATA_BIN, 200 + id);
+        run_for(STEP_US);
+    }
+    CHECK_EQ(s_num_telemetry_ids, EARLY_TELEMETRY);
+
+    mqtt_egress_get_alert_stats(&before);
+    enqueue_id(MQTT_EGRESS_TOPIC_ALERT_BIN, 200);
+    run_for(STEP_US);
+    mqtt_egress_get_alert_stats(&alert);
+    CHECK_EQ(alert.confirmed, before.confirmed + 1);
+    CHECK_EQ(alert.tracked, 0);
+
+    // Xác nhận thật tới muộn không được tính lại, không gửi lại
+    run_for((int64_t)SLOW_ACK_MS * 1000 + STEP_US);
+    host_mqtt_set_publish_hook(NULL, NULL);
+    mqtt_egress_get_alert_stats(&alert);
+    CHECK_EQ(alert.confirmed, before.confirmed + 1);
+    CHECK_EQ(alert.retransmits, 0);
+    CHECK_EQ(alert.expired, 0);
+}
+
+static void count_alerts(const char *topic, const uint8_t *data, int len, int qos, bool retain, void *ctx)
+{
+    (void)data;
+    (void)len;
+    (void)qos;
+    (void)retain;
+    (void)ctx;
+    if (strcmp(topic, "fire_system/alert/bin") == 0) {
+        s_alert_publishes++;
+    }
+}
+
+static void test_replay_tracked(void)
+{
+    telemetry_alert_stats_t before;
+    telemetry_alert_stats_t alert;
+
+    // Hai cảnh báo còn trên flash sau lần mất kết nối trước
+    for (uint32_t id = 300; id < 302; id++) {
+        CHECK_EQ(saf_append(SAF_LOG_ALERT, MQTT_EGRESS_TOPIC_ALERT_BIN, &id, sizeof(id)), 0);
+    }
+    mqtt_egress_get_alert_stats(&before);
+    host_mqtt_set_delays_ms(50, REPLAY_ACK_MS);
+    host_mqtt_set_publish_hook(count_alerts, NULL);
+    s_alert_publishes = 0;
+
+    // Mỗi lần một bản: đã publish nhưng chưa xác nhận thì vẫn còn trên flash
+    run_for((int64_t)MQTT_EGRESS_DRAIN_INTERVAL_MS * 1000);
+    CHECK_EQ(s_alert_publishes, 1);
+    CHECK_EQ(saf_pending(SAF_LOG_ALERT), 2);
+    mqtt_egress_get_alert_stats(&alert);
+    CHECK_EQ(alert.tracked, 1);
+    CHECK_EQ(alert.confirmed, before.confirmed);
+
+    run_for(2 * (REPLAY_ACK_MS * 1000 + STEP_US));
+    CHECK_EQ(s_alert_publishes, 2);
+    CHECK_EQ(saf_pending(SAF_LOG_ALERT), 0);
+    mqtt_egress_get_alert_stats(&alert);
+    CHECK_EQ(alert.tracked, 0);
+    CHECK_EQ(alert.confirmed, before.confirmed + 2);
+    CHECK_EQ(alert.latency.count, before.latency.count + 2);
+    CHECK(alert.latency.last_us >= REPLAY_ACK_MS * 1000);
+
+    // Xác nhận bị trễ quá hạn: gửi lại, bản ghi chưa rời flash
+    uint32_t id = 302;
+    CHECK_EQ(saf_append(SAF_LOG_ALERT, MQTT_EGRESS_TOPIC_ALERT_BIN, &id, sizeof(id)), 0);
+    host_mqtt_set_delays_ms(50, SLOW_ACK_MS);
+    run_for((int64_t)(MQTT_EGRESS_DRAIN_INTERVAL_MS + MQTT_EGRESS_ALERT_ACK_TIMEOUT_MS) * 1000);
+    host_mqtt_set_delays_ms(50, REPLAY_ACK_MS);
+    mqtt_egress_get_alert_stats(&alert);
+    CHECK_EQ(alert.retransmits, before.retransmits + 1);
+    CHECK_EQ(saf_pending(SAF_LOG_ALERT), 1);
+
+    // Lần gửi lại kế tiếp được xác nhận: bản ghi rời flash, không bị lưu lại
+    run_for((int64_t)(MQTT_EGRESS_ALERT_ACK_TIMEOUT_MS + REPLAY_ACK_MS) * 1000 + 2 * STEP_US);
+    host_mqtt_set_publish_hook(NULL, NULL);
+    mqtt_egress_get_alert_stats(&alert);
+    CHECK_EQ(alert.retransmits, before.retransmits + 2);
+    CHECK_EQ(alert.confirmed, before.confirmed + 3);
+    CHECK_EQ(alert.expired, before.expired);
+    CHECK_EQ(saf_pending(SAF_LOG_ALERT), 0);
+    CHECK_EQ(s_alert_publishes, 5);
+}
+
+int main(void)
+{
+    host_clock_set_mode(HOST_CLOCK_VIRTUAL);
+    host_log_set_level(ESP_LOG_NONE);
+
+    test_overflow_offline();
+    test_broker_latency();
+    test_early_ack();
+    test_replay_tracked();
+
+    _Exit(test_result());
+}
@@ -0,0 +1,165 @@
+#include <stdlib.h>
+#include <string.h>
+#include "test_check.h"
+#include "esp_log.h"
+#include "host_hal.h"
+#include "wifi/wifi.h"
+#include "mqtt/mqtt.h"
+
+/*
+ * Đường nhận MQTT qua broker loopback: với buffer của firmware
+ * (MQTT_RX_BUFFER_SIZE) lệnh vừa block đến trong một MQTT_EVENT_DATA; khi
+ * broker giả chia fragment nhỏ hơn (FRAGMENT_SIZE), message đến thành nhiều
+ * MQTT_EVENT_DATA và được ghép nguyên vẹn vào một block của pool; message
+ * không vừa block bị bỏ và đếm; hết block thì message bị bỏ, block được trả
+ * lại thì nhận tiếp được.
+ */
+
+#define STEP_US 10000
+#define CONNECT_TIMEOUT_US 5000000
+#define FRAGMENT_SIZE 256   // Nhỏ hơn block để ép đường ghép fragment
+
+static wifi_manager_t s_wifi;
+static mqtt_config_t s_mqtt;
+static char s_payload[MQTT_PAYLOAD_MAX_LEN + 1];
+
+static bool wait_until(bool (*ready)(void))
+{
+    for (int64_t t = 0; t < CONNECT_TIMEOUT_US; t += STEP_US) {
+        if (ready()) {
+            return true;
+        }
+        host_clock_advance_us(STEP_US);
+    }
+    return ready();
+}
+
+static bool wifi_up(void)
+{
+    return wifi_is_connected(&s_wifi);
+}
+
+static bool mqtt_up(void)
+{
+    return mqtt_is_connected(&s_mqtt);
+}
+
+static void fill_payload(int len, int seed)
+{
+    for (int i = 0; i < len; i++) {
+        s_payload[i] = (char)('a' + (i * 7 + seed) % 26);
+    }
+}
+
+/**
+ * @brief Gửi lệnh dài len qua broker rồi chờ các fragment được xử lý
+ */
+static void inject(int len, int seed)
+{
+    fill_payload(len, seed);
+    CHECK_EQ(host_mqtt_inject(MQTT_TOPIC_CONTROL, s_payload, len), 0);
+    host_clock_advance_us(STEP_US);
+}
+
+static void expect_message(int len, int seed)
+{
+    mqtt_message_t *msg = NULL;
+
+    CHECK(mqtt_receive_message(&s_mqtt, &msg, 1));
+    if (msg == NULL) {
+        return;
+    }
+    fill_payload(len, seed);
+    CHECK_STR_EQ(msg->topic, MQTT_TOPIC_CONTROL);
+    CHECK_EQ(msg->payload_len, len);
+    CHECK(memcmp(msg->payload, s_payload, len) == 0);
+    CHECK_EQ(msg->payload[len], '\0');
+    mqtt_release_message(&s_mqtt, msg);
+}
+
+static void test_single_event(void)
+{
+    mqtt_rx_stats_t stats;
+
+    // Buffer của firmware: lệnh dài nhất vừa block không bị chia
+    inject(MQTT_PAYLOAD_MAX_LEN - 1, 0);
+    expect_message(MQTT_PAYLOAD_MAX_LEN - 1, 0);
+    mqtt_get_rx_stats(&s_mqtt, &stats);
+    CHECK_EQ(stats.received, 1);
+    CHECK_EQ(stats.fragmented, 0);
+}
+
+static void test_fragmented_receive(void)
+{
+    // Fragment đầu chia buffer với header và topic
+    const int first_room = FRAGMENT_SIZE - 9 - (int)strlen(MQTT_TOPIC_CONTROL);
+    const int sizes[] = { 20, first_room, first_room + 1, 300, MQTT_PAYLOAD_MAX_LEN - 1 };
+    const int n = sizeof(sizes) / sizeof(sizes[0]);
+    mqtt_rx_stats_t before;
+    mqtt_rx_stats_t stats;
+
+    host_mqtt_set_fragment_size(FRAGMENT_SIZE);
+    mqtt_get_rx_stats(&s_mqtt, &before);
+
+    for (int k = 0; k < n; k++) {
+        inject(sizes[k], k);
+        expect_message(sizes[k], k);
+    }
+    mqtt_get_rx_stats(&s_mqtt, &stats);
+    CHECK_EQ(stats.received - before.received, n);
+    CHECK_EQ(stats.fragmented - before.fragmented, n - 2);
+    CHECK_EQ(stats.incomplete, 0);
+
+    // Không vừa block: bỏ cả message, không cắt cụt
+    inject(MQTT_PAYLOAD_MAX_LEN, 0);
+    inject(MQTT_PAYLOAD_MAX_LEN + 200, 0);
+    mqtt_get_rx_stats(&s_mqtt, &stats);
+    CHECK_EQ(stats.oversize, 2);
+    CHECK_EQ(stats.received - before.received, n);
+    CHECK_EQ(stats.incomplete, 0);
+}
+
+static void test_pool_exhausted(void)
+{
+    mqtt_rx_stats_t before;
+    mqtt_rx_stats_t stats;
+
+    mqtt_get_rx_stats(&s_mqtt, &before);
+
+    // Không trả block: message thứ MQTT_RX_POOL_SIZE + 1 bị bỏ
+    for (int k = 0; k <= MQTT_RX_POOL_SIZE; k++) {
+        inject(400, 100 + k);
+    }
+    mqtt_get_rx_stats(&s_mqtt, &stats);
+    CHECK_EQ(stats.received - before.received, MQTT_RX_POOL_SIZE);
+    CHECK_EQ(stats.pool_exhausted - before.pool_exhausted, 1);
+    CHECK_EQ(stats.incomplete, 0);
+    for (int k = 0; k < MQTT_RX_POOL_SIZE; k++) {
+        expect_message(400, 100 + k);
+    }
+
+    // Block đã được trả về pool
+    inject(400, 200);
+    expect_message(400, 200);
+}
+
+int main(void)
+{
+    host_clock_set_mode(HOST_CLOCK_VIRTUAL);
+    host_log_set_level(ESP_LOG_NONE);
+
+    CHECK_EQ(wifi_init(&s_wifi, "test", "password"), 0);
+    CHECK_EQ(wifi_start_connect(&s_wifi), 0);
+    CHECK(wait_until(wifi_up));
+    CHECK_EQ(mqtt_init(&s_mqtt, "mqtt://broker.local", NULL, NULL, "test", false), 0);
+    CHECK_EQ(mqtt_connect(&s_mqtt), 0);
+    CHECK(wait_until(mqtt_up));
+    // Chờ subscribe topic điều khiển
+    host_clock_advance_us(100000);
+
+    test_single_event();
+    test_fragmented_receive();
+    test_pool_exhausted();
+
+    _Exit(test_result());
+}
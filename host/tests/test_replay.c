@@ -0,0 +1,217 @@
+#include <stdlib.h>
+#include "test_check.h"
+#include "esp_log.h"
+#include "host_hal.h"
+#include "sensor/sensor.h"
+#include "replay.h"
+
+/*
+ * Đọc trace CSV / nhị phân (v1 và v2) với các giới hạn mong đợi, và
+ * replay_check() với từng loại vi phạm. Luật phiếu của tốc độ tăng nhiệt độ
+ * trong sensor_detect_fire() và điều kiện kéo dài trong sensor_evaluate().
+ */
+
+#define CSV_PATH "test_replay.csv"
+#define BIN_PATH "test_replay.bin"
+
+static const char s_csv[] =
+    "# Smoke and gas step at 10 s\n"
+    "# fire_at_ms=10000\n"
+    "# max_time_to_detect_ms=5000\n"
+    "# max_false_alarms_per_h=0.5\n"
+    "time_ms,smoke,temperature,ir_flame,gas\n"
+    "0,600,1200,0,600\n"
+    "10000,3800,1200,0,3800\n"
+    "30000,3800,1200,0,3800\n";
+
+static void write_file(const char *path, const void *data, size_t len)
+{
+    FILE *f = fopen(path, "wb");
+    CHECK(f != NULL);
+    if (f != NULL) {
+        CHECK_EQ(fwrite(data, 1, len, f), len);
+        fclose(f);
+    }
+}
+
+static void check_same_rows(const replay_trace_t *a, const replay_trace_t *b)
+{
+    CHECK_EQ(a->count, b->count);
+    CHECK_EQ(a->columns, b->columns);
+    CHECK_EQ(a->fire_at_ms, b->fire_at_ms);
+    if (a->count == b->count && a->columns == b->columns) {
+        CHECK(memcmp(a->time_ms, b->time_ms, a->count * sizeof(uint32_t)) == 0);
+        CHECK(memcmp(a->raw, b->raw, (size_t)a->count * a->columns * sizeof(uint16_t)) == 0);
+    }
+}
+
+static void test_csv_and_binary(void)
+{
+    replay_trace_t csv;
+    replay_trace_t bin;
+
+    write_file(CSV_PATH, s_csv, sizeof(s_csv) - 1);
+    CHECK_EQ(replay_trace_load(CSV_PATH, &csv), 0);
+    CHECK_EQ(csv.count, 3);
+    CHECK_EQ(csv.fire_at_ms, 10000);
+    CHECK_EQ(csv.limits.max_time_to_detect_ms, 5000);
+    CHECK(csv.limits.max_false_alarms_per_h == 0.5);
+
+    // v2 giữ các giới hạn
+    CHECK_EQ(replay_trace_save_binary(BIN_PATH, &csv), 0);
+    CHECK_EQ(replay_trace_load(BIN_PATH, &bin), 0);
+    check_same_rows(&csv, &bin);
+    CHECK_EQ(bin.limits.max_time_to_detect_ms, 5000);
+    CHECK(bin.limits.max_false_alarms_per_h == 0.5);
+    replay_trace_free(&bin);
+
+    // v1: header 16 bytes, không có giới hạn
+    FILE *f = fopen(BIN_PATH, "rb");
+    CHECK(f != NULL);
+    uint8_t data[4096];
+    size_t len = (f != NULL) ? fread(data, 1, sizeof(data), f) : 0;
+    if (f != NULL) {
+        fclose(f);
+    }
+    CHECK(len > 24);
+    data[4] = 1;
+    memmove(&data[16], &data[24], len - 24);
+    write_file(BIN_PATH, data, len - 8);
+    CHECK_EQ(replay_trace_load(BIN_PATH, &bin), 0);
+    check_same_rows(&csv, &bin);
+    CHECK_EQ(bin.limits.max_time_to_detect_ms, REPLAY_NO_LIMIT);
+    CHECK(bin.limits.max_false_alarms_per_h < 0);
+    replay_trace_free(&bin);
+
+    // Phiên bản lạ bị từ chối
+    data[4] = REPLAY_TRACE_VERSION + 1;
+    write_file(BIN_PATH, data, len - 8);
+    CHECK_EQ(replay_trace_load(BIN_PATH, &bin), -1);
+
+    // Bước khói + gas được phát hiện trong giới hạn
+    replay_result_t result;
+    CHECK_EQ(replay_run(&csv, SENSOR_READ_PERIOD_MS, &result), 0);
+    CHECK(result.detected);
+    CHECK_EQ(result.false_alarms, 0);
+    CHECK_EQ(replay_check(&result, &csv.limits), 0);
+    replay_trace_free(&csv);
+
+    remove(CSV_PATH);
+    remove(BIN_PATH);
+}
+
+static void test_check_limits(void)
+{
+    const replay_limits_t none = { REPLAY_NO_LIMIT, REPLAY_NO_LIMIT };
+    const replay_limits_t limits = { 30000, 1.0 };
+    replay_result_t r = {0};
+
+    // Trace cháy bị bỏ sót chỉ fail khi có giới hạn thời gian
+    r.has_fire = true;
+    r.quiet_ms = 3600000;
+    CHECK_EQ(replay_check(&r, &none), 0);
+    CHECK_EQ(replay_check(&r, &limits), REPLAY_FAIL_MISSED);
+
+    r.detected = true;
+    r.time_to_detect_ms = 30000;
+    CHECK_EQ(replay_check(&r, &limits), 0);
+    r.time_to_detect_ms = 30500;
+    CHECK_EQ(replay_check(&r, &limits), REPLAY_FAIL_TIME_TO_DETECT);
+
+    // Báo sai tính theo giờ không cháy
+    r.time_to_detect_ms = 1000;
+    r.false_alarms = 1;
+    CHECK_EQ(replay_check(&r, &limits), 0);
+    r.quiet_ms = 1800000;
+    CHECK(replay_false_alarms_per_h(&r) == 2.0);
+    CHECK_EQ(replay_check(&r, &limits), REPLAY_FAIL_FALSE_ALARMS);
+    CHECK_EQ(replay_check(&r, &none), 0);
+
+    r.has_fire = false;
+    r.detected = false;
+    CHECK_EQ(replay_check(&r, &limits), REPLAY_FAIL_FALSE_ALARMS);
+}
+
+static void test_ror_vote(void)
+{
+    sensor_status_t status;
+    CHECK_EQ(sensor_system_init(&status), 0);
+    int smoke = sensor_find(SENSOR_TYPE_SMOKE);
+    int gas = sensor_find(SENSOR_TYPE_GAS);
+    int temperature = sensor_find(SENSOR_TYPE_TEMPERATURE);
+    CHECK(smoke >= 0 && gas >= 0 && temperature >= 0);
+
+    // Một nguồn bất kỳ cùng ROR kéo dài: ROR là phiếu thứ hai
+    status.ror_triggered = true;
+    status.triggered_mask = 1UL << smoke;
+    CHECK(sensor_detect_fire(&status));
+    status.triggered_mask = 1UL << temperature;
+    CHECK(sensor_detect_fire(&status));
+    status.triggered_mask = 0;
+    CHECK(!sensor_detect_fire(&status));
+
+    status.ror_triggered = false;
+    status.triggered_mask = 1UL << smoke;
+    CHECK(!sensor_detect_fire(&status));
+
+    // Hai nguồn không nhiệt vẫn đủ, có hay không có ROR
+    status.triggered_mask = (1UL << smoke) | (1UL << gas);
+    CHECK(sensor_detect_fire(&status));
+    status.ror_triggered = true;
+    CHECK(sensor_detect_fire(&status));
+}
+
+/* Nhiệt độ (raw) tại chu kỳ t khi tăng slope raw/s từ ramp_ms tới đỉnh top */
+static uint16_t ramp_value(uint32_t t, uint32_t ramp_ms, uint32_t slope, uint32_t top)
+{
+    uint32_t v = 1200;
+    if (t > ramp_ms) {
+        v += (t - ramp_ms) / 1000 * slope;
+    }
+    return (uint16_t)((v < top) ? v : top);
+}
+
+/* Chu kỳ đầu tiên có ror_triggered, UINT32_MAX nếu không có */
+static uint32_t first_ror_ms(uint32_t ramp_ms, uint32_t slope, uint32_t top, uint32_t end_ms)
+{
+    sensor_status_t status;
+    CHECK_EQ(sensor_system_init(&status), 0);
+    int temperature = sensor_find(SENSOR_TYPE_TEMPERATURE);
+
+    for (uint32_t t = 0; t <= end_ms; t += SENSOR_READ_PERIOD_MS) {
+        status.last_read_time = t;
+        for (uint8_t i = 0; i < sensor_count(); i++) {
+            sensor_process_sample(&status, i, (i == temperature) ? ramp_value(t, ramp_ms, slope, top) : 600);
+        }
+        sensor_evaluate(&status);
+        if (status.ror_triggered) {
+            return t;
+        }
+    }
+    return UINT32_MAX;
+}
+
+static void test_ror_sustain(void)
+{
+    // Tăng đều 20 raw/s (1200 raw/phút): phiếu ROR chỉ có sau SENSOR_ROR_SUSTAIN_MS
+    uint32_t t = first_ror_ms(10000, 20, 3600, 120000);
+    CHECK(t != UINT32_MAX);
+    CHECK(t >= 10000 + SENSOR_ROR_SUSTAIN_MS);
+    CHECK(t <= 10000 + SENSOR_ROR_SUSTAIN_MS + 10000);
+
+    // Bước nhiệt ngắn (bếp, +100 raw trong 5 s rồi đứng yên): không có phiếu ROR
+    CHECK_EQ(first_ror_ms(10000, 20, 1300, 120000), UINT32_MAX);
+}
+
+int main(void)
+{
+    host_log_set_level(ESP_LOG_ERROR);
+
+    test_csv_and_binary();
+    test_check_limits();
+    test_ror_vote();
+    test_ror_sustain();
+
+    // Luồng dịch vụ của mock có thể đang chạy: kết thúc cả tiến trình
+    _Exit(test_result());
+}
@@ -0,0 +1,191 @@
+#include <stdlib.h>
+#include "test_check.h"
+#include "sensor_filter/sensor_filter.h"
+
+/*
+ * Đáp ứng bước của các tầng lọc: số chu kỳ đọc (500 ms) từ lúc đầu vào
+ * nhảy bậc tới khi đầu ra vào dải sai số, cho median, EMA, chuỗi MQ
+ * (median 3 + EMA 1/2) và debounce N-of-M. Thay đổi tham số bộ lọc làm
+ * đổi độ trễ phát hiện sẽ làm test này fail.
+ */
+
+#define LOW 600
+#define HIGH 3800
+#define PRIME_CYCLES 16
+#define MAX_CYCLES 64
+
+static void init_chain(sensor_filter_chain_t *chain, const sensor_filter_cfg_t *cfg, uint8_t n)
+{
+    CHECK_EQ(sensor_filter_chain_init(chain, cfg, n), 0);
+    for (int i = 0; i < PRIME_CYCLES; i++) {
+        sensor_filter_chain_apply(chain, LOW);
+    }
+}
+
+/**
+ * @brief Số mẫu sau bước tới khi |đầu ra - to| <= tol (mẫu đầu tiên ở mức mới là 1)
+ */
+static int settle_cycles(sensor_filter_chain_t *chain, uint16_t to, uint16_t tol)
+{
+    for (int k = 1; k <= MAX_CYCLES; k++) {
+        int out = sensor_filter_chain_apply(chain, to);
+        if (abs(out - (int)to) <= tol) {
+            return k;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Số mẫu sau bước tới khi đầu ra đạt ngưỡng raw
+ */
+static int cycles_to_threshold(sensor_filter_chain_t *chain, uint16_t to, uint16_t threshold)
+{
+    for (int k = 1; k <= MAX_CYCLES; k++) {
+        if (sensor_filter_chain_apply(chain, to) >= threshold) {
+            return k;
+        }
+    }
+    return -1;
+}
+
+static void test_median(void)
+{
+    sensor_filter_chain_t chain;
+    const sensor_filter_cfg_t median3[] = { { SENSOR_FILTER_MEDIAN, 3, 0 } };
+    const sensor_filter_cfg_t median5[] = { { SENSOR_FILTER_MEDIAN, 5, 0 } };
+    const sensor_filter_cfg_t median7[] = { { SENSOR_FILTER_MEDIAN, 7, 0 } };
+
+    // Median N chuyển hẳn sang mức mới sau (N + 1) / 2 mẫu, không có giá trị trung gian
+    init_chain(&chain, median3, 1);
+    CHECK_EQ(settle_cycles(&chain, HIGH, 0), 2);
+    init_chain(&chain, median5, 1);
+    CHECK_EQ(settle_cycles(&chain, HIGH, 0), 3);
+    init_chain(&chain, median7, 1);
+    CHECK_EQ(settle_cycles(&chain, HIGH, 0), 4);
+    CHECK_EQ(settle_cycles(&chain, LOW, 0), 4);
+
+    // Xung đơn lẻ (nhiễu) không qua median 3
+    init_chain(&chain, median3, 1);
+    CHECK_EQ(sensor_filter_chain_apply(&chain, 4095), LOW);
+    CHECK_EQ(sensor_filter_chain_apply(&chain, LOW), LOW);
+    CHECK_EQ(sensor_filter_chain_apply(&chain, LOW), LOW);
+
+    // Cửa sổ chưa đầy: mẫu đầu tiên đi thẳng ra
+    CHECK_EQ(sensor_filter_chain_init(&chain, median3, 1), 0);
+    CHECK_EQ(sensor_filter_chain_apply(&chain, HIGH), HIGH);
+}
+
+static void test_ema(void)
+{
+    sensor_filter_chain_t chain;
+    const sensor_filter_cfg_t ema1[] = { { SENSOR_FILTER_EMA, 1, 0 } };
+    const sensor_filter_cfg_t ema2[] = { { SENSOR_FILTER_EMA, 2, 0 } };
+    const sensor_filter_cfg_t ema3[] = { { SENSOR_FILTER_EMA, 3, 0 } };
+
+    // Sai số còn khoảng 3200 * (1 - 2^-shift)^k (đầu ra làm tròn); dải 1% bước (32 raw)
+    init_chain(&chain, ema1, 1);
+    CHECK_EQ(settle_cycles(&chain, HIGH, 32), 7);
+    init_chain(&chain, ema2, 1);
+    CHECK_EQ(settle_cycles(&chain, HIGH, 32), 16);
+    init_chain(&chain, ema3, 1);
+    CHECK_EQ(settle_cycles(&chain, HIGH, 32), 35);
+
+    // Bước xuống đối xứng
+    init_chain(&chain, ema2, 1);
+    settle_cycles(&chain, HIGH, 0);
+    CHECK_EQ(settle_cycles(&chain, LOW, 32), 16);
+
+    // Mẫu đầu tiên khởi tạo bộ tích lũy, không kéo từ 0 lên
+    CHECK_EQ(sensor_filter_chain_init(&chain, ema2, 1), 0);
+    CHECK_EQ(sensor_filter_chain_apply(&chain, HIGH), HIGH);
+
+    // Giữ nguyên đầu vào thì đầu ra đúng bằng đầu vào (không trôi do làm tròn)
+    for (int i = 0; i < MAX_CYCLES; i++) {
+        sensor_filter_chain_apply(&chain, 1234);
+    }
+    CHECK_EQ(sensor_filter_chain_apply(&chain, 1234), 1234);
+}
+
+static void test_mq_chain(void)
+{
+    sensor_filter_chain_t chain;
+    const sensor_filter_cfg_t mq[] = {
+        { SENSOR_FILTER_MEDIAN, 3, 0 },
+        { SENSOR_FILTER_EMA, 1, 0 },
+    };
+    const uint16_t smoke_threshold_raw = 2867;     // 0.7 * 4095, làm tròn lên
+
+    // Chuỗi của khói/gas: median trễ 1 mẫu rồi EMA 1/2
+    init_chain(&chain, mq, 2);
+    CHECK_EQ(settle_cycles(&chain, HIGH, 32), 8);
+    init_chain(&chain, mq, 2);
+    CHECK_EQ(cycles_to_threshold(&chain, HIGH, smoke_threshold_raw), 3);
+
+    // Một mẫu nhiễu 4095 giữa nền không làm đầu ra nhích lên
+    init_chain(&chain, mq, 2);
+    CHECK_EQ(sensor_filter_chain_apply(&chain, 4095), LOW);
+    CHECK_EQ(sensor_filter_chain_apply(&chain, LOW), LOW);
+}
+
+/**
+ * @brief Đưa chuỗi trạng thái vào debounce, trả về mặt nạ đầu ra (bit k = mẫu k)
+ */
+static uint32_t debounce_run(sensor_filter_chain_t *chain, const char *pattern)
+{
+    uint32_t out = 0;
+    for (int k = 0; pattern[k] != '\0'; k++) {
+        if (sensor_filter_chain_debounce(chain, pattern[k] == '1')) {
+            out |= 1u << k;
+        }
+    }
+    return out;
+}
+
+static void test_debounce(void)
+{
+    sensor_filter_chain_t chain;
+    const sensor_filter_cfg_t two_of_three[] = { { SENSOR_FILTER_DEBOUNCE, 2, 3 } };
+    const sensor_filter_cfg_t three_of_five[] = { { SENSOR_FILTER_DEBOUNCE, 3, 5 } };
+
+    // 2-of-3 (IR flame): bật ở mẫu kích hoạt thứ 2, tắt ở mẫu không kích hoạt thứ 2
+    CHECK_EQ(sensor_filter_chain_init(&chain, two_of_three, 1), 0);
+    CHECK_EQ(debounce_run(&chain, "0011110000"), 0x78u);
+    CHECK_EQ(sensor_filter_chain_init(&chain, two_of_three, 1), 0);
+    CHECK_EQ(debounce_run(&chain, "1000100010"), 0);        // xung đơn lẻ bị chặn
+    CHECK_EQ(sensor_filter_chain_init(&chain, two_of_three, 1), 0);
+    CHECK_EQ(debounce_run(&chain, "1010"), 0x4u);         // 1, 0, 1: đủ 2 trong 3 ở mẫu thứ 3
+
+    // 3-of-5: bật ở mẫu kích hoạt thứ 3, giữ tới khi còn dưới 3 trong 5
+    CHECK_EQ(sensor_filter_chain_init(&chain, three_of_five, 1), 0);
+    CHECK_EQ(debounce_run(&chain, "11111000"), 0x7Cu);
+    CHECK_EQ(sensor_filter_chain_init(&chain, three_of_five, 1), 0);
+    CHECK_EQ(debounce_run(&chain, "1100110011"), 0x30u | 0x300u);
+
+    // Chuỗi không có debounce giữ nguyên trạng thái
+    const sensor_filter_cfg_t ema1[] = { { SENSOR_FILTER_EMA, 1, 0 } };
+    CHECK_EQ(sensor_filter_chain_init(&chain, ema1, 1), 0);
+    CHECK_EQ(debounce_run(&chain, "0110"), 0x6u);
+}
+
+static void test_invalid_config(void)
+{
+    sensor_filter_chain_t chain;
+    const sensor_filter_cfg_t median8[] = { { SENSOR_FILTER_MEDIAN, SENSOR_FILTER_MEDIAN_MAX + 1, 0 } };
+    const sensor_filter_cfg_t bad_debounce[] = { { SENSOR_FILTER_DEBOUNCE, 4, 3 } };
+
+    CHECK_EQ(sensor_filter_chain_init(&chain, median8, 1), -1);
+    CHECK_EQ(sensor_filter_chain_init(&chain, bad_debounce, 1), -1);
+    CHECK_EQ(chain.num_stages, 0);
+}
+
+int main(void)
+{
+    test_median();
+    test_ema();
+    test_mq_chain();
+    test_debounce();
+    test_invalid_config();
+
+    return test_result();
+}
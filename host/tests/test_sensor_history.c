@@ -0,0 +1,83 @@
+#include <stdlib.h>
+#include "test_check.h"
+#include "esp_log.h"
+#include "host_hal.h"
+#include "sensor/sensor.h"
+
+/*
+ * Lịch sử cảm biến qua API của sensor: mẫu đi qua sensor_process_sample()
+ * mỗi 500 ms, đọc lại bằng sensor_get_history_raw() và
+ * sensor_get_history_bucket() (tầng 1 giây và 1 phút).
+ */
+
+#define SAMPLES 150                     // 75 s
+#define PERIOD_MS 500
+
+static uint16_t value_at(uint32_t k)
+{
+    return (uint16_t)(100 + k);
+}
+
+int main(void)
+{
+    sensor_status_t status;
+    sensor_history_bucket_t bucket;
+    uint16_t raw = 0;
+
+    host_clock_set_mode(HOST_CLOCK_VIRTUAL);
+    host_log_set_level(ESP_LOG_ERROR);
+    CHECK_EQ(sensor_system_init(&status), 0);
+
+    int smoke = sensor_find(SENSOR_TYPE_SMOKE);
+    int gas = sensor_find(SENSOR_TYPE_GAS);
+    CHECK(smoke >= 0 && gas >= 0);
+
+    // Chưa có mẫu
+    CHECK_EQ(sensor_get_history_raw((uint8_t)smoke, 0, &raw), -1);
+    CHECK_EQ(sensor_get_history_bucket((uint8_t)smoke, SENSOR_HISTORY_TIER_SEC, 0, &bucket), -1);
+
+    for (uint32_t k = 0; k < SAMPLES; k++) {
+        status.last_read_time = k * PERIOD_MS;
+        CHECK_EQ(sensor_process_sample(&status, (uint8_t)smoke, value_at(k)), 0);
+        CHECK_EQ(sensor_process_sample(&status, (uint8_t)gas, 4000), 0);
+    }
+
+    // Raw: age 0 là mẫu cuối, giữ đúng SENSOR_HISTORY_RAW_LEN mẫu, mỗi cảm biến riêng
+    for (uint16_t age = 0; age < SENSOR_HISTORY_RAW_LEN; age++) {
+        CHECK_EQ(sensor_get_history_raw((uint8_t)smoke, age, &raw), 0);
+        CHECK_EQ(raw, value_at(SAMPLES - 1 - age));
+    }
+    CHECK_EQ(sensor_get_history_raw((uint8_t)smoke, SENSOR_HISTORY_RAW_LEN, &raw), -1);
+    CHECK_EQ(sensor_get_history_raw((uint8_t)gas, 0, &raw), 0);
+    CHECK_EQ(raw, 4000);
+
+    // Bucket 1 giây: giây 74 đang tích lũy, giây 73 là bucket đóng gần nhất
+    CHECK_EQ(sensor_get_history_bucket((uint8_t)smoke, SENSOR_HISTORY_TIER_SEC, 0, &bucket), 0);
+    CHECK_EQ(bucket.start_ms, 73000);
+    CHECK_EQ(bucket.count, 2);
+    CHECK_EQ(bucket.min, value_at(146));
+    CHECK_EQ(bucket.max, value_at(147));
+    CHECK_EQ(sensor_history_bucket_mean(&bucket), value_at(146));
+    CHECK_EQ(sensor_get_history_bucket((uint8_t)smoke, SENSOR_HISTORY_TIER_SEC, SENSOR_HISTORY_SEC_LEN - 1, &bucket), 0);
+    CHECK_EQ(bucket.start_ms, (73 - (SENSOR_HISTORY_SEC_LEN - 1)) * 1000);
+    CHECK_EQ(sensor_get_history_bucket((uint8_t)smoke, SENSOR_HISTORY_TIER_SEC, SENSOR_HISTORY_SEC_LEN, &bucket), -1);
+
+    // Bucket 1 phút: phút 0 đã đóng, gồm 120 mẫu đầu
+    CHECK_EQ(sensor_get_history_bucket((uint8_t)smoke, SENSOR_HISTORY_TIER_MIN, 0, &bucket), 0);
+    CHECK_EQ(bucket.start_ms, 0);
+    CHECK_EQ(bucket.count, 120);
+    CHECK_EQ(bucket.min, value_at(0));
+    CHECK_EQ(bucket.max, value_at(119));
+    CHECK_EQ(bucket.sum, 120 * 100 + 119 * 120 / 2);
+    CHECK_EQ(sensor_get_history_bucket((uint8_t)smoke, SENSOR_HISTORY_TIER_MIN, 1, &bucket), -1);
+
+    // Chỉ số ngoài registry
+    CHECK_EQ(sensor_get_history_raw(sensor_count(), 0, &raw), -1);
+    CHECK_EQ(sensor_get_history_bucket(sensor_count(), SENSOR_HISTORY_TIER_SEC, 0, &bucket), -1);
+
+    // Khởi tạo lại xóa lịch sử
+    CHECK_EQ(sensor_system_init(&status), 0);
+    CHECK_EQ(sensor_get_history_raw((uint8_t)smoke, 0, &raw), -1);
+
+    _Exit(test_result());
+}
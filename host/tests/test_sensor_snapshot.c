@@ -0,0 +1,137 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "test_check.h"
+#include "esp_log.h"
+#include "host_hal.h"
+#include "sensor/sensor.h"
+
+/*
+ * sensor_snapshot_publish() / sensor_snapshot_acquire() dưới tải thật: một
+ * luồng ghi (đúng hợp đồng: chỉ sensor_task công bố) và nhiều luồng đọc
+ * chạy song song trên pthread. Mọi trường của bản chụp chu kỳ n đều suy ra
+ * từ n và event_time_us mang checksum của phần còn lại, nên bản chụp lẫn
+ * hai chu kỳ sẽ bị phát hiện. Chu kỳ n được công bố là bản chụp thứ n, nên
+ * số thứ tự trả về phải bằng chu kỳ của dữ liệu.
+ */
+
+#define CYCLES 2000000
+#define READERS 4
+
+typedef struct {
+    uint32_t reads;
+    uint32_t torn;              // Checksum không khớp
+    uint32_t backwards;         // Chu kỳ nhỏ hơn lần đọc trước
+    uint32_t mismatch;          // Số thứ tự trả về khác chu kỳ của dữ liệu
+} reader_stats_t;
+
+static atomic_bool s_done;
+
+static int64_t checksum(const sensor_status_t *s)
+{
+    uint64_t h = 1469598103934665603ULL;
+    h = (h ^ s->count) * 1099511628211ULL;
+    h = (h ^ s->triggered_mask) * 1099511628211ULL;
+    for (int i = 0; i < SENSOR_MAX_COUNT; i++) {
+        h = (h ^ s->raw_value[i]) * 1099511628211ULL;
+        h = (h ^ s->filtered_value[i]) * 1099511628211ULL;
+        h = (h ^ s->normalized_q15[i]) * 1099511628211ULL;
+    }
+    h = (h ^ s->last_read_time) * 1099511628211ULL;
+    h = (h ^ (uint32_t)s->temperature_rate) * 1099511628211ULL;
+    h = (h ^ (uint64_t)(s->ror_triggered + 2 * s->fire_detected)) * 1099511628211ULL;
+    h = (h ^ s->detection_timestamp) * 1099511628211ULL;
+    return (int64_t)(h >> 1);
+}
+
+static void fill_cycle(sensor_status_t *s, uint32_t n)
+{
+    s->count = (uint8_t)SENSOR_MAX_COUNT;
+    s->triggered_mask = n * 2654435761u;
+    for (int i = 0; i < SENSOR_MAX_COUNT; i++) {
+        s->raw_value[i] = (uint16_t)((n + (uint32_t)i) & 0x0FFF);
+        s->filtered_value[i] = (uint16_t)((n * 3u + (uint32_t)i) & 0x0FFF);
+        s->normalized_q15[i] = (uint16_t)((n * 7u + (uint32_t)i) & 0x7FFF);
+    }
+    s->last_read_time = n;
+    s->temperature_rate = -(int32_t)(n % 1000);
+    s->ror_triggered = (n & 1u) != 0;
+    s->fire_detected = (n & 2u) != 0;
+    s->detection_timestamp = ~n;
+    s->event_time_us = checksum(s);
+}
+
+static void *writer(void *arg)
+{
+    (void)arg;
+    sensor_status_t s;
+    for (uint32_t n = 1; n <= CYCLES; n++) {
+        fill_cycle(&s, n);
+        sensor_snapshot_publish(&s);
+    }
+    atomic_store(&s_done, true);
+    return NULL;
+}
+
+static void *reader(void *arg)
+{
+    reader_stats_t *stats = arg;
+    sensor_status_t s;
+    uint32_t last = 0;
+
+    while (!atomic_load(&s_done)) {
+        uint32_t seq = sensor_snapshot_acquire(&s);
+        if (seq == 0) {
+            continue;
+        }
+        stats->reads++;
+        if (s.event_time_us != checksum(&s)) {
+            stats->torn++;
+            continue;
+        }
+        if (s.last_read_time < last) {
+            stats->backwards++;
+        }
+        if (s.last_read_time != seq) {
+            stats->mismatch++;
+        }
+        last = s.last_read_time;
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    sensor_status_t s;
+    pthread_t writer_thread;
+    pthread_t reader_thread[READERS];
+    reader_stats_t stats[READERS] = {0};
+
+    host_log_set_level(ESP_LOG_ERROR);
+    CHECK_EQ(sensor_system_init(&s), 0);
+    CHECK_EQ(sensor_snapshot_acquire(&s), 0);
+
+    for (int i = 0; i < READERS; i++) {
+        CHECK_EQ(pthread_create(&reader_thread[i], NULL, reader, &stats[i]), 0);
+    }
+    CHECK_EQ(pthread_create(&writer_thread, NULL, writer, NULL), 0);
+    pthread_join(writer_thread, NULL);
+
+    uint32_t reads = 0;
+    for (int i = 0; i < READERS; i++) {
+        pthread_join(reader_thread[i], NULL);
+        reads += stats[i].reads;
+        CHECK_EQ(stats[i].torn, 0);
+        CHECK_EQ(stats[i].backwards, 0);
+        CHECK_EQ(stats[i].mismatch, 0);
+    }
+    printf("%d readers, %u snapshots read during %u cycles\n", READERS, (unsigned)reads, (unsigned)CYCLES);
+    CHECK(reads > 0);
+
+    // Sau khi ghi xong: bản chụp cuối, số thứ tự bằng số chu kỳ
+    CHECK_EQ(sensor_snapshot_acquire(&s), CYCLES);
+    CHECK_EQ(s.last_read_time, CYCLES);
+    CHECK_EQ(s.event_time_us, checksum(&s));
+
+    _Exit(test_result());
+}
@@ -0,0 +1,242 @@
+#include <stdlib.h>
+#include <string.h>
+#include "test_check.h"
+#include "esp_log.h"
+#include "host_hal.h"
+#include "store_forward/store_forward.h"
+
+/*
+ * Store-and-forward khi mất điện: cắt nguồn flash giả ở từng byte của một
+ * lần ghi bản ghi, lần đánh dấu đã gửi, lần mở sector mới và lần xóa sector
+ * cũ nhất khi log đầy, hoặc làm hỏng dữ liệu trên flash, rồi khởi động lại
+ * bằng saf_init(). Sau khôi phục: mọi bản ghi đã ghi xong vẫn còn, đúng thứ
+ * tự, không bản ghi dở nào được gửi, và log ghi tiếp được.
+ */
+
+#define LOG SAF_LOG_ALERT
+#define LABEL "saf_alert"
+#define SMALL_LEN 40
+#define LARGE_LEN 1000                      // 4 bản ghi mỗi sector
+#define RECORD_OVERHEAD 9                   // Header 8 byte + byte trạng thái
+#define RECORDS_PER_SECTOR 4
+#define SECTORS 16                          // Phân vùng saf_alert 64 KB
+#define MAX_RECORDS 128
+
+static uint8_t s_buf[SAF_RECORD_MAX_LEN];
+
+static void make_payload(uint32_t id, uint16_t len, uint8_t *out)
+{
+    memcpy(out, &id, sizeof(id));
+    for (uint16_t i = sizeof(id); i < len; i++) {
+        out[i] = (uint8_t)(id * 37u + i);
+    }
+}
+
+static int append(uint32_t id, uint16_t len)
+{
+    uint8_t data[SAF_RECORD_MAX_LEN];
+    make_payload(id, len, data);
+    return saf_append(LOG, 1, data, len);
+}
+
+/**
+ * @brief Flash trống, log mới với các bản ghi 1..n
+ */
+static void fresh_log(uint32_t n, uint16_t len)
+{
+    host_nvs_reset();
+    CHECK_EQ(saf_init(), 0);
+    for (uint32_t id = 1; id <= n; id++) {
+        CHECK_EQ(append(id, len), 0);
+    }
+}
+
+static void reboot(void)
+{
+    host_flash_power_restore();
+    CHECK_EQ(saf_init(), 0);
+}
+
+/**
+ * @brief Lấy hết bản ghi qua saf_peek/saf_pop, so với danh sách mong đợi
+ */
+static void expect_records(const uint32_t *ids, uint32_t n, uint16_t len, const char *what)
+{
+    uint8_t expected[SAF_RECORD_MAX_LEN];
+    uint32_t got = 0;
+    saf_log_id_t log;
+    uint8_t kind;
+    uint16_t out_len;
+
+    while (saf_peek(&log, &kind, s_buf, sizeof(s_buf), &out_len) == 0) {
+        uint32_t id;
+        memcpy(&id, s_buf, sizeof(id));
+        make_payload(id, len, expected);
+        if (got >= n || id != ids[got] || out_len != len || memcmp(s_buf, expected, len) != 0) {
+            fprintf(stderr, "%s: record %u: got id %u len %u\n", what, (unsigned)got, (unsigned)id, out_len);
+            CHECK(false);
+            return;
+        }
+        CHECK_EQ(saf_pop(log), 0);
+        got++;
+    }
+    if (got != n) {
+        fprintf(stderr, "%s: %u of %u records\n", what, (unsigned)got, (unsigned)n);
+    }
+    CHECK_EQ(got, n);
+    CHECK_EQ(saf_pending(LOG), 0);
+}
+
+static uint32_t id_range(uint32_t *ids, uint32_t n, uint32_t first, uint32_t last)
+{
+    for (uint32_t id = first; id <= last; id++) {
+        ids[n++] = id;
+    }
+    return n;
+}
+
+static void test_append_power_loss(void)
+{
+    const uint32_t total = SMALL_LEN + RECORD_OVERHEAD;
+    uint32_t ids[4];
+    char what[48];
+
+    // Cắt ở mọi byte của header, payload và byte trạng thái
+    for (uint32_t cut = 0; cut <= total; cut++) {
+        fresh_log(2, SMALL_LEN);
+        host_flash_power_loss_after(cut);
+        CHECK_EQ(append(3, SMALL_LEN), (cut == total) ? 0 : -1);
+        reboot();
+
+        uint32_t n = id_range(ids, 0, 1, (cut == total) ? 3 : 2);
+        CHECK_EQ(saf_pending(LOG), n);
+        CHECK_EQ(append(4, SMALL_LEN), 0);
+        ids[n++] = 4;
+        snprintf(what, sizeof(what), "append cut %u", (unsigned)cut);
+        expect_records(ids, n, SMALL_LEN, what);
+    }
+}
+
+static void test_pop_power_loss(void)
+{
+    const uint32_t all[] = { 1, 2, 3 };
+    saf_log_id_t log;
+    uint8_t kind;
+    uint16_t len;
+
+    // Chưa kịp đánh dấu: bản ghi được gửi lại (at-least-once)
+    fresh_log(3, SMALL_LEN);
+    CHECK_EQ(saf_peek(&log, &kind, s_buf, sizeof(s_buf), &len), 0);
+    host_flash_power_loss_after(0);
+    CHECK_EQ(saf_pop(log), -1);
+    reboot();
+    expect_records(all, 3, SMALL_LEN, "pop cut 0");
+
+    // Đã đánh dấu thì mất điện ngay sau đó: không gửi lại
+    fresh_log(3, SMALL_LEN);
+    CHECK_EQ(saf_peek(&log, &kind, s_buf, sizeof(s_buf), &len), 0);
+    host_flash_power_loss_after(1);
+    CHECK_EQ(saf_pop(log), 0);
+    CHECK_EQ(append(4, SMALL_LEN), -1);
+    reboot();
+    expect_records(&all[1], 2, SMALL_LEN, "pop cut 1");
+}
+
+static void test_sector_open_power_loss(void)
+{
+    // Bản ghi thứ 5 mở sector 1: xóa 4096 byte, seq, magic, rồi bản ghi
+    const uint32_t total = SAF_SECTOR_SIZE + 8 + LARGE_LEN + RECORD_OVERHEAD;
+    uint32_t ids[8];
+    char what[48];
+
+    for (uint32_t c = 0; c <= total; c++) {
+        fresh_log(RECORDS_PER_SECTOR, LARGE_LEN);
+        host_flash_power_loss_after(c);
+        CHECK_EQ(append(5, LARGE_LEN), (c == total) ? 0 : -1);
+        reboot();
+
+        uint32_t n = id_range(ids, 0, 1, (c == total) ? 5 : 4);
+        CHECK_EQ(saf_pending(LOG), n);
+        CHECK_EQ(append(6, LARGE_LEN), 0);
+        ids[n++] = 6;
+        snprintf(what, sizeof(what), "sector open cut %u", (unsigned)c);
+        expect_records(ids, n, LARGE_LEN, what);
+    }
+}
+
+static void test_wrap_power_loss(void)
+{
+    const uint32_t full = SECTORS * RECORDS_PER_SECTOR;
+    const uint32_t cuts[] = { 0, 1, 4, 8, SAF_SECTOR_SIZE / 2, SAF_SECTOR_SIZE, SAF_SECTOR_SIZE + 8 };
+    uint32_t ids[MAX_RECORDS];
+    char what[48];
+
+    // Log đầy: bản ghi kế tiếp xóa sector cũ nhất (bản ghi 1-4)
+    for (size_t k = 0; k < sizeof(cuts) / sizeof(cuts[0]); k++) {
+        fresh_log(full, LARGE_LEN);
+        host_flash_power_loss_after(cuts[k]);
+        CHECK_EQ(append(full + 1, LARGE_LEN), -1);
+        reboot();
+
+        // Chưa xóa byte nào thì sector cũ nhất vẫn nguyên trong chuỗi
+        uint32_t n = id_range(ids, 0, (cuts[k] == 0) ? 1 : RECORDS_PER_SECTOR + 1, full);
+        CHECK_EQ(saf_pending(LOG), n);
+        CHECK_EQ(append(full + 2, LARGE_LEN), 0);
+        if (cuts[k] == 0) {
+            // Lần ghi này mới xóa sector cũ nhất
+            n = id_range(ids, 0, RECORDS_PER_SECTOR + 1, full);
+        }
+        ids[n++] = full + 2;
+        snprintf(what, sizeof(what), "wrap cut %u", (unsigned)cuts[k]);
+        expect_records(ids, n, LARGE_LEN, what);
+    }
+}
+
+static void test_corruption(void)
+{
+    const uint32_t record = (SMALL_LEN + 8 + 3) & ~3u;     // Header + payload, căn 4 byte
+    const uint32_t third = 8 + 2 * record;          // Offset của bản ghi 3 trong sector 0
+    saf_stats_t stats;
+
+    // Payload hỏng: CRC sai, bản ghi bị bỏ qua, các bản ghi sau vẫn gửi
+    const uint32_t skip_payload[] = { 1, 2, 4, 5, 6 };
+    fresh_log(6, SMALL_LEN);
+    CHECK_EQ(host_flash_corrupt(LABEL, third + 8 + 10, 0x01), 0);
+    reboot();
+    CHECK_EQ(saf_pending(LOG), 6);
+    expect_records(skip_payload, 5, SMALL_LEN, "payload corrupt");
+    saf_get_stats(LOG, &stats);
+    CHECK_EQ(stats.corrupt, 1);
+
+    // Header hỏng: không biết độ dài nên phần còn lại của sector bị bỏ, ghi tiếp ở sector mới
+    const uint32_t skip_header[] = { 1, 2, 7 };
+    fresh_log(6, SMALL_LEN);
+    CHECK_EQ(host_flash_corrupt(LABEL, third, 0x10), 0);
+    reboot();
+    CHECK_EQ(saf_pending(LOG), 2);
+    CHECK_EQ(append(7, SMALL_LEN), 0);
+    expect_records(skip_header, 3, SMALL_LEN, "header corrupt");
+
+    // Magic của sector hỏng: log coi như trống và bắt đầu lại
+    const uint32_t restart[] = { 7 };
+    fresh_log(6, SMALL_LEN);
+    CHECK_EQ(host_flash_corrupt(LABEL, 0, 0xFF), 0);
+    reboot();
+    CHECK_EQ(saf_pending(LOG), 0);
+    CHECK_EQ(append(7, SMALL_LEN), 0);
+    expect_records(restart, 1, SMALL_LEN, "magic corrupt");
+}
+
+int main(void)
+{
+    host_clock_set_mode(HOST_CLOCK_VIRTUAL);
+    host_log_set_level(ESP_LOG_ERROR);
+
+    test_append_power_loss();
+    test_pop_power_loss();
+    test_sector_open_power_loss();
+    test_wrap_power_loss();
+    test_corruption();
+
+    _Exit(test_result());
+}
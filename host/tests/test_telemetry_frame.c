@@ -0,0 +1,255 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test_check.h"
+#include "esp_log.h"
+#include "host_hal.h"
+#include "telemetry_frame/telemetry_frame.h"
+#include "telemetry/telemetry.h"
+
+/*
+ * Frame nhị phân v1: mã hóa rồi giải mã lại đủ mọi trường (kể cả giá trị
+ * biên), bố cục byte cố định của header, payload batch/cảnh báo do
+ * telemetry_build_*_frame() tạo giải mã bằng telemetry_frame_decode_next(),
+ * các frame hỏng bị từ chối, và giá trị trong frame khớp với JSON của cùng
+ * chu kỳ.
+ */
+
+static void check_frame_eq(const telemetry_frame_t *a, const telemetry_frame_t *b)
+{
+    CHECK_EQ(a->kind, b->kind);
+    CHECK_EQ(a->flags, b->flags);
+    CHECK_EQ(a->count, b->count);
+    CHECK_EQ(a->timestamp_ms, b->timestamp_ms);
+    CHECK_EQ(a->triggered_mask, b->triggered_mask);
+    CHECK_EQ(a->temperature_rate, b->temperature_rate);
+    for (uint8_t i = 0; i < a->count && i < TELEMETRY_FRAME_MAX_SENSORS; i++) {
+        CHECK_EQ(a->sensor_type[i], b->sensor_type[i]);
+        CHECK_EQ(a->value[i], b->value[i]);
+    }
+}
+
+static void test_round_trip(void)
+{
+    uint8_t buf[TELEMETRY_FRAME_MAX_LEN];
+    telemetry_frame_t in = {
+        .kind = TELEMETRY_FRAME_ALERT,
+        .flags = TELEMETRY_FRAME_FLAG_FIRE | TELEMETRY_FRAME_FLAG_ROR,
+        .count = TELEMETRY_FRAME_MAX_SENSORS,
+        .timestamp_ms = 0xFEDCBA98u,
+        .triggered_mask = 0xA5,
+        .temperature_rate = -1234,
+    };
+    telemetry_frame_t out;
+
+    for (uint8_t i = 0; i < TELEMETRY_FRAME_MAX_SENSORS; i++) {
+        in.sensor_type[i] = (uint8_t)(i * 31);
+        in.value[i] = (uint16_t)(i * 9362);     // 0 .. 65534
+    }
+    in.value[1] = 0xFFFF;
+
+    CHECK_EQ(telemetry_frame_encode(&in, buf, sizeof(buf)), TELEMETRY_FRAME_MAX_LEN);
+    CHECK_EQ(telemetry_frame_decode(buf, TELEMETRY_FRAME_MAX_LEN, &out), 0);
+    CHECK_EQ(out.version, TELEMETRY_FRAME_VERSION);
+    check_frame_eq(&in, &out);
+
+    // Bố cục little-endian của header
+    static const uint8_t header[TELEMETRY_FRAME_HEADER_LEN] = {
+        TELEMETRY_FRAME_VERSION, TELEMETRY_FRAME_ALERT, 0x03, TELEMETRY_FRAME_MAX_SENSORS,
+        0x98, 0xBA, 0xDC, 0xFE, 0xA5, 0x2E, 0xFB,
+    };
+    CHECK(memcmp(buf, header, sizeof(header)) == 0);
+    CHECK_EQ(buf[TELEMETRY_FRAME_HEADER_LEN + TELEMETRY_FRAME_SENSOR_LEN + 1], 0xFF);
+
+    // Giá trị biên của temperature_rate và frame không có cảm biến
+    const int16_t rates[] = { INT16_MIN, -1, 0, INT16_MAX };
+    for (size_t k = 0; k < sizeof(rates) / sizeof(rates[0]); k++) {
+        in.temperature_rate = rates[k];
+        in.count = 0;
+        CHECK_EQ(telemetry_frame_encode(&in, buf, sizeof(buf)), TELEMETRY_FRAME_HEADER_LEN);
+        CHECK_EQ(telemetry_frame_decode(buf, TELEMETRY_FRAME_HEADER_LEN, &out), 0);
+        check_frame_eq(&in, &out);
+    }
+
+    // Buffer thiếu một byte, quá nhiều cảm biến
+    in.count = 4;
+    CHECK_EQ(telemetry_frame_size(4), 23);
+    CHECK_EQ(telemetry_frame_encode(&in, buf, 22), -1);
+    CHECK_EQ(telemetry_frame_encode(&in, buf, 23), 23);
+    in.count = TELEMETRY_FRAME_MAX_SENSORS + 1;
+    CHECK_EQ(telemetry_frame_encode(&in, buf, sizeof(buf)), -1);
+}
+
+static void test_decode_rejects(void)
+{
+    uint8_t buf[TELEMETRY_FRAME_MAX_LEN + 1];
+    telemetry_frame_t in = { .kind = TELEMETRY_FRAME_SENSOR_DATA, .count = 2, .timestamp_ms = 500 };
+    telemetry_frame_t out;
+
+    int len = telemetry_frame_encode(&in, buf, sizeof(buf));
+    CHECK_EQ(len, 17);
+
+    // Thiếu hoặc thừa byte so với số cảm biến trong header
+    CHECK_EQ(telemetry_frame_decode(buf, (size_t)len - 1, &out), -1);
+    CHECK_EQ(telemetry_frame_decode(buf, (size_t)len + 1, &out), -1);
+    CHECK_EQ(telemetry_frame_decode(buf, TELEMETRY_FRAME_HEADER_LEN - 1, &out), -1);
+
+    // Phiên bản lạ
+    buf[0] = TELEMETRY_FRAME_VERSION + 1;
+    CHECK_EQ(telemetry_frame_decode(buf, (size_t)len, &out), -1);
+    CHECK_EQ(telemetry_frame_decode_next(buf, (size_t)len, &out), -1);
+    buf[0] = TELEMETRY_FRAME_VERSION;
+
+    // Số cảm biến vượt giới hạn dù đủ byte
+    buf[3] = TELEMETRY_FRAME_MAX_SENSORS + 1;
+    memset(buf + len, 0, sizeof(buf) - (size_t)len);
+    CHECK_EQ(telemetry_frame_decode(buf, telemetry_frame_size(TELEMETRY_FRAME_MAX_SENSORS + 1), &out), -1);
+    buf[3] = 2;
+
+    CHECK_EQ(telemetry_frame_decode(NULL, (size_t)len, &out), -1);
+    CHECK_EQ(telemetry_frame_decode(buf, (size_t)len, &out), 0);
+}
+
+/**
+ * @brief Ba chu kỳ đọc cố định, chu kỳ cuối đang cháy với tốc độ tăng nhiệt vượt int16
+ */
+static void build_samples(sensor_status_t *samples)
+{
+    int temperature = sensor_find(SENSOR_TYPE_TEMPERATURE);
+    CHECK(temperature >= 0);
+
+    for (uint32_t k = 0; k < 3; k++) {
+        sensor_status_t *s = &samples[k];
+        for (uint8_t i = 0; i < s->count; i++) {
+            s->filtered_value[i] = (uint16_t)(1000 * k + 100 * i);
+        }
+        s->last_read_time = 1000 + 500 * k;
+        s->triggered_mask = 0;
+        s->temperature_rate = -(int32_t)k * 50;
+        s->ror_triggered = false;
+        s->fire_detected = false;
+    }
+    samples[2].filtered_value[temperature] = 4095;
+    samples[2].triggered_mask = 1UL << temperature;
+    samples[2].temperature_rate = 40000;
+    samples[2].ror_triggered = true;
+    samples[2].fire_detected = true;
+    samples[2].detection_timestamp = 2001;
+}
+
+static void test_telemetry_frames(void)
+{
+    sensor_status_t samples[3];
+    uint8_t buf[3 * TELEMETRY_FRAME_MAX_LEN];
+    telemetry_frame_t out;
+
+    CHECK_EQ(sensor_system_init(&samples[0]), 0);
+    samples[1] = samples[0];
+    samples[2] = samples[0];
+    build_samples(samples);
+    uint8_t count = samples[0].count;
+
+    // Payload batch: các frame nối tiếp, mỗi frame một chu kỳ
+    int len = telemetry_build_batch_frame(buf, sizeof(buf), samples, 3);
+    CHECK_EQ(len, 3 * (int)telemetry_frame_size(count));
+    size_t off = 0;
+    for (uint32_t k = 0; k < 3; k++) {
+        int n = telemetry_frame_decode_next(buf + off, (size_t)len - off, &out);
+        CHECK_EQ(n, telemetry_frame_size(count));
+        if (n < 0) {
+            return;
+        }
+        off += (size_t)n;
+        CHECK_EQ(out.kind, TELEMETRY_FRAME_SENSOR_DATA);
+        CHECK_EQ(out.count, count);
+        CHECK_EQ(out.timestamp_ms, samples[k].last_read_time);
+        CHECK_EQ(out.triggered_mask, samples[k].triggered_mask);
+        for (uint8_t i = 0; i < count; i++) {
+            CHECK_EQ(out.sensor_type[i], sensor_get_desc(i)->type);
+            CHECK_EQ(out.value[i], samples[k].filtered_value[i]);
+        }
+    }
+    CHECK_EQ(off, (size_t)len);
+    CHECK_EQ(out.flags, TELEMETRY_FRAME_FLAG_FIRE | TELEMETRY_FRAME_FLAG_ROR);
+    CHECK_EQ(out.temperature_rate, INT16_MAX);
+
+    // Frame cuối bị cắt: các frame trước vẫn giải mã được
+    CHECK_EQ(telemetry_frame_decode_next(buf + off - telemetry_frame_size(count),
+                                         telemetry_frame_size(count) - 1, &out), -1);
+    CHECK_EQ(telemetry_build_batch_frame(buf, (size_t)len - 1, samples, 3), -1);
+    CHECK_EQ(telemetry_build_batch_frame(buf, sizeof(buf), samples, 0), 0);
+
+    // Frame cảnh báo mang thời điểm phát hiện
+    samples[1].temperature_rate = -40000;
+    len = telemetry_build_alert_frame(buf, sizeof(buf), &samples[1]);
+    CHECK_EQ(len, telemetry_frame_size(count));
+    CHECK_EQ(telemetry_frame_decode(buf, (size_t)len, &out), 0);
+    CHECK_EQ(out.kind, TELEMETRY_FRAME_ALERT);
+    CHECK_EQ(out.temperature_rate, INT16_MIN);
+    len = telemetry_build_alert_frame(buf, sizeof(buf), &samples[2]);
+    CHECK_EQ(telemetry_frame_decode(buf, (size_t)len, &out), 0);
+    CHECK_EQ(out.timestamp_ms, 2001);
+    CHECK_EQ(out.flags, TELEMETRY_FRAME_FLAG_FIRE | TELEMETRY_FRAME_FLAG_ROR);
+}
+
+/**
+ * @brief JSON và frame của cùng một chu kỳ mang cùng giá trị sau lọc
+ *
+ * Cảm biến analog: JSON = value / 4095 (qua Q15, 4 chữ số thập phân).
+ * Cảm biến digital: JSON là trạng thái kích hoạt (bit trong triggered_mask),
+ * frame mang giá trị sau lọc.
+ */
+static void test_json_matches_frame(void)
+{
+    sensor_status_t status;
+    char json[TELEMETRY_BATCH_JSON_MAX_LEN(1)];
+    uint8_t buf[TELEMETRY_FRAME_MAX_LEN];
+    telemetry_frame_t out;
+
+    CHECK_EQ(sensor_system_init(&status), 0);
+    for (uint32_t k = 0; k < 8; k++) {
+        status.last_read_time = 500 * k;
+        for (uint8_t i = 0; i < status.count; i++) {
+            sensor_process_sample(&status, i, (uint16_t)((k == 7 ? 3000 : 2000) + 137 * i));
+        }
+        sensor_evaluate(&status);
+    }
+
+    CHECK(telemetry_build_batch_json(json, sizeof(json), &status, 1) > 0);
+    int len = telemetry_build_batch_frame(buf, sizeof(buf), &status, 1);
+    CHECK_EQ(telemetry_frame_decode(buf, (size_t)len, &out), 0);
+
+    for (uint8_t i = 0; i < out.count; i++) {
+        const sensor_desc_t *desc = sensor_get_desc(i);
+        char key[SENSOR_NAME_MAX_LEN + 4];
+        snprintf(key, sizeof(key), "\"%s\":", desc->name);
+        const char *field = strstr(json, key);
+        CHECK(field != NULL);
+        if (field == NULL) {
+            continue;
+        }
+        field += strlen(key);
+
+        CHECK_EQ(out.value[i], status.filtered_value[i]);
+        if (desc->is_analog) {
+            double value = strtod(field, NULL);
+            double expected = out.value[i] / 4095.0;
+            CHECK(value > expected - 1e-4 && value < expected + 1e-4);
+        } else {
+            bool triggered = (out.triggered_mask >> i) & 1;
+            CHECK(strncmp(field, triggered ? "true" : "false", triggered ? 4 : 5) == 0);
+        }
+    }
+}
+
+int main(void)
+{
+    host_log_set_level(ESP_LOG_ERROR);
+
+    test_round_trip();
+    test_decode_rejects();
+    test_telemetry_frames();
+    test_json_matches_frame();
+
+    _Exit(test_result());
+}
@@ -0,0 +1,268 @@
+#include <stdlib.h>
+#include <string.h>
+#include "test_check.h"
+#include "esp_log.h"
+#include "host_hal.h"
+#include "json_writer/json_writer.h"
+#include "telemetry/telemetry.h"
+#include "telemetry_batch/telemetry_batch.h"
+
+/*
+ * Đầu ra chuẩn (golden) của json_writer và các payload telemetry_build_*_json
+ * với đầu vào cố định: so khớp từng byte, nên đổi tên trường, thứ tự hay
+ * định dạng số đều làm test fail. Payload JSON là hợp đồng với backend.
+ */
+
+static char s_buf[TELEMETRY_STATUS_JSON_MAX_LEN];
+
+static void test_writer_values(void)
+{
+    json_writer_t w;
+    json_writer_init(&w, s_buf, sizeof(s_buf));
+    json_writer_object_begin(&w, NULL);
+    json_writer_add_string(&w, "s", "a\"b\\c\n\t\x01/");
+    json_writer_add_int(&w, "i", -42);
+    json_writer_add_int(&w, "min", INT64_MIN);
+    json_writer_add_int(&w, "max", INT64_MAX);
+    json_writer_add_fixed(&w, "f", 7071, 4);
+    json_writer_add_fixed(&w, "neg", -5, 3);
+    json_writer_add_fixed(&w, "int", 12, 0);
+    json_writer_add_bool(&w, "t", true);
+    json_writer_add_bool(&w, "f2", false);
+    json_writer_add_string(&w, "null", NULL);
+    json_writer_array_begin(&w, "arr");
+    json_writer_add_int(&w, NULL, 1);
+    json_writer_array_begin(&w, NULL);
+    json_writer_array_end(&w);
+    json_writer_object_begin(&w, NULL);
+    json_writer_object_end(&w);
+    json_writer_array_end(&w);
+    json_writer_object_end(&w);
+
+    static const char expected[] =
+        "{\"s\":\"a\\\"b\\\\c\\n\\t\\u0001/\",\"i\":-42,\"min\":-9223372036854775808,"
+        "\"max\":9223372036854775807,\"f\":0.7071,\"neg\":-0.005,\"int\":12,\"t\":true,"
+        "\"f2\":false,\"null\":\"\",\"arr\":[1,[],{}]}";
+    CHECK_EQ(json_writer_finish(&w), sizeof(expected) - 1);
+    CHECK_STR_EQ(s_buf, expected);
+}
+
+static void test_writer_errors(void)
+{
+    json_writer_t w;
+    char small[8];
+
+    // Vừa đủ chỗ cho chuỗi và '\0'
+    json_writer_init(&w, small, sizeof(small));
+    json_writer_object_begin(&w, NULL);
+    json_writer_add_int(&w, "a", 1);
+    json_writer_object_end(&w);
+    CHECK_EQ(json_writer_finish(&w), 7);
+    CHECK_STR_EQ(small, "{\"a\":1}");
+
+    // Thiếu một byte
+    json_writer_init(&w, small, 7);
+    json_writer_object_begin(&w, NULL);
+    json_writer_add_int(&w, "a", 1);
+    json_writer_object_end(&w);
+    CHECK_EQ(json_writer_finish(&w), -1);
+
+    // Lồng đúng JSON_WRITER_MAX_DEPTH mức được, thêm một mức thì lỗi
+    json_writer_init(&w, s_buf, sizeof(s_buf));
+    for (int i = 0; i < JSON_WRITER_MAX_DEPTH; i++) {
+        json_writer_array_begin(&w, NULL);
+    }
+    for (int i = 0; i < JSON_WRITER_MAX_DEPTH; i++) {
+        json_writer_array_end(&w);
+    }
+    CHECK_EQ(json_writer_finish(&w), 2 * JSON_WRITER_MAX_DEPTH);
+    json_writer_init(&w, s_buf, sizeof(s_buf));
+    for (int i = 0; i <= JSON_WRITER_MAX_DEPTH; i++) {
+        json_writer_array_begin(&w, NULL);
+    }
+    CHECK_EQ(json_writer_finish(&w), -1);
+
+    // Chưa đóng, đóng thừa, số chữ số thập phân ngoài phạm vi
+    json_writer_init(&w, s_buf, sizeof(s_buf));
+    json_writer_object_begin(&w, NULL);
+    CHECK_EQ(json_writer_finish(&w), -1);
+    json_writer_init(&w, s_buf, sizeof(s_buf));
+    json_writer_object_end(&w);
+    CHECK_EQ(json_writer_finish(&w), -1);
+    json_writer_init(&w, s_buf, sizeof(s_buf));
+    json_writer_add_fixed(&w, NULL, 1, 10);
+    CHECK_EQ(json_writer_finish(&w), -1);
+}
+
+/**
+ * @brief Hai chu kỳ đọc cố định: lúc cháy (IR flame kích hoạt) và lúc bình thường
+ */
+static void build_samples(sensor_status_t *samples)
+{
+    int smoke = sensor_find(SENSOR_TYPE_SMOKE);
+    int temperature = sensor_find(SENSOR_TYPE_TEMPERATURE);
+    int ir = sensor_find(SENSOR_TYPE_IR_FLAME);
+    int gas = sensor_find(SENSOR_TYPE_GAS);
+    CHECK(smoke >= 0 && temperature >= 0 && ir >= 0 && gas >= 0);
+
+    sensor_status_t *s = &samples[0];
+    s->normalized_q15[smoke] = 16384;           // 0.5000
+    s->normalized_q15[temperature] = 3;         // 0.0001
+    s->normalized_q15[gas] = 32767;             // 1.0000
+    s->triggered_mask = (1UL << ir) | (1UL << gas);
+    s->fire_detected = true;
+    s->last_read_time = 1000;
+    s->detection_timestamp = 123456;
+
+    s = &samples[1];
+    s->normalized_q15[smoke] = 1;               // Làm tròn về 0.0000
+    s->normalized_q15[temperature] = 0;
+    s->normalized_q15[gas] = 0;
+    s->triggered_mask = 0;
+    s->fire_detected = false;
+    s->last_read_time = 1500;
+}
+
+static void test_sensor_payloads(void)
+{
+    sensor_status_t samples[2];
+
+    CHECK_EQ(sensor_system_init(&samples[0]), 0);
+    samples[1] = samples[0];
+    build_samples(samples);
+
+    static const char alert[] =
+        "{\"type\":\"fire_alert\",\"detected\":true,\"timestamp\":123456,"
+        "\"smoke\":0.5000,\"temperature\":0.0001,\"ir_flame\":true,\"gas\":1.0000}";
+    CHECK_EQ(telemetry_build_alert_json(s_buf, TELEMETRY_JSON_MAX_LEN, &samples[0]), sizeof(alert) - 1);
+    CHECK_STR_EQ(s_buf, alert);
+
+    static const char batch[] =
+        "{\"samples\":["
+        "{\"timestamp\":1000,\"smoke\":0.5000,\"temperature\":0.0001,\"ir_flame\":true,\"gas\":1.0000,"
+        "\"fire_detected\":true},"
+        "{\"timestamp\":1500,\"smoke\":0.0000,\"temperature\":0.0000,\"ir_flame\":false,\"gas\":0.0000,"
+        "\"fire_detected\":false}]}";
+    CHECK_EQ(telemetry_build_batch_json(s_buf, sizeof(s_buf), samples, 2), sizeof(batch) - 1);
+    CHECK_STR_EQ(s_buf, batch);
+    CHECK_EQ(telemetry_build_batch_json(s_buf, sizeof(s_buf), samples, 0), 14);
+    CHECK_STR_EQ(s_buf, "{\"samples\":[]}");
+
+    // Buffer thiếu một byte
+    CHECK_EQ(telemetry_build_alert_json(s_buf, sizeof(alert) - 1, &samples[0]), -1);
+}
+
+static void test_batch_bound(void)
+{
+    static char batch_buf[TELEMETRY_BATCH_JSON_MAX_LEN(TELEMETRY_BATCH_MAX_SAMPLES)];
+    static sensor_status_t samples[TELEMETRY_BATCH_MAX_SAMPLES];
+
+    CHECK_EQ(sensor_system_init(&samples[0]), 0);
+
+    // Mẫu dài nhất: timestamp 10 chữ số, analog 1.0000, digital false
+    size_t sample_len = TELEMETRY_SAMPLE_JSON_FIXED_LEN;
+    for (uint8_t i = 0; i < samples[0].count; i++) {
+        const sensor_desc_t *desc = sensor_get_desc(i);
+        CHECK(strlen(desc->name) <= SENSOR_NAME_MAX_LEN);
+        sample_len += strlen(desc->name) + (desc->is_analog ? 10 : 9);
+        samples[0].normalized_q15[i] = 32767;
+    }
+    samples[0].triggered_mask = 0;
+    samples[0].fire_detected = false;
+    samples[0].last_read_time = UINT32_MAX;
+    for (int k = 1; k < TELEMETRY_BATCH_MAX_SAMPLES; k++) {
+        samples[k] = samples[0];
+    }
+
+    // Độ dài khớp công thức trong telemetry.h (mẫu cuối không có dấu phẩy, không tính '\0')
+    CHECK_EQ(telemetry_build_batch_json(batch_buf, sizeof(batch_buf), samples, 1), 14 + sample_len - 1);
+    int len = telemetry_build_batch_json(batch_buf, sizeof(batch_buf), samples, TELEMETRY_BATCH_MAX_SAMPLES);
+    CHECK_EQ(len, 14 + TELEMETRY_BATCH_MAX_SAMPLES * sample_len - 1);
+    CHECK(sample_len <= TELEMETRY_SAMPLE_JSON_MAX_LEN);
+}
+
+static void test_status_payload(void)
+{
+    telemetry_alert_stats_t alert = {
+        .tracked = 1, .confirmed = 3, .retransmits = 2, .expired = 0,
+        .enqueue_max_us = 120, .publish_max_us = 340, .ack_max_us = 2100,
+    };
+    conn_link_stats_t links[CONN_LINK_COUNT] = {0};
+
+    CHECK_EQ(latency_hist_init(&alert.latency, 1000), 0);
+    latency_hist_record(&alert.latency, 800);
+    latency_hist_record(&alert.latency, 1500);
+    latency_hist_record(&alert.latency, 3000);
+
+    links[CONN_LINK_WIFI].state = CONN_STATE_UP;
+    links[CONN_LINK_WIFI].attempts = 2;
+    links[CONN_LINK_WIFI].failures = 1;
+    links[CONN_LINK_MQTT].state = CONN_STATE_BACKOFF;
+    links[CONN_LINK_MQTT].attempts = 5;
+    links[CONN_LINK_MQTT].failures = 3;
+    links[CONN_LINK_MQTT].drops = 1;
+    links[CONN_LINK_MQTT].stalls = 1;
+    links[CONN_LINK_MQTT].reconnects = 1;
+    links[CONN_LINK_MQTT].down_total_ms = 4200;
+    links[CONN_LINK_MQTT].reconnect_last_ms = 4200;
+    links[CONN_LINK_MQTT].reconnect_max_ms = 4200;
+
+    static const char status[] =
+        "{\"status\":\"online\",\"uptime\":60000,"
+        "\"alert\":{\"confirmed\":3,\"pending\":1,\"retransmits\":2,\"expired\":0,"
+        "\"latency_us\":{\"count\":3,\"avg\":1766,\"p95\":3000,\"max\":3000,"
+        "\"enqueue_max\":120,\"publish_max\":340,\"ack_max\":2100,\"bucket_base\":1000,"
+        "\"buckets\":[1,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0]}},"
+        "\"links\":{"
+        "\"wifi\":{\"state\":\"up\",\"attempts\":2,\"failures\":1,\"drops\":0,\"stalls\":0,"
+        "\"reconnects\":0,\"down_ms\":0,\"reconnect_last_ms\":0,\"reconnect_max_ms\":0},"
+        "\"mqtt\":{\"state\":\"backoff\",\"attempts\":5,\"failures\":3,\"drops\":1,\"stalls\":1,"
+        "\"reconnects\":1,\"down_ms\":4200,\"reconnect_last_ms\":4200,\"reconnect_max_ms\":4200}}}";
+    CHECK_EQ(telemetry_build_status_json(s_buf, sizeof(s_buf), 60000, &alert, links), sizeof(status) - 1);
+    CHECK_STR_EQ(s_buf, status);
+
+    CHECK_EQ(telemetry_build_status_json(s_buf, sizeof(s_buf), 60000, NULL, NULL), 34);
+    CHECK_STR_EQ(s_buf, "{\"status\":\"online\",\"uptime\":60000}");
+}
+
+static void test_diag_payload(void)
+{
+    task_diag_snapshot_t diag = {
+        .interval_ms = 10000,
+        .heap_free = 150000, .heap_min_free = 120000, .heap_largest_block = 64000,
+        .num_tasks = 2, .total_tasks = 9, .has_runtime = true,
+        .tasks = {
+            { "sensor", 12, 1800, 5, 1 },
+            { "mqtt", 0, 900, 4, -1 },
+        },
+    };
+
+    static const char expected[] =
+        "{\"uptime\":60000,\"interval_ms\":10000,\"heap\":[150000,120000,64000],\"task_count\":9,"
+        "\"tasks\":[[\"sensor\",12,1800,5,1],[\"mqtt\",0,900,4,-1]]}";
+    CHECK_EQ(telemetry_build_diag_json(s_buf, TELEMETRY_DIAG_JSON_MAX_LEN, 60000, &diag), sizeof(expected) - 1);
+    CHECK_STR_EQ(s_buf, expected);
+
+    // Không có thống kê thời gian chạy: CPU là -1
+    diag.has_runtime = false;
+    diag.num_tasks = 1;
+    static const char no_runtime[] =
+        "{\"uptime\":60000,\"interval_ms\":10000,\"heap\":[150000,120000,64000],\"task_count\":9,"
+        "\"tasks\":[[\"sensor\",-1,1800,5,1]]}";
+    CHECK_EQ(telemetry_build_diag_json(s_buf, TELEMETRY_DIAG_JSON_MAX_LEN, 60000, &diag), sizeof(no_runtime) - 1);
+    CHECK_STR_EQ(s_buf, no_runtime);
+}
+
+int main(void)
+{
+    host_log_set_level(ESP_LOG_ERROR);
+
+    test_writer_values();
+    test_writer_errors();
+    test_sensor_payloads();
+    test_batch_bound();
+    test_status_payload();
+    test_diag_payload();
+
+    _Exit(test_result());
+}
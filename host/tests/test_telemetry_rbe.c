@@ -0,0 +1,99 @@
+#include <stdlib.h>
+#include "test_check.h"
+#include "esp_log.h"
+#include "host_hal.h"
+#include "sensor/sensor.h"
+#include "telemetry_rbe/telemetry_rbe.h"
+
+/*
+ * Report-by-exception: mốc deadband của từng cảm biến chỉ dời khi chính cảm
+ * biến đó vượt deadband (hoặc khi heartbeat), nên thay đổi chậm của một cảm
+ * biến vẫn được gửi dù cảm biến khác liên tục gây gửi.
+ */
+
+#define HEARTBEAT_MS 60000
+
+static sensor_status_t s_status;
+static int s_smoke;
+static int s_temperature;
+static int s_gas;
+
+static void set_values(uint16_t smoke, uint16_t temperature, uint16_t gas)
+{
+    s_status.filtered_value[s_smoke] = smoke;
+    s_status.filtered_value[s_temperature] = temperature;
+    s_status.filtered_value[s_gas] = gas;
+}
+
+static void test_per_channel_baseline(void)
+{
+    telemetry_rbe_t rbe;
+    telemetry_rbe_init(&rbe, HEARTBEAT_MS);
+
+    set_values(600, 1200, 600);
+    CHECK(telemetry_rbe_should_report(&rbe, &s_status, 0));
+    CHECK(!telemetry_rbe_should_report(&rbe, &s_status, 500));
+
+    // Gas vượt deadband, khói mới trôi 30: gửi, mốc khói giữ 600
+    set_values(630, 1200, 645);
+    CHECK(telemetry_rbe_should_report(&rbe, &s_status, 1000));
+
+    // Khói trôi thêm 15: 45 so với mốc, vẫn gửi
+    set_values(645, 1200, 645);
+    CHECK(telemetry_rbe_should_report(&rbe, &s_status, 1500));
+    CHECK(!telemetry_rbe_should_report(&rbe, &s_status, 2000));
+
+    // Gửi vì trạng thái kích hoạt đổi cũng không dời mốc nhiệt độ
+    set_values(645, 1215, 645);
+    s_status.triggered_mask = 1UL << s_smoke;
+    CHECK(telemetry_rbe_should_report(&rbe, &s_status, 2500));
+    s_status.triggered_mask = 0;
+    CHECK(telemetry_rbe_should_report(&rbe, &s_status, 3000));
+    set_values(645, 1221, 645);
+    CHECK(telemetry_rbe_should_report(&rbe, &s_status, 3500));
+
+    CHECK_EQ(rbe.stats.reported, 6);
+    CHECK_EQ(rbe.stats.heartbeats, 0);
+    CHECK_EQ(rbe.stats.suppressed, 2);
+}
+
+static void test_heartbeat_moves_all(void)
+{
+    telemetry_rbe_t rbe;
+    telemetry_rbe_init(&rbe, HEARTBEAT_MS);
+
+    set_values(600, 1200, 600);
+    CHECK(telemetry_rbe_should_report(&rbe, &s_status, 0));
+
+    // Trôi dưới deadband tới hạn heartbeat
+    set_values(630, 1215, 630);
+    CHECK(!telemetry_rbe_should_report(&rbe, &s_status, HEARTBEAT_MS - 1));
+    CHECK(telemetry_rbe_should_report(&rbe, &s_status, HEARTBEAT_MS));
+
+    // Mốc mới là giá trị lúc heartbeat: trôi thêm 30 / 15 không gửi
+    set_values(660, 1230, 660);
+    CHECK(!telemetry_rbe_should_report(&rbe, &s_status, HEARTBEAT_MS + 500));
+
+    CHECK_EQ(rbe.stats.reported, 1);
+    CHECK_EQ(rbe.stats.heartbeats, 1);
+    CHECK_EQ(rbe.stats.suppressed, 2);
+}
+
+int main(void)
+{
+    host_log_set_level(ESP_LOG_NONE);
+
+    CHECK_EQ(sensor_system_init(&s_status), 0);
+    s_smoke = sensor_find(SENSOR_TYPE_SMOKE);
+    s_temperature = sensor_find(SENSOR_TYPE_TEMPERATURE);
+    s_gas = sensor_find(SENSOR_TYPE_GAS);
+    CHECK(s_smoke >= 0 && s_temperature >= 0 && s_gas >= 0);
+    s_status.triggered_mask = 0;
+    s_status.fire_detected = false;
+    s_status.ror_triggered = false;
+
+    test_per_channel_baseline();
+    test_heartbeat_moves_all();
+
+    _Exit(test_result());
+}
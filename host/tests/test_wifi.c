@@ -0,0 +1,87 @@
+#include <stdlib.h>
+#include <string.h>
+#include "test_check.h"
+#include "esp_log.h"
+#include "host_hal.h"
+#include "wifi/wifi.h"
+
+/*
+ * Kết nối nhanh của WiFi: lần đầu quét toàn bộ và lưu BSSID/kênh; sau khi
+ * mất kết nối, lần tới kết nối thẳng tới BSSID/kênh đã lưu nhưng vẫn lấy IP
+ * qua DHCP, nên IP mới do server cấp được dùng thay cho lease cũ.
+ */
+
+#define STEP_US 10000
+#define CONNECT_TIMEOUT_US 5000000
+
+static wifi_manager_t s_wifi;
+
+static bool wait_until(bool (*ready)(void))
+{
+    for (int64_t t = 0; t < CONNECT_TIMEOUT_US; t += STEP_US) {
+        if (ready()) {
+            return true;
+        }
+        host_clock_advance_us(STEP_US);
+    }
+    return ready();
+}
+
+static bool wifi_up(void)
+{
+    return wifi_is_connected(&s_wifi);
+}
+
+static bool wifi_down(void)
+{
+    return !wifi_is_connected(&s_wifi);
+}
+
+static void expect_ip(const char *expected)
+{
+    char ip[16];
+
+    CHECK_EQ(wifi_get_ip_address(ip), 0);
+    CHECK_STR_EQ(ip, expected);
+}
+
+static void test_first_connect_full_scan(void)
+{
+    CHECK_EQ(wifi_start_connect(&s_wifi), 0);
+    CHECK(wait_until(wifi_up));
+    CHECK(!s_wifi.fast_connect);
+    CHECK_EQ(s_wifi.full_connects, 1);
+    CHECK_EQ(s_wifi.fast_connects, 0);
+    expect_ip("192.168.1.50");
+}
+
+static void test_fast_reconnect_new_lease(void)
+{
+    // Lease cũ hết hạn trong lúc mất kết nối, server cấp IP khác
+    host_wifi_set_ap_available(false);
+    CHECK(wait_until(wifi_down));
+    host_wifi_set_dhcp_ip(ESP_IP4TOADDR(192, 168, 1, 77));
+    host_wifi_set_ap_available(true);
+
+    CHECK_EQ(wifi_start_connect(&s_wifi), 0);
+    CHECK(wait_until(wifi_up));
+    CHECK(s_wifi.fast_connect);
+    CHECK_EQ(s_wifi.fast_connects, 1);
+    CHECK_EQ(s_wifi.full_connects, 1);
+    expect_ip("192.168.1.77");
+}
+
+int main(void)
+{
+    host_clock_set_mode(HOST_CLOCK_VIRTUAL);
+    host_log_set_level(ESP_LOG_NONE);
+    host_nvs_reset();
+    host_wifi_set_connect_delay_ms(80, 1200);
+
+    CHECK_EQ(wifi_init(&s_wifi, "test", "password"), 0);
+
+    test_first_connect_full_scan();
+    test_fast_reconnect_new_lease();
+
+    _Exit(test_result());
+}
@@ -0,0 +1,287 @@
+#include "adc_stream.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_adc/adc_continuous.h"
+#include "hal/adc_types.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "ADC_STREAM";
+
+// Số channel tối đa có thể mã hóa trong trường channel (4 bit) của kết quả TYPE1
+#define ADC_STREAM_CHANNEL_CODES 16
+
+// Tổng mẫu của các frame từ lần đọc trước, callback DMA ghi
+typedef struct {
+    uint32_t frames;
+    uint32_t invalid;
+    uint32_t sum[ADC_STREAM_MAX_CHANNELS];
+    uint32_t count[ADC_STREAM_MAX_CHANNELS];
+} adc_stream_acc_t;
+
+static adc_continuous_handle_t s_handle = NULL;
+static uint8_t s_channels[ADC_STREAM_MAX_CHANNELS];
+static uint8_t s_num_channels = 0;
+static uint8_t s_slot_of[ADC_STREAM_CHANNEL_CODES];    // Channel -> slot
+static uint32_t s_sequence = 0;
+static adc_stream_stats_t s_stats;
+
+static adc_stream_acc_t s_acc;
+static portMUX_TYPE s_acc_lock = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t s_acc_ready = NULL;           // Có frame đầu tiên từ lần đọc trước
+
+/**
+ * @brief Tách kết quả TYPE1 theo slot, cộng vào sum/count
+ * @param samples Nơi chép từng mẫu, NULL nếu chỉ cần tổng
+ * @return Số kết quả thuộc kênh không có trong pattern
+ */
+static uint32_t IRAM_ATTR demux_results(const uint8_t *buf, uint32_t len, const uint8_t *slot_of,
+                                        uint32_t *sum, uint32_t *count,
+                                        uint16_t (*samples)[ADC_STREAM_FRAME_RESULTS])
+{
+    uint32_t invalid = 0;
+    for (uint32_t i = 0; i + ADC_STREAM_RESULT_BYTES <= len; i += ADC_STREAM_RESULT_BYTES) {
+        // Định dạng TYPE1: bit 0-11 là dữ liệu, bit 12-15 là channel
+        uint16_t word = (uint16_t)buf[i] | ((uint16_t)buf[i + 1] << 8);
+        uint8_t slot = slot_of[word >> 12];
+        if (slot == ADC_STREAM_INVALID_SLOT) {
+            invalid++;
+            continue;
+        }
+
+        uint16_t value = word & 0x0FFF;
+        if (samples != NULL) {
+            samples[slot][count[slot]] = value;
+        }
+        count[slot]++;
+        sum[slot] += value;
+    }
+    return invalid;
+}
+
+/**
+ * @brief Callback mỗi frame DMA hoàn tất (chạy trong ISR): cộng dồn theo kênh
+ */
+static bool IRAM_ATTR adc_stream_on_conv_done(adc_continuous_handle_t handle,
+                                              const adc_continuous_evt_data_t *edata,
+                                              void *user_data)
+{
+    uint32_t sum[ADC_STREAM_MAX_CHANNELS] = {0};
+    uint32_t count[ADC_STREAM_MAX_CHANNELS] = {0};
+    uint32_t len = (edata->size < ADC_STREAM_FRAME_BYTES) ? edata->size : ADC_STREAM_FRAME_BYTES;
+    uint32_t invalid = demux_results(edata->conv_frame_buffer, len, s_slot_of, sum, count, NULL);
+
+    portENTER_CRITICAL_ISR(&s_acc_lock);
+    for (uint8_t i = 0; i < s_num_channels; i++) {
+        s_acc.sum[i] += sum[i];
+        s_acc.count[i] += count[i];
+    }
+    s_acc.invalid += invalid;
+    bool first = (s_acc.frames++ == 0);
+    portEXIT_CRITICAL_ISR(&s_acc_lock);
+
+    BaseType_t woken = pdFALSE;
+    if (first) {
+        xSemaphoreGiveFromISR(s_acc_ready, &woken);
+    }
+    return woken == pdTRUE;
+}
+
+/**
+ * @brief Giải phóng handle driver khi khởi tạo lỗi giữa chừng
+ */
+static int adc_stream_init_failed(const char *what, esp_err_t err)
+{
+    ESP_LOGE(TAG, "%s failed: %s", what, esp_err_to_name(err));
+    adc_continuous_deinit(s_handle);
+    s_handle = NULL;
+    return -1;
+}
+
+int adc_stream_init(const uint8_t *channels, uint8_t num_channels)
+{
+    if (channels == NULL || num_channels == 0 || num_channels > ADC_STREAM_MAX_CHANNELS) {
+        return -1;
+    }
+
+    if (s_handle != NULL) {
+        ESP_LOGW(TAG, "ADC stream already initialized");
+        return -1;
+    }
+
+    adc_continuous_handle_cfg_t handle_cfg = {
+        .max_store_buf_size = ADC_STREAM_FRAME_BYTES * ADC_STREAM_POOL_FRAMES,
+        .conv_frame_size = ADC_STREAM_FRAME_BYTES,
+    };
+    if (s_acc_ready == NULL) {
+        s_acc_ready = xSemaphoreCreateBinary();
+        if (s_acc_ready == NULL) {
+            ESP_LOGE(TAG, "Failed to create ADC stream semaphore");
+            return -1;
+        }
+    }
+    if (adc_continuous_new_handle(&handle_cfg, &s_handle) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create continuous ADC handle");
+        s_handle = NULL;
+        return -1;
+    }
+
+    // Pattern quét: mỗi kênh một lần theo thứ tự, lặp lại liên tục
+    adc_digi_pattern_config_t pattern[ADC_STREAM_MAX_CHANNELS] = {0};
+    for (uint8_t i = 0; i < num_channels; i++) {
+        pattern[i].atten = ADC_ATTEN_DB_12;
+        pattern[i].channel = channels[i] & 0x7;
+        pattern[i].unit = ADC_UNIT_1;
+        pattern[i].bit_width = ADC_BITWIDTH_12;
+        s_channels[i] = channels[i];
+    }
+    s_num_channels = num_channels;
+
+    memset(s_slot_of, ADC_STREAM_INVALID_SLOT, sizeof(s_slot_of));
+    for (uint8_t i = 0; i < num_channels; i++) {
+        s_slot_of[channels[i] & 0xF] = i;
+    }
+    memset(&s_acc, 0, sizeof(s_acc));
+    xSemaphoreTake(s_acc_ready, 0);
+
+    adc_continuous_config_t dig_cfg = {
+        .pattern_num = num_channels,
+        .adc_pattern = pattern,
+        .sample_freq_hz = ADC_STREAM_SAMPLE_FREQ_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+    };
+    esp_err_t err = adc_continuous_config(s_handle, &dig_cfg);
+    if (err != ESP_OK) {
+        return adc_stream_init_failed("adc_continuous_config", err);
+    }
+
+    // Ring buffer của driver không được đọc: tràn là bình thường, không đăng ký on_pool_ovf
+    adc_continuous_evt_cbs_t cbs = {
+        .on_conv_done = adc_stream_on_conv_done,
+    };
+    err = adc_continuous_register_event_callbacks(s_handle, &cbs, NULL);
+    if (err != ESP_OK) {
+        return adc_stream_init_failed("adc_continuous_register_event_callbacks", err);
+    }
+
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_sequence = 0;
+
+    ESP_LOGI(TAG, "ADC stream initialized: %d channels, %d Hz, %d results/frame",
+             num_channels, ADC_STREAM_SAMPLE_FREQ_HZ, ADC_STREAM_FRAME_RESULTS);
+
+    return 0;
+}
+
+int adc_stream_start(void)
+{
+    if (s_handle == NULL) {
+        return -1;
+    }
+    return (adc_continuous_start(s_handle) == ESP_OK) ? 0 : -1;
+}
+
+int adc_stream_stop(void)
+{
+    if (s_handle == NULL) {
+        return -1;
+    }
+    return (adc_continuous_stop(s_handle) == ESP_OK) ? 0 : -1;
+}
+
+int adc_stream_read_frame(adc_stream_frame_t *frame, uint32_t timeout_ms)
+{
+    if (frame == NULL || s_handle == NULL) {
+        return -1;
+    }
+
+    if (xSemaphoreTake(s_acc_ready, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        return -1;
+    }
+
+    // Lấy và xóa phần cộng dồn; frame kế tiếp báo lại s_acc_ready
+    adc_stream_acc_t acc;
+    portENTER_CRITICAL(&s_acc_lock);
+    acc = s_acc;
+    memset(&s_acc, 0, sizeof(s_acc));
+    portEXIT_CRITICAL(&s_acc_lock);
+
+    frame->num_channels = s_num_channels;
+    memcpy(frame->channel, s_channels, sizeof(s_channels));
+    memcpy(frame->sum, acc.sum, sizeof(acc.sum));
+    memcpy(frame->count, acc.count, sizeof(acc.count));
+    frame->sequence = ++s_sequence;
+
+    uint32_t valid = 0;
+    for (uint8_t i = 0; i < s_num_channels; i++) {
+        valid += acc.count[i];
+    }
+    s_stats.reads++;
+    s_stats.frames += acc.frames;
+    s_stats.samples += valid;
+    s_stats.invalid_samples += acc.invalid;
+
+    return 0;
+}
+
+int adc_stream_demux(const uint8_t *buf, uint32_t len, adc_stream_frame_t *frame)
+{
+    if (buf == NULL || frame == NULL || frame->num_channels > ADC_STREAM_MAX_CHANNELS) {
+        return -1;
+    }
+
+    if (len > ADC_STREAM_FRAME_BYTES) {
+        len = ADC_STREAM_FRAME_BYTES;
+    }
+
+    // Bảng tra channel -> slot theo channel[] của frame (tối đa 8 kênh)
+    uint8_t slot_of[ADC_STREAM_CHANNEL_CODES];
+    memset(slot_of, ADC_STREAM_INVALID_SLOT, sizeof(slot_of));
+    for (uint8_t i = 0; i < frame->num_channels; i++) {
+        slot_of[frame->channel[i] & 0xF] = i;
+        frame->count[i] = 0;
+        frame->sum[i] = 0;
+    }
+
+    uint32_t invalid = demux_results(buf, len, slot_of, frame->sum, frame->count, frame->samples);
+    int valid = (int)(len / ADC_STREAM_RESULT_BYTES - invalid);
+
+    frame->sequence = ++s_sequence;
+    return valid;
+}
+
+int adc_stream_slot(const adc_stream_frame_t *frame, uint8_t channel)
+{
+    if (frame == NULL) {
+        return -1;
+    }
+
+    for (uint8_t i = 0; i < frame->num_channels; i++) {
+        if (frame->channel[i] == channel) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int adc_stream_channel_mean(const adc_stream_frame_t *frame, uint8_t channel, uint16_t *out_value)
+{
+    int slot = adc_stream_slot(frame, channel);
+    if (slot < 0 || out_value == NULL || frame->count[slot] == 0) {
+        return -1;
+    }
+
+    *out_value = (uint16_t)(frame->sum[slot] / frame->count[slot]);
+    return 0;
+}
+
+void adc_stream_get_stats(adc_stream_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    *stats = s_stats;
+}
@@ -0,0 +1,103 @@
+#ifndef ADC_STREAM_H
+#define ADC_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Cấu hình thu mẫu ADC liên tục (DMA)
+#define ADC_STREAM_MAX_CHANNELS 8          // Số kênh analog tối đa trong pattern (ADC1 có 8 kênh)
+#define ADC_STREAM_SAMPLE_FREQ_HZ 20000    // Tần số lấy mẫu tổng (mức thấp nhất của ESP32), chia đều cho các kênh
+#define ADC_STREAM_FRAME_RESULTS 128       // Số kết quả chuyển đổi trong một frame DMA
+#define ADC_STREAM_RESULT_BYTES 2          // Kích thước một kết quả (ESP32: TYPE1, 2 bytes)
+#define ADC_STREAM_FRAME_BYTES (ADC_STREAM_FRAME_RESULTS * ADC_STREAM_RESULT_BYTES)
+#define ADC_STREAM_POOL_FRAMES 1           // Ring buffer của driver (không đọc, frame được cộng dồn trong callback)
+#define ADC_STREAM_INVALID_SLOT 0xFF
+
+// Mẫu đã được tách theo kênh: một frame DMA (adc_stream_demux) hoặc mọi
+// frame giữa hai lần đọc (adc_stream_read_frame, không điền samples)
+typedef struct {
+    uint32_t sequence;                                               // Số thứ tự
+    uint8_t num_channels;                                            // Số kênh trong pattern
+    uint8_t channel[ADC_STREAM_MAX_CHANNELS];                        // ADC channel của từng slot
+    uint32_t count[ADC_STREAM_MAX_CHANNELS];                         // Số mẫu của từng slot
+    uint32_t sum[ADC_STREAM_MAX_CHANNELS];                           // Tổng mẫu (để tính trung bình)
+    uint16_t samples[ADC_STREAM_MAX_CHANNELS][ADC_STREAM_FRAME_RESULTS];
+} adc_stream_frame_t;
+
+// Thống kê bộ thu mẫu
+typedef struct {
+    uint32_t reads;             // Số lần adc_stream_read_frame() có dữ liệu
+    uint32_t frames;            // Số frame DMA đã tách kênh
+    uint32_t samples;           // Tổng số mẫu hợp lệ
+    uint32_t invalid_samples;   // Mẫu thuộc kênh không có trong pattern
+} adc_stream_stats_t;
+
+/**
+ * @brief Khởi tạo bộ thu mẫu ADC1 liên tục qua DMA
+ * @param channels Mảng ADC channel cần quét (theo thứ tự pattern)
+ * @param num_channels Số kênh (tối đa ADC_STREAM_MAX_CHANNELS)
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int adc_stream_init(const uint8_t *channels, uint8_t num_channels);
+
+/**
+ * @brief Bắt đầu chuyển đổi liên tục
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int adc_stream_start(void);
+
+/**
+ * @brief Dừng chuyển đổi liên tục
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int adc_stream_stop(void);
+
+/**
+ * @brief Lấy tổng/số mẫu của mọi frame DMA từ lần đọc trước
+ *
+ * Mỗi frame hoàn tất được tách kênh và cộng dồn ngay trong callback DMA,
+ * nên trung bình (adc_stream_channel_mean) phủ cả chu kỳ đọc và không
+ * frame nào bị bỏ. samples[] không được điền.
+ *
+ * @param frame Con trỏ đến frame đầu ra
+ * @param timeout_ms Thời gian chờ tối đa nếu chưa có frame nào (ms)
+ * @return 0 nếu thành công, -1 nếu lỗi hoặc hết thời gian chờ
+ */
+int adc_stream_read_frame(adc_stream_frame_t *frame, uint32_t timeout_ms);
+
+/**
+ * @brief Tách một buffer kết quả DMA thô thành các kênh
+ *
+ * Không phụ thuộc driver, có thể gọi với dữ liệu giả lập.
+ *
+ * @param buf Buffer kết quả thô
+ * @param len Độ dài buffer (bytes)
+ * @param frame Frame đầu ra (num_channels và channel[] phải đã được thiết lập)
+ * @return Số mẫu hợp lệ đã tách, -1 nếu lỗi
+ */
+int adc_stream_demux(const uint8_t *buf, uint32_t len, adc_stream_frame_t *frame);
+
+/**
+ * @brief Tìm slot của một ADC channel trong frame
+ * @param frame Con trỏ đến frame
+ * @param channel ADC channel
+ * @return Chỉ số slot, -1 nếu channel không có trong pattern
+ */
+int adc_stream_slot(const adc_stream_frame_t *frame, uint8_t channel);
+
+/**
+ * @brief Giá trị trung bình của một kênh trong frame (hoặc chu kỳ)
+ * @param frame Con trỏ đến frame
+ * @param channel ADC channel
+ * @param out_value Giá trị trung bình (0-4095)
+ * @return 0 nếu thành công, -1 nếu kênh không có mẫu
+ */
+int adc_stream_channel_mean(const adc_stream_frame_t *frame, uint8_t channel, uint16_t *out_value);
+
+/**
+ * @brief Lấy thống kê bộ thu mẫu
+ * @param stats Con trỏ đến cấu trúc thống kê
+ */
+void adc_stream_get_stats(adc_stream_stats_t *stats);
+
+#endif // ADC_STREAM_H
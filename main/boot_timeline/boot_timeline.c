@@ -0,0 +1,71 @@
+#include "boot_timeline.h"
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "BOOT";
+
+static const char *const stage_names[BOOT_STAGE_COUNT] = {
+    [BOOT_STAGE_APP_MAIN]       = "app_main",
+    [BOOT_STAGE_SENSORS_READY]  = "sensors_ready",
+    [BOOT_STAGE_ALARM_READY]    = "alarm_ready",
+    [BOOT_STAGE_LOCAL_READY]    = "local_ready",
+    [BOOT_STAGE_FIRST_SAMPLE]   = "first_sample",
+    [BOOT_STAGE_WIFI_CONNECTED] = "wifi_connected",
+    [BOOT_STAGE_MQTT_CONNECTED] = "mqtt_connected",
+};
+
+// 0 = chưa tới mốc (esp_timer luôn > 0 khi app_main chạy)
+static int64_t s_stage_us[BOOT_STAGE_COUNT];
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void boot_timeline_mark(boot_stage_t stage)
+{
+    if (stage >= BOOT_STAGE_COUNT) {
+        return;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_stage_us[stage] == 0) {
+        s_stage_us[stage] = now_us;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+int64_t boot_timeline_get_us(boot_stage_t stage)
+{
+    if (stage >= BOOT_STAGE_COUNT) {
+        return -1;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    int64_t t = s_stage_us[stage];
+    portEXIT_CRITICAL(&s_lock);
+
+    return (t == 0) ? -1 : t;
+}
+
+const char *boot_timeline_stage_name(boot_stage_t stage)
+{
+    return (stage < BOOT_STAGE_COUNT) ? stage_names[stage] : "unknown";
+}
+
+void boot_timeline_log(void)
+{
+    int64_t prev_us = 0;
+
+    ESP_LOGI(TAG, "Boot timeline (ms since boot, +delta from previous stage):");
+    for (int i = 0; i < BOOT_STAGE_COUNT; i++) {
+        int64_t t = boot_timeline_get_us((boot_stage_t)i);
+        if (t < 0) {
+            ESP_LOGI(TAG, "  %-15s -", stage_names[i]);
+            continue;
+        }
+        ESP_LOGI(TAG, "  %-15s %6" PRIu32 ".%03" PRIu32 " ms (+%" PRIu32 " ms)", stage_names[i],
+                 (uint32_t)(t / 1000), (uint32_t)(t % 1000), (uint32_t)((t - prev_us) / 1000));
+        prev_us = t;
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Mốc thời gian khởi động. Mỗi mốc lưu thời điểm esp_timer (us kể từ khi
+ * esp_timer khởi tạo, ngay sau bootloader) của lần đánh dấu đầu tiên.
+ */
+
+typedef enum {
+    BOOT_STAGE_APP_MAIN = 0,        // Bắt đầu app_main
+    BOOT_STAGE_SENSORS_READY,       // Cảm biến đã khởi tạo
+    BOOT_STAGE_ALARM_READY,         // Còi đã khởi tạo
+    BOOT_STAGE_LOCAL_READY,         // Task cảm biến/cảnh báo/còi đã chạy
+    BOOT_STAGE_FIRST_SAMPLE,        // Chu kỳ đọc cảm biến đầu tiên đã được đánh giá
+    BOOT_STAGE_WIFI_CONNECTED,      // Có địa chỉ IP
+    BOOT_STAGE_MQTT_CONNECTED,      // Kết nối MQTT broker
+    BOOT_STAGE_COUNT
+} boot_stage_t;
+
+/**
+ * @brief Đánh dấu một mốc (chỉ lần đầu tiên được ghi nhận)
+ * @param stage Mốc khởi động
+ */
+void boot_timeline_mark(boot_stage_t stage);
+
+/**
+ * @brief Thời điểm của một mốc
+ * @param stage Mốc khởi động
+ * @return Thời điểm (us), -1 nếu chưa tới mốc
+ */
+int64_t boot_timeline_get_us(boot_stage_t stage);
+
+/**
+ * @brief Tên của một mốc
+ * @param stage Mốc khởi động
+ * @return Tên mốc
+ */
+const char *boot_timeline_stage_name(boot_stage_t stage);
+
+/**
+ * @brief In các mốc đã đạt ra log
+ */
+void boot_timeline_log(void);
+
+#endif // BOOT_TIMELINE_H
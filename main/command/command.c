@@ -0,0 +1,285 @@
+#include "command.h"
+#include <string.h>
+#include <stdbool.h>
+#include "esp_log.h"
+
+static const char *TAG = "COMMAND";
+
+// Bảng băm địa chỉ mở, kích thước là lũy thừa của 2 và >= 2 lần số lệnh
+// để chuỗi dò tuyến tính luôn ngắn
+#define COMMAND_TABLE_SIZE 16
+
+_Static_assert((COMMAND_TABLE_SIZE & (COMMAND_TABLE_SIZE - 1)) == 0, "COMMAND_TABLE_SIZE must be a power of 2");
+_Static_assert(COMMAND_TABLE_SIZE >= 2 * COMMAND_MAX_HANDLERS, "COMMAND_TABLE_SIZE too small");
+
+typedef struct {
+    const char *name;           // NULL nếu slot trống
+    uint32_t hash;
+    command_handler_t handler;
+    void *ctx;
+} command_entry_t;
+
+static command_entry_t s_table[COMMAND_TABLE_SIZE];
+static uint8_t s_count = 0;
+static command_stats_t s_stats;
+
+/**
+ * @brief Hàm băm FNV-1a 32-bit
+ */
+static uint32_t hash_name(const char *s)
+{
+    uint32_t h = 2166136261u;
+
+    while (*s != '\0') {
+        h ^= (uint8_t)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @brief Tìm slot của lệnh, hoặc slot trống đầu tiên trên chuỗi dò
+ */
+static command_entry_t *find_slot(const char *name, uint32_t hash)
+{
+    for (uint32_t i = 0; i < COMMAND_TABLE_SIZE; i++) {
+        command_entry_t *e = &s_table[(hash + i) & (COMMAND_TABLE_SIZE - 1)];
+        if (e->name == NULL || (e->hash == hash && strcmp(e->name, name) == 0)) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static char *skip_ws(char *p)
+{
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+        p++;
+    }
+    return p;
+}
+
+/**
+ * @brief Đọc chuỗi JSON bắt đầu tại dấu nháy, giải escape tại chỗ
+ * @param out Nhận con trỏ tới chuỗi đã giải escape (kết thúc bằng '\0')
+ * @return Vị trí sau dấu nháy đóng, NULL nếu lỗi
+ */
+static char *parse_string(char *p, const char **out)
+{
+    char *dst = ++p;
+    *out = dst;
+
+    while (*p != '"') {
+        if (*p == '\0' || (unsigned char)*p < 0x20) {
+            return NULL;
+        }
+
+        if (*p != '\\') {
+            *dst++ = *p++;
+            continue;
+        }
+
+        // Chuỗi sau khi giải escape luôn ngắn hơn nên dst không vượt p
+        p++;
+        switch (*p) {
+            case '"':
+            case '\\':
+            case '/': *dst = *p; break;
+            case 'b': *dst = '\b'; break;
+            case 'f': *dst = '\f'; break;
+            case 'n': *dst = '\n'; break;
+            case 'r': *dst = '\r'; break;
+            case 't': *dst = '\t'; break;
+            default:
+                return NULL;    // \uXXXX không dùng trong lệnh điều khiển
+        }
+        dst++;
+        p++;
+    }
+
+    *dst = '\0';
+    return p + 1;
+}
+
+/**
+ * @brief Bỏ qua một object/array lồng nhau
+ * @return Vị trí sau dấu đóng, NULL nếu lỗi
+ */
+static char *skip_container(char *p)
+{
+    int depth = 0;
+
+    do {
+        if (*p == '\0') {
+            return NULL;
+        }
+
+        if (*p == '"') {
+            for (p++; *p != '"'; p++) {
+                if (*p == '\0') {
+                    return NULL;
+                }
+                if (*p == '\\' && p[1] != '\0') {
+                    p++;
+                }
+            }
+        } else if (*p == '{' || *p == '[') {
+            depth++;
+        } else if (*p == '}' || *p == ']') {
+            depth--;
+        }
+        p++;
+    } while (depth > 0);
+
+    return p;
+}
+
+static bool is_literal_char(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           c == '-' || c == '+' || c == '.';
+}
+
+int command_parse(char *json, command_request_t *req)
+{
+    if (json == NULL || req == NULL) {
+        return -1;
+    }
+
+    memset(req, 0, sizeof(command_request_t));
+
+    char *p = skip_ws(json);
+    if (*p != '{') {
+        return -1;
+    }
+
+    p = skip_ws(p + 1);
+    char delim = *p;
+
+    while (delim != '}') {
+        command_field_t field = { 0 };
+        bool is_string = false;
+
+        if (*p != '"' || (p = parse_string(p, &field.key)) == NULL) {
+            return -1;
+        }
+
+        p = skip_ws(p);
+        if (*p != ':') {
+            return -1;
+        }
+        p = skip_ws(p + 1);
+
+        if (*p == '"') {
+            if ((p = parse_string(p, &field.value)) == NULL) {
+                return -1;
+            }
+            is_string = true;
+            p = skip_ws(p);
+            delim = *p;
+        } else if (*p == '{' || *p == '[') {
+            if ((p = skip_container(p)) == NULL) {
+                return -1;
+            }
+            p = skip_ws(p);
+            delim = *p;
+        } else {
+            // Literal (số, true/false/null): kết thúc bằng '\0' tại ký tự
+            // ngay sau nó, sau khi đã lưu lại dấu phân cách
+            field.value = p;
+            while (is_literal_char(*p)) {
+                p++;
+            }
+            if (p == field.value) {
+                return -1;
+            }
+            char *end = p;
+            p = skip_ws(p);
+            delim = *p;
+            *end = '\0';
+        }
+
+        if (req->num_fields >= COMMAND_MAX_FIELDS) {
+            return -1;
+        }
+        req->fields[req->num_fields++] = field;
+
+        if (is_string && strcmp(field.key, COMMAND_NAME_KEY) == 0) {
+            req->name = field.value;
+        }
+
+        if (delim == ',') {
+            p = skip_ws(p + 1);
+        } else if (delim != '}') {
+            return -1;
+        }
+    }
+
+    // Không cho phép dữ liệu thừa sau object
+    return (*skip_ws(p + 1) == '\0') ? 0 : -1;
+}
+
+int command_register(const char *name, command_handler_t handler, void *ctx)
+{
+    if (name == NULL || handler == NULL || s_count >= COMMAND_MAX_HANDLERS) {
+        return -1;
+    }
+
+    uint32_t hash = hash_name(name);
+    command_entry_t *e = find_slot(name, hash);
+    if (e == NULL || e->name != NULL) {
+        ESP_LOGE(TAG, "Cannot register command '%s'", name);
+        return -1;
+    }
+
+    e->hash = hash;
+    e->handler = handler;
+    e->ctx = ctx;
+    e->name = name;
+    s_count++;
+    return 0;
+}
+
+int command_dispatch(char *json)
+{
+    command_request_t req;
+
+    if (command_parse(json, &req) != 0 || req.name == NULL) {
+        s_stats.parse_errors++;
+        ESP_LOGW(TAG, "Invalid command payload");
+        return -1;
+    }
+
+    command_entry_t *e = find_slot(req.name, hash_name(req.name));
+    if (e == NULL || e->name == NULL) {
+        s_stats.unknown++;
+        ESP_LOGW(TAG, "Unknown command '%s'", req.name);
+        return -1;
+    }
+
+    s_stats.dispatched++;
+    return e->handler(&req, e->ctx);
+}
+
+const char *command_get_field(const command_request_t *req, const char *key)
+{
+    if (req == NULL || key == NULL) {
+        return NULL;
+    }
+
+    for (uint8_t i = 0; i < req->num_fields; i++) {
+        if (strcmp(req->fields[i].key, key) == 0) {
+            return req->fields[i].value;
+        }
+    }
+    return NULL;
+}
+
+void command_get_stats(command_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    memcpy(stats, &s_stats, sizeof(command_stats_t));
+}
@@ -0,0 +1,86 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Bộ điều phối lệnh cho topic điều khiển.
+ *
+ * Payload JSON phẳng ({"command":"buzzer_on", ...}) được tách token ngay trên
+ * buffer nhận (không cấp phát, không tạo cây cJSON): chuỗi được giải escape
+ * tại chỗ và kết thúc bằng '\0'. Tên lệnh được tra trong bảng băm cố định.
+ * Handler không được chặn; hành động có thời gian dùng timer.
+ */
+
+#define COMMAND_MAX_HANDLERS 8      // Số lệnh đăng ký tối đa
+#define COMMAND_MAX_FIELDS 8        // Số trường tối đa trong một payload
+#define COMMAND_NAME_KEY "command"  // Trường chứa tên lệnh
+
+// Một cặp key/value của payload (value là chuỗi hoặc literal như 3000, true)
+typedef struct {
+    const char *key;
+    const char *value;          // NULL nếu value là object/array
+} command_field_t;
+
+// Payload đã tách token
+typedef struct {
+    const char *name;           // Giá trị của trường "command"
+    command_field_t fields[COMMAND_MAX_FIELDS];
+    uint8_t num_fields;
+} command_request_t;
+
+/**
+ * @brief Handler của một lệnh
+ * @param req Payload đã tách token
+ * @param ctx Con trỏ truyền lúc đăng ký
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+typedef int (*command_handler_t)(const command_request_t *req, void *ctx);
+
+// Thống kê
+typedef struct {
+    uint32_t dispatched;        // Số lệnh đã chạy
+    uint32_t unknown;           // Số lệnh không có trong bảng
+    uint32_t parse_errors;      // Số payload không hợp lệ
+} command_stats_t;
+
+/**
+ * @brief Đăng ký một lệnh (gọi trước khi task điều khiển chạy)
+ * @param name Tên lệnh (chuỗi tĩnh)
+ * @param handler Hàm xử lý
+ * @param ctx Con trỏ truyền cho handler
+ * @return 0 nếu thành công, -1 nếu bảng đầy hoặc tên đã tồn tại
+ */
+int command_register(const char *name, command_handler_t handler, void *ctx);
+
+/**
+ * @brief Tách token payload JSON ngay trên buffer
+ * @param json Payload (kết thúc bằng '\0', sẽ bị ghi đè)
+ * @param req Kết quả
+ * @return 0 nếu thành công, -1 nếu payload không hợp lệ
+ */
+int command_parse(char *json, command_request_t *req);
+
+/**
+ * @brief Tách token payload và chạy handler của lệnh
+ * @param json Payload (kết thúc bằng '\0', sẽ bị ghi đè)
+ * @return Giá trị trả về của handler, -1 nếu payload lỗi hoặc lệnh không tồn tại
+ */
+int command_dispatch(char *json);
+
+/**
+ * @brief Lấy giá trị một trường của payload
+ * @param req Payload đã tách token
+ * @param key Tên trường
+ * @return Giá trị, NULL nếu không có
+ */
+const char *command_get_field(const command_request_t *req, const char *key);
+
+/**
+ * @brief Lấy thống kê bộ điều phối
+ * @param stats Con trỏ đến cấu trúc thống kê
+ */
+void command_get_stats(command_stats_t *stats);
+
+#endif // COMMAND_H
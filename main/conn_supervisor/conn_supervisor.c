@@ -0,0 +1,347 @@
+#include "conn_supervisor.h"
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "CONN";
+
+// Giới hạn số lần nhân đôi để không tràn khi tính khoảng chờ
+#define CONN_BACKOFF_MAX_SHIFT 16
+
+typedef struct {
+    bool registered;
+    conn_link_ops_t ops;
+    conn_policy_t policy;
+    conn_link_t depends_on;
+    conn_state_t state;
+    bool attempted;             // Đã từng bắt đầu kết nối (lần đầu dùng start_jitter_ms)
+    bool down;                  // Đã mất kết nối sau khi UP, đang đo thời gian
+    uint32_t down_since_ms;
+    uint32_t deadline_ms;       // BACKOFF: thời điểm thử, CONNECTING: hết thời gian
+    uint32_t fail_streak;       // Số lần thất bại liên tiếp
+    uint32_t rx_last;           // Bộ đếm rx ở lần thay đổi gần nhất
+    uint32_t tx_acked;          // Bộ đếm tx tại lần rx gần nhất
+    bool waiting;               // Đang chờ phản hồi (phát hiện treo)
+    uint32_t waiting_since_ms;
+    conn_link_stats_t stats;
+} link_ctx_t;
+
+// Bản sao cho task khác đọc (step_link() gọi ops nên không chạy trong critical section)
+typedef struct {
+    conn_link_stats_t stats;
+    bool down;
+    uint32_t down_since_ms;
+} link_snapshot_t;
+
+static link_ctx_t s_links[CONN_LINK_COUNT];
+static link_snapshot_t s_snapshot[CONN_LINK_COUNT];
+static uint32_t s_now_ms = 0;
+static uint32_t s_rand_state = 1;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *const link_names[CONN_LINK_COUNT] = {
+    [CONN_LINK_WIFI] = "wifi",
+    [CONN_LINK_MQTT] = "mqtt",
+};
+
+static const char *const state_names[] = {
+    [CONN_STATE_IDLE]       = "idle",
+    [CONN_STATE_CONNECTING] = "connecting",
+    [CONN_STATE_UP]         = "up",
+    [CONN_STATE_BACKOFF]    = "backoff",
+};
+
+/**
+ * @brief Số ngẫu nhiên giả (xorshift32), đủ để rải thời điểm kết nối lại
+ */
+static uint32_t next_random(void)
+{
+    uint32_t x = s_rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    s_rand_state = x;
+    return x;
+}
+
+/**
+ * @brief Số ngẫu nhiên trong [lo, hi]
+ */
+static uint32_t random_between(uint32_t lo, uint32_t hi)
+{
+    if (hi <= lo) {
+        return lo;
+    }
+    return lo + next_random() % (hi - lo + 1);
+}
+
+static bool time_reached(uint32_t now_ms, uint32_t deadline_ms)
+{
+    return (int32_t)(now_ms - deadline_ms) >= 0;
+}
+
+/**
+ * @brief Khoảng chờ trước lần thử tiếp theo
+ *
+ * Lần đầu: ngẫu nhiên trong [0, start_jitter_ms]. Sau đó giới hạn
+ * cap = min(backoff_min_ms * 2^fail_streak, backoff_max_ms) và chọn ngẫu nhiên
+ * trong [cap/2, cap] để các thiết bị không đồng bộ với nhau.
+ */
+static uint32_t backoff_delay(const link_ctx_t *l)
+{
+    if (!l->attempted) {
+        return random_between(0, l->policy.start_jitter_ms);
+    }
+
+    uint32_t shift = l->fail_streak < CONN_BACKOFF_MAX_SHIFT ? l->fail_streak : CONN_BACKOFF_MAX_SHIFT;
+    uint64_t cap = (uint64_t)l->policy.backoff_min_ms << shift;
+    if (cap > l->policy.backoff_max_ms) {
+        cap = l->policy.backoff_max_ms;
+    }
+    return random_between((uint32_t)cap / 2, (uint32_t)cap);
+}
+
+static void enter_backoff(link_ctx_t *l, uint32_t now_ms)
+{
+    uint32_t delay = backoff_delay(l);
+
+    l->stats.backoff_last_ms = delay;
+    l->deadline_ms = now_ms + delay;
+    l->state = CONN_STATE_BACKOFF;
+}
+
+/**
+ * @brief Đặt mốc phát hiện treo từ bộ đếm hiện tại
+ */
+static void reset_activity(link_ctx_t *l, uint32_t now_ms)
+{
+    if (l->ops.rx_activity == NULL) {
+        return;
+    }
+
+    l->rx_last = l->ops.rx_activity(l->ops.ctx);
+    l->tx_acked = (l->ops.tx_activity != NULL) ? l->ops.tx_activity(l->ops.ctx) : 0;
+    // Không có bộ đếm tx: luôn chờ rx
+    l->waiting = (l->ops.tx_activity == NULL);
+    l->waiting_since_ms = now_ms;
+}
+
+/**
+ * @brief Kiểm tra link UP nhưng không có phản hồi
+ *
+ * Có bộ đếm tx: treo khi đã gửi gói cần phản hồi mà không nhận được gì trong
+ * stall_timeout_ms kể từ gói đầu tiên chưa được phản hồi. Không có bộ đếm tx:
+ * treo khi không nhận được gì trong stall_timeout_ms.
+ */
+static bool is_stalled(link_ctx_t *l, uint32_t now_ms)
+{
+    if (l->ops.rx_activity == NULL || l->policy.stall_timeout_ms == 0) {
+        return false;
+    }
+
+    uint32_t rx = l->ops.rx_activity(l->ops.ctx);
+    uint32_t tx = (l->ops.tx_activity != NULL) ? l->ops.tx_activity(l->ops.ctx) : 0;
+
+    if (rx != l->rx_last) {
+        l->rx_last = rx;
+        l->tx_acked = tx;
+        l->waiting = (l->ops.tx_activity == NULL);
+        l->waiting_since_ms = now_ms;
+        return false;
+    }
+
+    if (!l->waiting && tx != l->tx_acked) {
+        l->waiting = true;
+        l->waiting_since_ms = now_ms;
+    }
+
+    return l->waiting && (now_ms - l->waiting_since_ms) >= l->policy.stall_timeout_ms;
+}
+
+static void on_up(link_ctx_t *l, conn_link_t id, uint32_t now_ms)
+{
+    l->stats.connects++;
+    if (l->down) {
+        uint32_t outage_ms = now_ms - l->down_since_ms;
+        l->stats.reconnects++;
+        l->stats.down_total_ms += outage_ms;
+        l->stats.reconnect_last_ms = outage_ms;
+        if (outage_ms > l->stats.reconnect_max_ms) {
+            l->stats.reconnect_max_ms = outage_ms;
+        }
+        l->down = false;
+        ESP_LOGI(TAG, "%s reconnected after %" PRIu32 " ms", link_names[id], outage_ms);
+    } else {
+        ESP_LOGI(TAG, "%s connected", link_names[id]);
+    }
+
+    l->fail_streak = 0;
+    l->state = CONN_STATE_UP;
+    reset_activity(l, now_ms);
+}
+
+static void on_down(link_ctx_t *l, uint32_t now_ms)
+{
+    l->stats.drops++;
+    l->down = true;
+    l->down_since_ms = now_ms;
+}
+
+static void on_failure(link_ctx_t *l, conn_link_t id, uint32_t now_ms)
+{
+    l->stats.failures++;
+    l->fail_streak++;
+    enter_backoff(l, now_ms);
+    ESP_LOGW(TAG, "%s connect failed (%" PRIu32 " in a row), retry in %" PRIu32 " ms", link_names[id],
+             l->fail_streak, l->stats.backoff_last_ms);
+}
+
+static void step_link(link_ctx_t *l, conn_link_t id, uint32_t now_ms)
+{
+    bool dep_up = (l->depends_on >= CONN_LINK_COUNT) ||
+                  (s_links[l->depends_on].state == CONN_STATE_UP);
+    conn_link_status_t status = l->ops.poll(l->ops.ctx);
+
+    switch (l->state) {
+        case CONN_STATE_IDLE:
+            if (dep_up) {
+                enter_backoff(l, now_ms);
+            }
+            break;
+
+        case CONN_STATE_BACKOFF:
+            if (!dep_up) {
+                l->state = CONN_STATE_IDLE;
+            } else if (status == CONN_LINK_STATUS_UP) {
+                // Tầng dưới tự kết nối lại
+                on_up(l, id, now_ms);
+            } else if (time_reached(now_ms, l->deadline_ms)) {
+                l->attempted = true;
+                l->stats.attempts++;
+                if (l->ops.connect(l->ops.ctx) != 0) {
+                    on_failure(l, id, now_ms);
+                } else {
+                    l->deadline_ms = now_ms + l->policy.connect_timeout_ms;
+                    l->state = CONN_STATE_CONNECTING;
+                }
+            }
+            break;
+
+        case CONN_STATE_CONNECTING:
+            if (!dep_up) {
+                l->ops.disconnect(l->ops.ctx);
+                l->state = CONN_STATE_IDLE;
+            } else if (status == CONN_LINK_STATUS_UP) {
+                on_up(l, id, now_ms);
+            } else if (status == CONN_LINK_STATUS_DOWN) {
+                on_failure(l, id, now_ms);
+            } else if (time_reached(now_ms, l->deadline_ms)) {
+                l->ops.disconnect(l->ops.ctx);
+                on_failure(l, id, now_ms);
+            }
+            break;
+
+        case CONN_STATE_UP:
+            if (!dep_up) {
+                ESP_LOGW(TAG, "%s down (%s lost)", link_names[id], link_names[l->depends_on]);
+                l->ops.disconnect(l->ops.ctx);
+                on_down(l, now_ms);
+                l->state = CONN_STATE_IDLE;
+            } else if (status != CONN_LINK_STATUS_UP) {
+                // Dừng cơ chế tự kết nối lại của tầng dưới, chỉ bộ giám sát quyết định lúc thử lại
+                ESP_LOGW(TAG, "%s connection lost", link_names[id]);
+                l->ops.disconnect(l->ops.ctx);
+                on_down(l, now_ms);
+                enter_backoff(l, now_ms);
+            } else if (is_stalled(l, now_ms)) {
+                ESP_LOGW(TAG, "%s stalled (no response for %" PRIu32 " ms), reconnecting", link_names[id],
+                         now_ms - l->waiting_since_ms);
+                l->stats.stalls++;
+                l->ops.disconnect(l->ops.ctx);
+                on_down(l, now_ms);
+                enter_backoff(l, now_ms);
+            }
+            break;
+    }
+
+    l->stats.state = l->state;
+}
+
+void conn_supervisor_init(uint32_t seed)
+{
+    portENTER_CRITICAL(&s_lock);
+    memset(s_links, 0, sizeof(s_links));
+    memset(s_snapshot, 0, sizeof(s_snapshot));
+    s_now_ms = 0;
+    s_rand_state = (seed != 0) ? seed : 0x9E3779B9u;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+int conn_supervisor_add(conn_link_t link, const conn_link_ops_t *ops,
+                        const conn_policy_t *policy, conn_link_t depends_on)
+{
+    if (link >= CONN_LINK_COUNT || ops == NULL || policy == NULL || depends_on == link ||
+        ops->connect == NULL || ops->disconnect == NULL || ops->poll == NULL ||
+        policy->backoff_min_ms == 0 || policy->backoff_max_ms < policy->backoff_min_ms) {
+        return -1;
+    }
+
+    link_ctx_t *l = &s_links[link];
+    memset(l, 0, sizeof(link_ctx_t));
+    l->ops = *ops;
+    l->policy = *policy;
+    l->depends_on = depends_on;
+    l->state = CONN_STATE_IDLE;
+    l->registered = true;
+    return 0;
+}
+
+void conn_supervisor_step(uint32_t now_ms)
+{
+    // Link phụ thuộc đứng sau link nó phụ thuộc trong enum nên thấy trạng thái mới trong cùng bước
+    for (int i = 0; i < CONN_LINK_COUNT; i++) {
+        link_ctx_t *l = &s_links[i];
+        if (!l->registered) {
+            continue;
+        }
+
+        step_link(l, (conn_link_t)i, now_ms);
+
+        portENTER_CRITICAL(&s_lock);
+        s_snapshot[i].stats = l->stats;
+        s_snapshot[i].down = l->down;
+        s_snapshot[i].down_since_ms = l->down_since_ms;
+        portEXIT_CRITICAL(&s_lock);
+    }
+
+    // Ghi sau cùng để conn_supervisor_get_stats() tính thời gian mất kết nối hiện tại
+    portENTER_CRITICAL(&s_lock);
+    s_now_ms = now_ms;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void conn_supervisor_get_stats(conn_link_t link, conn_link_stats_t *stats)
+{
+    if (link >= CONN_LINK_COUNT || stats == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    *stats = s_snapshot[link].stats;
+    // Cộng cả lần mất kết nối đang diễn ra
+    if (s_snapshot[link].down) {
+        stats->down_total_ms += s_now_ms - s_snapshot[link].down_since_ms;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+const char *conn_supervisor_link_name(conn_link_t link)
+{
+    return (link < CONN_LINK_COUNT) ? link_names[link] : "unknown";
+}
+
+const char *conn_supervisor_state_name(conn_state_t state)
+{
+    return (state <= CONN_STATE_BACKOFF) ? state_names[state] : "unknown";
+}
@@ -0,0 +1,118 @@
+#ifndef CONN_SUPERVISOR_H
+#define CONN_SUPERVISOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Bộ giám sát kết nối WiFi và MQTT.
+ *
+ * Mỗi link là một máy trạng thái IDLE -> CONNECTING -> UP, thất bại hoặc mất
+ * kết nối chuyển sang BACKOFF. Thời gian chờ tăng gấp đôi sau mỗi lần thất
+ * bại liên tiếp (tới backoff_max_ms) và được lấy ngẫu nhiên trong nửa trên
+ * của khoảng, nên các thiết bị mất điện/mất AP cùng lúc không kết nối lại
+ * cùng lúc. Link chỉ được kết nối khi link phụ thuộc (MQTT -> WiFi) đã UP.
+ *
+ * Module không gọi trực tiếp WiFi/MQTT và không tự đọc đồng hồ: thao tác trên
+ * link đi qua conn_link_ops_t và thời gian được truyền vào conn_supervisor_step(),
+ * nên có thể chạy với link giả.
+ */
+
+// Chu kỳ gọi conn_supervisor_step() khuyến nghị (ms)
+#define CONN_SUPERVISOR_PERIOD_MS 100
+
+typedef enum {
+    CONN_LINK_WIFI = 0,
+    CONN_LINK_MQTT,
+    CONN_LINK_COUNT
+} conn_link_t;
+
+typedef enum {
+    CONN_STATE_IDLE = 0,        // Chưa kết nối, chờ link phụ thuộc hoặc lần thử đầu
+    CONN_STATE_CONNECTING,      // Đã bắt đầu kết nối, chờ kết quả
+    CONN_STATE_UP,              // Đã kết nối
+    CONN_STATE_BACKOFF,         // Chờ trước lần thử tiếp theo
+} conn_state_t;
+
+// Trạng thái link do tầng dưới báo
+typedef enum {
+    CONN_LINK_STATUS_DOWN = 0,  // Không kết nối (lần thử hiện tại đã thất bại)
+    CONN_LINK_STATUS_PENDING,   // Đang kết nối
+    CONN_LINK_STATUS_UP,        // Đã kết nối
+} conn_link_status_t;
+
+// Thao tác trên link (tầng WiFi/MQTT thật hoặc link giả)
+typedef struct {
+    int (*connect)(void *ctx);                  // Bắt đầu kết nối, không chặn; 0 nếu thành công
+    void (*disconnect)(void *ctx);              // Hủy kết nối (hết thời gian, bị treo)
+    conn_link_status_t (*poll)(void *ctx);      // Trạng thái hiện tại
+    uint32_t (*rx_activity)(void *ctx);         // Bộ đếm sự kiện nhận (NULL: không kiểm tra treo)
+    uint32_t (*tx_activity)(void *ctx);         // Bộ đếm gói gửi cần phản hồi (NULL: chỉ xét rx)
+    void *ctx;
+} conn_link_ops_t;
+
+// Chính sách kết nối lại của một link
+typedef struct {
+    uint32_t backoff_min_ms;        // Chờ sau lần thất bại đầu tiên
+    uint32_t backoff_max_ms;        // Chờ tối đa
+    uint32_t start_jitter_ms;       // Trễ ngẫu nhiên tối đa trước lần kết nối đầu tiên
+    uint32_t connect_timeout_ms;    // Thời gian chờ một lần kết nối
+    uint32_t stall_timeout_ms;      // Không nhận gì trong khoảng này coi là treo (0: tắt)
+} conn_policy_t;
+
+// Thống kê của một link
+typedef struct {
+    conn_state_t state;
+    uint32_t attempts;              // Số lần gọi connect
+    uint32_t connects;              // Số lần lên UP
+    uint32_t reconnects;            // Số lần lên UP lại sau khi mất kết nối
+    uint32_t failures;              // Lần thử thất bại hoặc hết thời gian
+    uint32_t drops;                 // Mất kết nối khi đang UP (gồm cả treo)
+    uint32_t stalls;                // Link UP nhưng không có phản hồi
+    uint32_t down_total_ms;         // Tổng thời gian mất kết nối (sau lần UP đầu tiên)
+    uint32_t reconnect_last_ms;     // Mất kết nối -> UP lại, lần gần nhất
+    uint32_t reconnect_max_ms;      // Mất kết nối -> UP lại, lớn nhất
+    uint32_t backoff_last_ms;       // Thời gian chờ được chọn gần nhất
+} conn_link_stats_t;
+
+/**
+ * @brief Khởi tạo bộ giám sát (xóa mọi link đã đăng ký)
+ * @param seed Hạt giống cho jitter (ví dụ esp_random()), 0 sẽ được thay bằng hằng số
+ */
+void conn_supervisor_init(uint32_t seed);
+
+/**
+ * @brief Đăng ký một link
+ * @param link Link
+ * @param ops Thao tác trên link (được sao chép)
+ * @param policy Chính sách kết nối lại (được sao chép)
+ * @param depends_on Link phải UP trước, hoặc CONN_LINK_COUNT nếu không phụ thuộc
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int conn_supervisor_add(conn_link_t link, const conn_link_ops_t *ops,
+                        const conn_policy_t *policy, conn_link_t depends_on);
+
+/**
+ * @brief Chạy máy trạng thái của mọi link một bước
+ * @param now_ms Thời gian hiện tại (ms, đơn điệu)
+ */
+void conn_supervisor_step(uint32_t now_ms);
+
+/**
+ * @brief Lấy thống kê của một link
+ * @param link Link
+ * @param stats Con trỏ đến cấu trúc thống kê
+ */
+void conn_supervisor_get_stats(conn_link_t link, conn_link_stats_t *stats);
+
+/**
+ * @brief Tên của một link ("wifi", "mqtt")
+ */
+const char *conn_supervisor_link_name(conn_link_t link);
+
+/**
+ * @brief Tên của một trạng thái ("idle", "connecting", "up", "backoff")
+ */
+const char *conn_supervisor_state_name(conn_state_t state);
+
+#endif // CONN_SUPERVISOR_H
@@ -0,0 +1,253 @@
+#include "json_writer.h"
+#include <string.h>
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/**
+ * @brief Ghi n bytes vào buffer, đánh dấu overflow nếu không đủ chỗ
+ */
+static void put_raw(json_writer_t *w, const char *data, size_t n)
+{
+    if (w->overflow) {
+        return;
+    }
+
+    // Luôn chừa 1 byte cho '\0'
+    if (w->len + n + 1 > w->size) {
+        w->overflow = true;
+        return;
+    }
+
+    memcpy(w->buf + w->len, data, n);
+    w->len += n;
+    w->buf[w->len] = '\0';
+}
+
+static void put_char(json_writer_t *w, char c)
+{
+    put_raw(w, &c, 1);
+}
+
+/**
+ * @brief Ghi số nguyên không dấu (không dùng printf)
+ */
+static void put_uint(json_writer_t *w, uint64_t value, uint8_t min_digits)
+{
+    char digits[20];
+    uint8_t n = 0;
+
+    do {
+        digits[sizeof(digits) - 1 - n] = (char)('0' + (value % 10));
+        value /= 10;
+        n++;
+    } while ((value != 0 || n < min_digits) && n < sizeof(digits));
+
+    put_raw(w, &digits[sizeof(digits) - n], n);
+}
+
+/**
+ * @brief Ghi chuỗi trong dấu nháy kép, escape theo RFC 8259
+ */
+static void put_string(json_writer_t *w, const char *s)
+{
+    put_char(w, '"');
+
+    const char *run = s;
+    for (; *s != '\0'; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        // Ghi đoạn ký tự thường trước ký tự cần escape
+        put_raw(w, run, (size_t)(s - run));
+        run = s + 1;
+
+        switch (c) {
+            case '"':  put_raw(w, "\\\"", 2); break;
+            case '\\': put_raw(w, "\\\\", 2); break;
+            case '\n': put_raw(w, "\\n", 2); break;
+            case '\r': put_raw(w, "\\r", 2); break;
+            case '\t': put_raw(w, "\\t", 2); break;
+            default: {
+                char esc[6] = { '\\', 'u', '0', '0', hex_digits[c >> 4], hex_digits[c & 0x0F] };
+                put_raw(w, esc, sizeof(esc));
+                break;
+            }
+        }
+    }
+    put_raw(w, run, (size_t)(s - run));
+
+    put_char(w, '"');
+}
+
+/**
+ * @brief Ghi dấu phẩy (nếu cần) và tên trường trước một giá trị
+ */
+static void put_prefix(json_writer_t *w, const char *key)
+{
+    if (w->need_comma[w->depth]) {
+        put_char(w, ',');
+    }
+    w->need_comma[w->depth] = true;
+
+    if (key != NULL) {
+        put_string(w, key);
+        put_char(w, ':');
+    }
+}
+
+static void open_container(json_writer_t *w, const char *key, char c)
+{
+    if (w->depth >= JSON_WRITER_MAX_DEPTH) {
+        w->overflow = true;
+        return;
+    }
+
+    put_prefix(w, key);
+    put_char(w, c);
+    w->depth++;
+    w->need_comma[w->depth] = false;
+}
+
+static void close_container(json_writer_t *w, char c)
+{
+    if (w->depth == 0) {
+        w->overflow = true;
+        return;
+    }
+
+    w->depth--;
+    put_char(w, c);
+}
+
+void json_writer_init(json_writer_t *w, char *buf, size_t size)
+{
+    if (w == NULL) {
+        return;
+    }
+
+    memset(w, 0, sizeof(json_writer_t));
+    w->buf = buf;
+    w->size = size;
+
+    if (buf == NULL || size == 0) {
+        w->overflow = true;
+        return;
+    }
+
+    buf[0] = '\0';
+}
+
+void json_writer_object_begin(json_writer_t *w, const char *key)
+{
+    if (w == NULL) {
+        return;
+    }
+
+    open_container(w, key, '{');
+}
+
+void json_writer_object_end(json_writer_t *w)
+{
+    if (w == NULL) {
+        return;
+    }
+
+    close_container(w, '}');
+}
+
+void json_writer_array_begin(json_writer_t *w, const char *key)
+{
+    if (w == NULL) {
+        return;
+    }
+
+    open_container(w, key, '[');
+}
+
+void json_writer_array_end(json_writer_t *w)
+{
+    if (w == NULL) {
+        return;
+    }
+
+    close_container(w, ']');
+}
+
+void json_writer_add_string(json_writer_t *w, const char *key, const char *value)
+{
+    if (w == NULL) {
+        return;
+    }
+
+    put_prefix(w, key);
+    put_string(w, value != NULL ? value : "");
+}
+
+void json_writer_add_bool(json_writer_t *w, const char *key, bool value)
+{
+    if (w == NULL) {
+        return;
+    }
+
+    put_prefix(w, key);
+    if (value) {
+        put_raw(w, "true", 4);
+    } else {
+        put_raw(w, "false", 5);
+    }
+}
+
+void json_writer_add_int(json_writer_t *w, const char *key, int64_t value)
+{
+    if (w == NULL) {
+        return;
+    }
+
+    put_prefix(w, key);
+    if (value < 0) {
+        put_char(w, '-');
+        put_uint(w, (uint64_t)0 - (uint64_t)value, 1);
+    } else {
+        put_uint(w, (uint64_t)value, 1);
+    }
+}
+
+void json_writer_add_fixed(json_writer_t *w, const char *key, int32_t value, uint8_t decimals)
+{
+    static const uint32_t pow10[] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+    };
+
+    if (w == NULL) {
+        return;
+    }
+
+    if (decimals >= sizeof(pow10) / sizeof(pow10[0])) {
+        w->overflow = true;
+        return;
+    }
+
+    put_prefix(w, key);
+
+    uint32_t magnitude = (value < 0) ? (uint32_t)0 - (uint32_t)value : (uint32_t)value;
+    if (value < 0) {
+        put_char(w, '-');
+    }
+
+    put_uint(w, magnitude / pow10[decimals], 1);
+    if (decimals > 0) {
+        put_char(w, '.');
+        put_uint(w, magnitude % pow10[decimals], decimals);
+    }
+}
+
+int json_writer_finish(json_writer_t *w)
+{
+    if (w == NULL || w->overflow || w->depth != 0) {
+        return -1;
+    }
+
+    return (int)w->len;
+}
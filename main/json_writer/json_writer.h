@@ -0,0 +1,98 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Độ sâu lồng object/array tối đa
+#define JSON_WRITER_MAX_DEPTH 4
+
+// Bộ ghi JSON dạng stream vào buffer do người gọi cấp (không cấp phát heap)
+typedef struct {
+    char *buf;
+    size_t size;                // Kích thước buffer (bytes, gồm cả '\0')
+    size_t len;                 // Số bytes đã ghi (không gồm '\0')
+    uint8_t depth;              // Độ sâu lồng hiện tại
+    bool need_comma[JSON_WRITER_MAX_DEPTH + 1]; // Phần tử tiếp theo ở mỗi mức cần dấu ','
+    bool overflow;              // Buffer không đủ chỗ hoặc lồng quá sâu
+} json_writer_t;
+
+/**
+ * @brief Khởi tạo bộ ghi trên một buffer
+ * @param w Con trỏ đến bộ ghi
+ * @param buf Buffer đầu ra
+ * @param size Kích thước buffer (bytes)
+ */
+void json_writer_init(json_writer_t *w, char *buf, size_t size);
+
+/**
+ * @brief Mở một object
+ * @param w Con trỏ đến bộ ghi
+ * @param key Tên trường trong object cha (NULL nếu là gốc hoặc phần tử array)
+ */
+void json_writer_object_begin(json_writer_t *w, const char *key);
+
+/**
+ * @brief Đóng object đang mở
+ * @param w Con trỏ đến bộ ghi
+ */
+void json_writer_object_end(json_writer_t *w);
+
+/**
+ * @brief Mở một array
+ * @param w Con trỏ đến bộ ghi
+ * @param key Tên trường trong object cha (NULL nếu là gốc hoặc phần tử array)
+ */
+void json_writer_array_begin(json_writer_t *w, const char *key);
+
+/**
+ * @brief Đóng array đang mở
+ * @param w Con trỏ đến bộ ghi
+ */
+void json_writer_array_end(json_writer_t *w);
+
+/**
+ * @brief Ghi một chuỗi (có escape)
+ * @param w Con trỏ đến bộ ghi
+ * @param key Tên trường (NULL nếu là phần tử array)
+ * @param value Chuỗi giá trị
+ */
+void json_writer_add_string(json_writer_t *w, const char *key, const char *value);
+
+/**
+ * @brief Ghi một giá trị bool
+ * @param w Con trỏ đến bộ ghi
+ * @param key Tên trường (NULL nếu là phần tử array)
+ * @param value Giá trị
+ */
+void json_writer_add_bool(json_writer_t *w, const char *key, bool value);
+
+/**
+ * @brief Ghi một số nguyên
+ * @param w Con trỏ đến bộ ghi
+ * @param key Tên trường (NULL nếu là phần tử array)
+ * @param value Giá trị
+ */
+void json_writer_add_int(json_writer_t *w, const char *key, int64_t value);
+
+/**
+ * @brief Ghi một số thập phân cố định từ giá trị nguyên đã nhân 10^decimals
+ *
+ * Không dùng float/printf: ví dụ value = 7071, decimals = 4 ghi ra 0.7071.
+ *
+ * @param w Con trỏ đến bộ ghi
+ * @param key Tên trường (NULL nếu là phần tử array)
+ * @param value Giá trị đã nhân 10^decimals
+ * @param decimals Số chữ số sau dấu thập phân (0-9)
+ */
+void json_writer_add_fixed(json_writer_t *w, const char *key, int32_t value, uint8_t decimals);
+
+/**
+ * @brief Kết thúc, kiểm tra lỗi và lấy độ dài chuỗi JSON
+ * @param w Con trỏ đến bộ ghi
+ * @return Độ dài chuỗi (bytes, không gồm '\0'), -1 nếu tràn buffer hoặc object/array chưa đóng
+ */
+int json_writer_finish(json_writer_t *w);
+
+#endif // JSON_WRITER_H
@@ -0,0 +1,66 @@
+#include "latency_hist.h"
+#include <string.h>
+
+int latency_hist_init(latency_hist_t *hist, uint32_t base_us)
+{
+    if (hist == NULL || base_us == 0) {
+        return -1;
+    }
+
+    memset(hist, 0, sizeof(latency_hist_t));
+    hist->base_us = base_us;
+    return 0;
+}
+
+uint32_t latency_hist_bucket_limit(const latency_hist_t *hist, uint8_t index)
+{
+    if (hist == NULL || index >= LATENCY_HIST_BUCKETS - 1) {
+        return UINT32_MAX;
+    }
+
+    uint64_t limit = (uint64_t)hist->base_us << index;
+    return (limit > UINT32_MAX) ? UINT32_MAX : (uint32_t)limit;
+}
+
+void latency_hist_record(latency_hist_t *hist, uint32_t latency_us)
+{
+    if (hist == NULL || hist->base_us == 0) {
+        return;
+    }
+
+    // Chỉ số bucket = số lần nhân đôi base_us cần để vượt mẫu
+    uint8_t index = 0;
+    uint64_t limit = hist->base_us;
+    while (index < LATENCY_HIST_BUCKETS - 1 && latency_us >= limit) {
+        limit <<= 1;
+        index++;
+    }
+
+    hist->bucket[index]++;
+    hist->count++;
+    hist->last_us = latency_us;
+    hist->total_us += latency_us;
+    if (latency_us > hist->max_us) {
+        hist->max_us = latency_us;
+    }
+}
+
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint8_t percent)
+{
+    if (hist == NULL || hist->count == 0 || percent == 0) {
+        return 0;
+    }
+
+    uint64_t target = ((uint64_t)hist->count * (percent > 100 ? 100 : percent) + 99) / 100;
+    uint64_t seen = 0;
+
+    for (uint8_t i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        seen += hist->bucket[i];
+        if (seen >= target) {
+            // Bucket cuối không có giới hạn trên: dùng giá trị lớn nhất đã gặp
+            uint32_t limit = latency_hist_bucket_limit(hist, i);
+            return (limit < hist->max_us) ? limit : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
@@ -0,0 +1,54 @@
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include <stdint.h>
+
+/*
+ * Histogram độ trễ với bucket tăng theo lũy thừa 2: bucket 0 chứa mẫu
+ * < base_us, bucket i chứa mẫu < (base_us << i), bucket cuối chứa mọi mẫu
+ * lớn hơn. Ghi một mẫu tốn tối đa LATENCY_HIST_BUCKETS bước và không cấp phát.
+ */
+
+#define LATENCY_HIST_BUCKETS 16
+
+typedef struct {
+    uint32_t base_us;                       // Giới hạn trên của bucket 0
+    uint32_t bucket[LATENCY_HIST_BUCKETS];
+    uint32_t count;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} latency_hist_t;
+
+/**
+ * @brief Khởi tạo histogram
+ * @param hist Con trỏ đến histogram
+ * @param base_us Giới hạn trên của bucket đầu tiên (us, > 0)
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int latency_hist_init(latency_hist_t *hist, uint32_t base_us);
+
+/**
+ * @brief Ghi một mẫu độ trễ
+ * @param hist Con trỏ đến histogram
+ * @param latency_us Độ trễ (us)
+ */
+void latency_hist_record(latency_hist_t *hist, uint32_t latency_us);
+
+/**
+ * @brief Giới hạn trên của một bucket
+ * @param hist Con trỏ đến histogram
+ * @param index Chỉ số bucket
+ * @return Giới hạn trên (us), UINT32_MAX với bucket cuối
+ */
+uint32_t latency_hist_bucket_limit(const latency_hist_t *hist, uint8_t index);
+
+/**
+ * @brief Ước lượng phân vị (giới hạn trên của bucket chứa phân vị)
+ * @param hist Con trỏ đến histogram
+ * @param percent Phân vị (1-100)
+ * @return Độ trễ (us), 0 nếu histogram rỗng
+ */
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint8_t percent);
+
+#endif // LATENCY_HIST_H
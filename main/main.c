@@ -1,15 +1,28 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <inttypes.h>
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "cJSON.h"
+#include "freertos/queue.h"
+#include "esp_timer.h"
 
 #include "sensor/sensor.h"
 #include "buzzer/buzzer.h"
 #include "wifi/wifi.h"
 #include "mqtt/mqtt.h"
+#include "telemetry/telemetry.h"
+#include "telemetry_batch/telemetry_batch.h"
+#include "telemetry_rbe/telemetry_rbe.h"
+#include "store_forward/store_forward.h"
+#include "mqtt_egress/mqtt_egress.h"
+#include "command/command.h"
+#include "boot_timeline/boot_timeline.h"
+#include "conn_supervisor/conn_supervisor.h"
+#include "task_diag/task_diag.h"
+#include "trace/trace.h"
+#include "esp_random.h"
 
 static const char *TAG = "MAIN";
 
@@ -25,208 +38,485 @@ static const char *TAG = "MAIN";
 
 #define BUZZER_GPIO_PIN GPIO_NUM_25  // Thay đổi theo GPIO bạn sử dụng
 
+#define TEST_ALARM_DURATION_MS 3000  // Thời gian còi kêu khi nhận lệnh test_alarm
+
 // Biến toàn cục
+// g_sensor_status chỉ do sensor_task ghi, các task khác đọc qua sensor_snapshot_acquire()
 static sensor_status_t g_sensor_status;
 static buzzer_t g_buzzer;
 static wifi_manager_t g_wifi_manager;
 static mqtt_config_t g_mqtt_config;
 
+// Mẫu của mọi chu kỳ đọc, từ sensor_task tới mqtt_sensor_task
+static QueueHandle_t g_sample_queue = NULL;
+static telemetry_batch_t g_telemetry_batch;
+static telemetry_rbe_t g_telemetry_rbe;
+
+// Thống kê độ trễ phát hiện cháy -> bật còi (us)
+typedef struct {
+    uint32_t count;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} alarm_latency_stats_t;
+
+// warning_task ghi, vòng lặp trạng thái của app_main đọc: total_us 64-bit không ghi nguyên tử
+static alarm_latency_stats_t g_alarm_latency;
+static portMUX_TYPE g_alarm_latency_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Chính sách kết nối lại: backoff tăng gấp đôi tới max, jitter để cả loạt thiết bị
+// có điện lại cùng lúc không kết nối AP/broker cùng lúc
+static const conn_policy_t WIFI_CONN_POLICY = {
+    .backoff_min_ms = 1000,
+    .backoff_max_ms = 60000,
+    .start_jitter_ms = 500,
+    .connect_timeout_ms = 15000,    // Đủ cho quét toàn bộ + DHCP
+    .stall_timeout_ms = 0,          // Treo ở tầng IP được phát hiện qua MQTT
+};
+
+static const conn_policy_t MQTT_CONN_POLICY = {
+    .backoff_min_ms = 2000,
+    .backoff_max_ms = 120000,
+    .start_jitter_ms = 3000,
+    .connect_timeout_ms = 20000,    // Gồm bắt tay TLS
+    .stall_timeout_ms = 30000,      // Không có PUBACK/PUBCOMP nào sau khi gửi QoS > 0
+};
+
+// Chẩn đoán task/heap, lấy mẫu trong vòng lặp trạng thái của app_main
+static task_diag_snapshot_t g_task_diag;
+static char g_diag_payload[TELEMETRY_DIAG_JSON_MAX_LEN];
+
+// Payload báo cáo trace, tạo trong task điều khiển khi nhận lệnh trace_report
+static char g_trace_payload[TELEMETRY_TRACE_JSON_MAX_LEN];
+
+// Timer tắt còi sau lệnh test_alarm (không chặn task điều khiển)
+static esp_timer_handle_t g_test_alarm_timer = NULL;
+
+/**
+ * @brief Ghi nhận độ trễ từ lúc phát hiện cháy đến lúc bật còi
+ */
+static void alarm_latency_record(int64_t event_time_us)
+{
+    uint32_t latency_us = (uint32_t)(esp_timer_get_time() - event_time_us);
+    
+    portENTER_CRITICAL(&g_alarm_latency_lock);
+    g_alarm_latency.count++;
+    g_alarm_latency.last_us = latency_us;
+    g_alarm_latency.total_us += latency_us;
+    if (latency_us > g_alarm_latency.max_us) {
+        g_alarm_latency.max_us = latency_us;
+    }
+    portEXIT_CRITICAL(&g_alarm_latency_lock);
+}
+
 /**
  * @brief Task cảnh báo - xử lý khi phát hiện cháy
+ *
+ * Task ngủ cho đến khi sensor_system_read_all() gửi thông báo thay đổi
+ * trạng thái cháy (SENSOR_EVENT_FIRE_DETECTED / SENSOR_EVENT_FIRE_CLEARED).
  */
 void warning_task(void *pvParameters)
 {
     ESP_LOGI(TAG, "Warning task started");
     
     bool last_fire_state = false;
+    uint32_t events = 0;
+    sensor_status_t snapshot;
+    static char alert_payload[TELEMETRY_JSON_MAX_LEN];
+    static uint8_t alert_frame[TELEMETRY_FRAME_MAX_LEN];
     
     while (1) {
-        // Kiểm tra trạng thái cháy
-        if (g_sensor_status.fire_detected) {
-            if (!last_fire_state) {
-                // Cháy mới được phát hiện
-                ESP_LOGW(TAG, "FIRE DETECTED! Activating alarm...");
-                
-                // Kích hoạt buzzer ở chế độ báo động
-                buzzer_set_mode(&g_buzzer, BUZZER_ALARM);
-                
-                // Gửi cảnh báo qua MQTT
-                if (mqtt_is_connected(&g_mqtt_config)) {
-                    cJSON *alert = cJSON_CreateObject();
-                    cJSON_AddStringToObject(alert, "type", "fire_alert");
-                    cJSON_AddBoolToObject(alert, "detected", true);
-                    cJSON_AddNumberToObject(alert, "timestamp", 
-                                          (double)g_sensor_status.detection_timestamp);
-                    cJSON_AddNumberToObject(alert, "smoke", g_sensor_status.smoke.normalized_value);
-                    cJSON_AddNumberToObject(alert, "temperature", g_sensor_status.temperature.normalized_value);
-                    cJSON_AddBoolToObject(alert, "ir_flame", g_sensor_status.ir_flame.is_triggered);
-                    cJSON_AddNumberToObject(alert, "gas", g_sensor_status.gas.normalized_value);
-                    
-                    char *alert_json = cJSON_Print(alert);
-                    if (alert_json != NULL) {
-                        mqtt_publish_alert(&g_mqtt_config, alert_json);
-                        free(alert_json);
-                    }
-                    cJSON_Delete(alert);
-                }
-            }
+        // Chờ sự kiện từ sensor_task, không polling
+        if (xTaskNotifyWait(0, UINT32_MAX, &events, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        
+        // Bản chụp nhất quán của chu kỳ đọc đã gây ra sự kiện
+        sensor_snapshot_acquire(&snapshot);
+        
+        if ((events & SENSOR_EVENT_FIRE_DETECTED) && !last_fire_state) {
+            // Cháy mới được phát hiện
+            ESP_LOGW(TAG, "FIRE DETECTED! Activating alarm...");
+            
+            // Kích hoạt buzzer ở chế độ báo động
+            buzzer_set_mode(&g_buzzer, BUZZER_ALARM);
+            TRACE_POINT(TRACE_ALARM_ON, trace_tag(snapshot.event_time_us));
+            alarm_latency_record(snapshot.event_time_us);
             last_fire_state = true;
-        } else {
-            if (last_fire_state) {
-                // Cháy đã được dập tắt
-                ESP_LOGI(TAG, "Fire extinguished. Deactivating alarm...");
-                buzzer_set_mode(&g_buzzer, BUZZER_OFF);
-                last_fire_state = false;
+            
+            // Gửi cảnh báo qua task egress (lớp ưu tiên cao nhất, không chờ mạng)
+            int len = (TELEMETRY_FORMATS & TELEMETRY_FORMAT_JSON) ?
+                      telemetry_build_alert_json(alert_payload, sizeof(alert_payload), &snapshot) : -1;
+            if (len > 0) {
+                mqtt_egress_enqueue_at(MQTT_EGRESS_TOPIC_ALERT, (const uint8_t *)alert_payload, len,
+                                       snapshot.event_time_us);
+            }
+            
+            len = (TELEMETRY_FORMATS & TELEMETRY_FORMAT_BINARY) ?
+                  telemetry_build_alert_frame(alert_frame, sizeof(alert_frame), &snapshot) : -1;
+            if (len > 0) {
+                mqtt_egress_enqueue_at(MQTT_EGRESS_TOPIC_ALERT_BIN, alert_frame, len, snapshot.event_time_us);
             }
+            TRACE_POINT(TRACE_ALERT_ENQUEUED, trace_tag(snapshot.event_time_us));
         }
         
-        vTaskDelay(pdMS_TO_TICKS(100)); // Kiểm tra mỗi 100ms
+        if ((events & SENSOR_EVENT_FIRE_CLEARED) && last_fire_state && !snapshot.fire_detected) {
+            // Cháy đã được dập tắt
+            ESP_LOGI(TAG, "Fire extinguished. Deactivating alarm...");
+            buzzer_set_mode(&g_buzzer, BUZZER_OFF);
+            last_fire_state = false;
+        }
     }
 }
 
+/**
+ * @brief Đưa batch hiện tại vào hàng đợi gửi MQTT (lớp telemetry)
+ * @return Tổng số bytes payload đã xếp hàng hoặc đã lưu, 0 nếu batch bị mất
+ */
+static uint32_t publish_sensor_batch(const telemetry_batch_t *batch)
+{
+    static char batch_payload[TELEMETRY_BATCH_JSON_MAX_LEN(TELEMETRY_BATCH_MAX_SAMPLES)];
+    static uint8_t batch_frame[TELEMETRY_BATCH_MAX_SAMPLES * TELEMETRY_FRAME_MAX_LEN];
+    uint32_t bytes = 0;
+    
+    // Tạo JSON chứa các mẫu của batch (ghi thẳng vào buffer tĩnh, không cấp phát heap)
+    int len = (TELEMETRY_FORMATS & TELEMETRY_FORMAT_JSON) ?
+              telemetry_build_batch_json(batch_payload, sizeof(batch_payload), batch->samples, batch->count) : -1;
+    if (len > 0 && mqtt_egress_enqueue(MQTT_EGRESS_TOPIC_SENSOR_DATA, (const uint8_t *)batch_payload, len) == 0) {
+        bytes += len;
+    }
+    
+    // Frame nhị phân song song trên topic .../bin
+    len = (TELEMETRY_FORMATS & TELEMETRY_FORMAT_BINARY) ?
+          telemetry_build_batch_frame(batch_frame, sizeof(batch_frame), batch->samples, batch->count) : -1;
+    if (len > 0 && mqtt_egress_enqueue(MQTT_EGRESS_TOPIC_SENSOR_DATA_BIN, batch_frame, len) == 0) {
+        bytes += len;
+    }
+    
+    return bytes;
+}
+
 /**
  * @brief Task gửi dữ liệu cảm biến lên MQTT
+ *
+ * Nhận mọi chu kỳ đọc từ sensor_task qua g_sample_queue, bỏ qua các chu kỳ
+ * không có thay đổi (report-by-exception, có heartbeat) và gửi theo batch:
+ * khi đủ TELEMETRY_BATCH_MAX_SAMPLES mẫu hoặc sau TELEMETRY_BATCH_WINDOW_MS.
  */
 void mqtt_sensor_task(void *pvParameters)
 {
     ESP_LOGI(TAG, "MQTT sensor task started");
     
-    const TickType_t delay = pdMS_TO_TICKS(5000); // Gửi mỗi 5 giây
+    sensor_status_t sample;
+    telemetry_batch_init(&g_telemetry_batch, TELEMETRY_BATCH_MAX_SAMPLES, TELEMETRY_BATCH_WINDOW_MS);
+    telemetry_rbe_init(&g_telemetry_rbe, TELEMETRY_RBE_HEARTBEAT_MS);
     
     while (1) {
-        if (mqtt_is_connected(&g_mqtt_config)) {
-            // Tạo JSON chứa dữ liệu cảm biến
-            cJSON *json = cJSON_CreateObject();
-            cJSON_AddNumberToObject(json, "timestamp", 
-                                  (double)(xTaskGetTickCount() * portTICK_PERIOD_MS));
-            cJSON_AddNumberToObject(json, "smoke", g_sensor_status.smoke.normalized_value);
-            cJSON_AddNumberToObject(json, "temperature", g_sensor_status.temperature.normalized_value);
-            cJSON_AddBoolToObject(json, "ir_flame", g_sensor_status.ir_flame.is_triggered);
-            cJSON_AddNumberToObject(json, "gas", g_sensor_status.gas.normalized_value);
-            cJSON_AddBoolToObject(json, "fire_detected", g_sensor_status.fire_detected);
-            
-            char *json_string = cJSON_Print(json);
-            if (json_string != NULL) {
-                mqtt_publish_sensor_data(&g_mqtt_config, json_string);
-                free(json_string);
+        uint32_t now_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+        TickType_t wait = pdMS_TO_TICKS(telemetry_batch_time_left(&g_telemetry_batch, now_ms));
+        
+        if (xQueueReceive(g_sample_queue, &sample, wait) == pdTRUE) {
+            boot_timeline_mark(BOOT_STAGE_FIRST_SAMPLE);
+            now_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+            if (!TELEMETRY_RBE_ENABLED || telemetry_rbe_should_report(&g_telemetry_rbe, &sample, now_ms)) {
+                telemetry_batch_add(&g_telemetry_batch, &sample, now_ms);
             }
-            cJSON_Delete(json);
-        } else {
-            ESP_LOGW(TAG, "MQTT not connected, skipping sensor data publish");
         }
         
-        vTaskDelay(delay);
+        now_ms = xTaskGetTickCount() * portTICK_PERIOD_MS;
+        if (!telemetry_batch_ready(&g_telemetry_batch, now_ms)) {
+            continue;
+        }
+        
+        uint32_t bytes = publish_sensor_batch(&g_telemetry_batch);
+        if (bytes == 0) {
+            ESP_LOGW(TAG, "Sensor batch neither published nor stored, discarding %d samples",
+                     g_telemetry_batch.count);
+        }
+        telemetry_batch_complete(&g_telemetry_batch, bytes, now_ms);
+    }
+}
+
+/**
+ * @brief Kết thúc test_alarm (chạy trong task esp_timer)
+ */
+static void test_alarm_timer_cb(void *arg)
+{
+    sensor_status_t snapshot;
+    sensor_snapshot_acquire(&snapshot);
+    
+    // Không tắt còi nếu trong lúc test có cháy thật
+    if (!snapshot.fire_detected) {
+        buzzer_set_mode(&g_buzzer, BUZZER_OFF);
+    }
+    ESP_LOGI(TAG, "Test alarm finished");
+}
+
+static int cmd_buzzer_on(const command_request_t *req, void *ctx)
+{
+    buzzer_set_mode(&g_buzzer, BUZZER_NORMAL);
+    ESP_LOGI(TAG, "Buzzer turned on via MQTT");
+    return 0;
+}
+
+static int cmd_buzzer_off(const command_request_t *req, void *ctx)
+{
+    buzzer_set_mode(&g_buzzer, BUZZER_OFF);
+    ESP_LOGI(TAG, "Buzzer turned off via MQTT");
+    return 0;
+}
+
+static int cmd_test_alarm(const command_request_t *req, void *ctx)
+{
+    buzzer_set_mode(&g_buzzer, BUZZER_ALARM);
+    
+    // Lệnh test_alarm mới trong lúc đang test sẽ kéo dài thời gian còi kêu
+    esp_timer_stop(g_test_alarm_timer);
+    if (esp_timer_start_once(g_test_alarm_timer, (uint64_t)TEST_ALARM_DURATION_MS * 1000) != ESP_OK) {
+        buzzer_set_mode(&g_buzzer, BUZZER_OFF);
+        return -1;
+    }
+    
+    ESP_LOGI(TAG, "Test alarm started via MQTT (%d ms)", TEST_ALARM_DURATION_MS);
+    return 0;
+}
+
+static int cmd_trace_report(const command_request_t *req, void *ctx)
+{
+    trace_fold();
+    
+    int len = telemetry_build_trace_json(g_trace_payload, sizeof(g_trace_payload), esp_log_timestamp());
+    if (len < 0 || mqtt_egress_enqueue(MQTT_EGRESS_TOPIC_DIAG, (const uint8_t *)g_trace_payload, len) != 0) {
+        return -1;
+    }
+    
+    ESP_LOGI(TAG, "Trace report queued via MQTT (%d bytes)", len);
+    return 0;
+}
+
+/**
+ * @brief Đăng ký các lệnh điều khiển qua MQTT
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+static int control_commands_init(void)
+{
+    const esp_timer_create_args_t timer_args = {
+        .callback = test_alarm_timer_cb,
+        .name = "test_alarm",
+    };
+    
+    if (esp_timer_create(&timer_args, &g_test_alarm_timer) != ESP_OK) {
+        return -1;
+    }
+    
+    if (command_register("buzzer_on", cmd_buzzer_on, NULL) != 0 ||
+        command_register("buzzer_off", cmd_buzzer_off, NULL) != 0 ||
+        command_register("test_alarm", cmd_test_alarm, NULL) != 0 ||
+        command_register("trace_report", cmd_trace_report, NULL) != 0) {
+        return -1;
     }
+    
+    return 0;
 }
 
 /**
  * @brief Task xử lý message MQTT nhận được
+ *
+ * Payload được tách token ngay trong block của pool nhận và chạy qua bảng
+ * lệnh; các handler không chặn nên lệnh kế tiếp được xử lý ngay.
  */
 void mqtt_control_task(void *pvParameters)
 {
     ESP_LOGI(TAG, "MQTT control task started");
     
-    mqtt_message_t message;
+    mqtt_message_t *message = NULL;
     
     while (1) {
         if (mqtt_receive_message(&g_mqtt_config, &message, 1000)) {
             ESP_LOGI(TAG, "Received MQTT message - Topic: %s, Payload: %s", 
-                     message.topic, message.payload);
+                     message->topic, message->payload);
             
             // Xử lý message điều khiển
-            if (strstr(message.topic, "control") != NULL) {
-                cJSON *json = cJSON_Parse(message.payload);
-                if (json != NULL) {
-                    cJSON *cmd = cJSON_GetObjectItem(json, "command");
-                    if (cmd != NULL && cJSON_IsString(cmd)) {
-                        const char *command = cJSON_GetStringValue(cmd);
-                        
-                        if (strcmp(command, "buzzer_on") == 0) {
-                            buzzer_set_mode(&g_buzzer, BUZZER_NORMAL);
-                            ESP_LOGI(TAG, "Buzzer turned on via MQTT");
-                        } else if (strcmp(command, "buzzer_off") == 0) {
-                            buzzer_set_mode(&g_buzzer, BUZZER_OFF);
-                            ESP_LOGI(TAG, "Buzzer turned off via MQTT");
-                        } else if (strcmp(command, "test_alarm") == 0) {
-                            buzzer_set_mode(&g_buzzer, BUZZER_ALARM);
-                            vTaskDelay(pdMS_TO_TICKS(3000));
-                            buzzer_set_mode(&g_buzzer, BUZZER_OFF);
-                            ESP_LOGI(TAG, "Test alarm executed via MQTT");
-                        }
-                    }
-                    cJSON_Delete(json);
-                }
+            if (strcmp(message->topic, MQTT_TOPIC_CONTROL) == 0) {
+                command_dispatch(message->payload);
             }
+            
+            // Trả block về pool nhận
+            mqtt_release_message(&g_mqtt_config, message);
         }
     }
 }
 
-void app_main(void)
+// Thao tác trên link cho bộ giám sát kết nối
+static int wifi_link_connect(void *ctx)
 {
-    ESP_LOGI(TAG, "=== Hệ thống báo cháy ESP32 khởi động ===");
+    return wifi_start_connect((wifi_manager_t *)ctx);
+}
+
+static void wifi_link_disconnect(void *ctx)
+{
+    wifi_abort_connect((wifi_manager_t *)ctx);
+}
+
+static conn_link_status_t wifi_link_poll(void *ctx)
+{
+    wifi_manager_t *manager = (wifi_manager_t *)ctx;
     
-    // 1. Khởi tạo cảm biến
-    ESP_LOGI(TAG, "Initializing sensors...");
-    if (sensor_system_init(&g_sensor_status) != 0) {
-        ESP_LOGE(TAG, "Failed to initialize sensors");
-        return;
+    if (wifi_is_connected(manager)) {
+        return CONN_LINK_STATUS_UP;
     }
-    ESP_LOGI(TAG, "Sensors initialized successfully");
+    return (xEventGroupGetBits(manager->event_group) & WIFI_FAIL_BIT) ?
+           CONN_LINK_STATUS_DOWN : CONN_LINK_STATUS_PENDING;
+}
+
+static int mqtt_link_connect(void *ctx)
+{
+    return mqtt_connect((mqtt_config_t *)ctx);
+}
+
+static void mqtt_link_disconnect(void *ctx)
+{
+    mqtt_disconnect((mqtt_config_t *)ctx);
+}
+
+static conn_link_status_t mqtt_link_poll(void *ctx)
+{
+    mqtt_config_t *config = (mqtt_config_t *)ctx;
     
-    // 2. Khởi tạo buzzer
-    ESP_LOGI(TAG, "Initializing buzzer...");
-    if (buzzer_init(&g_buzzer, BUZZER_GPIO_PIN) != 0) {
-        ESP_LOGE(TAG, "Failed to initialize buzzer");
-        return;
+    if (mqtt_is_connected(config)) {
+        return CONN_LINK_STATUS_UP;
     }
-    buzzer_set_mode(&g_buzzer, BUZZER_OFF);
-    ESP_LOGI(TAG, "Buzzer initialized successfully");
+    return config->connect_failed ? CONN_LINK_STATUS_DOWN : CONN_LINK_STATUS_PENDING;
+}
+
+static uint32_t mqtt_link_rx_activity(void *ctx)
+{
+    return ((mqtt_config_t *)ctx)->rx_events;
+}
+
+static uint32_t mqtt_link_tx_activity(void *ctx)
+{
+    return ((mqtt_config_t *)ctx)->tx_acked_publishes;
+}
+
+/**
+ * @brief Task mạng (chạy song song với cảm biến và báo động cục bộ)
+ *
+ * Khởi tạo WiFi và MQTT rồi chạy bộ giám sát kết nối: kết nối lại với backoff
+ * và jitter, phát hiện MQTT bị treo. Mất mạng không ảnh hưởng tới phát hiện
+ * cháy và còi.
+ */
+void network_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "Network task started");
     
-    // 3. Khởi tạo và kết nối WiFi
     ESP_LOGI(TAG, "Initializing WiFi...");
     if (wifi_init(&g_wifi_manager, WIFI_SSID, WIFI_PASSWORD) != 0) {
-        ESP_LOGE(TAG, "Failed to initialize WiFi");
+        ESP_LOGE(TAG, "Failed to initialize WiFi, running without network");
+        vTaskDelete(NULL);
         return;
     }
     
-    ESP_LOGI(TAG, "Connecting to WiFi: %s", WIFI_SSID);
-    if (wifi_connect(&g_wifi_manager) != 0) {
-        ESP_LOGE(TAG, "Failed to connect to WiFi");
+    ESP_LOGI(TAG, "Initializing MQTT...");
+    if (mqtt_init(&g_mqtt_config, MQTT_BROKER_URI, MQTT_USERNAME, 
+                  MQTT_PASSWORD, MQTT_CLIENT_ID, MQTT_USE_TLS) != 0) {
+        ESP_LOGE(TAG, "Failed to initialize MQTT, running without network");
+        vTaskDelete(NULL);
         return;
     }
-    ESP_LOGI(TAG, "WiFi connected successfully");
     
-    // Hiển thị địa chỉ IP
-    char ip_str[16];
-    if (wifi_get_ip_address(ip_str) == 0) {
-        ESP_LOGI(TAG, "IP Address: %s", ip_str);
+    const conn_link_ops_t wifi_ops = {
+        .connect = wifi_link_connect,
+        .disconnect = wifi_link_disconnect,
+        .poll = wifi_link_poll,
+        .ctx = &g_wifi_manager,
+    };
+    const conn_link_ops_t mqtt_ops = {
+        .connect = mqtt_link_connect,
+        .disconnect = mqtt_link_disconnect,
+        .poll = mqtt_link_poll,
+        .rx_activity = mqtt_link_rx_activity,
+        .tx_activity = mqtt_link_tx_activity,
+        .ctx = &g_mqtt_config,
+    };
+    
+    conn_supervisor_init(esp_random());
+    conn_supervisor_add(CONN_LINK_WIFI, &wifi_ops, &WIFI_CONN_POLICY, CONN_LINK_COUNT);
+    conn_supervisor_add(CONN_LINK_MQTT, &mqtt_ops, &MQTT_CONN_POLICY, CONN_LINK_WIFI);
+    
+    // Task xử lý message MQTT (ưu tiên trung bình)
+    xTaskCreate(mqtt_control_task, "mqtt_control_task", 4096, NULL, 
+                configMAX_PRIORITIES - 3, NULL);
+    
+    // Task MQTT (ưu tiên thấp, trạng thái mỗi 5s)
+    xTaskCreate(mqtt_task, "mqtt_task", 4096, &g_mqtt_config, 
+                configMAX_PRIORITIES - 4, NULL);
+    
+    bool wifi_logged = false;
+    bool mqtt_logged = false;
+    while (1) {
+        conn_supervisor_step((uint32_t)(esp_timer_get_time() / 1000));
+        
+        // Mốc khởi động: chỉ lần kết nối đầu tiên
+        if (!wifi_logged && wifi_is_connected(&g_wifi_manager)) {
+            wifi_logged = true;
+            boot_timeline_mark(BOOT_STAGE_WIFI_CONNECTED);
+            
+            char ip_str[16];
+            if (wifi_get_ip_address(ip_str) == 0) {
+                ESP_LOGI(TAG, "IP Address: %s", ip_str);
+            }
+            ESP_LOGI(TAG, "Boot to IP: %" PRIu32 " ms (WiFi connect: %" PRIu32 " ms, %s)",
+                     g_wifi_manager.boot_to_ip_ms, g_wifi_manager.connect_to_ip_ms,
+                     g_wifi_manager.fast_connect ? "fast connect" : "full scan + DHCP");
+        }
+        if (!mqtt_logged && mqtt_is_connected(&g_mqtt_config)) {
+            mqtt_logged = true;
+            boot_timeline_mark(BOOT_STAGE_MQTT_CONNECTED);
+            boot_timeline_log();
+        }
+        
+        vTaskDelay(pdMS_TO_TICKS(CONN_SUPERVISOR_PERIOD_MS));
     }
+}
+
+void app_main(void)
+{
+    boot_timeline_mark(BOOT_STAGE_APP_MAIN);
+    ESP_LOGI(TAG, "=== Hệ thống báo cháy ESP32 khởi động ===");
     
-    // 4. Khởi tạo và kết nối MQTT
-    ESP_LOGI(TAG, "Initializing MQTT...");
-    if (mqtt_init(&g_mqtt_config, MQTT_BROKER_URI, MQTT_USERNAME, 
-                  MQTT_PASSWORD, MQTT_CLIENT_ID, MQTT_USE_TLS) != 0) {
-        ESP_LOGE(TAG, "Failed to initialize MQTT");
-        return;
+    // Điểm đo độ trễ đường nóng, trước khi các task ghi sự kiện
+    if (trace_init() != 0) {
+        ESP_LOGW(TAG, "Trace unavailable, hot-path latency is not recorded");
     }
     
-    ESP_LOGI(TAG, "Connecting to MQTT broker...");
-    if (mqtt_connect(&g_mqtt_config) != 0) {
-        ESP_LOGE(TAG, "Failed to connect to MQTT broker");
+    // Giai đoạn 1: phát hiện cháy và báo động cục bộ, không phụ thuộc mạng
+    ESP_LOGI(TAG, "Initializing sensors...");
+    if (sensor_system_init(&g_sensor_status) != 0) {
+        ESP_LOGE(TAG, "Failed to initialize sensors");
         return;
     }
+    boot_timeline_mark(BOOT_STAGE_SENSORS_READY);
+    ESP_LOGI(TAG, "Sensors initialized successfully");
     
-    // Đợi một chút để MQTT kết nối
-    vTaskDelay(pdMS_TO_TICKS(2000));
-    
-    if (mqtt_is_connected(&g_mqtt_config)) {
-        ESP_LOGI(TAG, "MQTT connected successfully");
-    } else {
-        ESP_LOGW(TAG, "MQTT connection pending...");
+    ESP_LOGI(TAG, "Initializing buzzer...");
+    if (buzzer_init(&g_buzzer, BUZZER_GPIO_PIN) != 0) {
+        ESP_LOGE(TAG, "Failed to initialize buzzer");
+        return;
     }
+    buzzer_set_mode(&g_buzzer, BUZZER_OFF);
+    boot_timeline_mark(BOOT_STAGE_ALARM_READY);
+    ESP_LOGI(TAG, "Buzzer initialized successfully");
     
-    // 5. Tạo các FreeRTOS tasks
-    ESP_LOGI(TAG, "Creating FreeRTOS tasks...");
+    // Task cảnh báo (ưu tiên cao, chờ sự kiện cháy từ sensor_task)
+    TaskHandle_t warning_handle = NULL;
+    xTaskCreate(warning_task, "warning_task", 4096, NULL, 
+                configMAX_PRIORITIES - 1, &warning_handle);
+    sensor_set_event_task(warning_handle);
+    
+    // Queue mẫu cho bộ gom telemetry (đủ chỗ cho một batch)
+    g_sample_queue = xQueueCreate(TELEMETRY_BATCH_MAX_SAMPLES, sizeof(sensor_status_t));
+    sensor_set_sample_queue(g_sample_queue);
     
     // Task đọc cảm biến (ưu tiên cao, chu kỳ 500ms)
     xTaskCreate(sensor_task, "sensor_task", 4096, &g_sensor_status, 
@@ -235,33 +525,165 @@ void app_main(void)
     // Task điều khiển buzzer (ưu tiên cao)
     xTaskCreate(buzzer_task, "buzzer_task", 2048, &g_buzzer, 
                 configMAX_PRIORITIES - 2, NULL);
+    boot_timeline_mark(BOOT_STAGE_LOCAL_READY);
+    ESP_LOGI(TAG, "Local detection and alarm running");
     
-    // Task cảnh báo (ưu tiên cao, xử lý khi phát hiện cháy)
-    xTaskCreate(warning_task, "warning_task", 4096, NULL, 
-                configMAX_PRIORITIES - 1, NULL);
+    // Giai đoạn 2: đường gửi dữ liệu (hoạt động cả khi chưa có mạng: lưu flash)
+    if (saf_init() != 0) {
+        ESP_LOGW(TAG, "Store-and-forward unavailable, data is lost while MQTT is offline");
+    }
     
-    // Task gửi dữ liệu cảm biến lên MQTT (ưu tiên trung bình, chu kỳ 5s)
-    xTaskCreate(mqtt_sensor_task, "mqtt_sensor_task", 4096, NULL, 
-                configMAX_PRIORITIES - 3, NULL);
+    if (mqtt_egress_init(&g_mqtt_config) != 0 || control_commands_init() != 0) {
+        ESP_LOGE(TAG, "Failed to initialize MQTT egress/control commands");
+    }
     
-    // Task xử lý message MQTT (ưu tiên trung bình)
-    xTaskCreate(mqtt_control_task, "mqtt_control_task", 4096, NULL, 
+    // Task duy nhất publish MQTT: cảnh báo > telemetry > trạng thái, gửi lại dữ liệu tồn đọng trên flash
+    xTaskCreate(mqtt_egress_task, "mqtt_egress_task", 4096, NULL, 
+                configMAX_PRIORITIES - 2, NULL);
+    
+    // Task gửi dữ liệu cảm biến lên MQTT theo batch (ưu tiên trung bình, tối đa 5s/batch)
+    xTaskCreate(mqtt_sensor_task, "mqtt_sensor_task", 4096, NULL, 
                 configMAX_PRIORITIES - 3, NULL);
     
-    // Task MQTT (ưu tiên thấp, chu kỳ 30s)
-    xTaskCreate(mqtt_task, "mqtt_task", 4096, &g_mqtt_config, 
+    // Giai đoạn 3: WiFi + MQTT chạy nền, không chặn app_main
+    xTaskCreate(network_task, "network_task", 4096, NULL, 
                 configMAX_PRIORITIES - 4, NULL);
     
     ESP_LOGI(TAG, "=== Hệ thống đã sẵn sàng ===");
-    ESP_LOGI(TAG, "All tasks started. System is running...");
+    ESP_LOGI(TAG, "All tasks started, networking continues in background");
+    boot_timeline_log();
     
     // Main task có thể làm việc khác hoặc đợi
+    sensor_status_t snapshot = {0};
     while (1) {
+        sensor_snapshot_acquire(&snapshot);
+        
         // Hiển thị trạng thái hệ thống định kỳ
         ESP_LOGI(TAG, "System Status - WiFi: %s, MQTT: %s, Fire: %s",
                  wifi_is_connected(&g_wifi_manager) ? "Connected" : "Disconnected",
                  mqtt_is_connected(&g_mqtt_config) ? "Connected" : "Disconnected",
-                 g_sensor_status.fire_detected ? "DETECTED" : "Normal");
+                 snapshot.fire_detected ? "DETECTED" : "Normal");
+        
+        alarm_latency_stats_t alarm_latency;
+        portENTER_CRITICAL(&g_alarm_latency_lock);
+        alarm_latency = g_alarm_latency;
+        portEXIT_CRITICAL(&g_alarm_latency_lock);
+        if (alarm_latency.count > 0) {
+            ESP_LOGI(TAG, "Alarm latency - count: %" PRIu32 ", last: %" PRIu32 " us, max: %" PRIu32 " us, avg: %" PRIu32 " us",
+                     alarm_latency.count, alarm_latency.last_us, alarm_latency.max_us,
+                     (uint32_t)(alarm_latency.total_us / alarm_latency.count));
+        }
+        
+        const telemetry_batch_stats_t *batch = &g_telemetry_batch.stats;
+        if (batch->samples > 0) {
+            ESP_LOGI(TAG, "Telemetry batch - batches: %" PRIu32 ", samples: %" PRIu32 ", bytes/sample: %" PRIu32 ", "
+                     "latency last/max: %" PRIu32 "/%" PRIu32 " ms, discarded: %" PRIu32 ", dropped: %" PRIu32,
+                     batch->batches, batch->samples, batch->bytes / batch->samples,
+                     batch->last_latency_ms, batch->max_latency_ms,
+                     batch->discarded, batch->dropped + sensor_get_sample_drops());
+        }
+        
+        saf_stats_t saf_alert;
+        saf_stats_t saf_data;
+        saf_get_stats(SAF_LOG_ALERT, &saf_alert);
+        saf_get_stats(SAF_LOG_TELEMETRY, &saf_data);
+        if (saf_alert.appended > 0 || saf_data.appended > 0) {
+            ESP_LOGI(TAG, "Store-and-forward - alert pending: %" PRIu32 ", data pending: %" PRIu32 ", drained: %" PRIu32 ", dropped: %" PRIu32,
+                     saf_alert.pending, saf_data.pending, saf_alert.drained + saf_data.drained,
+                     saf_alert.dropped + saf_data.dropped);
+        }
+        
+        static const char *const egress_names[MQTT_EGRESS_CLASS_COUNT] = { "alert", "telemetry", "status" };
+        for (int cls = 0; cls < MQTT_EGRESS_CLASS_COUNT; cls++) {
+            mqtt_egress_stats_t egress;
+            mqtt_egress_get_stats((mqtt_egress_class_t)cls, &egress);
+            if (egress.enqueued == 0) {
+                continue;
+            }
+            ESP_LOGI(TAG, "MQTT egress %s - sent: %" PRIu32 ", spilled: %" PRIu32 ", dropped: %" PRIu32 ", latency avg/max: %" PRIu32 "/%" PRIu32 " us",
+                     egress_names[cls], egress.sent, egress.spilled, egress.dropped,
+                     egress.sent > 0 ? (uint32_t)(egress.latency_total_us / egress.sent) : 0,
+                     egress.latency_max_us);
+        }
+        
+        telemetry_alert_stats_t alert;
+        mqtt_egress_get_alert_stats(&alert);
+        if (alert.confirmed + alert.tracked + alert.expired > 0) {
+            ESP_LOGI(TAG, "Alert delivery - confirmed: %" PRIu32 ", pending: %" PRIu32 ", retransmits: %" PRIu32 ", expired: %" PRIu32 ", "
+                     "detect->ack avg/p95/max: %" PRIu32 "/%" PRIu32 "/%" PRIu32 " us",
+                     alert.confirmed, alert.tracked, alert.retransmits, alert.expired,
+                     alert.latency.count > 0 ? (uint32_t)(alert.latency.total_us / alert.latency.count) : 0,
+                     latency_hist_percentile(&alert.latency, 95), alert.latency.max_us);
+        }
+        
+        mqtt_rx_stats_t rx;
+        mqtt_get_rx_stats(&g_mqtt_config, &rx);
+        if (rx.received > 0 || rx.pool_exhausted + rx.oversize + rx.incomplete + rx.queue_full > 0) {
+            ESP_LOGI(TAG, "MQTT rx - received: %" PRIu32 ", fragmented: %" PRIu32 ", dropped pool/oversize/incomplete/queue: %" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32,
+                     rx.received, rx.fragmented, rx.pool_exhausted, rx.oversize, rx.incomplete, rx.queue_full);
+        }
+        
+        for (int i = 0; i < CONN_LINK_COUNT; i++) {
+            conn_link_stats_t link;
+            conn_supervisor_get_stats((conn_link_t)i, &link);
+            if (link.drops + link.failures == 0) {
+                continue;
+            }
+            ESP_LOGI(TAG, "Link %s - %s, reconnects: %" PRIu32 ", failures: %" PRIu32 ", stalls: %" PRIu32 ", "
+                     "down: %" PRIu32 " ms, reconnect last/max: %" PRIu32 "/%" PRIu32 " ms",
+                     conn_supervisor_link_name((conn_link_t)i), conn_supervisor_state_name(link.state),
+                     link.reconnects, link.failures, link.stalls, link.down_total_ms,
+                     link.reconnect_last_ms, link.reconnect_max_ms);
+        }
+        
+        command_stats_t cmd;
+        command_get_stats(&cmd);
+        if (cmd.dispatched + cmd.unknown + cmd.parse_errors > 0) {
+            ESP_LOGI(TAG, "Control commands - dispatched: %" PRIu32 ", unknown: %" PRIu32 ", invalid: %" PRIu32,
+                     cmd.dispatched, cmd.unknown, cmd.parse_errors);
+        }
+        
+        const telemetry_rbe_stats_t *rbe = &g_telemetry_rbe.stats;
+        if (TELEMETRY_RBE_ENABLED) {
+            ESP_LOGI(TAG, "Report-by-exception - reported: %" PRIu32 ", heartbeats: %" PRIu32 ", suppressed: %" PRIu32,
+                     rbe->reported, rbe->heartbeats, rbe->suppressed);
+        }
+        
+        // CPU tính trên chu kỳ log này, stack/heap là mức thấp nhất từ khi khởi động
+        if (task_diag_sample(&g_task_diag) == 0) {
+            const task_diag_task_t *min_stack = task_diag_min_stack(&g_task_diag);
+            const task_diag_task_t *max_cpu = task_diag_max_cpu(&g_task_diag);
+            ESP_LOGI(TAG, "Diagnostics - heap free/min/largest: %" PRIu32 "/%" PRIu32 "/%" PRIu32 ", tasks: %u, "
+                     "min stack free: %s %" PRIu32 " B, max CPU: %s %u.%u%%",
+                     g_task_diag.heap_free, g_task_diag.heap_min_free, g_task_diag.heap_largest_block,
+                     g_task_diag.total_tasks,
+                     min_stack ? min_stack->name : "-", min_stack ? min_stack->stack_free_min : 0,
+                     max_cpu ? max_cpu->name : "-", max_cpu ? max_cpu->cpu_permille / 10 : 0,
+                     max_cpu ? max_cpu->cpu_permille % 10 : 0);
+            
+            if (mqtt_is_connected(&g_mqtt_config)) {
+                int len = telemetry_build_diag_json(g_diag_payload, sizeof(g_diag_payload),
+                                                    esp_log_timestamp(), &g_task_diag);
+                if (len > 0) {
+                    mqtt_egress_enqueue(MQTT_EGRESS_TOPIC_DIAG, (const uint8_t *)g_diag_payload, len);
+                }
+            }
+        }
+        
+        // Độ trễ theo điểm đo: stage tính từ điểm trước, total từ frame ADC
+        trace_fold();
+        for (int i = TRACE_SENSOR_EVALUATED; i < TRACE_POINT_COUNT; i++) {
+            trace_stats_t trace;
+            if (trace_get_stats((trace_point_t)i, &trace) != 0 || trace.stage.count == 0) {
+                continue;
+            }
+            ESP_LOGI(TAG, "Trace %s - count: %" PRIu32 ", stage p50/p95/p99/max: %" PRIu32 "/%" PRIu32 "/%" PRIu32 "/%" PRIu32 " us, "
+                     "total p99/max: %" PRIu32 "/%" PRIu32 " us, unmatched: %" PRIu32,
+                     trace_point_name((trace_point_t)i), trace.stage.count,
+                     latency_hist_percentile(&trace.stage, 50), latency_hist_percentile(&trace.stage, 95),
+                     latency_hist_percentile(&trace.stage, 99), trace.stage.max_us,
+                     latency_hist_percentile(&trace.total, 99), trace.total.max_us, trace.unmatched);
+        }
         
         vTaskDelay(pdMS_TO_TICKS(30000)); // Log mỗi 30 giây
     }
@@ -1,6 +1,8 @@
 #include "mqtt.h"
 #include "esp_log.h"
-#include "cJSON.h"
+#include "telemetry/telemetry.h"
+#include "mqtt_egress/mqtt_egress.h"
+#include "conn_supervisor/conn_supervisor.h"
 #include <string.h>
 #include <stdlib.h>
 
@@ -12,9 +14,98 @@ static const char *TAG = "MQTT";
 
 // Topics mặc định
 #define TOPIC_SENSOR_DATA "fire_system/sensor/data"
+#define TOPIC_SENSOR_DATA_BIN "fire_system/sensor/data/bin"
 #define TOPIC_ALERT       "fire_system/alert"
+#define TOPIC_ALERT_BIN   "fire_system/alert/bin"
 #define TOPIC_STATUS      "fire_system/status"
-#define TOPIC_CONTROL     "fire_system/control"
+#define TOPIC_DIAG        "fire_system/diag"
+#define TOPIC_CONTROL     MQTT_TOPIC_CONTROL
+
+// Lệnh vừa block (cùng header và topic) đến trong một MQTT_EVENT_DATA
+_Static_assert(MQTT_RX_BUFFER_SIZE >= MQTT_PAYLOAD_MAX_LEN + MQTT_TOPIC_MAX_LEN,
+               "rx buffer must hold a full pool block and its topic");
+
+// ===============================
+// RX POOL
+// ===============================
+
+/**
+ * @brief Bỏ message đang ghép dở (thiếu fragment), trả block về pool
+ */
+static void mqtt_rx_abort(mqtt_config_t *config)
+{
+    if (config->rx_pending == NULL) return;
+
+    config->rx_stats.incomplete++;
+    xQueueSend(config->rx_free_queue, &config->rx_pending, 0);
+    config->rx_pending = NULL;
+}
+
+/**
+ * @brief Ghi một fragment MQTT_EVENT_DATA thẳng vào block của pool
+ *
+ * Fragment đầu (offset 0) mang topic và lấy một block từ pool; các fragment
+ * sau được ghép vào đúng vị trí. Khi đủ total_data_len, con trỏ block được
+ * đưa vào message_queue. Message không vừa block bị bỏ và đếm, không cắt cụt.
+ */
+static void mqtt_handle_data(mqtt_config_t *config, esp_mqtt_event_handle_t event)
+{
+    mqtt_rx_stats_t *stats = &config->rx_stats;
+    int offset = event->current_data_offset;
+
+    if (offset == 0) {
+        mqtt_rx_abort(config);
+
+        if (event->total_data_len >= MQTT_PAYLOAD_MAX_LEN || event->topic_len >= MQTT_TOPIC_MAX_LEN) {
+            stats->oversize++;
+            ESP_LOGW(TAG, "MQTT message too large (%d bytes), dropped", event->total_data_len);
+            return;
+        }
+
+        mqtt_message_t *msg = NULL;
+        if (xQueueReceive(config->rx_free_queue, &msg, 0) != pdTRUE) {
+            stats->pool_exhausted++;
+            ESP_LOGW(TAG, "MQTT rx pool exhausted, message dropped");
+            return;
+        }
+
+        memcpy(msg->topic, event->topic, event->topic_len);
+        msg->topic[event->topic_len] = '\0';
+        msg->payload_len = 0;
+        msg->qos = event->qos;
+        msg->retain = event->retain;
+        config->rx_pending = msg;
+    }
+
+    // Các fragment của message đã bị bỏ được bỏ qua
+    mqtt_message_t *msg = config->rx_pending;
+    if (msg == NULL) return;
+
+    // Fragment phải liền mạch và nằm trong block
+    if (offset != msg->payload_len || event->data_len < 0 ||
+        offset + event->data_len > event->total_data_len ||
+        event->total_data_len >= MQTT_PAYLOAD_MAX_LEN) {
+        mqtt_rx_abort(config);
+        return;
+    }
+
+    memcpy(msg->payload + offset, event->data, event->data_len);
+    msg->payload_len = offset + event->data_len;
+    if (msg->payload_len < event->total_data_len) return;
+
+    msg->payload[msg->payload_len] = '\0';
+    config->rx_pending = NULL;
+
+    if (xQueueSend(config->message_queue, &msg, 0) != pdTRUE) {
+        stats->queue_full++;
+        xQueueSend(config->rx_free_queue, &msg, 0);
+        return;
+    }
+    stats->received++;
+    if (offset > 0) {
+        stats->fragmented++;
+    }
+}
 
 // ===============================
 // MQTT EVENT HANDLER
@@ -29,6 +120,7 @@ void mqtt_event_handler(void *handler_args, esp_event_base_t base,
 
     case MQTT_EVENT_CONNECTED:
         ESP_LOGI(TAG, "MQTT Connected");
+        config->rx_events++;
         config->is_connected = true;
         esp_mqtt_client_subscribe(event->client, TOPIC_CONTROL, MQTT_QOS_1);
         break;
@@ -36,32 +128,25 @@ void mqtt_event_handler(void *handler_args, esp_event_base_t base,
     case MQTT_EVENT_DISCONNECTED:
         ESP_LOGW(TAG, "MQTT Disconnected");
         config->is_connected = false;
+        config->connect_failed = true;
+        mqtt_rx_abort(config);
         break;
 
-    case MQTT_EVENT_DATA: {
-        ESP_LOGI(TAG, "MQTT data received");
-
-        if (config->message_queue) {
-            mqtt_message_t msg;
-            memset(&msg, 0, sizeof(mqtt_message_t));
-
-            int tlen = event->topic_len;
-            if (tlen >= MQTT_TOPIC_MAX_LEN) tlen = MQTT_TOPIC_MAX_LEN - 1;
-            memcpy(msg.topic, event->topic, tlen);
-            msg.topic[tlen] = '\0';
-
-            int dlen = event->data_len;
-            if (dlen >= MQTT_PAYLOAD_MAX_LEN) dlen = MQTT_PAYLOAD_MAX_LEN - 1;
-            memcpy(msg.payload, event->data, dlen);
-            msg.payload[dlen] = '\0';
+    case MQTT_EVENT_SUBSCRIBED:
+    case MQTT_EVENT_UNSUBSCRIBED:
+        config->rx_events++;
+        break;
 
-            msg.qos = event->qos;
-            msg.retain = 0;
+    case MQTT_EVENT_PUBLISHED:
+        // Broker đã xác nhận message QoS 1 (PUBACK) / QoS 2 (PUBCOMP)
+        config->rx_events++;
+        mqtt_egress_on_published(event->msg_id);
+        break;
 
-            xQueueSend(config->message_queue, &msg, 0);
-        }
+    case MQTT_EVENT_DATA:
+        config->rx_events++;
+        mqtt_handle_data(config, event);
         break;
-    }
 
     case MQTT_EVENT_ERROR:
         ESP_LOGE(TAG, "MQTT error");
@@ -93,8 +178,15 @@ int mqtt_init(mqtt_config_t *config,
     if (username) strncpy(config->username, username, sizeof(config->username) - 1);
     if (password) strncpy(config->password, password, sizeof(config->password) - 1);
 
-    config->message_queue = xQueueCreate(10, sizeof(mqtt_message_t));
-    if (!config->message_queue) return -1;
+    // Queue chỉ chứa con trỏ tới block trong rx_pool
+    config->message_queue = xQueueCreate(MQTT_RX_POOL_SIZE, sizeof(mqtt_message_t *));
+    config->rx_free_queue = xQueueCreate(MQTT_RX_POOL_SIZE, sizeof(mqtt_message_t *));
+    if (!config->message_queue || !config->rx_free_queue) return -1;
+
+    for (int i = 0; i < MQTT_RX_POOL_SIZE; i++) {
+        mqtt_message_t *block = &config->rx_pool[i];
+        xQueueSend(config->rx_free_queue, &block, 0);
+    }
 
     esp_mqtt_client_config_t mqtt_cfg = {0};
 
@@ -105,6 +197,13 @@ int mqtt_init(mqtt_config_t *config,
     mqtt_cfg.credentials.username  = config->username;
     mqtt_cfg.credentials.authentication.password = config->password;
 
+    // Kết nối lại do bộ giám sát kết nối quyết định (backoff + jitter)
+    mqtt_cfg.network.disable_auto_reconnect = true;
+
+    // Message vẫn bị chia fragment (buffer nhỏ hơn) được ghép trong mqtt_handle_data()
+    mqtt_cfg.buffer.size = MQTT_RX_BUFFER_SIZE;
+    mqtt_cfg.buffer.out_size = MQTT_TX_BUFFER_SIZE;
+
     // TLS nếu bật
     if (use_tls) {
         mqtt_cfg.broker.verification.certificate = (const char *)hivemq_ca_pem_start;
@@ -126,16 +225,31 @@ int mqtt_init(mqtt_config_t *config,
 int mqtt_connect(mqtt_config_t *config)
 {
     if (!config || !config->client) return -1;
+
+    // Client đã chạy (lần thử trước thất bại): khởi động lại cho một lần kết nối mới
+    if (config->started) {
+        esp_mqtt_client_stop(config->client);
+        config->started = false;
+    }
+
     ESP_LOGI(TAG, "MQTT starting...");
-    return (esp_mqtt_client_start(config->client) == ESP_OK) ? 0 : -1;
+    config->connect_failed = false;
+    if (esp_mqtt_client_start(config->client) != ESP_OK) return -1;
+    config->started = true;
+    return 0;
 }
 
 // ===============================
 int mqtt_disconnect(mqtt_config_t *config)
 {
     if (!config || !config->client) return -1;
-    esp_mqtt_client_stop(config->client);
+    if (config->started) {
+        esp_mqtt_client_stop(config->client);
+        config->started = false;
+    }
     config->is_connected = false;
+    config->connect_failed = true;
+    mqtt_rx_abort(config);
     return 0;
 }
 
@@ -165,6 +279,18 @@ int mqtt_publish(mqtt_config_t *config, const char *topic,
 
     int id = esp_mqtt_client_publish(config->client, topic, payload,
                                      strlen(payload), qos, retain);
+    if (id >= 0 && qos > MQTT_QOS_0) config->tx_acked_publishes++;
+    return (id >= 0) ? id : -1;
+}
+
+int mqtt_publish_binary(mqtt_config_t *config, const char *topic,
+                        const uint8_t *data, size_t len, int qos, int retain)
+{
+    if (!config || !topic || !data || len == 0 || !config->is_connected) return -1;
+
+    int id = esp_mqtt_client_publish(config->client, topic, (const char *)data,
+                                     (int)len, qos, retain);
+    if (id >= 0 && qos > MQTT_QOS_0) config->tx_acked_publishes++;
     return (id >= 0) ? id : -1;
 }
 
@@ -179,9 +305,29 @@ int mqtt_publish_alert(mqtt_config_t *config, const char *alert_data)
     return mqtt_publish(config, TOPIC_ALERT, alert_data, MQTT_QOS_2, 1);
 }
 
+int mqtt_publish_sensor_data_bin(mqtt_config_t *config, const uint8_t *data, size_t len)
+{
+    return mqtt_publish_binary(config, TOPIC_SENSOR_DATA_BIN, data, len, MQTT_QOS_1, 0);
+}
+
+int mqtt_publish_alert_bin(mqtt_config_t *config, const uint8_t *data, size_t len)
+{
+    return mqtt_publish_binary(config, TOPIC_ALERT_BIN, data, len, MQTT_QOS_2, 1);
+}
+
+int mqtt_publish_status(mqtt_config_t *config, const char *status_data)
+{
+    return mqtt_publish(config, TOPIC_STATUS, status_data, MQTT_QOS_0, 0);
+}
+
+int mqtt_publish_diag(mqtt_config_t *config, const char *diag_data)
+{
+    return mqtt_publish(config, TOPIC_DIAG, diag_data, MQTT_QOS_0, 0);
+}
+
 // ===============================
 bool mqtt_receive_message(mqtt_config_t *config,
-                          mqtt_message_t *message,
+                          mqtt_message_t **message,
                           uint32_t timeout_ms)
 {
     if (!config || !message || !config->message_queue) return false;
@@ -190,24 +336,40 @@ bool mqtt_receive_message(mqtt_config_t *config,
     return xQueueReceive(config->message_queue, message, t) == pdTRUE;
 }
 
+void mqtt_release_message(mqtt_config_t *config, mqtt_message_t *message)
+{
+    if (!config || !message || !config->rx_free_queue) return;
+    xQueueSend(config->rx_free_queue, &message, 0);
+}
+
+void mqtt_get_rx_stats(mqtt_config_t *config, mqtt_rx_stats_t *stats)
+{
+    if (!config || !stats) return;
+    memcpy(stats, &config->rx_stats, sizeof(mqtt_rx_stats_t));
+}
+
 // ===============================
 void mqtt_task(void *pvParameters)
 {
     mqtt_config_t *config = (mqtt_config_t *)pvParameters;
     if (!config) vTaskDelete(NULL);
 
+    static char status_payload[MQTT_EGRESS_STATUS_MAX_LEN];
+
     while (1) {
         if (config->is_connected) {
-            cJSON *root = cJSON_CreateObject();
-            cJSON_AddStringToObject(root, "status", "online");
-            cJSON_AddNumberToObject(root, "uptime", esp_log_timestamp());
-
-            char *buf = cJSON_Print(root);
-            if (buf) {
-                mqtt_publish(config, TOPIC_STATUS, buf, MQTT_QOS_0, 0);
-                free(buf);
+            // Gửi qua task egress, sau cảnh báo và telemetry
+            telemetry_alert_stats_t alert;
+            conn_link_stats_t links[CONN_LINK_COUNT];
+            mqtt_egress_get_alert_stats(&alert);
+            for (int i = 0; i < CONN_LINK_COUNT; i++) {
+                conn_supervisor_get_stats((conn_link_t)i, &links[i]);
+            }
+            int len = telemetry_build_status_json(status_payload, sizeof(status_payload),
+                                                  esp_log_timestamp(), &alert, links);
+            if (len > 0) {
+                mqtt_egress_enqueue(MQTT_EGRESS_TOPIC_STATUS, (const uint8_t *)status_payload, len);
             }
-            cJSON_Delete(root);
         }
         vTaskDelay(pdMS_TO_TICKS(5000));
     }
@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stddef.h>
 #include "mqtt_client.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -15,12 +16,39 @@
 #define MQTT_CLIENT_ID_MAX_LEN 32
 #define MQTT_TOPIC_MAX_LEN 128
 #define MQTT_PAYLOAD_MAX_LEN 512
+#ifndef MQTT_RX_BUFFER_SIZE
+#define MQTT_RX_BUFFER_SIZE 1024   // Buffer nhận của esp-mqtt, chứa trọn một lệnh vừa block cùng header và topic
+#endif
+#define MQTT_TX_BUFFER_SIZE 1024   // Buffer gửi (mặc định của esp-mqtt)
+#define MQTT_RX_POOL_SIZE 4     // Số block nhận, mỗi block chứa một message
+
+// Topic nhận lệnh điều khiển
+#define MQTT_TOPIC_CONTROL "fire_system/control"
 
 // QoS levels
 #define MQTT_QOS_0 0
 #define MQTT_QOS_1 1
 #define MQTT_QOS_2 2
 
+// Cấu trúc message MQTT (một block trong pool nhận)
+typedef struct {
+    char topic[MQTT_TOPIC_MAX_LEN];
+    char payload[MQTT_PAYLOAD_MAX_LEN];
+    int payload_len;
+    int qos;
+    int retain;
+} mqtt_message_t;
+
+// Thống kê đường nhận
+typedef struct {
+    uint32_t received;          // Số message đã đưa tới task xử lý
+    uint32_t fragmented;        // Số message được ghép từ nhiều fragment
+    uint32_t pool_exhausted;    // Bỏ vì hết block trong pool
+    uint32_t oversize;          // Bỏ vì payload/topic lớn hơn block
+    uint32_t incomplete;        // Bỏ vì thiếu fragment
+    uint32_t queue_full;        // Bỏ vì queue message đầy
+} mqtt_rx_stats_t;
+
 // Cấu trúc cấu hình MQTT
 typedef struct {
     char uri[MQTT_URI_MAX_LEN];
@@ -29,18 +57,18 @@ typedef struct {
     char client_id[MQTT_CLIENT_ID_MAX_LEN];
     bool use_tls;
     bool is_connected;
+    bool started;                           // esp_mqtt_client_start() đã được gọi
+    bool connect_failed;                    // Lần kết nối gần nhất thất bại hoặc đã mất kết nối
+    uint32_t rx_events;                     // Số gói nhận từ broker (CONNACK, PUBACK, DATA, ...)
+    uint32_t tx_acked_publishes;            // Số message QoS > 0 đã gửi (chờ broker phản hồi)
     esp_mqtt_client_handle_t client;
-    QueueHandle_t message_queue;
+    QueueHandle_t message_queue;            // Con trỏ tới block đã nhận đủ
+    QueueHandle_t rx_free_queue;            // Con trỏ tới block còn trống
+    mqtt_message_t rx_pool[MQTT_RX_POOL_SIZE];
+    mqtt_message_t *rx_pending;             // Block đang ghép fragment
+    mqtt_rx_stats_t rx_stats;
 } mqtt_config_t;
 
-// Cấu trúc message MQTT
-typedef struct {
-    char topic[MQTT_TOPIC_MAX_LEN];
-    char payload[MQTT_PAYLOAD_MAX_LEN];
-    int qos;
-    int retain;
-} mqtt_message_t;
-
 /**
  * @brief Khởi tạo MQTT client
  * @param config Con trỏ đến cấu trúc cấu hình MQTT
@@ -55,7 +83,11 @@ int mqtt_init(mqtt_config_t *config, const char *uri, const char *username,
               const char *password, const char *client_id, bool use_tls);
 
 /**
- * @brief Kết nối MQTT broker
+ * @brief Bắt đầu một lần kết nối MQTT broker (không chặn)
+ *
+ * Client không tự kết nối lại; nếu lần thử thất bại hoặc mất kết nối,
+ * connect_failed được đặt và người gọi gọi lại hàm này (client được khởi động lại).
+ *
  * @param config Con trỏ đến cấu trúc cấu hình MQTT
  * @return 0 nếu thành công, -1 nếu lỗi
  */
@@ -104,6 +136,19 @@ int mqtt_unsubscribe(mqtt_config_t *config, const char *topic);
 int mqtt_publish(mqtt_config_t *config, const char *topic, const char *payload,
                  int qos, int retain);
 
+/**
+ * @brief Gửi payload nhị phân lên MQTT broker
+ * @param config Con trỏ đến cấu trúc cấu hình MQTT
+ * @param topic Topic để publish
+ * @param data Dữ liệu
+ * @param len Độ dài dữ liệu (bytes)
+ * @param qos QoS level (0, 1, hoặc 2)
+ * @param retain Retain flag
+ * @return Message ID nếu thành công, -1 nếu lỗi
+ */
+int mqtt_publish_binary(mqtt_config_t *config, const char *topic,
+                        const uint8_t *data, size_t len, int qos, int retain);
+
 /**
  * @brief Gửi dữ liệu cảm biến lên MQTT
  * @param config Con trỏ đến cấu trúc cấu hình MQTT
@@ -121,15 +166,67 @@ int mqtt_publish_sensor_data(mqtt_config_t *config, const char *sensor_data);
 int mqtt_publish_alert(mqtt_config_t *config, const char *alert_data);
 
 /**
- * @brief Nhận message từ queue
+ * @brief Gửi frame nhị phân dữ liệu cảm biến lên topic sensor/data/bin
  * @param config Con trỏ đến cấu trúc cấu hình MQTT
- * @param message Con trỏ đến cấu trúc message
+ * @param data Frame nhị phân
+ * @param len Độ dài frame (bytes)
+ * @return Message ID nếu thành công, -1 nếu lỗi
+ */
+int mqtt_publish_sensor_data_bin(mqtt_config_t *config, const uint8_t *data, size_t len);
+
+/**
+ * @brief Gửi frame nhị phân cảnh báo cháy lên topic alert/bin
+ * @param config Con trỏ đến cấu trúc cấu hình MQTT
+ * @param data Frame nhị phân
+ * @param len Độ dài frame (bytes)
+ * @return Message ID nếu thành công, -1 nếu lỗi
+ */
+int mqtt_publish_alert_bin(mqtt_config_t *config, const uint8_t *data, size_t len);
+
+/**
+ * @brief Gửi trạng thái thiết bị lên topic status
+ * @param config Con trỏ đến cấu trúc cấu hình MQTT
+ * @param status_data JSON string chứa trạng thái
+ * @return Message ID nếu thành công, -1 nếu lỗi
+ */
+int mqtt_publish_status(mqtt_config_t *config, const char *status_data);
+
+/**
+ * @brief Gửi thống kê chẩn đoán task/heap lên topic diag
+ * @param config Con trỏ đến cấu trúc cấu hình MQTT
+ * @param diag_data JSON string chứa thống kê
+ * @return Message ID nếu thành công, -1 nếu lỗi
+ */
+int mqtt_publish_diag(mqtt_config_t *config, const char *diag_data);
+
+/**
+ * @brief Nhận message từ queue (không sao chép)
+ *
+ * Message nằm trong block của pool nhận; phải trả lại bằng
+ * mqtt_release_message() sau khi xử lý xong.
+ *
+ * @param config Con trỏ đến cấu trúc cấu hình MQTT
+ * @param message Nhận con trỏ tới message
  * @param timeout_ms Timeout (ms)
  * @return true nếu nhận được message
  */
-bool mqtt_receive_message(mqtt_config_t *config, mqtt_message_t *message, 
+bool mqtt_receive_message(mqtt_config_t *config, mqtt_message_t **message, 
                          uint32_t timeout_ms);
 
+/**
+ * @brief Trả block của message về pool nhận
+ * @param config Con trỏ đến cấu trúc cấu hình MQTT
+ * @param message Message nhận từ mqtt_receive_message()
+ */
+void mqtt_release_message(mqtt_config_t *config, mqtt_message_t *message);
+
+/**
+ * @brief Lấy thống kê đường nhận
+ * @param config Con trỏ đến cấu trúc cấu hình MQTT
+ * @param stats Con trỏ đến cấu trúc thống kê
+ */
+void mqtt_get_rx_stats(mqtt_config_t *config, mqtt_rx_stats_t *stats);
+
 /**
  * @brief Event handler cho MQTT
  * @param handler_args Tham số handler
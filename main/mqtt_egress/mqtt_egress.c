@@ -0,0 +1,714 @@
+#include "mqtt_egress.h"
+#include <string.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "store_forward/store_forward.h"
+#include "trace/trace.h"
+
+static const char *TAG = "MQTT_EGRESS";
+
+#define EGRESS_MAX_DEPTH 4
+
+// Xác nhận tới sớm của cảnh báo được nhận ra nhờ message ID tăng dần
+#if !CONFIG_MQTT_MSG_ID_INCREMENTAL
+#error "mqtt_egress requires CONFIG_MQTT_MSG_ID_INCREMENTAL"
+#endif
+
+// Trạng thái slot: payload được sao chép ngoài s_lock, slot đang ghi/đọc không bị thay
+typedef enum {
+    EGRESS_SLOT_WRITING = 0,    // Task tạo message đang chép payload vào
+    EGRESS_SLOT_READY,
+    EGRESS_SLOT_READING,        // Task egress đang chép payload ra
+} egress_slot_state_t;
+
+// Một message trong hàng đợi, payload nằm trong vùng lưu trữ tĩnh của lớp
+typedef struct {
+    uint8_t topic;
+    uint8_t state;              // egress_slot_state_t
+    uint16_t len;
+    int64_t origin_us;          // Thời điểm sự kiện (cảnh báo: lúc phát hiện)
+    int64_t enqueue_us;
+} egress_slot_t;
+
+// Hàng đợi vòng của một lớp
+typedef struct {
+    egress_slot_t slot[EGRESS_MAX_DEPTH];
+    uint8_t *storage;           // depth * max_len bytes
+    uint16_t max_len;
+    uint8_t depth;
+    uint8_t head;               // Slot cũ nhất
+    uint8_t count;
+    mqtt_egress_stats_t stats;
+} egress_class_t;
+
+_Static_assert(MQTT_EGRESS_ALERT_DEPTH <= EGRESS_MAX_DEPTH &&
+               MQTT_EGRESS_ALERT_OVERFLOW_DEPTH <= EGRESS_MAX_DEPTH &&
+               MQTT_EGRESS_TELEMETRY_DEPTH <= EGRESS_MAX_DEPTH &&
+               MQTT_EGRESS_STATUS_DEPTH <= EGRESS_MAX_DEPTH, "egress depth exceeds EGRESS_MAX_DEPTH");
+_Static_assert(TELEMETRY_DIAG_JSON_MAX_LEN <= MQTT_EGRESS_STATUS_MAX_LEN, "diagnostics payload must fit a status slot");
+_Static_assert(MQTT_EGRESS_TELEMETRY_MAX_LEN <= SAF_RECORD_MAX_LEN, "telemetry payload must fit a store-and-forward record");
+
+static uint8_t s_alert_storage[MQTT_EGRESS_ALERT_DEPTH * MQTT_EGRESS_ALERT_MAX_LEN];
+static uint8_t s_telemetry_storage[MQTT_EGRESS_TELEMETRY_DEPTH * MQTT_EGRESS_TELEMETRY_MAX_LEN];
+static uint8_t s_status_storage[MQTT_EGRESS_STATUS_DEPTH * MQTT_EGRESS_STATUS_MAX_LEN];
+static uint8_t s_alert_overflow_storage[MQTT_EGRESS_ALERT_OVERFLOW_DEPTH * MQTT_EGRESS_ALERT_MAX_LEN];
+
+static egress_class_t s_class[MQTT_EGRESS_CLASS_COUNT] = {
+    [MQTT_EGRESS_ALERT]     = { .storage = s_alert_storage, .max_len = MQTT_EGRESS_ALERT_MAX_LEN,
+                                .depth = MQTT_EGRESS_ALERT_DEPTH },
+    [MQTT_EGRESS_TELEMETRY] = { .storage = s_telemetry_storage, .max_len = MQTT_EGRESS_TELEMETRY_MAX_LEN,
+                                .depth = MQTT_EGRESS_TELEMETRY_DEPTH },
+    [MQTT_EGRESS_STATUS]    = { .storage = s_status_storage, .max_len = MQTT_EGRESS_STATUS_MAX_LEN,
+                                .depth = MQTT_EGRESS_STATUS_DEPTH },
+};
+
+// Cảnh báo tới khi hàng đợi cảnh báo đầy; thống kê tính vào lớp cảnh báo
+static egress_class_t s_alert_overflow = {
+    .storage = s_alert_overflow_storage, .max_len = MQTT_EGRESS_ALERT_MAX_LEN,
+    .depth = MQTT_EGRESS_ALERT_OVERFLOW_DEPTH,
+};
+
+// Cảnh báo đã publish, chờ broker xác nhận
+typedef struct {
+    int msg_id;                 // 0 nếu slot trống
+    uint8_t topic;
+    uint8_t retries;
+    bool replay;                // Bản ghi cũ nhất của log cảnh báo trên flash, pop khi được xác nhận
+    uint16_t len;
+    int64_t origin_us;
+    int64_t enqueue_us;
+    int64_t publish_us;         // Lần publish đầu tiên
+    int64_t deadline_us;
+    uint8_t payload[MQTT_EGRESS_ALERT_MAX_LEN];
+} alert_track_t;
+
+static alert_track_t s_track[MQTT_EGRESS_ALERT_TRACK_MAX];
+
+// PUBCOMP có thể tới trước khi publish() trả về message ID của cảnh báo. Chỉ
+// task egress publish QoS > 0 và ID tăng dần, nên trong lúc publish cảnh báo
+// chỉ xác nhận có ID mới hơn mọi ID đã trả về mới có thể là của cảnh báo đó.
+static uint16_t s_last_msg_id = 0;      // ID gần nhất publish() trả về
+static bool s_alert_publishing = false;
+static int s_early_ack = 0;             // Xác nhận tới sớm, 0 nếu chưa có
+static telemetry_alert_stats_t s_alert_stats;
+
+// Mỗi lần chỉ một cảnh báo từ flash được gửi lại; bản ghi chỉ được pop (trong
+// task egress) sau khi broker xác nhận
+static bool s_replay_inflight = false;
+static bool s_replay_acked = false;
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static mqtt_config_t *s_config = NULL;
+static TaskHandle_t s_task = NULL;
+
+// Buffer gửi của task egress (+1 cho ký tự kết thúc của JSON)
+static uint8_t s_tx_buf[SAF_RECORD_MAX_LEN + 1];
+
+static mqtt_egress_class_t topic_class(mqtt_egress_topic_t topic)
+{
+    switch (topic) {
+        case MQTT_EGRESS_TOPIC_ALERT:
+        case MQTT_EGRESS_TOPIC_ALERT_BIN:
+            return MQTT_EGRESS_ALERT;
+        case MQTT_EGRESS_TOPIC_SENSOR_DATA:
+        case MQTT_EGRESS_TOPIC_SENSOR_DATA_BIN:
+            return MQTT_EGRESS_TELEMETRY;
+        default:
+            return MQTT_EGRESS_STATUS;
+    }
+}
+
+/**
+ * @brief Publish payload lên topic (data phải kết thúc bằng '\0' với topic JSON)
+ * @return Message ID nếu thành công, -1 nếu lỗi
+ */
+static int publish(mqtt_egress_topic_t topic, const uint8_t *data, uint16_t len)
+{
+    int msg_id;
+
+    switch (topic) {
+        case MQTT_EGRESS_TOPIC_SENSOR_DATA:
+            msg_id = mqtt_publish_sensor_data(s_config, (const char *)data);
+            break;
+        case MQTT_EGRESS_TOPIC_SENSOR_DATA_BIN:
+            msg_id = mqtt_publish_sensor_data_bin(s_config, data, len);
+            break;
+        case MQTT_EGRESS_TOPIC_ALERT:
+            msg_id = mqtt_publish_alert(s_config, (const char *)data);
+            break;
+        case MQTT_EGRESS_TOPIC_ALERT_BIN:
+            msg_id = mqtt_publish_alert_bin(s_config, data, len);
+            break;
+        case MQTT_EGRESS_TOPIC_STATUS:
+            msg_id = mqtt_publish_status(s_config, (const char *)data);
+            break;
+        case MQTT_EGRESS_TOPIC_DIAG:
+            msg_id = mqtt_publish_diag(s_config, (const char *)data);
+            break;
+        default:
+            msg_id = -1;
+            break;
+    }
+
+    if (msg_id > 0) {
+        portENTER_CRITICAL(&s_lock);
+        s_last_msg_id = (uint16_t)msg_id;
+        portEXIT_CRITICAL(&s_lock);
+    }
+    return msg_id;
+}
+
+/**
+ * @brief Publish một cảnh báo sẽ được theo dõi; kết thúc bằng early_ack_take()
+ * @return Message ID nếu thành công, -1 nếu lỗi
+ */
+static int publish_alert(mqtt_egress_topic_t topic, const uint8_t *data, uint16_t len)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_alert_publishing = true;
+    s_early_ack = 0;
+    portEXIT_CRITICAL(&s_lock);
+
+    return publish(topic, data, len);
+}
+
+/**
+ * @brief Chuyển message sang store-and-forward (không áp dụng cho trạng thái)
+ */
+static void spill(mqtt_egress_class_t cls, mqtt_egress_topic_t topic, const uint8_t *data, uint16_t len)
+{
+    saf_log_id_t log = (cls == MQTT_EGRESS_ALERT) ? SAF_LOG_ALERT : SAF_LOG_TELEMETRY;
+    bool stored = (cls != MQTT_EGRESS_STATUS) && (saf_append(log, (uint8_t)topic, data, len) == 0);
+
+    // Chỉ task egress ghi flash; thống kê được đọc từ task khác
+    portENTER_CRITICAL(&s_lock);
+    if (stored) {
+        s_class[cls].stats.spilled++;
+    } else {
+        s_class[cls].stats.dropped++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!stored && cls == MQTT_EGRESS_ALERT) {
+        ESP_LOGE(TAG, "Fire alert lost (MQTT offline and store-and-forward unavailable)");
+    }
+}
+
+/**
+ * @brief Lấy message cũ nhất của một lớp vào s_tx_buf
+ *
+ * Slot được giữ ở trạng thái READING trong lúc chép (ngoài s_lock) rồi mới
+ * trả lại hàng đợi. Slot cũ nhất còn đang được ghi thì chờ lần đánh thức sau.
+ */
+static bool dequeue(egress_class_t *c, egress_slot_t *out)
+{
+    portENTER_CRITICAL(&s_lock);
+    uint8_t idx = c->head;
+    bool found = (c->count > 0) && (c->slot[idx].state == EGRESS_SLOT_READY);
+    if (found) {
+        c->slot[idx].state = EGRESS_SLOT_READING;
+        *out = c->slot[idx];
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!found) {
+        s_tx_buf[0] = '\0';
+        return false;
+    }
+
+    memcpy(s_tx_buf, &c->storage[(size_t)idx * c->max_len], out->len);
+    s_tx_buf[out->len] = '\0';
+
+    portENTER_CRITICAL(&s_lock);
+    c->head = (c->head + 1) % c->depth;
+    c->count--;
+    portEXIT_CRITICAL(&s_lock);
+    return true;
+}
+
+static void update_max(uint32_t *max, int64_t value_us)
+{
+    uint32_t v = (value_us > 0) ? (uint32_t)value_us : 0;
+    if (v > *max) {
+        *max = v;
+    }
+}
+
+/**
+ * @brief Ghi nhận xác nhận của một cảnh báo và giải phóng slot (giữ s_lock)
+ */
+static void track_confirm(alert_track_t *t, int64_t now_us)
+{
+    update_max(&s_alert_stats.enqueue_max_us, t->enqueue_us - t->origin_us);
+    update_max(&s_alert_stats.publish_max_us, t->publish_us - t->enqueue_us);
+    update_max(&s_alert_stats.ack_max_us, now_us - t->publish_us);
+    latency_hist_record(&s_alert_stats.latency, (uint32_t)(now_us - t->origin_us));
+
+    s_alert_stats.confirmed++;
+    s_alert_stats.tracked--;
+    if (t->replay) {
+        s_replay_acked = true;
+    }
+    t->msg_id = 0;
+}
+
+/**
+ * @brief Kết thúc lần publish cảnh báo đã mở bằng publish_alert() (giữ s_lock)
+ * @return true nếu broker đã xác nhận msg_id trước khi publish() trả về
+ */
+static bool early_ack_take(int msg_id)
+{
+    bool acked = (msg_id > 0) && (s_early_ack == msg_id);
+    s_alert_publishing = false;
+    s_early_ack = 0;
+    return acked;
+}
+
+/**
+ * @brief Bắt đầu theo dõi xác nhận của một cảnh báo vừa publish (payload trong s_tx_buf)
+ *
+ * Slot được giữ bằng msg_id -1 (không khớp xác nhận nào) trong lúc chép
+ * payload ngoài s_lock; chỉ task egress cấp phát slot.
+ *
+ * @param replay true nếu là bản ghi cũ nhất của log cảnh báo trên flash
+ */
+static void track_alert(const egress_slot_t *msg, int msg_id, int64_t now_us, bool replay)
+{
+    portENTER_CRITICAL(&s_lock);
+    alert_track_t *t = NULL;
+    for (int i = 0; msg_id > 0 && i < MQTT_EGRESS_ALERT_TRACK_MAX; i++) {
+        if (s_track[i].msg_id == 0) {
+            t = &s_track[i];
+            t->msg_id = -1;
+            break;
+        }
+    }
+    if (t == NULL) {
+        s_alert_stats.untracked++;
+        early_ack_take(msg_id);
+        if (replay) {
+            // Bản ghi chưa được pop, drain_backlog() gửi lại sau
+            s_replay_inflight = false;
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (t == NULL) {
+        return;
+    }
+    memcpy(t->payload, s_tx_buf, msg->len);
+
+    portENTER_CRITICAL(&s_lock);
+    t->msg_id = msg_id;
+    t->topic = msg->topic;
+    t->retries = 0;
+    t->replay = replay;
+    t->len = msg->len;
+    t->origin_us = msg->origin_us;
+    t->enqueue_us = msg->enqueue_us;
+    t->publish_us = now_us;
+    t->deadline_us = now_us + (int64_t)MQTT_EGRESS_ALERT_ACK_TIMEOUT_MS * 1000;
+    s_alert_stats.tracked++;
+
+    if (early_ack_take(msg_id)) {
+        track_confirm(t, now_us);
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+/**
+ * @brief Gửi lại các cảnh báo quá hạn xác nhận
+ *
+ * Sau MQTT_EGRESS_ALERT_MAX_RETRIES lần gửi lại (hoặc khi mất kết nối),
+ * cảnh báo được chuyển sang store-and-forward để gửi lại sau.
+ */
+static void check_alert_deadlines(void)
+{
+    for (int i = 0; i < MQTT_EGRESS_ALERT_TRACK_MAX; i++) {
+        alert_track_t *t = &s_track[i];
+        int64_t now_us = esp_timer_get_time();
+
+        portENTER_CRITICAL(&s_lock);
+        bool expired = (t->msg_id != 0) && (now_us >= t->deadline_us);
+        if (expired) {
+            // Xác nhận muộn của ID cũ sẽ không còn khớp slot này
+            t->msg_id = -1;
+        }
+        portEXIT_CRITICAL(&s_lock);
+
+        if (!expired) {
+            continue;
+        }
+
+        // Slot có msg_id -1 chỉ task egress truy cập, chép ngoài s_lock
+        memcpy(s_tx_buf, t->payload, t->len);
+        s_tx_buf[t->len] = '\0';
+
+        int msg_id = -1;
+        if (t->retries < MQTT_EGRESS_ALERT_MAX_RETRIES && mqtt_is_connected(s_config)) {
+            msg_id = publish_alert((mqtt_egress_topic_t)t->topic, s_tx_buf, t->len);
+        }
+
+        portENTER_CRITICAL(&s_lock);
+        bool early_ack = early_ack_take(msg_id);
+        if (msg_id > 0) {
+            t->msg_id = msg_id;
+            t->retries++;
+            t->deadline_us = now_us + (int64_t)MQTT_EGRESS_ALERT_ACK_TIMEOUT_MS * 1000;
+            s_alert_stats.retransmits++;
+            if (early_ack) {
+                track_confirm(t, esp_timer_get_time());
+            }
+        } else {
+            t->msg_id = 0;
+            s_alert_stats.tracked--;
+            s_alert_stats.expired++;
+            if (t->replay) {
+                // Bản ghi vẫn còn trên flash, drain_backlog() gửi lại sau
+                s_replay_inflight = false;
+            }
+        }
+        portEXIT_CRITICAL(&s_lock);
+
+        if (msg_id <= 0 && !t->replay) {
+            ESP_LOGW(TAG, "Alert not confirmed after %d retransmits, moving to store-and-forward", t->retries);
+            spill(MQTT_EGRESS_ALERT, (mqtt_egress_topic_t)t->topic, s_tx_buf, t->len);
+        }
+    }
+}
+
+/**
+ * @brief Gửi một message đã lấy khỏi hàng đợi
+ */
+static void send(mqtt_egress_class_t cls, const egress_slot_t *msg)
+{
+    egress_class_t *c = &s_class[cls];
+    mqtt_egress_topic_t topic = (mqtt_egress_topic_t)msg->topic;
+
+    // Telemetry xếp sau dữ liệu tồn đọng trên flash để giữ đúng thứ tự
+    bool backlog = (cls == MQTT_EGRESS_TELEMETRY) && (saf_pending(SAF_LOG_TELEMETRY) > 0);
+
+    int msg_id = -1;
+    if (!backlog && mqtt_is_connected(s_config)) {
+        msg_id = (cls == MQTT_EGRESS_ALERT) ? publish_alert(topic, s_tx_buf, msg->len)
+                                            : publish(topic, s_tx_buf, msg->len);
+    }
+    if (msg_id < 0) {
+        if (cls == MQTT_EGRESS_ALERT) {
+            portENTER_CRITICAL(&s_lock);
+            early_ack_take(msg_id);
+            portEXIT_CRITICAL(&s_lock);
+        }
+        spill(cls, topic, s_tx_buf, msg->len);
+        return;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    uint32_t latency_us = (uint32_t)(now_us - msg->enqueue_us);
+    if (cls == MQTT_EGRESS_ALERT) {
+        track_alert(msg, msg_id, now_us, false);
+        TRACE_POINT(TRACE_ALERT_PUBLISHED, trace_tag(msg->origin_us));
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    c->stats.sent++;
+    c->stats.latency_last_us = latency_us;
+    c->stats.latency_total_us += latency_us;
+    if (latency_us > c->stats.latency_max_us) {
+        c->stats.latency_max_us = latency_us;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+/**
+ * @brief Pop cảnh báo từ flash đã được broker xác nhận
+ * @return true nếu đã pop một bản ghi
+ */
+static bool replay_pop_acked(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    bool acked = s_replay_acked;
+    s_replay_acked = false;
+    if (acked) {
+        s_replay_inflight = false;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (acked) {
+        saf_pop(SAF_LOG_ALERT);
+    }
+    return acked;
+}
+
+/**
+ * @brief Gửi lại một bản ghi tồn đọng trên flash
+ *
+ * Cảnh báo đi qua cùng đường theo dõi xác nhận với cảnh báo mới (gửi lại khi
+ * quá hạn, đo độ trễ) và chỉ được pop khi broker xác nhận; trong lúc chờ,
+ * không bản ghi nào khác được gửi. Telemetry được pop ngay khi publish xong.
+ *
+ * @param alerts_only Chỉ gửi nếu còn cảnh báo tồn đọng
+ * @return true nếu đã gửi một bản ghi
+ */
+static bool drain_backlog(bool alerts_only)
+{
+    if (!mqtt_is_connected(s_config) || (alerts_only && saf_pending(SAF_LOG_ALERT) == 0)) {
+        return false;
+    }
+
+    // Đang chờ xác nhận một cảnh báo từ flash, hoặc hết slot theo dõi
+    portENTER_CRITICAL(&s_lock);
+    bool busy = s_replay_inflight || (s_alert_stats.tracked >= MQTT_EGRESS_ALERT_TRACK_MAX);
+    portEXIT_CRITICAL(&s_lock);
+    if (busy && saf_pending(SAF_LOG_ALERT) > 0) {
+        return false;
+    }
+
+    saf_log_id_t log;
+    uint8_t kind;
+    uint16_t len;
+    if (saf_peek(&log, &kind, s_tx_buf, SAF_RECORD_MAX_LEN, &len) != 0) {
+        return false;
+    }
+    s_tx_buf[len] = '\0';   // Payload JSON được lưu không có ký tự kết thúc
+
+    if (log == SAF_LOG_ALERT) {
+        int msg_id = publish_alert((mqtt_egress_topic_t)kind, s_tx_buf, len);
+        if (msg_id < 0) {
+            portENTER_CRITICAL(&s_lock);
+            early_ack_take(msg_id);
+            portEXIT_CRITICAL(&s_lock);
+            return false;
+        }
+
+        // Thời điểm phát hiện không được lưu (esp_timer bắt đầu lại sau reset):
+        // độ trễ tính từ lần gửi lại đầu tiên
+        int64_t now_us = esp_timer_get_time();
+        egress_slot_t msg = { .topic = kind, .len = len, .origin_us = now_us, .enqueue_us = now_us };
+        portENTER_CRITICAL(&s_lock);
+        s_replay_inflight = true;
+        portEXIT_CRITICAL(&s_lock);
+        track_alert(&msg, msg_id, now_us, true);
+        return true;
+    }
+
+    // Chỉ đánh dấu đã gửi sau khi publish thành công (at-least-once)
+    if (publish((mqtt_egress_topic_t)kind, s_tx_buf, len) < 0) {
+        return false;
+    }
+
+    saf_pop(log);
+    return true;
+}
+
+/**
+ * @brief Lưu các cảnh báo trong vùng tràn sang store-and-forward
+ *
+ * Cảnh báo trong vùng tràn mới hơn mọi cảnh báo trong hàng đợi, nên chỉ được
+ * lưu khi hàng đợi đã rỗng; drain_backlog() gửi lại chúng đúng thứ tự.
+ *
+ * @return true nếu đã lưu ít nhất một cảnh báo
+ */
+static bool spill_alert_overflow(void)
+{
+    egress_slot_t msg;
+    bool spilled = false;
+
+    portENTER_CRITICAL(&s_lock);
+    bool queue_empty = (s_class[MQTT_EGRESS_ALERT].count == 0);
+    portEXIT_CRITICAL(&s_lock);
+
+    while (queue_empty && dequeue(&s_alert_overflow, &msg)) {
+        spill(MQTT_EGRESS_ALERT, (mqtt_egress_topic_t)msg.topic, s_tx_buf, msg.len);
+        spilled = true;
+    }
+    return spilled;
+}
+
+/**
+ * @brief Gửi message ưu tiên cao nhất đang chờ
+ * @return true nếu đã xử lý một message
+ */
+static bool send_next(void)
+{
+    egress_slot_t msg;
+
+    for (int cls = 0; cls < MQTT_EGRESS_CLASS_COUNT; cls++) {
+        if (dequeue(&s_class[cls], &msg)) {
+            send((mqtt_egress_class_t)cls, &msg);
+            return true;
+        }
+
+        // Cảnh báo tràn hàng đợi và tồn đọng trên flash được gửi trước mọi telemetry
+        if (cls == MQTT_EGRESS_ALERT && (spill_alert_overflow() || replay_pop_acked() || drain_backlog(true))) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int mqtt_egress_init(mqtt_config_t *config)
+{
+    if (config == NULL) {
+        return -1;
+    }
+
+    s_config = config;
+    latency_hist_init(&s_alert_stats.latency, MQTT_EGRESS_LATENCY_BASE_US);
+    return 0;
+}
+
+int mqtt_egress_enqueue(mqtt_egress_topic_t topic, const uint8_t *data, uint16_t len)
+{
+    return mqtt_egress_enqueue_at(topic, data, len, 0);
+}
+
+int mqtt_egress_enqueue_at(mqtt_egress_topic_t topic, const uint8_t *data, uint16_t len,
+                           int64_t origin_us)
+{
+    if (data == NULL || len == 0) {
+        return -1;
+    }
+
+    mqtt_egress_class_t cls = topic_class(topic);
+    egress_class_t *c = &s_class[cls];
+
+    if (len > c->max_len) {
+        ESP_LOGE(TAG, "Payload too large for class %d (%d > %d bytes)", cls, len, c->max_len);
+        portENTER_CRITICAL(&s_lock);
+        c->stats.dropped++;
+        portEXIT_CRITICAL(&s_lock);
+        return -1;
+    }
+
+    bool queued = false;
+    uint8_t idx = 0;
+    egress_class_t *q = c;
+    int64_t now_us = esp_timer_get_time();
+
+    // Giữ slot dưới s_lock, chép payload ngoài s_lock; không ghi flash ở task gọi
+    portENTER_CRITICAL(&s_lock);
+    c->stats.enqueued++;
+    if (cls == MQTT_EGRESS_ALERT) {
+        // Cảnh báo không bao giờ bị thay; đã có bản trong vùng tràn thì xếp sau nó
+        if (c->count == c->depth || s_alert_overflow.count > 0) {
+            q = &s_alert_overflow;
+        }
+    } else if (c->count == c->depth && c->slot[c->head].state == EGRESS_SLOT_READY) {
+        // Hàng đợi đầy (task egress không theo kịp): bỏ bản cũ nhất
+        c->head = (c->head + 1) % c->depth;
+        c->count--;
+        c->stats.dropped++;
+    }
+    if (q->count < q->depth) {
+        idx = (q->head + q->count) % q->depth;
+        q->slot[idx].topic = (uint8_t)topic;
+        q->slot[idx].state = EGRESS_SLOT_WRITING;
+        q->slot[idx].len = len;
+        q->slot[idx].origin_us = (origin_us > 0) ? origin_us : now_us;
+        q->slot[idx].enqueue_us = now_us;
+        q->count++;
+        queued = true;
+    } else {
+        // Bản cũ nhất đang được chép, hoặc vùng tràn cảnh báo cũng đầy: bỏ bản mới
+        c->stats.dropped++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!queued) {
+        if (cls == MQTT_EGRESS_ALERT) {
+            ESP_LOGE(TAG, "Fire alert dropped (egress queue and overflow full)");
+        }
+        return -1;
+    }
+
+    memcpy(&q->storage[(size_t)idx * q->max_len], data, len);
+
+    portENTER_CRITICAL(&s_lock);
+    q->slot[idx].state = EGRESS_SLOT_READY;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (s_task != NULL) {
+        xTaskNotifyGive(s_task);
+    }
+
+    return 0;
+}
+
+void mqtt_egress_get_stats(mqtt_egress_class_t cls, mqtt_egress_stats_t *stats)
+{
+    if (cls >= MQTT_EGRESS_CLASS_COUNT || stats == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    memcpy(stats, &s_class[cls].stats, sizeof(mqtt_egress_stats_t));
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void mqtt_egress_on_published(int msg_id)
+{
+    if (msg_id <= 0) {
+        return;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    bool found = false;
+    for (int i = 0; i < MQTT_EGRESS_ALERT_TRACK_MAX; i++) {
+        if (s_track[i].msg_id == msg_id) {
+            track_confirm(&s_track[i], now_us);
+            found = true;
+            break;
+        }
+    }
+    bool replay_acked = s_replay_acked;
+    // Xác nhận của message đã publish trước đó (telemetry, cảnh báo hết theo dõi) bị bỏ qua
+    uint16_t ahead = (uint16_t)((uint16_t)msg_id - s_last_msg_id);
+    if (!found && s_alert_publishing && ahead != 0 && ahead < 0x8000) {
+        s_early_ack = msg_id;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    // Task egress pop bản ghi trên flash
+    if (replay_acked && s_task != NULL) {
+        xTaskNotifyGive(s_task);
+    }
+}
+
+void mqtt_egress_get_alert_stats(telemetry_alert_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    memcpy(stats, &s_alert_stats, sizeof(telemetry_alert_stats_t));
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void mqtt_egress_task(void *pvParameters)
+{
+    ESP_LOGI(TAG, "MQTT egress task started");
+
+    s_task = xTaskGetCurrentTaskHandle();
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MQTT_EGRESS_DRAIN_INTERVAL_MS));
+
+        // Xử lý đến khi các hàng đợi rỗng, mỗi lần đều bắt đầu từ lớp ưu tiên cao nhất
+        while (send_next()) {
+        }
+
+        check_alert_deadlines();
+
+        // Telemetry tồn đọng: tối đa một bản ghi mỗi chu kỳ
+        drain_backlog(false);
+    }
+}
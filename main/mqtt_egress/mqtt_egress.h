@@ -0,0 +1,128 @@
+#ifndef MQTT_EGRESS_H
+#define MQTT_EGRESS_H
+
+#include <stdint.h>
+#include "mqtt/mqtt.h"
+#include "telemetry/telemetry.h"
+#include "telemetry_batch/telemetry_batch.h"
+
+// Độ sâu hàng đợi và kích thước payload tối đa của từng lớp
+#define MQTT_EGRESS_ALERT_DEPTH 4
+#define MQTT_EGRESS_ALERT_OVERFLOW_DEPTH 4  // Cảnh báo tới khi hàng đợi đầy, task egress lưu flash
+#define MQTT_EGRESS_ALERT_MAX_LEN TELEMETRY_JSON_MAX_LEN
+#define MQTT_EGRESS_TELEMETRY_DEPTH 4
+#define MQTT_EGRESS_TELEMETRY_MAX_LEN TELEMETRY_BATCH_JSON_MAX_LEN(TELEMETRY_BATCH_MAX_SAMPLES)
+#define MQTT_EGRESS_STATUS_DEPTH 2      // Trạng thái + chẩn đoán
+#define MQTT_EGRESS_STATUS_MAX_LEN TELEMETRY_STATUS_JSON_MAX_LEN
+
+// Gửi lại tối đa 1 bản ghi telemetry tồn đọng trên flash mỗi khoảng này (ms)
+#define MQTT_EGRESS_DRAIN_INTERVAL_MS 250
+
+// Theo dõi xác nhận cảnh báo (MQTT_EVENT_PUBLISHED / PUBCOMP)
+#define MQTT_EGRESS_ALERT_TRACK_MAX 4           // Số cảnh báo chờ xác nhận cùng lúc
+#define MQTT_EGRESS_ALERT_ACK_TIMEOUT_MS 5000   // Quá hạn này thì gửi lại
+#define MQTT_EGRESS_ALERT_MAX_RETRIES 2         // Sau đó chuyển sang store-and-forward
+#define MQTT_EGRESS_LATENCY_BASE_US 1000        // Bucket đầu của histogram độ trễ (< 1 ms)
+
+// Lớp ưu tiên, chỉ số nhỏ hơn được gửi trước
+typedef enum {
+    MQTT_EGRESS_ALERT = 0,      // Cảnh báo cháy: không bao giờ bị thay, mất kết nối hoặc không được xác nhận thì lưu flash
+    MQTT_EGRESS_TELEMETRY,      // Batch cảm biến: mất kết nối hoặc tồn đọng thì xếp sau trên flash, đầy thì bỏ batch cũ nhất
+    MQTT_EGRESS_STATUS,         // Trạng thái, chẩn đoán: best-effort, chỉ giữ bản mới nhất
+    MQTT_EGRESS_CLASS_COUNT
+} mqtt_egress_class_t;
+
+// Topic đích (giá trị cũng là loại bản ghi store-and-forward, không được đổi)
+typedef enum {
+    MQTT_EGRESS_TOPIC_SENSOR_DATA = 1,
+    MQTT_EGRESS_TOPIC_SENSOR_DATA_BIN = 2,
+    MQTT_EGRESS_TOPIC_ALERT = 3,
+    MQTT_EGRESS_TOPIC_ALERT_BIN = 4,
+    MQTT_EGRESS_TOPIC_STATUS = 5,
+    MQTT_EGRESS_TOPIC_DIAG = 6,
+} mqtt_egress_topic_t;
+
+// Thống kê của một lớp
+typedef struct {
+    uint32_t enqueued;          // Số message được đưa vào hàng đợi
+    uint32_t sent;              // Số message đã publish
+    uint32_t spilled;           // Số message chuyển sang store-and-forward
+    uint32_t dropped;           // Số message bị bỏ (hàng đợi đầy, quá dài, không lưu được)
+    uint32_t latency_last_us;   // Thời gian từ lúc vào hàng đợi đến lúc publish xong
+    uint32_t latency_max_us;
+    uint64_t latency_total_us;  // Chia cho sent để lấy trung bình
+} mqtt_egress_stats_t;
+
+/**
+ * @brief Khởi tạo bộ điều phối gửi MQTT
+ * @param config Cấu hình MQTT dùng để publish
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int mqtt_egress_init(mqtt_config_t *config);
+
+/**
+ * @brief Đưa một message vào hàng đợi của lớp tương ứng với topic
+ *
+ * Không bao giờ chờ mạng hay ghi flash: payload được sao chép vào slot tĩnh
+ * và task egress được đánh thức; khi mất kết nối, task egress chuyển message
+ * sang store-and-forward. Khi hàng đợi đầy (task egress không theo kịp):
+ * - cảnh báo: không bản nào bị thay; bản mới vào vùng tràn
+ *   (MQTT_EGRESS_ALERT_OVERFLOW_DEPTH slot) và task egress lưu thẳng sang
+ *   store-and-forward ở lần chạy kế tiếp. Chỉ bị bỏ khi cả vùng tràn cũng đầy;
+ * - telemetry, trạng thái: bản cũ nhất bị thay bằng bản mới và được đếm
+ *   trong dropped. Batch telemetry không được gộp: mỗi slot chỉ vừa một batch
+ *   đầy đủ, nên khi task egress bị chặn lâu hơn MQTT_EGRESS_TELEMETRY_DEPTH cửa
+ *   sổ batch thì cả batch cũ nhất bị mất.
+ *
+ * @param topic Topic đích
+ * @param data Payload (JSON không cần ký tự kết thúc)
+ * @param len Độ dài payload (bytes)
+ * @return 0 nếu đã xếp hàng hoặc đã lưu, -1 nếu message bị bỏ
+ */
+int mqtt_egress_enqueue(mqtt_egress_topic_t topic, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Như mqtt_egress_enqueue(), kèm thời điểm phát sinh sự kiện
+ *
+ * Dùng cho cảnh báo: độ trễ phát hiện -> xác nhận được tính từ origin_us.
+ *
+ * @param topic Topic đích
+ * @param data Payload
+ * @param len Độ dài payload (bytes)
+ * @param origin_us Thời điểm sự kiện (esp_timer), 0 nếu là lúc gọi hàm
+ * @return 0 nếu đã xếp hàng hoặc đã lưu, -1 nếu message bị bỏ
+ */
+int mqtt_egress_enqueue_at(mqtt_egress_topic_t topic, const uint8_t *data, uint16_t len,
+                           int64_t origin_us);
+
+/**
+ * @brief Báo broker đã xác nhận một message (gọi từ MQTT_EVENT_PUBLISHED)
+ * @param msg_id Message ID
+ */
+void mqtt_egress_on_published(int msg_id);
+
+/**
+ * @brief Lấy thống kê xác nhận và độ trễ cảnh báo
+ * @param stats Con trỏ đến cấu trúc thống kê
+ */
+void mqtt_egress_get_alert_stats(telemetry_alert_stats_t *stats);
+
+/**
+ * @brief Lấy thống kê của một lớp
+ * @param cls Lớp ưu tiên
+ * @param stats Con trỏ đến cấu trúc thống kê
+ */
+void mqtt_egress_get_stats(mqtt_egress_class_t cls, mqtt_egress_stats_t *stats);
+
+/**
+ * @brief Task duy nhất publish lên MQTT
+ *
+ * Luôn gửi message của lớp ưu tiên cao nhất trước, sau đó gửi lại
+ * dữ liệu tồn đọng trên flash (cảnh báo trước, telemetry có giới hạn tốc độ).
+ * Cảnh báo chưa được xác nhận sau MQTT_EGRESS_ALERT_ACK_TIMEOUT_MS được gửi lại.
+ *
+ * @param pvParameters Không dùng
+ */
+void mqtt_egress_task(void *pvParameters);
+
+#endif // MQTT_EGRESS_H
@@ -0,0 +1,67 @@
+#include "rate_of_rise.h"
+#include <string.h>
+
+/*
+ * Với chỉ số mẫu đều i = 0..N-1:
+ *   slope = (N * Σ(i*y) - Σi * Σy) / (N * Σi² - (Σi)²)
+ * Σi và Σi² là hằng số khi cửa sổ đầy. Khi trượt (bỏ y_0, thêm y_N),
+ * các chỉ số giảm 1 nên:
+ *   Σ(i*y)' = Σ(i*y) - (Σy - y_0) + (N-1) * y_N
+ *   Σy'     = Σy - y_0 + y_N
+ * Độ dốc theo mẫu được đổi sang theo phút bằng khoảng thời gian thực của cửa sổ.
+ */
+
+void ror_init(ror_detector_t *ror)
+{
+    if (ror == NULL) {
+        return;
+    }
+
+    memset(ror, 0, sizeof(ror_detector_t));
+}
+
+void ror_add(ror_detector_t *ror, uint16_t value, uint32_t time_ms)
+{
+    if (ror == NULL) {
+        return;
+    }
+
+    if (ror->count < ROR_WINDOW_LEN) {
+        ror->sum_iy += (int32_t)ror->count * value;
+        ror->sum_y += value;
+        ror->count++;
+    } else {
+        int32_t oldest = ror->samples[ror->head];
+        ror->sum_iy = ror->sum_iy - (ror->sum_y - oldest) + (int32_t)(ROR_WINDOW_LEN - 1) * value;
+        ror->sum_y = ror->sum_y - oldest + value;
+    }
+
+    ror->samples[ror->head] = value;
+    ror->times[ror->head] = time_ms;
+    ror->head = (ror->head + 1) % ROR_WINDOW_LEN;
+}
+
+int ror_get_rate(const ror_detector_t *ror, int32_t *out_rate)
+{
+    if (ror == NULL || out_rate == NULL || ror->count < ROR_WINDOW_LEN) {
+        return -1;
+    }
+
+    const int64_t n = ROR_WINDOW_LEN;
+    const int64_t sum_i = n * (n - 1) / 2;
+    const int64_t denom = n * n * (n * n - 1) / 12;     // N * Σi² - (Σi)²
+
+    // Cửa sổ đầy: head là mẫu cũ nhất, head - 1 là mẫu mới nhất
+    uint32_t oldest_ms = ror->times[ror->head];
+    uint32_t newest_ms = ror->times[(ror->head + ROR_WINDOW_LEN - 1) % ROR_WINDOW_LEN];
+    uint32_t span_ms = newest_ms - oldest_ms;
+    if (span_ms == 0) {
+        return -1;
+    }
+
+    int64_t numer = n * ror->sum_iy - sum_i * ror->sum_y;
+
+    // slope_per_sample * (N-1) mẫu / span_ms * 60000 ms
+    *out_rate = (int32_t)((numer * (n - 1) * 60000) / (denom * (int64_t)span_ms));
+    return 0;
+}
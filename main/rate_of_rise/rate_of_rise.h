@@ -0,0 +1,44 @@
+#ifndef RATE_OF_RISE_H
+#define RATE_OF_RISE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Độ dài cửa sổ trượt (số mẫu), 20 mẫu ~ 10 giây với chu kỳ đọc 500ms
+#ifndef ROR_WINDOW_LEN
+#define ROR_WINDOW_LEN 20
+#endif
+
+// Bộ ước lượng tốc độ tăng (hồi quy tuyến tính bình phương tối thiểu trên cửa sổ trượt)
+typedef struct {
+    uint16_t samples[ROR_WINDOW_LEN];
+    uint32_t times[ROR_WINDOW_LEN];
+    uint8_t head;           // Vị trí ghi tiếp theo (= mẫu cũ nhất khi cửa sổ đầy)
+    uint8_t count;          // Số mẫu trong cửa sổ
+    int32_t sum_y;          // Tổng y_i
+    int32_t sum_iy;         // Tổng i * y_i, i = 0 là mẫu cũ nhất
+} ror_detector_t;
+
+/**
+ * @brief Khởi tạo (xóa) bộ ước lượng
+ * @param ror Con trỏ đến bộ ước lượng
+ */
+void ror_init(ror_detector_t *ror);
+
+/**
+ * @brief Thêm một mẫu, cập nhật các tổng của hồi quy trong O(1)
+ * @param ror Con trỏ đến bộ ước lượng
+ * @param value Giá trị mẫu (raw 0-4095)
+ * @param time_ms Thời điểm lấy mẫu (ms)
+ */
+void ror_add(ror_detector_t *ror, uint16_t value, uint32_t time_ms);
+
+/**
+ * @brief Lấy độ dốc của đường hồi quy trên cửa sổ
+ * @param ror Con trỏ đến bộ ước lượng
+ * @param out_rate Tốc độ thay đổi (đơn vị raw / phút, âm nếu giảm)
+ * @return 0 nếu thành công, -1 nếu cửa sổ chưa đầy
+ */
+int ror_get_rate(const ror_detector_t *ror, int32_t *out_rate);
+
+#endif // RATE_OF_RISE_H
@@ -1,10 +1,17 @@
 #include "sensor.h"
+#include <string.h>
+#include <stdatomic.h>
+#include <inttypes.h>
 #include "esp_log.h"
-#include "esp_adc/adc_oneshot.h"
 #include "esp_adc/adc_cali.h"
 #include "esp_adc/adc_cali_scheme.h"
 #include "hal/adc_types.h"
 #include "driver/gpio.h"
+#include "esp_timer.h"
+#include "adc_stream/adc_stream.h"
+#include "sensor_filter/sensor_filter.h"
+#include "rate_of_rise/rate_of_rise.h"
+#include "trace/trace.h"
 
 static const char *TAG = "SENSOR";
 
@@ -13,12 +20,99 @@ static const char *TAG = "SENSOR";
 #define TEMPERATURE_THRESHOLD 0.8f
 #define IR_FLAME_THRESHOLD 0.6f
 #define GAS_THRESHOLD 0.7f
+#define CO_THRESHOLD 0.6f
+
+// Ngưỡng tốc độ tăng nhiệt độ (raw / phút, trên cửa sổ ROR_WINDOW_LEN mẫu)
+#define TEMPERATURE_ROR_THRESHOLD 400
+
+// Thời gian chờ frame DMA tối đa mỗi chu kỳ đọc (ms)
+#define SENSOR_FRAME_TIMEOUT_MS 50
 
 // ADC handles
-static adc_oneshot_unit_handle_t adc1_handle = NULL;
 static adc_cali_handle_t adc1_cali_handle = NULL;
 static bool adc_initialized = false;
 
+// Tổng mẫu của chu kỳ đọc hiện tại từ bộ thu ADC liên tục
+static adc_stream_frame_t s_adc_frame;
+static bool s_adc_frame_valid = false;
+
+// Task nhận thông báo khi trạng thái cháy thay đổi
+static TaskHandle_t s_event_task = NULL;
+
+// Queue nhận bản sao trạng thái mỗi chu kỳ đọc (cho bộ gom telemetry)
+static QueueHandle_t s_sample_queue = NULL;
+static uint32_t s_sample_drops = 0;
+
+// Chuỗi lọc theo loại cảm biến: median + EMA cho MQ khói/gas/CO, EMA cho nhiệt độ,
+// debounce 2-of-3 cho đầu vào digital IR flame
+static const sensor_filter_cfg_t mq_filters[] = {
+    { SENSOR_FILTER_MEDIAN, 3, 0 },
+    { SENSOR_FILTER_EMA, 1, 0 },
+};
+static const sensor_filter_cfg_t temperature_filters[] = {
+    { SENSOR_FILTER_EMA, 2, 0 },
+};
+static const sensor_filter_cfg_t ir_flame_filters[] = {
+    { SENSOR_FILTER_DEBOUNCE, 2, 3 },
+};
+
+#define FILTERS(f) (f), (sizeof(f) / sizeof((f)[0]))
+
+// Cấu hình theo loại cảm biến
+static const struct {
+    float threshold;                    // Ngưỡng kích hoạt (0.0 - 1.0)
+    const sensor_filter_cfg_t *filters;
+    uint8_t num_filters;
+    bool instant;                       // Kích hoạt là báo cháy ngay, không cần nguồn thứ hai
+} sensor_type_config[SENSOR_TYPE_COUNT] = {
+    [SENSOR_TYPE_SMOKE]       = { SMOKE_THRESHOLD,       FILTERS(mq_filters),          false },
+    [SENSOR_TYPE_TEMPERATURE] = { TEMPERATURE_THRESHOLD, FILTERS(temperature_filters), false },
+    [SENSOR_TYPE_IR_FLAME]    = { IR_FLAME_THRESHOLD,    FILTERS(ir_flame_filters),    true  },
+    [SENSOR_TYPE_GAS]         = { GAS_THRESHOLD,         FILTERS(mq_filters),          false },
+    [SENSOR_TYPE_CO]          = { CO_THRESHOLD,          FILTERS(mq_filters),          false },
+};
+
+// Registry các đầu vào cảm biến của node. Thêm đầu vào bằng cách thêm một dòng, ví dụ:
+//   { "smoke_2", SENSOR_TYPE_SMOKE, ADC_CHANNEL_0, true },   // GPIO 36
+//   { "co",      SENSOR_TYPE_CO,    ADC_CHANNEL_3, true },   // GPIO 39
+static const sensor_desc_t sensor_registry[] = {
+    { "smoke",       SENSOR_TYPE_SMOKE,       ADC_CHANNEL_6, true  },   // GPIO 34
+    { "temperature", SENSOR_TYPE_TEMPERATURE, ADC_CHANNEL_7, true  },   // GPIO 35
+    { "ir_flame",    SENSOR_TYPE_IR_FLAME,    GPIO_NUM_32,   false },   // Digital
+    { "gas",         SENSOR_TYPE_GAS,         ADC_CHANNEL_5, true  },   // GPIO 33
+};
+
+#define SENSOR_REGISTRY_COUNT (sizeof(sensor_registry) / sizeof(sensor_registry[0]))
+_Static_assert(SENSOR_REGISTRY_COUNT <= SENSOR_MAX_COUNT, "sensor registry exceeds SENSOR_MAX_COUNT");
+
+// Ngưỡng raw và trạng thái bộ lọc của từng cảm biến (chỉ sensor_task truy cập)
+static uint16_t s_threshold_raw[SENSOR_REGISTRY_COUNT];
+static sensor_filter_chain_t s_filter[SENSOR_REGISTRY_COUNT];
+
+// Mặt nạ các cảm biến báo cháy ngay khi kích hoạt
+static uint32_t s_instant_mask = 0;
+
+// Bộ ước lượng tốc độ tăng nhiệt độ (chỉ sensor_task truy cập)
+static ror_detector_t s_temperature_ror;
+static int s_temperature_index = -1;
+static bool s_ror_rising = false;           // Tốc độ đang vượt ngưỡng
+static uint32_t s_ror_rising_since_ms = 0;  // Chu kỳ đầu tiên vượt ngưỡng của lần này
+
+// Lịch sử mẫu của từng cảm biến (ghi bởi sensor_task, đọc từ task khác qua critical section)
+static sensor_history_t s_history[SENSOR_REGISTRY_COUNT];
+static portMUX_TYPE s_history_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Bản chụp trạng thái dạng double-buffer, mỗi buffer có seqlock riêng
+typedef struct {
+    atomic_uint seq;            // Lẻ: đang ghi, chẵn: ổn định
+    uint32_t number;            // Số thứ tự của bản chụp trong buffer
+    sensor_status_t data;
+} sensor_snapshot_slot_t;
+
+static sensor_snapshot_slot_t s_snapshot[2];
+static atomic_uint s_snapshot_active;   // Chỉ số buffer đang hoạt động
+static atomic_uint s_snapshot_count;    // Số bản chụp đã công bố
+
 /**
  * @brief Calibration ADC
  */
@@ -72,133 +166,221 @@ static bool adc_calibration_init(adc_unit_t unit, adc_channel_t channel,
 }
 
 /**
- * @brief Khởi tạo ADC cho cảm biến analog
+ * @brief Khởi tạo ADC1 ở chế độ liên tục (DMA) cho các cảm biến analog
+ * @param channels Danh sách ADC channel cần quét
+ * @param num_channels Số channel
  */
-static void sensor_adc_init(void)
+static int sensor_adc_init(const uint8_t *channels, uint8_t num_channels)
 {
     if (adc_initialized) {
-        return;
+        return 0;
     }
     
-    // Cấu hình ADC1
-    adc_oneshot_unit_init_cfg_t init_config1 = {
-        .unit_id = ADC_UNIT_1,
-    };
-    ESP_ERROR_CHECK(adc_oneshot_new_unit(&init_config1, &adc1_handle));
-    
-    // Calibration (sử dụng channel 0 làm mặc định, sẽ được cấu hình lại cho từng channel)
+    // Calibration (sử dụng channel 0 làm mặc định)
     adc_calibration_init(ADC_UNIT_1, ADC_CHANNEL_0, ADC_ATTEN_DB_12, &adc1_cali_handle);
     
+    // Quét liên tục tất cả channel analog, mỗi frame DMA được cộng dồn theo kênh
+    if (adc_stream_init(channels, num_channels) != 0 || adc_stream_start() != 0) {
+        ESP_LOGE(TAG, "Failed to start continuous ADC");
+        return -1;
+    }
+    
     adc_initialized = true;
-    ESP_LOGI(TAG, "ADC initialized");
+    ESP_LOGI(TAG, "ADC initialized (continuous mode)");
+    
+    return 0;
 }
 
-int sensor_init(sensor_t *sensor, sensor_type_t type, uint8_t pin, bool is_analog)
+/**
+ * @brief Đổi ngưỡng chuẩn hóa (0.0 - 1.0) sang số đếm ADC raw, làm tròn lên
+ *
+ * raw >= threshold_raw tương đương raw / 4095.0f >= threshold,
+ * nên đường đọc nóng chỉ cần so sánh số nguyên.
+ */
+static uint16_t sensor_threshold_to_raw(float threshold)
 {
-    if (sensor == NULL) {
-        return -1;
+    float scaled = threshold * (float)SENSOR_RAW_MAX;
+    if (scaled <= 0.0f) {
+        return 0;
+    }
+    if (scaled >= (float)SENSOR_RAW_MAX) {
+        return SENSOR_RAW_MAX;
     }
     
-    sensor->type = type;
-    sensor->pin = pin;
-    sensor->is_analog = is_analog;
-    sensor->raw_value = 0;
-    sensor->normalized_value = 0.0f;
-    sensor->is_triggered = false;
-    sensor->last_read_time = 0;
+    uint16_t raw = (uint16_t)scaled;
+    if ((float)raw < scaled) {
+        raw++;
+    }
+    return raw;
+}
+
+uint8_t sensor_count(void)
+{
+    return SENSOR_REGISTRY_COUNT;
+}
+
+const sensor_desc_t *sensor_get_desc(uint8_t index)
+{
+    if (index >= SENSOR_REGISTRY_COUNT) {
+        return NULL;
+    }
     
-    if (is_analog) {
-        // Khởi tạo ADC nếu chưa khởi tạo
-        if (!adc_initialized) {
-            sensor_adc_init();
+    return &sensor_registry[index];
+}
+
+int sensor_find(sensor_type_t type)
+{
+    for (uint8_t i = 0; i < SENSOR_REGISTRY_COUNT; i++) {
+        if (sensor_registry[i].type == type) {
+            return i;
         }
-        
-        // Cấu hình channel cho sensor này
-        adc_oneshot_chan_cfg_t config = {
-            .bitwidth = ADC_BITWIDTH_DEFAULT,
-            .atten = ADC_ATTEN_DB_12,
-        };
-        ESP_ERROR_CHECK(adc_oneshot_config_channel(adc1_handle, pin, &config));
-    } else {
-        // Cấu hình GPIO cho cảm biến digital
-        gpio_set_direction(pin, GPIO_MODE_INPUT);
-        gpio_set_pull_mode(pin, GPIO_PULLUP_ONLY);
     }
     
-    ESP_LOGI(TAG, "Sensor type %d initialized on pin %d (analog: %s)", 
-             type, pin, is_analog ? "yes" : "no");
+    return -1;
+}
+
+/**
+ * @brief Khởi tạo một cảm biến theo mô tả trong registry
+ */
+static void sensor_init(uint8_t index)
+{
+    const sensor_desc_t *desc = &sensor_registry[index];
+    sensor_type_t type = desc->type;
+    
+    s_threshold_raw[index] = sensor_threshold_to_raw(sensor_type_config[type].threshold);
+    sensor_filter_chain_init(&s_filter[index], sensor_type_config[type].filters,
+                             sensor_type_config[type].num_filters);
+    sensor_history_init(&s_history[index]);
     
-    return 0;
+    if (sensor_type_config[type].instant) {
+        s_instant_mask |= (1UL << index);
+    }
+    
+    // Channel analog được cấu hình chung trong pattern quét của sensor_system_init()
+    if (!desc->is_analog) {
+        // Cấu hình GPIO cho cảm biến digital
+        gpio_set_direction(desc->pin, GPIO_MODE_INPUT);
+        gpio_set_pull_mode(desc->pin, GPIO_PULLUP_ONLY);
+    }
+    
+    ESP_LOGI(TAG, "Sensor %s (type %d) initialized on pin %d (analog: %s)", 
+             desc->name, type, desc->pin, desc->is_analog ? "yes" : "no");
 }
 
-int sensor_read(sensor_t *sensor)
+int sensor_read(sensor_status_t *status, uint8_t index)
 {
-    if (sensor == NULL) {
+    if (status == NULL || index >= SENSOR_REGISTRY_COUNT) {
         return -1;
     }
     
-    if (sensor->is_analog) {
-        // Đọc giá trị ADC
-        int adc_reading = 0;
-        ESP_ERROR_CHECK(adc_oneshot_read(adc1_handle, sensor->pin, &adc_reading));
-        
-        int voltage = 0;
-        if (adc1_cali_handle != NULL) {
-            ESP_ERROR_CHECK(adc_cali_raw_to_voltage(adc1_cali_handle, adc_reading, &voltage));
-        } else {
-            // Nếu không có calibration, sử dụng giá trị raw (0-4095)
-            voltage = adc_reading;
+    const sensor_desc_t *desc = &sensor_registry[index];
+    uint16_t raw_value = 0;
+    
+    if (desc->is_analog) {
+        // Lấy giá trị trung bình của channel trên cả chu kỳ đọc
+        if (!s_adc_frame_valid ||
+            adc_stream_channel_mean(&s_adc_frame, desc->pin, &raw_value) != 0) {
+            return -1;
         }
-        // Lưu giá trị raw (0-4095) thay vì voltage
-        sensor->raw_value = (uint16_t)adc_reading;
     } else {
         // Đọc giá trị digital
-        sensor->raw_value = gpio_get_level(sensor->pin) ? 0 : 4095; // Invert vì pull-up
+        raw_value = gpio_get_level(desc->pin) ? 0 : 4095; // Invert vì pull-up
     }
     
-    // Chuẩn hóa giá trị
-    sensor->normalized_value = sensor_normalize(sensor);
+    return sensor_process_sample(status, index, raw_value);
+}
+
+int sensor_process_sample(sensor_status_t *status, uint8_t index, uint16_t raw_value)
+{
+    if (status == NULL || index >= SENSOR_REGISTRY_COUNT) {
+        return -1;
+    }
+    
+    // Lọc nhiễu (median/EMA) trước khi so ngưỡng
+    uint16_t filtered = sensor_filter_chain_apply(&s_filter[index], raw_value);
+    
+    status->raw_value[index] = raw_value;
+    status->filtered_value[index] = filtered;
+    
+    // Chuẩn hóa giá trị (Q15, chỉ nhân và dịch bit)
+    status->normalized_q15[index] = sensor_raw_to_q15(filtered);
     
-    // Kiểm tra ngưỡng kích hoạt
-    float threshold = 0.0f;
-    switch (sensor->type) {
-        case SENSOR_TYPE_SMOKE:
-            threshold = SMOKE_THRESHOLD;
-            break;
-        case SENSOR_TYPE_TEMPERATURE:
-            threshold = TEMPERATURE_THRESHOLD;
-            break;
-        case SENSOR_TYPE_IR_FLAME:
-            threshold = IR_FLAME_THRESHOLD;
-            break;
-        case SENSOR_TYPE_GAS:
-            threshold = GAS_THRESHOLD;
-            break;
+    // Kiểm tra ngưỡng kích hoạt (so sánh số nguyên với ngưỡng đã quy đổi lúc init),
+    // sau đó debounce N-of-M nếu có
+    bool triggered = sensor_filter_chain_debounce(&s_filter[index], filtered >= s_threshold_raw[index]);
+    if (triggered) {
+        status->triggered_mask |= (1UL << index);
+    } else {
+        status->triggered_mask &= ~(1UL << index);
     }
     
-    sensor->is_triggered = (sensor->normalized_value >= threshold);
-    sensor->last_read_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    // Lưu mẫu vào lịch sử (O(1))
+    portENTER_CRITICAL(&s_history_lock);
+    sensor_history_add(&s_history[index], raw_value, status->last_read_time);
+    portEXIT_CRITICAL(&s_history_lock);
     
     return 0;
 }
 
-float sensor_normalize(sensor_t *sensor)
+int sensor_get_threshold(uint8_t index, float *threshold, uint16_t *threshold_raw)
 {
-    if (sensor == NULL) {
+    if (index >= SENSOR_REGISTRY_COUNT) {
+        return -1;
+    }
+    
+    if (threshold != NULL) {
+        *threshold = sensor_type_config[sensor_registry[index].type].threshold;
+    }
+    if (threshold_raw != NULL) {
+        *threshold_raw = s_threshold_raw[index];
+    }
+    return 0;
+}
+
+float sensor_normalize(const sensor_status_t *status, uint8_t index)
+{
+    if (status == NULL || index >= SENSOR_MAX_COUNT) {
         return 0.0f;
     }
     
-    // Chuẩn hóa từ 0-4095 về 0.0-1.0
-    return (float)sensor->raw_value / 4095.0f;
+    // Chuyển Q15 về 0.0-1.0 (chỉ dùng khi hiển thị/serialize)
+    return (float)status->normalized_q15[index] / (float)SENSOR_Q15_MAX;
 }
 
-bool sensor_is_triggered(sensor_t *sensor)
+bool sensor_is_triggered(const sensor_status_t *status, uint8_t index)
 {
-    if (sensor == NULL) {
+    if (status == NULL || index >= SENSOR_MAX_COUNT) {
         return false;
     }
     
-    return sensor->is_triggered;
+    return (status->triggered_mask >> index) & 1UL;
+}
+
+int sensor_get_history_raw(uint8_t index, uint16_t age, uint16_t *out_value)
+{
+    if (index >= SENSOR_REGISTRY_COUNT) {
+        return -1;
+    }
+    
+    portENTER_CRITICAL(&s_history_lock);
+    int ret = sensor_history_get_raw(&s_history[index], age, out_value);
+    portEXIT_CRITICAL(&s_history_lock);
+    
+    return ret;
+}
+
+int sensor_get_history_bucket(uint8_t index, sensor_history_tier_t tier,
+                              uint16_t age, sensor_history_bucket_t *out_bucket)
+{
+    if (index >= SENSOR_REGISTRY_COUNT) {
+        return -1;
+    }
+    
+    portENTER_CRITICAL(&s_history_lock);
+    int ret = sensor_history_get_bucket(&s_history[index], tier, age, out_bucket);
+    portEXIT_CRITICAL(&s_history_lock);
+    
+    return ret;
 }
 
 int sensor_system_init(sensor_status_t *status)
@@ -207,22 +389,39 @@ int sensor_system_init(sensor_status_t *status)
         return -1;
     }
     
-    // Khởi tạo cảm biến khói (ví dụ: GPIO 34 - ADC_CHANNEL_6)
-    sensor_init(&status->smoke, SENSOR_TYPE_SMOKE, ADC_CHANNEL_6, true);
+    memset(status, 0, sizeof(sensor_status_t));
+    status->count = SENSOR_REGISTRY_COUNT;
     
-    // Khởi tạo cảm biến nhiệt độ (ví dụ: GPIO 35 - ADC_CHANNEL_7)
-    sensor_init(&status->temperature, SENSOR_TYPE_TEMPERATURE, ADC_CHANNEL_7, true);
+    // Độ dài payload JSON tính theo SENSOR_NAME_MAX_LEN (xem telemetry.h)
+    for (uint8_t i = 0; i < SENSOR_REGISTRY_COUNT; i++) {
+        if (strlen(sensor_registry[i].name) > SENSOR_NAME_MAX_LEN) {
+            ESP_LOGE(TAG, "Sensor name too long: %s", sensor_registry[i].name);
+            return -1;
+        }
+    }
     
-    // Khởi tạo cảm biến IR flame (ví dụ: GPIO 32 - digital)
-    sensor_init(&status->ir_flame, SENSOR_TYPE_IR_FLAME, GPIO_NUM_32, false);
+    // Các channel analog trong registry được quét liên tục theo thứ tự
+    uint8_t analog_channels[SENSOR_REGISTRY_COUNT];
+    uint8_t num_analog = 0;
+    for (uint8_t i = 0; i < SENSOR_REGISTRY_COUNT; i++) {
+        if (sensor_registry[i].is_analog) {
+            analog_channels[num_analog++] = sensor_registry[i].pin;
+        }
+    }
+    if (num_analog > 0 && sensor_adc_init(analog_channels, num_analog) != 0) {
+        return -1;
+    }
     
-    // Khởi tạo cảm biến khí gas (ví dụ: GPIO 33 - ADC_CHANNEL_5)
-    sensor_init(&status->gas, SENSOR_TYPE_GAS, ADC_CHANNEL_5, true);
+    s_instant_mask = 0;
+    for (uint8_t i = 0; i < SENSOR_REGISTRY_COUNT; i++) {
+        sensor_init(i);
+    }
     
-    status->fire_detected = false;
-    status->detection_timestamp = 0;
+    ror_init(&s_temperature_ror);
+    s_ror_rising = false;
+    s_temperature_index = sensor_find(SENSOR_TYPE_TEMPERATURE);
     
-    ESP_LOGI(TAG, "Sensor system initialized");
+    ESP_LOGI(TAG, "Sensor system initialized (%d sensors)", (int)SENSOR_REGISTRY_COUNT);
     
     return 0;
 }
@@ -233,40 +432,169 @@ int sensor_system_read_all(sensor_status_t *status)
         return -1;
     }
     
-    sensor_read(&status->smoke);
-    sensor_read(&status->temperature);
-    sensor_read(&status->ir_flame);
-    sensor_read(&status->gas);
+    // Lấy trung bình mọi mẫu từ chu kỳ trước cho các cảm biến analog
+    s_adc_frame_valid = (adc_stream_read_frame(&s_adc_frame, SENSOR_FRAME_TIMEOUT_MS) == 0);
+    if (s_adc_frame_valid) {
+        TRACE_POINT(TRACE_ADC_FRAME, TRACE_TAG_NONE);
+    } else {
+        ESP_LOGW(TAG, "No ADC frame available, keeping previous analog values");
+    }
+    
+    status->last_read_time = xTaskGetTickCount() * portTICK_PERIOD_MS;
+    for (uint8_t i = 0; i < SENSOR_REGISTRY_COUNT; i++) {
+        sensor_read(status, i);
+    }
+    
+    bool changed = sensor_evaluate(status);
+    
+    // Công bố bản chụp trước khi báo để task cảnh báo đọc được chu kỳ này
+    sensor_snapshot_publish(status);
+    
+    // Chuyển mẫu của chu kỳ này cho bộ gom telemetry, không chờ
+    if (s_sample_queue != NULL && xQueueSend(s_sample_queue, status, 0) != pdTRUE) {
+        s_sample_drops++;
+    }
+    
+    // Báo ngay cho task cảnh báo khi trạng thái thay đổi
+    if (changed && s_event_task != NULL) {
+        xTaskNotify(s_event_task,
+                    status->fire_detected ? SENSOR_EVENT_FIRE_DETECTED : SENSOR_EVENT_FIRE_CLEARED,
+                    eSetBits);
+    }
+    
+    return 0;
+}
+
+bool sensor_evaluate(sensor_status_t *status)
+{
+    if (status == NULL) {
+        return false;
+    }
+    
+    // Tốc độ tăng nhiệt độ trên giá trị đã lọc, là một nguồn kích hoạt riêng khi
+    // vượt ngưỡng liên tục SENSOR_ROR_SUSTAIN_MS
+    status->temperature_rate = 0;
+    status->ror_triggered = false;
+    if (s_temperature_index >= 0) {
+        ror_add(&s_temperature_ror, status->filtered_value[s_temperature_index], status->last_read_time);
+        bool rising = (ror_get_rate(&s_temperature_ror, &status->temperature_rate) == 0) &&
+                      (status->temperature_rate >= TEMPERATURE_ROR_THRESHOLD);
+        if (rising && !s_ror_rising) {
+            s_ror_rising_since_ms = status->last_read_time;
+        }
+        s_ror_rising = rising;
+        status->ror_triggered = rising &&
+                                (status->last_read_time - s_ror_rising_since_ms >= SENSOR_ROR_SUSTAIN_MS);
+    }
     
     // Phát hiện cháy
+    bool was_detected = status->fire_detected;
     status->fire_detected = sensor_detect_fire(status);
+    TRACE_POINT(TRACE_SENSOR_EVALUATED, TRACE_TAG_NONE);
     if (status->fire_detected) {
-        status->detection_timestamp = xTaskGetTickCount() * portTICK_PERIOD_MS;
+        status->detection_timestamp = status->last_read_time;
     }
     
-    return 0;
+    bool changed = (status->fire_detected != was_detected);
+    if (changed) {
+        status->event_time_us = esp_timer_get_time();
+        if (status->fire_detected) {
+            TRACE_POINT(TRACE_FIRE_DETECTED, trace_tag(status->event_time_us));
+        }
+    }
+    
+    return changed;
 }
 
-bool sensor_detect_fire(sensor_status_t *status)
+void sensor_snapshot_publish(const sensor_status_t *status)
 {
     if (status == NULL) {
-        return false;
+        return;
     }
     
-    // Logic phát hiện cháy: nếu có ít nhất 2 cảm biến kích hoạt
-    int triggered_count = 0;
+    // Ghi vào buffer không hoạt động, reader đang đọc buffer kia không bị ảnh hưởng
+    unsigned int idx = atomic_load_explicit(&s_snapshot_active, memory_order_relaxed) ^ 1u;
+    sensor_snapshot_slot_t *slot = &s_snapshot[idx];
+    
+    unsigned int seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    
+    uint32_t number = atomic_load_explicit(&s_snapshot_count, memory_order_relaxed) + 1;
+    slot->number = number;
+    memcpy(&slot->data, status, sizeof(sensor_status_t));
+    
+    atomic_store_explicit(&slot->seq, seq + 2, memory_order_release);
+    atomic_store_explicit(&s_snapshot_active, idx, memory_order_release);
+    atomic_store_explicit(&s_snapshot_count, number, memory_order_release);
+}
+
+uint32_t sensor_snapshot_acquire(sensor_status_t *out)
+{
+    if (out == NULL) {
+        return 0;
+    }
     
-    if (status->smoke.is_triggered) triggered_count++;
-    if (status->temperature.is_triggered) triggered_count++;
-    if (status->ir_flame.is_triggered) triggered_count++;
-    if (status->gas.is_triggered) triggered_count++;
+    if (atomic_load_explicit(&s_snapshot_count, memory_order_acquire) == 0) {
+        return 0;
+    }
     
-    // Nếu IR flame kích hoạt, coi như cháy ngay lập tức
-    if (status->ir_flame.is_triggered) {
+    while (1) {
+        unsigned int idx = atomic_load_explicit(&s_snapshot_active, memory_order_acquire);
+        const sensor_snapshot_slot_t *slot = &s_snapshot[idx];
+        
+        unsigned int seq1 = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (seq1 & 1u) {
+            // Writer đã vòng qua buffer này, chỉ số active đã trỏ sang buffer kia
+            continue;
+        }
+        
+        uint32_t number = slot->number;
+        memcpy(out, &slot->data, sizeof(sensor_status_t));
+        
+        atomic_thread_fence(memory_order_acquire);
+        unsigned int seq2 = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+        if (seq1 == seq2) {
+            // Số thứ tự đọc cùng buffer nên luôn khớp với dữ liệu trả về
+            return number;
+        }
+    }
+}
+
+void sensor_set_event_task(TaskHandle_t task)
+{
+    s_event_task = task;
+}
+
+void sensor_set_sample_queue(QueueHandle_t queue)
+{
+    s_sample_queue = queue;
+}
+
+uint32_t sensor_get_sample_drops(void)
+{
+    return s_sample_drops;
+}
+
+bool sensor_detect_fire(const sensor_status_t *status)
+{
+    if (status == NULL) {
+        return false;
+    }
+    
+    // Nếu cảm biến báo ngay (IR flame) kích hoạt, coi như cháy ngay lập tức
+    if (status->triggered_mask & s_instant_mask) {
         return true;
     }
     
-    // Nếu có ít nhất 2 cảm biến khác kích hoạt
+    // Logic phát hiện cháy: có ít nhất 2 nguồn kích hoạt, tốc độ tăng nhiệt độ kéo dài
+    // (ror_triggered) là một nguồn riêng nên cùng khói hoặc gas báo cháy trước khi
+    // nhiệt độ chạm ngưỡng
+    int triggered_count = __builtin_popcount(status->triggered_mask);
+    if (status->ror_triggered) {
+        triggered_count++;
+    }
+    
     return (triggered_count >= 2);
 }
 
@@ -280,7 +608,7 @@ void sensor_task(void *pvParameters)
         return;
     }
     
-    const TickType_t delay = pdMS_TO_TICKS(500); // 500ms chu kỳ
+    const TickType_t delay = pdMS_TO_TICKS(SENSOR_READ_PERIOD_MS);
     
     ESP_LOGI(TAG, "Sensor task started");
     
@@ -289,15 +617,15 @@ void sensor_task(void *pvParameters)
         sensor_system_read_all(status);
         
         // Log thông tin cảm biến
-        ESP_LOGD(TAG, "Smoke: %.2f, Temp: %.2f, IR: %d, Gas: %.2f, Fire: %s",
-                 status->smoke.normalized_value,
-                 status->temperature.normalized_value,
-                 status->ir_flame.is_triggered,
-                 status->gas.normalized_value,
+        for (uint8_t i = 0; i < status->count; i++) {
+            ESP_LOGD(TAG, "%s: %.2f (triggered: %d)", sensor_registry[i].name,
+                     sensor_normalize(status, i), sensor_is_triggered(status, i));
+        }
+        ESP_LOGD(TAG, "ROR: %" PRId32 " raw/min, Fire: %s", status->temperature_rate,
                  status->fire_detected ? "YES" : "NO");
         
         if (status->fire_detected) {
-            ESP_LOGW(TAG, "FIRE DETECTED! Timestamp: %lu", status->detection_timestamp);
+            ESP_LOGW(TAG, "FIRE DETECTED! Timestamp: %" PRIu32, status->detection_timestamp);
         }
         
         vTaskDelay(delay);
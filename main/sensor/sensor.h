@@ -5,88 +5,243 @@
 #include <stdbool.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
 #include "driver/gpio.h"
+#include "sensor_history/sensor_history.h"
+
+// Số cảm biến tối đa trong registry (mỗi cảm biến một bit trong triggered_mask)
+#ifndef SENSOR_MAX_COUNT
+#define SENSOR_MAX_COUNT 8
+#endif
+
+// Độ dài tối đa tên cảm biến (key trong JSON), kiểm tra khi khởi tạo registry
+#define SENSOR_NAME_MAX_LEN 11
+
+// Chu kỳ đọc của sensor_task (ms)
+#define SENSOR_READ_PERIOD_MS 500
+
+// Tốc độ tăng nhiệt độ phải vượt ngưỡng liên tục chừng này (ms) mới là một nguồn kích
+// hoạt: bước nhiệt ngắn của bếp chỉ làm độ dốc vượt ngưỡng trong khoảng một cửa sổ ROR
+#ifndef SENSOR_ROR_SUSTAIN_MS
+#define SENSOR_ROR_SUSTAIN_MS 20000
+#endif
+
+// Hệ số đổi raw (0-4095) sang Q15 (0-32767): round(32767 * 65536 / 4095)
+#define SENSOR_RAW_MAX 4095
+#define SENSOR_Q15_MAX 32767
+#define SENSOR_RAW_TO_Q15_MUL 524400u
 
 // Định nghĩa các loại cảm biến
 typedef enum {
     SENSOR_TYPE_SMOKE = 0,      // Cảm biến khói
     SENSOR_TYPE_TEMPERATURE,    // Cảm biến nhiệt độ
     SENSOR_TYPE_IR_FLAME,       // Cảm biến tia lửa hồng ngoại
-    SENSOR_TYPE_GAS             // Cảm biến khí gas
+    SENSOR_TYPE_GAS,            // Cảm biến khí gas
+    SENSOR_TYPE_CO,             // Cảm biến khí CO
+    SENSOR_TYPE_COUNT           // Số loại cảm biến
 } sensor_type_t;
 
-// Cấu trúc dữ liệu cảm biến
+// Mô tả một đầu vào cảm biến trong registry
 typedef struct {
+    const char *name;           // Tên cảm biến (dùng làm key trong JSON)
     sensor_type_t type;
-    uint8_t pin;
+    uint8_t pin;                // GPIO pin hoặc ADC channel
     bool is_analog;
-    uint16_t raw_value;
-    float normalized_value;
-    bool is_triggered;
-    uint32_t last_read_time;
-} sensor_t;
+} sensor_desc_t;
 
-// Cấu trúc trạng thái tổng hợp cảm biến
+// Cấu trúc trạng thái tổng hợp cảm biến (structure-of-arrays, chỉ số i ứng với registry[i])
 typedef struct {
-    sensor_t smoke;
-    sensor_t temperature;
-    sensor_t ir_flame;
-    sensor_t gas;
+    uint8_t count;                              // Số cảm biến trong registry
+    uint32_t triggered_mask;                    // Bit i = cảm biến i đang kích hoạt
+    uint16_t raw_value[SENSOR_MAX_COUNT];       // Giá trị raw (0-4095)
+    uint16_t filtered_value[SENSOR_MAX_COUNT];  // Giá trị sau chuỗi lọc (median/EMA), dùng để so ngưỡng
+    uint16_t normalized_q15[SENSOR_MAX_COUNT];  // Giá trị sau lọc chuẩn hóa Q15 (0 - 32767 tương ứng 0.0 - 1.0)
+    uint32_t last_read_time;                    // Thời điểm chu kỳ đọc gần nhất (ms)
+    int32_t temperature_rate;   // Tốc độ tăng nhiệt độ (raw / phút)
+    bool ror_triggered;         // Tốc độ tăng nhiệt độ vượt ngưỡng kéo dài
     bool fire_detected;
     uint32_t detection_timestamp;
+    int64_t event_time_us;      // Thời điểm (esp_timer) trạng thái cháy thay đổi gần nhất
 } sensor_status_t;
 
+// Bit thông báo (task notification) gửi tới task đăng ký nhận sự kiện cháy
+#define SENSOR_EVENT_FIRE_DETECTED (1UL << 0)
+#define SENSOR_EVENT_FIRE_CLEARED  (1UL << 1)
+
 /**
- * @brief Khởi tạo cảm biến
- * @param sensor Con trỏ đến cấu trúc cảm biến
+ * @brief Số cảm biến trong registry
+ * @return Số cảm biến
+ */
+uint8_t sensor_count(void);
+
+/**
+ * @brief Lấy mô tả của cảm biến trong registry
+ * @param index Chỉ số cảm biến
+ * @return Con trỏ đến mô tả, NULL nếu chỉ số không hợp lệ
+ */
+const sensor_desc_t *sensor_get_desc(uint8_t index);
+
+/**
+ * @brief Tìm cảm biến đầu tiên thuộc một loại
  * @param type Loại cảm biến
- * @param pin GPIO pin hoặc ADC channel
- * @param is_analog true nếu là cảm biến analog, false nếu digital
- * @return ESP_OK nếu thành công
+ * @return Chỉ số cảm biến, -1 nếu không có
  */
-int sensor_init(sensor_t *sensor, sensor_type_t type, uint8_t pin, bool is_analog);
+int sensor_find(sensor_type_t type);
 
 /**
- * @brief Đọc giá trị từ cảm biến
- * @param sensor Con trỏ đến cấu trúc cảm biến
- * @return ESP_OK nếu thành công
+ * @brief Đọc giá trị từ cảm biến và xử lý mẫu
+ * @param status Con trỏ đến cấu trúc trạng thái cảm biến
+ * @param index Chỉ số cảm biến
+ * @return 0 nếu thành công, -1 nếu lỗi
  */
-int sensor_read(sensor_t *sensor);
+int sensor_read(sensor_status_t *status, uint8_t index);
 
 /**
- * @brief Chuẩn hóa giá trị cảm biến (0.0 - 1.0)
- * @param sensor Con trỏ đến cấu trúc cảm biến
+ * @brief Xử lý một mẫu raw: lọc, chuẩn hóa, so ngưỡng, lưu lịch sử
+ *
+ * Không truy cập phần cứng; thời điểm mẫu lấy từ status->last_read_time.
+ *
+ * @param status Con trỏ đến cấu trúc trạng thái cảm biến
+ * @param index Chỉ số cảm biến
+ * @param raw_value Giá trị raw (0-4095)
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int sensor_process_sample(sensor_status_t *status, uint8_t index, uint16_t raw_value);
+
+/**
+ * @brief Chuẩn hóa raw (0-4095) sang Q15, chỉ nhân và dịch bit
+ */
+static inline uint16_t sensor_raw_to_q15(uint16_t raw)
+{
+    return (uint16_t)(((uint32_t)raw * SENSOR_RAW_TO_Q15_MUL + 0x8000u) >> 16);
+}
+
+/**
+ * @brief Ngưỡng kích hoạt của cảm biến
+ * @param index Chỉ số cảm biến
+ * @param threshold Ngưỡng chuẩn hóa (0.0 - 1.0), NULL nếu không cần
+ * @param threshold_raw Ngưỡng đã quy đổi sang raw, NULL nếu không cần
+ * @return 0 nếu thành công, -1 nếu chỉ số không hợp lệ
+ */
+int sensor_get_threshold(uint8_t index, float *threshold, uint16_t *threshold_raw);
+
+/**
+ * @brief Chuẩn hóa giá trị cảm biến (0.0 - 1.0) dạng float
+ *
+ * Chỉ dùng ở bước hiển thị/serialize; đường đọc nóng dùng normalized_q15
+ * và ngưỡng raw.
+ *
+ * @param status Con trỏ đến cấu trúc trạng thái cảm biến
+ * @param index Chỉ số cảm biến
  * @return Giá trị đã chuẩn hóa
  */
-float sensor_normalize(sensor_t *sensor);
+float sensor_normalize(const sensor_status_t *status, uint8_t index);
 
 /**
  * @brief Kiểm tra cảm biến có bị kích hoạt không
- * @param sensor Con trỏ đến cấu trúc cảm biến
+ * @param status Con trỏ đến cấu trúc trạng thái cảm biến
+ * @param index Chỉ số cảm biến
  * @return true nếu bị kích hoạt
  */
-bool sensor_is_triggered(sensor_t *sensor);
+bool sensor_is_triggered(const sensor_status_t *status, uint8_t index);
 
 /**
- * @brief Khởi tạo tất cả cảm biến
+ * @brief Lấy mẫu raw trong lịch sử của một cảm biến
+ * @param index Chỉ số cảm biến
+ * @param age 0 là mẫu mới nhất
+ * @param out_value Giá trị đầu ra
+ * @return 0 nếu thành công, -1 nếu không có mẫu
+ */
+int sensor_get_history_raw(uint8_t index, uint16_t age, uint16_t *out_value);
+
+/**
+ * @brief Lấy bucket min/max/mean đã đóng trong lịch sử của một cảm biến
+ * @param index Chỉ số cảm biến
+ * @param tier Tầng bucket (1 giây / 1 phút)
+ * @param age 0 là bucket đã đóng gần nhất
+ * @param out_bucket Bucket đầu ra
+ * @return 0 nếu thành công, -1 nếu không có bucket
+ */
+int sensor_get_history_bucket(uint8_t index, sensor_history_tier_t tier,
+                              uint16_t age, sensor_history_bucket_t *out_bucket);
+
+/**
+ * @brief Khởi tạo tất cả cảm biến trong registry
  * @param status Con trỏ đến cấu trúc trạng thái cảm biến
- * @return ESP_OK nếu thành công
+ * @return 0 nếu thành công
  */
 int sensor_system_init(sensor_status_t *status);
 
 /**
  * @brief Đọc tất cả cảm biến
  * @param status Con trỏ đến cấu trúc trạng thái cảm biến
- * @return ESP_OK nếu thành công
+ * @return 0 nếu thành công
  */
 int sensor_system_read_all(sensor_status_t *status);
 
+/**
+ * @brief Đánh giá một chu kỳ đọc: tốc độ tăng nhiệt độ và phát hiện cháy
+ *
+ * Gọi sau sensor_process_sample() cho mọi cảm biến của chu kỳ. Không truy
+ * cập phần cứng và không báo task nào, nên dùng được khi replay trace.
+ *
+ * @param status Trạng thái của chu kỳ (last_read_time là thời điểm chu kỳ)
+ * @return true nếu trạng thái cháy thay đổi
+ */
+bool sensor_evaluate(sensor_status_t *status);
+
+/**
+ * @brief Công bố bản chụp trạng thái cảm biến cho các task đọc
+ *
+ * Ghi vào buffer không hoạt động của cặp double-buffer rồi chuyển chỉ số,
+ * không bao giờ chặn. Chỉ một task (sensor_task) được phép gọi.
+ *
+ * @param status Trạng thái của chu kỳ đọc vừa hoàn tất
+ */
+void sensor_snapshot_publish(const sensor_status_t *status);
+
+/**
+ * @brief Lấy bản chụp nhất quán (cùng một chu kỳ đọc) của trạng thái cảm biến
+ *
+ * Không dùng mutex: đọc lại nếu bản chụp bị ghi đè trong lúc sao chép.
+ *
+ * @param out Con trỏ đến cấu trúc nhận bản chụp
+ * @return Số thứ tự bản chụp (>= 1), 0 nếu chưa có bản chụp nào
+ */
+uint32_t sensor_snapshot_acquire(sensor_status_t *out);
+
+/**
+ * @brief Đăng ký task nhận thông báo khi trạng thái cháy thay đổi
+ *
+ * sensor_system_read_all() gửi SENSOR_EVENT_FIRE_DETECTED hoặc
+ * SENSOR_EVENT_FIRE_CLEARED tới task này bằng xTaskNotify (eSetBits).
+ *
+ * @param task Handle của task nhận sự kiện (NULL để hủy đăng ký)
+ */
+void sensor_set_event_task(TaskHandle_t task);
+
+/**
+ * @brief Đăng ký queue nhận bản sao trạng thái của mọi chu kỳ đọc
+ *
+ * sensor_system_read_all() gửi sensor_status_t vào queue mà không chờ;
+ * mẫu bị bỏ (và được đếm) nếu queue đầy.
+ *
+ * @param queue Queue có phần tử kích thước sizeof(sensor_status_t) (NULL để hủy đăng ký)
+ */
+void sensor_set_sample_queue(QueueHandle_t queue);
+
+/**
+ * @brief Số mẫu bị bỏ do queue mẫu đầy
+ * @return Số mẫu bị bỏ
+ */
+uint32_t sensor_get_sample_drops(void);
+
 /**
  * @brief Phát hiện cháy dựa trên dữ liệu cảm biến
  * @param status Con trỏ đến cấu trúc trạng thái cảm biến
  * @return true nếu phát hiện cháy
  */
-bool sensor_detect_fire(sensor_status_t *status);
+bool sensor_detect_fire(const sensor_status_t *status);
 
 /**
  * @brief Task FreeRTOS để đọc cảm biến định kỳ
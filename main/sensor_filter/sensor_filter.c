@@ -0,0 +1,159 @@
+#include "sensor_filter.h"
+#include <string.h>
+
+// Số bit phần thập phân của bộ tích lũy EMA
+#define EMA_FRAC_BITS 4
+
+static bool stage_cfg_valid(const sensor_filter_cfg_t *cfg)
+{
+    switch (cfg->type) {
+        case SENSOR_FILTER_MEDIAN:
+            return cfg->param >= 1 && cfg->param <= SENSOR_FILTER_MEDIAN_MAX;
+        case SENSOR_FILTER_EMA:
+            return cfg->param <= 15;
+        case SENSOR_FILTER_DEBOUNCE:
+            return cfg->param >= 1 && cfg->param2 >= cfg->param &&
+                   cfg->param2 <= SENSOR_FILTER_DEBOUNCE_MAX;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Median trượt: giữ mảng đã sắp xếp, mỗi mẫu bỏ một phần tử và chèn một phần tử
+ */
+static uint16_t median_apply(sensor_filter_stage_t *stage, uint16_t value)
+{
+    uint8_t len = stage->cfg.param;
+    uint16_t *window = stage->state.median.window;
+    uint16_t *sorted = stage->state.median.sorted;
+    uint8_t count = stage->state.median.count;
+
+    // Cửa sổ đầy: loại mẫu cũ nhất khỏi mảng đã sắp xếp
+    if (count == len) {
+        uint16_t oldest = window[stage->state.median.head];
+        uint8_t i = 0;
+        while (i < count && sorted[i] != oldest) {
+            i++;
+        }
+        for (; i + 1 < count; i++) {
+            sorted[i] = sorted[i + 1];
+        }
+        count--;
+    }
+
+    // Chèn mẫu mới giữ thứ tự tăng dần
+    uint8_t pos = count;
+    while (pos > 0 && sorted[pos - 1] > value) {
+        sorted[pos] = sorted[pos - 1];
+        pos--;
+    }
+    sorted[pos] = value;
+    count++;
+
+    window[stage->state.median.head] = value;
+    stage->state.median.head = (stage->state.median.head + 1) % len;
+    stage->state.median.count = count;
+
+    return sorted[count / 2];
+}
+
+/**
+ * @brief EMA fixed-point: acc += (x - acc) / 2^shift
+ */
+static uint16_t ema_apply(sensor_filter_stage_t *stage, uint16_t value)
+{
+    int32_t x = (int32_t)value << EMA_FRAC_BITS;
+
+    if (!stage->state.ema.primed) {
+        stage->state.ema.acc = x;
+        stage->state.ema.primed = true;
+    } else {
+        stage->state.ema.acc += (x - stage->state.ema.acc) >> stage->cfg.param;
+    }
+
+    return (uint16_t)((stage->state.ema.acc + (1 << (EMA_FRAC_BITS - 1))) >> EMA_FRAC_BITS);
+}
+
+/**
+ * @brief Debounce N-of-M: kích hoạt khi ít nhất N trong M mẫu gần nhất kích hoạt
+ */
+static bool debounce_apply(sensor_filter_stage_t *stage, bool triggered)
+{
+    uint8_t m = stage->cfg.param2;
+    uint32_t mask = (m >= 32) ? 0xFFFFFFFFu : ((1u << m) - 1u);
+
+    stage->state.debounce.history = ((stage->state.debounce.history << 1) | (triggered ? 1u : 0u)) & mask;
+
+    return __builtin_popcount(stage->state.debounce.history) >= stage->cfg.param;
+}
+
+int sensor_filter_chain_init(sensor_filter_chain_t *chain, const sensor_filter_cfg_t *cfg,
+                             uint8_t num_stages)
+{
+    if (chain == NULL || num_stages > SENSOR_FILTER_MAX_STAGES || (cfg == NULL && num_stages > 0)) {
+        return -1;
+    }
+
+    memset(chain, 0, sizeof(sensor_filter_chain_t));
+
+    for (uint8_t i = 0; i < num_stages; i++) {
+        if (!stage_cfg_valid(&cfg[i])) {
+            chain->num_stages = 0;
+            return -1;
+        }
+        chain->stages[i].cfg = cfg[i];
+    }
+    chain->num_stages = num_stages;
+
+    return 0;
+}
+
+void sensor_filter_chain_reset(sensor_filter_chain_t *chain)
+{
+    if (chain == NULL) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < chain->num_stages; i++) {
+        memset(&chain->stages[i].state, 0, sizeof(chain->stages[i].state));
+    }
+}
+
+uint16_t sensor_filter_chain_apply(sensor_filter_chain_t *chain, uint16_t value)
+{
+    if (chain == NULL) {
+        return value;
+    }
+
+    for (uint8_t i = 0; i < chain->num_stages; i++) {
+        sensor_filter_stage_t *stage = &chain->stages[i];
+        switch (stage->cfg.type) {
+            case SENSOR_FILTER_MEDIAN:
+                value = median_apply(stage, value);
+                break;
+            case SENSOR_FILTER_EMA:
+                value = ema_apply(stage, value);
+                break;
+            default:
+                break;
+        }
+    }
+
+    return value;
+}
+
+bool sensor_filter_chain_debounce(sensor_filter_chain_t *chain, bool triggered)
+{
+    if (chain == NULL) {
+        return triggered;
+    }
+
+    for (uint8_t i = 0; i < chain->num_stages; i++) {
+        if (chain->stages[i].cfg.type == SENSOR_FILTER_DEBOUNCE) {
+            triggered = debounce_apply(&chain->stages[i], triggered);
+        }
+    }
+
+    return triggered;
+}
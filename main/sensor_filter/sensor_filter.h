@@ -0,0 +1,85 @@
+#ifndef SENSOR_FILTER_H
+#define SENSOR_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Giới hạn của chuỗi lọc (bộ nhớ cố định cho mỗi cảm biến)
+#define SENSOR_FILTER_MAX_STAGES 3      // Số tầng lọc tối đa trong một chuỗi
+#define SENSOR_FILTER_MEDIAN_MAX 7      // Cửa sổ median tối đa
+#define SENSOR_FILTER_DEBOUNCE_MAX 32   // M tối đa của debounce N-of-M
+
+// Các loại bộ lọc
+typedef enum {
+    SENSOR_FILTER_NONE = 0,
+    SENSOR_FILTER_MEDIAN,       // Median trượt, param = độ dài cửa sổ
+    SENSOR_FILTER_EMA,          // Trung bình trượt mũ, param = hệ số dịch (alpha = 1 / 2^param)
+    SENSOR_FILTER_DEBOUNCE      // N-of-M trên trạng thái kích hoạt, param = N, param2 = M
+} sensor_filter_type_t;
+
+// Cấu hình một tầng lọc
+typedef struct {
+    sensor_filter_type_t type;
+    uint8_t param;
+    uint8_t param2;
+} sensor_filter_cfg_t;
+
+// Trạng thái một tầng lọc
+typedef struct {
+    sensor_filter_cfg_t cfg;
+    union {
+        struct {
+            uint16_t window[SENSOR_FILTER_MEDIAN_MAX];  // Mẫu theo thứ tự thời gian (vòng)
+            uint16_t sorted[SENSOR_FILTER_MEDIAN_MAX];  // Cùng các mẫu, đã sắp xếp
+            uint8_t head;
+            uint8_t count;
+        } median;
+        struct {
+            int32_t acc;            // Giá trị trung bình, dạng fixed-point (<< 4)
+            bool primed;
+        } ema;
+        struct {
+            uint32_t history;       // Bit i = trạng thái kích hoạt của mẫu cách đây i lần đọc
+        } debounce;
+    } state;
+} sensor_filter_stage_t;
+
+// Chuỗi lọc của một cảm biến
+typedef struct {
+    sensor_filter_stage_t stages[SENSOR_FILTER_MAX_STAGES];
+    uint8_t num_stages;
+} sensor_filter_chain_t;
+
+/**
+ * @brief Khởi tạo chuỗi lọc từ danh sách cấu hình
+ * @param chain Con trỏ đến chuỗi lọc
+ * @param cfg Mảng cấu hình các tầng (theo thứ tự áp dụng)
+ * @param num_stages Số tầng (tối đa SENSOR_FILTER_MAX_STAGES)
+ * @return 0 nếu thành công, -1 nếu cấu hình không hợp lệ
+ */
+int sensor_filter_chain_init(sensor_filter_chain_t *chain, const sensor_filter_cfg_t *cfg,
+                             uint8_t num_stages);
+
+/**
+ * @brief Xóa trạng thái của chuỗi lọc, giữ nguyên cấu hình
+ * @param chain Con trỏ đến chuỗi lọc
+ */
+void sensor_filter_chain_reset(sensor_filter_chain_t *chain);
+
+/**
+ * @brief Đưa một mẫu qua các tầng lọc giá trị (median, EMA)
+ * @param chain Con trỏ đến chuỗi lọc
+ * @param value Mẫu raw (0-4095)
+ * @return Giá trị sau lọc
+ */
+uint16_t sensor_filter_chain_apply(sensor_filter_chain_t *chain, uint16_t value);
+
+/**
+ * @brief Đưa trạng thái kích hoạt qua các tầng debounce
+ * @param chain Con trỏ đến chuỗi lọc
+ * @param triggered Trạng thái kích hoạt của mẫu hiện tại
+ * @return Trạng thái kích hoạt sau debounce (không đổi nếu chuỗi không có debounce)
+ */
+bool sensor_filter_chain_debounce(sensor_filter_chain_t *chain, bool triggered);
+
+#endif // SENSOR_FILTER_H
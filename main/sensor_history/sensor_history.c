@@ -0,0 +1,150 @@
+#include "sensor_history.h"
+#include <string.h>
+
+// Chu kỳ và vòng đệm của từng tầng
+static const uint32_t tier_period_ms[SENSOR_HISTORY_TIER_COUNT] = {
+    [SENSOR_HISTORY_TIER_SEC] = SENSOR_HISTORY_SEC_PERIOD_MS,
+    [SENSOR_HISTORY_TIER_MIN] = SENSOR_HISTORY_MIN_PERIOD_MS,
+};
+
+static const uint16_t tier_len[SENSOR_HISTORY_TIER_COUNT] = {
+    [SENSOR_HISTORY_TIER_SEC] = SENSOR_HISTORY_SEC_LEN,
+    [SENSOR_HISTORY_TIER_MIN] = SENSOR_HISTORY_MIN_LEN,
+};
+
+static sensor_history_bucket_t *tier_buckets(sensor_history_t *history, sensor_history_tier_t tier)
+{
+    return (tier == SENSOR_HISTORY_TIER_SEC) ? history->sec_buckets : history->min_buckets;
+}
+
+static const sensor_history_bucket_t *tier_buckets_const(const sensor_history_t *history,
+                                                         sensor_history_tier_t tier)
+{
+    return (tier == SENSOR_HISTORY_TIER_SEC) ? history->sec_buckets : history->min_buckets;
+}
+
+/**
+ * @brief Gộp một bucket (hoặc một mẫu đơn) vào bucket đang tích lũy của tầng
+ * @return true nếu bucket cũ vừa được đóng
+ */
+static bool tier_merge(sensor_history_t *history, sensor_history_tier_t tier,
+                       const sensor_history_bucket_t *in, sensor_history_bucket_t *closed)
+{
+    sensor_history_tier_state_t *state = &history->tier[tier];
+    sensor_history_bucket_t *cur = &state->current;
+    uint32_t start_ms = in->start_ms - (in->start_ms % tier_period_ms[tier]);
+    bool did_close = false;
+
+    // Sang chu kỳ mới: đóng bucket hiện tại và đưa vào vòng đệm
+    if (cur->count > 0 && cur->start_ms != start_ms) {
+        tier_buckets(history, tier)[state->head] = *cur;
+        state->head = (state->head + 1) % tier_len[tier];
+        if (state->count < tier_len[tier]) {
+            state->count++;
+        }
+        *closed = *cur;
+        did_close = true;
+        cur->count = 0;
+    }
+
+    if (cur->count == 0) {
+        cur->start_ms = start_ms;
+        cur->sum = 0;
+        cur->min = in->min;
+        cur->max = in->max;
+    }
+
+    cur->sum += in->sum;
+    cur->count += in->count;
+    if (in->min < cur->min) cur->min = in->min;
+    if (in->max > cur->max) cur->max = in->max;
+
+    return did_close;
+}
+
+void sensor_history_init(sensor_history_t *history)
+{
+    if (history == NULL) {
+        return;
+    }
+
+    memset(history, 0, sizeof(sensor_history_t));
+}
+
+void sensor_history_add(sensor_history_t *history, uint16_t value, uint32_t time_ms)
+{
+    if (history == NULL) {
+        return;
+    }
+
+    // Vòng đệm mẫu raw
+    history->raw[history->raw_head] = value;
+    history->raw_head = (history->raw_head + 1) % SENSOR_HISTORY_RAW_LEN;
+    if (history->raw_count < SENSOR_HISTORY_RAW_LEN) {
+        history->raw_count++;
+    }
+
+    // Tầng 1 giây nhận từng mẫu, tầng 1 phút nhận các bucket 1 giây đã đóng
+    sensor_history_bucket_t sample = {
+        .start_ms = time_ms,
+        .sum = value,
+        .min = value,
+        .max = value,
+        .count = 1,
+    };
+    sensor_history_bucket_t closed;
+    if (tier_merge(history, SENSOR_HISTORY_TIER_SEC, &sample, &closed)) {
+        sensor_history_bucket_t unused;
+        tier_merge(history, SENSOR_HISTORY_TIER_MIN, &closed, &unused);
+    }
+}
+
+int sensor_history_get_raw(const sensor_history_t *history, uint16_t age, uint16_t *out_value)
+{
+    if (history == NULL || out_value == NULL || age >= history->raw_count) {
+        return -1;
+    }
+
+    uint16_t idx = (history->raw_head + SENSOR_HISTORY_RAW_LEN - 1 - age) % SENSOR_HISTORY_RAW_LEN;
+    *out_value = history->raw[idx];
+    return 0;
+}
+
+int sensor_history_get_bucket(const sensor_history_t *history, sensor_history_tier_t tier,
+                              uint16_t age, sensor_history_bucket_t *out_bucket)
+{
+    if (history == NULL || out_bucket == NULL || tier >= SENSOR_HISTORY_TIER_COUNT) {
+        return -1;
+    }
+
+    const sensor_history_tier_state_t *state = &history->tier[tier];
+    if (age >= state->count) {
+        return -1;
+    }
+
+    uint16_t len = tier_len[tier];
+    uint16_t idx = (state->head + len - 1 - age) % len;
+    *out_bucket = tier_buckets_const(history, tier)[idx];
+    return 0;
+}
+
+int sensor_history_get_current(const sensor_history_t *history, sensor_history_tier_t tier,
+                               sensor_history_bucket_t *out_bucket)
+{
+    if (history == NULL || out_bucket == NULL || tier >= SENSOR_HISTORY_TIER_COUNT ||
+        history->tier[tier].current.count == 0) {
+        return -1;
+    }
+
+    *out_bucket = history->tier[tier].current;
+    return 0;
+}
+
+uint16_t sensor_history_bucket_mean(const sensor_history_bucket_t *bucket)
+{
+    if (bucket == NULL || bucket->count == 0) {
+        return 0;
+    }
+
+    return (uint16_t)(bucket->sum / bucket->count);
+}
@@ -0,0 +1,105 @@
+#ifndef SENSOR_HISTORY_H
+#define SENSOR_HISTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Kích thước lịch sử (có thể ghi đè khi build, ví dụ -DSENSOR_HISTORY_RAW_LEN=128)
+#ifndef SENSOR_HISTORY_RAW_LEN
+#define SENSOR_HISTORY_RAW_LEN 64       // Số mẫu raw gần nhất
+#endif
+#ifndef SENSOR_HISTORY_SEC_LEN
+#define SENSOR_HISTORY_SEC_LEN 60       // Số bucket 1 giây (1 phút gần nhất)
+#endif
+#ifndef SENSOR_HISTORY_MIN_LEN
+#define SENSOR_HISTORY_MIN_LEN 30       // Số bucket 1 phút (30 phút gần nhất)
+#endif
+
+#define SENSOR_HISTORY_SEC_PERIOD_MS 1000
+#define SENSOR_HISTORY_MIN_PERIOD_MS 60000
+
+// Các tầng lấy mẫu thưa
+typedef enum {
+    SENSOR_HISTORY_TIER_SEC = 0,    // Bucket 1 giây
+    SENSOR_HISTORY_TIER_MIN,        // Bucket 1 phút
+    SENSOR_HISTORY_TIER_COUNT
+} sensor_history_tier_t;
+
+// Bucket thống kê min/max/mean
+typedef struct {
+    uint32_t start_ms;      // Thời điểm bắt đầu bucket
+    uint32_t sum;           // Tổng giá trị (mean = sum / count)
+    uint16_t min;
+    uint16_t max;
+    uint16_t count;         // Số mẫu trong bucket (0 = rỗng)
+} sensor_history_bucket_t;
+
+// Trạng thái một tầng: bucket đang tích lũy và vị trí trong vòng đệm
+typedef struct {
+    sensor_history_bucket_t current;
+    uint16_t head;          // Vị trí ghi bucket tiếp theo
+    uint16_t count;         // Số bucket đã đóng trong vòng đệm
+} sensor_history_tier_state_t;
+
+// Lịch sử mẫu của một cảm biến (cấp phát tĩnh, kích thước cố định)
+typedef struct {
+    uint16_t raw[SENSOR_HISTORY_RAW_LEN];
+    uint16_t raw_head;
+    uint16_t raw_count;
+    sensor_history_tier_state_t tier[SENSOR_HISTORY_TIER_COUNT];
+    sensor_history_bucket_t sec_buckets[SENSOR_HISTORY_SEC_LEN];
+    sensor_history_bucket_t min_buckets[SENSOR_HISTORY_MIN_LEN];
+} sensor_history_t;
+
+/**
+ * @brief Khởi tạo (xóa) lịch sử
+ * @param history Con trỏ đến cấu trúc lịch sử
+ */
+void sensor_history_init(sensor_history_t *history);
+
+/**
+ * @brief Thêm một mẫu, cập nhật vòng đệm raw và các tầng bucket (O(1))
+ * @param history Con trỏ đến cấu trúc lịch sử
+ * @param value Giá trị raw (0-4095)
+ * @param time_ms Thời điểm lấy mẫu (ms)
+ */
+void sensor_history_add(sensor_history_t *history, uint16_t value, uint32_t time_ms);
+
+/**
+ * @brief Lấy mẫu raw theo tuổi
+ * @param history Con trỏ đến cấu trúc lịch sử
+ * @param age 0 là mẫu mới nhất
+ * @param out_value Giá trị đầu ra
+ * @return 0 nếu thành công, -1 nếu không có mẫu
+ */
+int sensor_history_get_raw(const sensor_history_t *history, uint16_t age, uint16_t *out_value);
+
+/**
+ * @brief Lấy bucket đã đóng của một tầng theo tuổi
+ * @param history Con trỏ đến cấu trúc lịch sử
+ * @param tier Tầng bucket
+ * @param age 0 là bucket đã đóng gần nhất
+ * @param out_bucket Bucket đầu ra
+ * @return 0 nếu thành công, -1 nếu không có bucket
+ */
+int sensor_history_get_bucket(const sensor_history_t *history, sensor_history_tier_t tier,
+                              uint16_t age, sensor_history_bucket_t *out_bucket);
+
+/**
+ * @brief Lấy bucket đang tích lũy (chưa đóng) của một tầng
+ * @param history Con trỏ đến cấu trúc lịch sử
+ * @param tier Tầng bucket
+ * @param out_bucket Bucket đầu ra
+ * @return 0 nếu thành công, -1 nếu bucket rỗng
+ */
+int sensor_history_get_current(const sensor_history_t *history, sensor_history_tier_t tier,
+                               sensor_history_bucket_t *out_bucket);
+
+/**
+ * @brief Giá trị trung bình của bucket
+ * @param bucket Con trỏ đến bucket
+ * @return Giá trị trung bình, 0 nếu bucket rỗng
+ */
+uint16_t sensor_history_bucket_mean(const sensor_history_bucket_t *bucket);
+
+#endif // SENSOR_HISTORY_H
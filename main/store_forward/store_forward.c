@@ -0,0 +1,493 @@
+#include "store_forward.h"
+#include <string.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "SAF";
+
+#define SAF_SECTOR_MAGIC 0x31464153u       // "SAF1"
+#define SAF_SECTOR_HEADER_LEN 8
+#define SAF_RECORD_HEADER_LEN 8
+
+// Trạng thái bản ghi (chỉ xóa bit, không cần xóa sector)
+#define SAF_STATE_ERASED   0xFF
+#define SAF_STATE_VALID    0xFE
+#define SAF_STATE_CONSUMED 0xFC
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;               // Tăng dần mỗi lần mở sector mới
+} saf_sector_header_t;
+
+typedef struct {
+    uint16_t len;
+    uint16_t crc;               // CRC16-CCITT của payload
+    uint8_t kind;
+    uint8_t state;
+    uint8_t check;              // Kiểm tra header bị ghi dở
+    uint8_t reserved;
+} saf_record_header_t;
+
+_Static_assert(sizeof(saf_sector_header_t) == SAF_SECTOR_HEADER_LEN, "sector header size");
+_Static_assert(sizeof(saf_record_header_t) == SAF_RECORD_HEADER_LEN, "record header size");
+
+// Trạng thái một log (vị trí tính theo sector và offset trong sector)
+typedef struct {
+    const esp_partition_t *part;
+    uint16_t num_sectors;
+    uint16_t head_sector;       // Sector đang ghi
+    uint32_t head_offset;       // Offset ghi tiếp theo trong head_sector
+    uint32_t head_seq;
+    uint16_t tail_sector;       // Vị trí bản ghi cũ nhất chưa gửi
+    uint32_t tail_offset;
+    saf_stats_t stats;
+} saf_log_t;
+
+static const char *const saf_partition_label[SAF_LOG_COUNT] = {
+    [SAF_LOG_ALERT]     = "saf_alert",
+    [SAF_LOG_TELEMETRY] = "saf_data",
+};
+
+static saf_log_t s_logs[SAF_LOG_COUNT];
+static SemaphoreHandle_t s_lock = NULL;
+
+static uint16_t crc16(const uint8_t *data, uint16_t len)
+{
+    uint16_t crc = 0xFFFF;
+
+    for (uint16_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+static uint8_t header_check(const saf_record_header_t *h)
+{
+    return (uint8_t)~((h->len & 0xFF) ^ (h->len >> 8) ^ (h->crc & 0xFF) ^ (h->crc >> 8) ^ h->kind);
+}
+
+static uint32_t record_size(uint16_t len)
+{
+    return (SAF_RECORD_HEADER_LEN + len + 3u) & ~3u;
+}
+
+static size_t flash_addr(uint16_t sector, uint32_t offset)
+{
+    return (size_t)sector * SAF_SECTOR_SIZE + offset;
+}
+
+/**
+ * @brief Đọc header bản ghi
+ * @return 1 nếu hợp lệ, 0 nếu vùng chưa ghi, -1 nếu header hỏng/ghi dở
+ */
+static int read_record_header(const saf_log_t *log, uint16_t sector, uint32_t offset,
+                              saf_record_header_t *h)
+{
+    if (offset + SAF_RECORD_HEADER_LEN > SAF_SECTOR_SIZE) {
+        return 0;
+    }
+
+    if (esp_partition_read(log->part, flash_addr(sector, offset), h, sizeof(*h)) != ESP_OK) {
+        return -1;
+    }
+
+    static const uint8_t erased[SAF_RECORD_HEADER_LEN] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+    if (memcmp(h, erased, sizeof(erased)) == 0) {
+        return 0;
+    }
+
+    if (h->len == 0 || h->len > SAF_RECORD_MAX_LEN || h->check != header_check(h) ||
+        offset + record_size(h->len) > SAF_SECTOR_SIZE) {
+        return -1;
+    }
+
+    return 1;
+}
+
+static bool read_sector_header(const saf_log_t *log, uint16_t sector, uint32_t *out_seq)
+{
+    saf_sector_header_t hdr;
+
+    if (esp_partition_read(log->part, flash_addr(sector, 0), &hdr, sizeof(hdr)) != ESP_OK ||
+        hdr.magic != SAF_SECTOR_MAGIC) {
+        return false;
+    }
+
+    *out_seq = hdr.seq;
+    return true;
+}
+
+/**
+ * @brief Xóa sector và ghi header với seq mới, sector trở thành head
+ */
+static int open_sector(saf_log_t *log, uint16_t sector, uint32_t seq)
+{
+    uint32_t magic = SAF_SECTOR_MAGIC;
+
+    log->head_sector = sector;
+    log->head_seq = seq;
+    log->head_offset = SAF_SECTOR_SIZE;     // Không dùng được nếu ghi header lỗi
+
+    if (esp_partition_erase_range(log->part, flash_addr(sector, 0), SAF_SECTOR_SIZE) != ESP_OK) {
+        return -1;
+    }
+    log->stats.erases++;
+
+    // Ghi seq trước magic: magic hợp lệ đảm bảo seq đã được ghi xong
+    if (esp_partition_write(log->part, flash_addr(sector, offsetof(saf_sector_header_t, seq)),
+                            &seq, sizeof(seq)) != ESP_OK ||
+        esp_partition_write(log->part, flash_addr(sector, 0), &magic, sizeof(magic)) != ESP_OK) {
+        return -1;
+    }
+
+    log->head_offset = SAF_SECTOR_HEADER_LEN;
+    return 0;
+}
+
+/**
+ * @brief Tìm bản ghi VALID đầu tiên từ vị trí (sector, offset), dừng ở vị trí head
+ */
+static void find_valid(const saf_log_t *log, uint16_t *sector, uint32_t *offset)
+{
+    while (!(*sector == log->head_sector && *offset >= log->head_offset)) {
+        saf_record_header_t h;
+        if (read_record_header(log, *sector, *offset, &h) != 1) {
+            // Hết dữ liệu trong sector, sang sector kế tiếp trong chuỗi
+            if (*sector == log->head_sector) {
+                break;
+            }
+            *sector = (*sector + 1) % log->num_sectors;
+            *offset = SAF_SECTOR_HEADER_LEN;
+            continue;
+        }
+
+        if (h.state == SAF_STATE_VALID) {
+            return;
+        }
+        *offset += record_size(h.len);
+    }
+
+    *sector = log->head_sector;
+    *offset = log->head_offset;
+}
+
+/**
+ * @brief Chuyển tail qua bản ghi hiện tại tới bản ghi VALID kế tiếp
+ */
+static void advance_tail(saf_log_t *log, uint16_t len)
+{
+    if (log->stats.pending == 0) {
+        log->tail_sector = log->head_sector;
+        log->tail_offset = log->head_offset;
+        return;
+    }
+
+    log->tail_offset += record_size(len);
+    find_valid(log, &log->tail_sector, &log->tail_offset);
+}
+
+/**
+ * @brief Bỏ các bản ghi chưa gửi trong sector tail để ghi đè (log đầy)
+ */
+static void drop_tail_sector(saf_log_t *log)
+{
+    uint16_t sector = log->tail_sector;
+    uint32_t offset = log->tail_offset;
+    saf_record_header_t h;
+
+    while (read_record_header(log, sector, offset, &h) == 1) {
+        if (h.state == SAF_STATE_VALID && log->stats.pending > 0) {
+            log->stats.pending--;
+            log->stats.dropped++;
+        }
+        offset += record_size(h.len);
+    }
+
+    if (log->stats.pending == 0) {
+        log->tail_sector = log->head_sector;
+        log->tail_offset = log->head_offset;
+        return;
+    }
+
+    log->tail_sector = (sector + 1) % log->num_sectors;
+    log->tail_offset = SAF_SECTOR_HEADER_LEN;
+    find_valid(log, &log->tail_sector, &log->tail_offset);
+}
+
+/**
+ * @brief Khôi phục vị trí head/tail của một log từ flash
+ */
+static int log_recover(saf_log_t *log)
+{
+    uint32_t seq = 0;
+    bool found = false;
+
+    // Head là sector hợp lệ có seq lớn nhất
+    for (uint16_t s = 0; s < log->num_sectors; s++) {
+        uint32_t sector_seq;
+        if (read_sector_header(log, s, &sector_seq) && (!found || sector_seq > seq)) {
+            found = true;
+            seq = sector_seq;
+            log->head_sector = s;
+        }
+    }
+
+    if (!found) {
+        log->tail_sector = 0;
+        log->tail_offset = SAF_SECTOR_HEADER_LEN;
+        return open_sector(log, 0, 1);
+    }
+    log->head_seq = seq;
+
+    // Lùi từ head qua các sector có seq liên tiếp để tìm sector cũ nhất
+    uint16_t oldest = log->head_sector;
+    for (uint16_t i = 1; i < log->num_sectors; i++) {
+        uint16_t prev = (oldest + log->num_sectors - 1) % log->num_sectors;
+        uint32_t prev_seq;
+        if (!read_sector_header(log, prev, &prev_seq) || prev_seq != seq - 1) {
+            break;
+        }
+        oldest = prev;
+        seq = prev_seq;
+    }
+
+    // Quét chuỗi sector: đếm bản ghi chưa gửi, tìm tail và vị trí ghi tiếp theo
+    log->stats.pending = 0;
+    for (uint16_t s = oldest; ; s = (s + 1) % log->num_sectors) {
+        uint32_t offset = SAF_SECTOR_HEADER_LEN;
+        saf_record_header_t h;
+        int ret;
+
+        while ((ret = read_record_header(log, s, offset, &h)) == 1) {
+            if (h.state == SAF_STATE_VALID) {
+                if (log->stats.pending == 0) {
+                    log->tail_sector = s;
+                    log->tail_offset = offset;
+                }
+                log->stats.pending++;
+            }
+            offset += record_size(h.len);
+        }
+
+        if (s == log->head_sector) {
+            // Header ghi dở: không ghi tiếp vào sector này
+            log->head_offset = (ret == 0) ? offset : SAF_SECTOR_SIZE;
+            break;
+        }
+    }
+
+    if (log->stats.pending == 0) {
+        log->tail_sector = log->head_sector;
+        log->tail_offset = log->head_offset;
+    }
+
+    return 0;
+}
+
+int saf_init(void)
+{
+    int available = 0;
+
+    if (s_lock == NULL) {
+        s_lock = xSemaphoreCreateMutex();
+        if (s_lock == NULL) {
+            return -1;
+        }
+    }
+
+    for (int i = 0; i < SAF_LOG_COUNT; i++) {
+        saf_log_t *log = &s_logs[i];
+        memset(log, 0, sizeof(saf_log_t));
+
+        log->part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                             saf_partition_label[i]);
+        if (log->part == NULL || log->part->size / SAF_SECTOR_SIZE < 2) {
+            ESP_LOGW(TAG, "Partition %s not found, store-and-forward disabled for it",
+                     saf_partition_label[i]);
+            log->part = NULL;
+            continue;
+        }
+        log->num_sectors = log->part->size / SAF_SECTOR_SIZE;
+
+        if (log_recover(log) != 0) {
+            ESP_LOGE(TAG, "Failed to recover log %s", saf_partition_label[i]);
+            log->part = NULL;
+            continue;
+        }
+
+        ESP_LOGI(TAG, "Log %s: %d sectors, %" PRIu32 " pending records", saf_partition_label[i],
+                 log->num_sectors, log->stats.pending);
+        available++;
+    }
+
+    return (available > 0) ? 0 : -1;
+}
+
+int saf_append(saf_log_id_t id, uint8_t kind, const void *data, uint16_t len)
+{
+    if (id >= SAF_LOG_COUNT || data == NULL || len == 0 || len > SAF_RECORD_MAX_LEN ||
+        kind == 0xFF || s_lock == NULL) {
+        return -1;
+    }
+
+    saf_log_t *log = &s_logs[id];
+    if (log->part == NULL) {
+        return -1;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+
+    uint32_t need = record_size(len);
+    if (log->head_offset + need > SAF_SECTOR_SIZE) {
+        uint16_t next = (log->head_sector + 1) % log->num_sectors;
+
+        // Log đầy: sector kế tiếp vẫn còn bản ghi chưa gửi
+        if (log->stats.pending > 0 && log->tail_sector == next) {
+            drop_tail_sector(log);
+        }
+
+        if (open_sector(log, next, log->head_seq + 1) != 0) {
+            xSemaphoreGive(s_lock);
+            return -1;
+        }
+    }
+
+    saf_record_header_t h = {
+        .len = len,
+        .crc = crc16(data, len),
+        .kind = kind,
+        .state = SAF_STATE_ERASED,
+        .reserved = 0xFF,
+    };
+    h.check = header_check(&h);
+
+    size_t addr = flash_addr(log->head_sector, log->head_offset);
+    uint8_t state = SAF_STATE_VALID;
+    uint32_t offset = log->head_offset;
+    log->head_offset += need;
+
+    // Header, payload, rồi mới đánh dấu VALID: mất điện giữa chừng chỉ để lại bản ghi bị bỏ qua
+    if (esp_partition_write(log->part, addr, &h, sizeof(h)) != ESP_OK ||
+        esp_partition_write(log->part, addr + SAF_RECORD_HEADER_LEN, data, len) != ESP_OK ||
+        esp_partition_write(log->part, addr + offsetof(saf_record_header_t, state),
+                            &state, sizeof(state)) != ESP_OK) {
+        xSemaphoreGive(s_lock);
+        return -1;
+    }
+
+    if (log->stats.pending == 0) {
+        log->tail_sector = log->head_sector;
+        log->tail_offset = offset;
+    }
+    log->stats.pending++;
+    log->stats.appended++;
+
+    xSemaphoreGive(s_lock);
+    return 0;
+}
+
+int saf_peek(saf_log_id_t *out_log, uint8_t *out_kind, void *buf, uint16_t size, uint16_t *out_len)
+{
+    if (out_log == NULL || out_kind == NULL || buf == NULL || out_len == NULL || s_lock == NULL) {
+        return -1;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+
+    for (int i = 0; i < SAF_LOG_COUNT; i++) {
+        saf_log_t *log = &s_logs[i];
+
+        while (log->part != NULL && log->stats.pending > 0) {
+            saf_record_header_t h;
+            if (read_record_header(log, log->tail_sector, log->tail_offset, &h) != 1) {
+                // Không đọc được vị trí tail: khôi phục lại từ flash, bỏ qua log nếu vẫn lỗi
+                if (log_recover(log) != 0 ||
+                    (log->stats.pending > 0 &&
+                     read_record_header(log, log->tail_sector, log->tail_offset, &h) != 1)) {
+                    break;
+                }
+                continue;
+            }
+
+            size_t addr = flash_addr(log->tail_sector, log->tail_offset) + SAF_RECORD_HEADER_LEN;
+            if (h.len <= size &&
+                esp_partition_read(log->part, addr, buf, h.len) == ESP_OK &&
+                crc16(buf, h.len) == h.crc) {
+                *out_log = (saf_log_id_t)i;
+                *out_kind = h.kind;
+                *out_len = h.len;
+                xSemaphoreGive(s_lock);
+                return 0;
+            }
+
+            // Bản ghi hỏng: đánh dấu đã xử lý để không chặn hàng đợi
+            uint8_t state = SAF_STATE_CONSUMED;
+            esp_partition_write(log->part, addr - SAF_RECORD_HEADER_LEN + offsetof(saf_record_header_t, state),
+                                &state, sizeof(state));
+            log->stats.pending--;
+            log->stats.corrupt++;
+            advance_tail(log, h.len);
+        }
+    }
+
+    xSemaphoreGive(s_lock);
+    return -1;
+}
+
+int saf_pop(saf_log_id_t id)
+{
+    if (id >= SAF_LOG_COUNT || s_lock == NULL) {
+        return -1;
+    }
+
+    saf_log_t *log = &s_logs[id];
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+
+    saf_record_header_t h;
+    if (log->part == NULL || log->stats.pending == 0 ||
+        read_record_header(log, log->tail_sector, log->tail_offset, &h) != 1) {
+        xSemaphoreGive(s_lock);
+        return -1;
+    }
+
+    uint8_t state = SAF_STATE_CONSUMED;
+    size_t addr = flash_addr(log->tail_sector, log->tail_offset) + offsetof(saf_record_header_t, state);
+    if (esp_partition_write(log->part, addr, &state, sizeof(state)) != ESP_OK) {
+        xSemaphoreGive(s_lock);
+        return -1;
+    }
+
+    log->stats.pending--;
+    log->stats.drained++;
+    advance_tail(log, h.len);
+
+    xSemaphoreGive(s_lock);
+    return 0;
+}
+
+uint32_t saf_pending(saf_log_id_t id)
+{
+    if (id >= SAF_LOG_COUNT) {
+        return 0;
+    }
+
+    return s_logs[id].stats.pending;
+}
+
+void saf_get_stats(saf_log_id_t id, saf_stats_t *stats)
+{
+    if (id >= SAF_LOG_COUNT || stats == NULL) {
+        return;
+    }
+
+    memcpy(stats, &s_logs[id].stats, sizeof(saf_stats_t));
+}
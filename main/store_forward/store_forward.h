@@ -0,0 +1,93 @@
+#ifndef STORE_FORWARD_H
+#define STORE_FORWARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Hàng đợi store-and-forward lưu trên flash cho dữ liệu chưa gửi được khi
+ * MQTT mất kết nối. Mỗi log là một partition dữ liệu riêng (xem partitions.csv),
+ * ghi vòng tròn theo sector 4 KB nên các sector được xóa lần lượt, đều nhau.
+ *
+ * Mỗi sector bắt đầu bằng header {magic, seq}; seq tăng dần nên sau khi mất
+ * điện có thể tìm lại sector đầu ghi (seq lớn nhất) và chuỗi sector liên tiếp.
+ * Mỗi bản ghi có header {len, crc, kind, state, check}; state chỉ chuyển bit
+ * 1 -> 0 (ERASED -> VALID -> CONSUMED) nên không cần xóa để đánh dấu. Bản ghi
+ * được đánh dấu CONSUMED sau khi gửi thành công: mất điện giữa lúc gửi và lúc
+ * đánh dấu dẫn tới gửi lại (at-least-once), không bao giờ mất bản ghi.
+ *
+ * RAM sử dụng cố định (vài con trỏ vị trí mỗi log), không phụ thuộc số bản ghi.
+ */
+
+#define SAF_SECTOR_SIZE 4096
+#define SAF_RECORD_MAX_LEN 2560             // Độ dài payload tối đa một bản ghi (bytes), đủ cho batch JSON
+
+// Các log, log có chỉ số nhỏ hơn được xả trước
+typedef enum {
+    SAF_LOG_ALERT = 0,          // Cảnh báo cháy (partition "saf_alert")
+    SAF_LOG_TELEMETRY,          // Dữ liệu cảm biến (partition "saf_data")
+    SAF_LOG_COUNT
+} saf_log_id_t;
+
+// Thống kê một log
+typedef struct {
+    uint32_t pending;           // Số bản ghi chưa gửi
+    uint32_t appended;          // Số bản ghi đã ghi
+    uint32_t drained;           // Số bản ghi đã gửi và đánh dấu
+    uint32_t dropped;           // Số bản ghi cũ bị ghi đè khi log đầy
+    uint32_t corrupt;           // Số bản ghi hỏng (CRC sai) bị bỏ qua
+    uint32_t erases;            // Số lần xóa sector
+} saf_stats_t;
+
+/**
+ * @brief Khởi tạo các log và khôi phục vị trí đọc/ghi từ flash
+ * @return 0 nếu thành công, -1 nếu không có partition nào
+ */
+int saf_init(void);
+
+/**
+ * @brief Ghi một bản ghi vào cuối log
+ *
+ * Nếu log đầy, sector cũ nhất bị xóa và các bản ghi chưa gửi trong đó bị bỏ.
+ *
+ * @param log Log cần ghi
+ * @param kind Loại bản ghi do người gọi định nghĩa (khác 0xFF)
+ * @param data Dữ liệu
+ * @param len Độ dài (1 - SAF_RECORD_MAX_LEN bytes)
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int saf_append(saf_log_id_t log, uint8_t kind, const void *data, uint16_t len);
+
+/**
+ * @brief Đọc bản ghi cũ nhất chưa gửi, ưu tiên log cảnh báo
+ * @param out_log Log chứa bản ghi
+ * @param out_kind Loại bản ghi
+ * @param buf Buffer nhận dữ liệu (nên có SAF_RECORD_MAX_LEN bytes)
+ * @param size Kích thước buffer
+ * @param out_len Độ dài dữ liệu
+ * @return 0 nếu có bản ghi, -1 nếu các log rỗng hoặc lỗi
+ */
+int saf_peek(saf_log_id_t *out_log, uint8_t *out_kind, void *buf, uint16_t size, uint16_t *out_len);
+
+/**
+ * @brief Đánh dấu bản ghi cũ nhất của log đã gửi xong
+ * @param log Log chứa bản ghi (giá trị trả về từ saf_peek)
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int saf_pop(saf_log_id_t log);
+
+/**
+ * @brief Số bản ghi chưa gửi trong một log
+ * @param log Log cần kiểm tra
+ * @return Số bản ghi
+ */
+uint32_t saf_pending(saf_log_id_t log);
+
+/**
+ * @brief Lấy thống kê của một log
+ * @param log Log cần lấy thống kê
+ * @param stats Con trỏ đến cấu trúc thống kê
+ */
+void saf_get_stats(saf_log_id_t log, saf_stats_t *stats);
+
+#endif // STORE_FORWARD_H
@@ -0,0 +1,119 @@
+#include "task_diag.h"
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Trạng thái do uxTaskGetSystemState() ghi, giữ tĩnh để không tốn stack người gọi
+static TaskStatus_t s_status[TASK_DIAG_MAX_TASKS];
+
+// Bộ đếm thời gian chạy ở lần lấy mẫu trước, theo xTaskNumber
+static UBaseType_t s_prev_number[TASK_DIAG_MAX_TASKS];
+static uint32_t s_prev_counter[TASK_DIAG_MAX_TASKS];
+static uint8_t s_prev_count = 0;
+static uint32_t s_prev_total = 0;
+
+/**
+ * @brief Bộ đếm của task ở lần lấy mẫu trước, 0 nếu task mới được tạo
+ */
+static uint32_t prev_counter(UBaseType_t number)
+{
+    for (uint8_t i = 0; i < s_prev_count; i++) {
+        if (s_prev_number[i] == number) {
+            return s_prev_counter[i];
+        }
+    }
+    return 0;
+}
+
+int task_diag_sample(task_diag_snapshot_t *snapshot)
+{
+    if (snapshot == NULL) {
+        return -1;
+    }
+
+    memset(snapshot, 0, sizeof(task_diag_snapshot_t));
+    snapshot->heap_free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    snapshot->heap_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    snapshot->heap_largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    uint32_t total = 0;
+    UBaseType_t count = uxTaskGetSystemState(s_status, TASK_DIAG_MAX_TASKS, &total);
+
+    snapshot->total_tasks = (uint8_t)uxTaskGetNumberOfTasks();
+    snapshot->num_tasks = (uint8_t)count;
+    if (count == 0) {
+        // Nhiều task hơn TASK_DIAG_MAX_TASKS: FreeRTOS không ghi gì
+        return 0;
+    }
+
+    // Bộ đếm dùng esp_timer (us) và tràn sau ~71 phút, hiệu số không dấu vẫn đúng
+    uint32_t elapsed = total - s_prev_total;
+    snapshot->interval_ms = elapsed / 1000;
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    snapshot->has_runtime = (elapsed > 0);
+#endif
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t *st = &s_status[i];
+        task_diag_task_t *task = &snapshot->tasks[i];
+
+        strncpy(task->name, st->pcTaskName, sizeof(task->name) - 1);
+        task->stack_free_min = st->usStackHighWaterMark;
+        task->priority = (uint8_t)st->uxCurrentPriority;
+        task->core = (st->xCoreID == tskNO_AFFINITY) ? -1 : (int8_t)st->xCoreID;
+
+        if (snapshot->has_runtime) {
+            uint32_t ran = st->ulRunTimeCounter - prev_counter(st->xTaskNumber);
+            uint64_t permille = (uint64_t)ran * 1000 / elapsed;
+            task->cpu_permille = (uint16_t)(permille > 1000 ? 1000 : permille);
+        }
+    }
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        s_prev_number[i] = s_status[i].xTaskNumber;
+        s_prev_counter[i] = s_status[i].ulRunTimeCounter;
+    }
+    s_prev_count = (uint8_t)count;
+    s_prev_total = total;
+#endif
+
+    return 0;
+}
+
+const task_diag_task_t *task_diag_min_stack(const task_diag_snapshot_t *snapshot)
+{
+    const task_diag_task_t *min = NULL;
+
+    if (snapshot == NULL) {
+        return NULL;
+    }
+
+    for (uint8_t i = 0; i < snapshot->num_tasks; i++) {
+        if (min == NULL || snapshot->tasks[i].stack_free_min < min->stack_free_min) {
+            min = &snapshot->tasks[i];
+        }
+    }
+    return min;
+}
+
+const task_diag_task_t *task_diag_max_cpu(const task_diag_snapshot_t *snapshot)
+{
+    const task_diag_task_t *max = NULL;
+
+    if (snapshot == NULL) {
+        return NULL;
+    }
+
+    for (uint8_t i = 0; i < snapshot->num_tasks; i++) {
+        const task_diag_task_t *task = &snapshot->tasks[i];
+        if (strncmp(task->name, "IDLE", 4) == 0) {
+            continue;
+        }
+        if (max == NULL || task->cpu_permille > max->cpu_permille) {
+            max = task;
+        }
+    }
+    return max;
+}
@@ -0,0 +1,65 @@
+#ifndef TASK_DIAG_H
+#define TASK_DIAG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Chẩn đoán runtime: tỉ lệ CPU, stack còn trống nhỏ nhất (high-water mark)
+ * của từng task và tình trạng heap.
+ *
+ * Cần CONFIG_FREERTOS_USE_TRACE_FACILITY (danh sách task) và
+ * CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS (bộ đếm thời gian chạy, nguồn
+ * esp_timer). Thiếu cấu hình nào thì phần tương ứng để trống / bằng 0.
+ */
+
+#define TASK_DIAG_MAX_TASKS 24          // Số task tối đa trong một lần lấy mẫu
+#define TASK_DIAG_NAME_LEN 16           // = CONFIG_FREERTOS_MAX_TASK_NAME_LEN
+
+// Một task trong lần lấy mẫu
+typedef struct {
+    char name[TASK_DIAG_NAME_LEN];
+    uint16_t cpu_permille;              // Thời gian chạy / thời gian lấy mẫu, phần nghìn của một core
+    uint32_t stack_free_min;            // Stack còn trống nhỏ nhất từ khi tạo task (bytes)
+    uint8_t priority;
+    int8_t core;                        // Core được ghim, -1 nếu không ghim
+} task_diag_task_t;
+
+// Kết quả một lần lấy mẫu
+typedef struct {
+    uint32_t interval_ms;               // Khoảng thời gian tính CPU (từ lần lấy mẫu trước)
+    uint32_t heap_free;                 // Heap trống hiện tại (bytes)
+    uint32_t heap_min_free;             // Heap trống thấp nhất từ khi khởi động
+    uint32_t heap_largest_block;        // Block liên tục lớn nhất có thể cấp phát
+    uint8_t num_tasks;
+    uint8_t total_tasks;                // Số task thực tế (có thể > num_tasks)
+    bool has_runtime;                   // cpu_permille hợp lệ
+    task_diag_task_t tasks[TASK_DIAG_MAX_TASKS];
+} task_diag_snapshot_t;
+
+/**
+ * @brief Lấy mẫu thống kê task và heap
+ *
+ * Tỉ lệ CPU tính trên khoảng từ lần gọi trước (lần đầu: từ khi khởi động).
+ * Chỉ gọi từ một task.
+ *
+ * @param snapshot Kết quả
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int task_diag_sample(task_diag_snapshot_t *snapshot);
+
+/**
+ * @brief Tìm task có stack còn trống ít nhất
+ * @param snapshot Kết quả lấy mẫu
+ * @return Con trỏ tới task, NULL nếu không có task
+ */
+const task_diag_task_t *task_diag_min_stack(const task_diag_snapshot_t *snapshot);
+
+/**
+ * @brief Tìm task dùng CPU nhiều nhất (bỏ qua task IDLE)
+ * @param snapshot Kết quả lấy mẫu
+ * @return Con trỏ tới task, NULL nếu không có task
+ */
+const task_diag_task_t *task_diag_max_cpu(const task_diag_snapshot_t *snapshot);
+
+#endif // TASK_DIAG_H
@@ -0,0 +1,298 @@
+#include "telemetry.h"
+#include "json_writer/json_writer.h"
+
+// 10^TELEMETRY_VALUE_DECIMALS
+#define TELEMETRY_VALUE_SCALE 10000
+#define TELEMETRY_Q15_MAX 32767
+
+_Static_assert(SENSOR_MAX_COUNT <= TELEMETRY_FRAME_MAX_SENSORS, "binary frame cannot hold SENSOR_MAX_COUNT sensors");
+
+/**
+ * @brief Ghi giá trị của tất cả cảm biến trong registry
+ *
+ * Cảm biến analog ghi giá trị chuẩn hóa (từ Q15, không dùng float), cảm biến
+ * digital ghi trạng thái kích hoạt; key là tên cảm biến trong registry.
+ */
+static void write_sensor_fields(json_writer_t *w, const sensor_status_t *status)
+{
+    for (uint8_t i = 0; i < status->count; i++) {
+        const sensor_desc_t *desc = sensor_get_desc(i);
+        if (desc == NULL) {
+            continue;
+        }
+
+        if (desc->is_analog) {
+            int32_t value = ((int32_t)status->normalized_q15[i] * TELEMETRY_VALUE_SCALE
+                             + TELEMETRY_Q15_MAX / 2) / TELEMETRY_Q15_MAX;
+            json_writer_add_fixed(w, desc->name, value, TELEMETRY_VALUE_DECIMALS);
+        } else {
+            json_writer_add_bool(w, desc->name, sensor_is_triggered(status, i));
+        }
+    }
+}
+
+/**
+ * @brief Ghi một mẫu dữ liệu cảm biến dạng object
+ */
+static void write_sample(json_writer_t *w, const sensor_status_t *status, uint32_t timestamp_ms)
+{
+    json_writer_object_begin(w, NULL);
+    json_writer_add_int(w, "timestamp", timestamp_ms);
+    write_sensor_fields(w, status);
+    json_writer_add_bool(w, "fire_detected", status->fire_detected);
+    json_writer_object_end(w);
+}
+
+int telemetry_build_batch_json(char *buf, size_t size, const sensor_status_t *samples, uint8_t count)
+{
+    if (buf == NULL || samples == NULL) {
+        return -1;
+    }
+
+    json_writer_t w;
+    json_writer_init(&w, buf, size);
+    json_writer_object_begin(&w, NULL);
+    json_writer_array_begin(&w, "samples");
+    for (uint8_t i = 0; i < count; i++) {
+        write_sample(&w, &samples[i], samples[i].last_read_time);
+    }
+    json_writer_array_end(&w);
+    json_writer_object_end(&w);
+
+    return json_writer_finish(&w);
+}
+
+int telemetry_build_alert_json(char *buf, size_t size, const sensor_status_t *status)
+{
+    if (buf == NULL || status == NULL) {
+        return -1;
+    }
+
+    json_writer_t w;
+    json_writer_init(&w, buf, size);
+    json_writer_object_begin(&w, NULL);
+    json_writer_add_string(&w, "type", "fire_alert");
+    json_writer_add_bool(&w, "detected", true);
+    json_writer_add_int(&w, "timestamp", status->detection_timestamp);
+    write_sensor_fields(&w, status);
+    json_writer_object_end(&w);
+
+    return json_writer_finish(&w);
+}
+
+/**
+ * @brief Ghi thống kê gửi cảnh báo và histogram độ trễ
+ */
+static void write_alert_stats(json_writer_t *w, const telemetry_alert_stats_t *alert)
+{
+    const latency_hist_t *hist = &alert->latency;
+
+    json_writer_object_begin(w, "alert");
+    json_writer_add_int(w, "confirmed", alert->confirmed);
+    json_writer_add_int(w, "pending", alert->tracked);
+    json_writer_add_int(w, "retransmits", alert->retransmits);
+    json_writer_add_int(w, "expired", alert->expired);
+
+    json_writer_object_begin(w, "latency_us");
+    json_writer_add_int(w, "count", hist->count);
+    json_writer_add_int(w, "avg", hist->count > 0 ? hist->total_us / hist->count : 0);
+    json_writer_add_int(w, "p95", latency_hist_percentile(hist, 95));
+    json_writer_add_int(w, "max", hist->max_us);
+    json_writer_add_int(w, "enqueue_max", alert->enqueue_max_us);
+    json_writer_add_int(w, "publish_max", alert->publish_max_us);
+    json_writer_add_int(w, "ack_max", alert->ack_max_us);
+    json_writer_add_int(w, "bucket_base", hist->base_us);
+
+    // Bucket i chứa mẫu < bucket_base * 2^i, bucket cuối không giới hạn
+    json_writer_array_begin(w, "buckets");
+    for (uint8_t i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        json_writer_add_int(w, NULL, hist->bucket[i]);
+    }
+    json_writer_array_end(w);
+    json_writer_object_end(w);
+
+    json_writer_object_end(w);
+}
+
+/**
+ * @brief Ghi thống kê kết nối lại của từng link
+ */
+static void write_link_stats(json_writer_t *w, const conn_link_stats_t *links)
+{
+    json_writer_object_begin(w, "links");
+    for (int i = 0; i < CONN_LINK_COUNT; i++) {
+        const conn_link_stats_t *link = &links[i];
+
+        json_writer_object_begin(w, conn_supervisor_link_name((conn_link_t)i));
+        json_writer_add_string(w, "state", conn_supervisor_state_name(link->state));
+        json_writer_add_int(w, "attempts", link->attempts);
+        json_writer_add_int(w, "failures", link->failures);
+        json_writer_add_int(w, "drops", link->drops);
+        json_writer_add_int(w, "stalls", link->stalls);
+        json_writer_add_int(w, "reconnects", link->reconnects);
+        json_writer_add_int(w, "down_ms", link->down_total_ms);
+        json_writer_add_int(w, "reconnect_last_ms", link->reconnect_last_ms);
+        json_writer_add_int(w, "reconnect_max_ms", link->reconnect_max_ms);
+        json_writer_object_end(w);
+    }
+    json_writer_object_end(w);
+}
+
+int telemetry_build_status_json(char *buf, size_t size, uint32_t uptime_ms,
+                                const telemetry_alert_stats_t *alert,
+                                const conn_link_stats_t *links)
+{
+    if (buf == NULL) {
+        return -1;
+    }
+
+    json_writer_t w;
+    json_writer_init(&w, buf, size);
+    json_writer_object_begin(&w, NULL);
+    json_writer_add_string(&w, "status", "online");
+    json_writer_add_int(&w, "uptime", uptime_ms);
+    if (alert != NULL) {
+        write_alert_stats(&w, alert);
+    }
+    if (links != NULL) {
+        write_link_stats(&w, links);
+    }
+    json_writer_object_end(&w);
+
+    return json_writer_finish(&w);
+}
+
+int telemetry_build_diag_json(char *buf, size_t size, uint32_t uptime_ms,
+                              const task_diag_snapshot_t *diag)
+{
+    if (buf == NULL || diag == NULL) {
+        return -1;
+    }
+
+    json_writer_t w;
+    json_writer_init(&w, buf, size);
+    json_writer_object_begin(&w, NULL);
+    json_writer_add_int(&w, "uptime", uptime_ms);
+    json_writer_add_int(&w, "interval_ms", diag->interval_ms);
+
+    json_writer_array_begin(&w, "heap");
+    json_writer_add_int(&w, NULL, diag->heap_free);
+    json_writer_add_int(&w, NULL, diag->heap_min_free);
+    json_writer_add_int(&w, NULL, diag->heap_largest_block);
+    json_writer_array_end(&w);
+
+    json_writer_add_int(&w, "task_count", diag->total_tasks);
+    json_writer_array_begin(&w, "tasks");
+    for (uint8_t i = 0; i < diag->num_tasks; i++) {
+        const task_diag_task_t *task = &diag->tasks[i];
+
+        json_writer_array_begin(&w, NULL);
+        json_writer_add_string(&w, NULL, task->name);
+        json_writer_add_int(&w, NULL, diag->has_runtime ? task->cpu_permille : -1);
+        json_writer_add_int(&w, NULL, task->stack_free_min);
+        json_writer_add_int(&w, NULL, task->priority);
+        json_writer_add_int(&w, NULL, task->core);
+        json_writer_array_end(&w);
+    }
+    json_writer_array_end(&w);
+    json_writer_object_end(&w);
+
+    return json_writer_finish(&w);
+}
+
+int telemetry_build_trace_json(char *buf, size_t size, uint32_t uptime_ms)
+{
+    if (buf == NULL) {
+        return -1;
+    }
+
+    json_writer_t w;
+    json_writer_init(&w, buf, size);
+    json_writer_object_begin(&w, NULL);
+    json_writer_add_int(&w, "uptime", uptime_ms);
+    json_writer_add_int(&w, "dropped", trace_get_dropped());
+
+    json_writer_array_begin(&w, "points");
+    for (int i = TRACE_SENSOR_EVALUATED; i < TRACE_POINT_COUNT; i++) {
+        trace_stats_t trace;
+        if (trace_get_stats((trace_point_t)i, &trace) != 0) {
+            continue;
+        }
+
+        json_writer_array_begin(&w, NULL);
+        json_writer_add_string(&w, NULL, trace_point_name((trace_point_t)i));
+        json_writer_add_int(&w, NULL, trace.stage.count);
+        json_writer_add_int(&w, NULL, trace.unmatched);
+        json_writer_add_int(&w, NULL, latency_hist_percentile(&trace.stage, 50));
+        json_writer_add_int(&w, NULL, latency_hist_percentile(&trace.stage, 95));
+        json_writer_add_int(&w, NULL, latency_hist_percentile(&trace.stage, 99));
+        json_writer_add_int(&w, NULL, trace.stage.max_us);
+        json_writer_add_int(&w, NULL, latency_hist_percentile(&trace.total, 50));
+        json_writer_add_int(&w, NULL, latency_hist_percentile(&trace.total, 99));
+        json_writer_add_int(&w, NULL, trace.total.max_us);
+        json_writer_array_end(&w);
+    }
+    json_writer_array_end(&w);
+    json_writer_object_end(&w);
+
+    return json_writer_finish(&w);
+}
+
+/**
+ * @brief Mã hóa bản chụp trạng thái thành frame nhị phân
+ */
+static int build_frame(uint8_t *buf, size_t size, const sensor_status_t *status,
+                       telemetry_frame_kind_t kind, uint32_t timestamp_ms)
+{
+    if (buf == NULL || status == NULL) {
+        return -1;
+    }
+
+    telemetry_frame_t frame = {0};
+    frame.kind = kind;
+    frame.flags = (status->fire_detected ? TELEMETRY_FRAME_FLAG_FIRE : 0) |
+                  (status->ror_triggered ? TELEMETRY_FRAME_FLAG_ROR : 0);
+    frame.count = status->count;
+    frame.timestamp_ms = timestamp_ms;
+    frame.triggered_mask = (uint8_t)status->triggered_mask;
+
+    // Bão hòa tốc độ tăng nhiệt độ về int16
+    int32_t rate = status->temperature_rate;
+    frame.temperature_rate = (int16_t)(rate > INT16_MAX ? INT16_MAX : (rate < INT16_MIN ? INT16_MIN : rate));
+
+    for (uint8_t i = 0; i < status->count; i++) {
+        const sensor_desc_t *desc = sensor_get_desc(i);
+        frame.sensor_type[i] = (desc != NULL) ? (uint8_t)desc->type : 0xFF;
+        frame.value[i] = status->filtered_value[i];
+    }
+
+    return telemetry_frame_encode(&frame, buf, size);
+}
+
+int telemetry_build_batch_frame(uint8_t *buf, size_t size, const sensor_status_t *samples, uint8_t count)
+{
+    if (buf == NULL || samples == NULL) {
+        return -1;
+    }
+
+    size_t len = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        int n = build_frame(buf + len, size - len, &samples[i], TELEMETRY_FRAME_SENSOR_DATA,
+                            samples[i].last_read_time);
+        if (n < 0) {
+            return -1;
+        }
+        len += (size_t)n;
+    }
+
+    return (int)len;
+}
+
+int telemetry_build_alert_frame(uint8_t *buf, size_t size, const sensor_status_t *status)
+{
+    if (status == NULL) {
+        return -1;
+    }
+
+    return build_frame(buf, size, status, TELEMETRY_FRAME_ALERT, status->detection_timestamp);
+}
@@ -0,0 +1,147 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sensor/sensor.h"
+#include "telemetry_frame/telemetry_frame.h"
+#include "latency_hist/latency_hist.h"
+#include "conn_supervisor/conn_supervisor.h"
+#include "task_diag/task_diag.h"
+#include "trace/trace.h"
+
+// Kích thước buffer payload JSON khuyến nghị (bytes, gồm cả '\0')
+#define TELEMETRY_JSON_MAX_LEN 384
+
+// Kích thước buffer payload trạng thái (gồm histogram độ trễ cảnh báo và thống kê kết nối)
+#define TELEMETRY_STATUS_JSON_MAX_LEN 1152
+
+// Kích thước buffer payload chẩn đoán (đủ cho TASK_DIAG_MAX_TASKS task)
+#define TELEMETRY_DIAG_JSON_MAX_LEN 1152
+
+// Kích thước buffer payload báo cáo trace (đủ cho TRACE_POINT_COUNT điểm đo)
+#define TELEMETRY_TRACE_JSON_MAX_LEN 640
+
+// Độ dài tối đa một mẫu trong payload JSON dạng batch (bytes): phần cố định
+// {"timestamp":<10 chữ số>,"fire_detected":false}, và dấu phẩy, cộng mỗi cảm biến ,"<tên>":1.0000
+#define TELEMETRY_SAMPLE_JSON_FIXED_LEN 47
+#define TELEMETRY_SENSOR_JSON_MAX_LEN (SENSOR_NAME_MAX_LEN + 10)
+#define TELEMETRY_SAMPLE_JSON_MAX_LEN (TELEMETRY_SAMPLE_JSON_FIXED_LEN + SENSOR_MAX_COUNT * TELEMETRY_SENSOR_JSON_MAX_LEN)
+
+// Kích thước buffer payload batch JSON với n mẫu ({"samples":[...]} và '\0')
+#define TELEMETRY_BATCH_JSON_MAX_LEN(n) (15 + (n) * TELEMETRY_SAMPLE_JSON_MAX_LEN)
+
+// Định dạng payload được gửi (có thể kết hợp): JSON và/hoặc frame nhị phân trên topic .../bin
+#define TELEMETRY_FORMAT_JSON   (1U << 0)
+#define TELEMETRY_FORMAT_BINARY (1U << 1)
+
+#ifndef TELEMETRY_FORMATS
+#define TELEMETRY_FORMATS (TELEMETRY_FORMAT_JSON | TELEMETRY_FORMAT_BINARY)
+#endif
+
+// Số chữ số thập phân của giá trị cảm biến chuẩn hóa trong JSON (giá trị sau lọc / 4095,
+// cùng giá trị với trường value của frame nhị phân)
+#define TELEMETRY_VALUE_DECIMALS 4
+
+// Thống kê gửi cảnh báo cháy tới broker
+typedef struct {
+    uint32_t tracked;           // Số message cảnh báo đang chờ xác nhận
+    uint32_t confirmed;         // Số message được broker xác nhận (PUBCOMP)
+    uint32_t retransmits;       // Số lần gửi lại do quá hạn xác nhận
+    uint32_t expired;           // Không được xác nhận sau mọi lần gửi lại, chuyển sang flash
+    uint32_t untracked;         // Gửi đi nhưng không theo dõi được (hết slot)
+    uint32_t enqueue_max_us;    // Phát hiện -> vào hàng đợi, lớn nhất
+    uint32_t publish_max_us;    // Vào hàng đợi -> publish, lớn nhất
+    uint32_t ack_max_us;        // Publish -> xác nhận, lớn nhất
+    latency_hist_t latency;     // Phát hiện -> xác nhận
+} telemetry_alert_stats_t;
+
+/**
+ * @brief Tạo payload JSON cho một batch nhiều chu kỳ đọc (topic sensor/data)
+ *
+ * Dạng {"samples":[{...},...]}, mỗi phần tử có cùng các trường như payload
+ * một mẫu, timestamp là thời điểm đọc của chu kỳ đó.
+ *
+ * @param buf Buffer đầu ra
+ * @param size Kích thước buffer (bytes)
+ * @param samples Mảng trạng thái các chu kỳ đọc
+ * @param count Số mẫu
+ * @return Độ dài payload, -1 nếu lỗi hoặc buffer không đủ
+ */
+int telemetry_build_batch_json(char *buf, size_t size, const sensor_status_t *samples, uint8_t count);
+
+/**
+ * @brief Tạo payload JSON cảnh báo cháy (topic alert)
+ * @param buf Buffer đầu ra
+ * @param size Kích thước buffer (bytes)
+ * @param status Bản chụp trạng thái cảm biến tại thời điểm phát hiện
+ * @return Độ dài payload, -1 nếu lỗi hoặc buffer không đủ
+ */
+int telemetry_build_alert_json(char *buf, size_t size, const sensor_status_t *status);
+
+/**
+ * @brief Tạo payload JSON trạng thái thiết bị (topic status)
+ * @param buf Buffer đầu ra (nên có TELEMETRY_STATUS_JSON_MAX_LEN bytes)
+ * @param size Kích thước buffer (bytes)
+ * @param uptime_ms Thời gian hoạt động (ms)
+ * @param alert Thống kê gửi cảnh báo (NULL để bỏ qua)
+ * @param links Thống kê kết nối, CONN_LINK_COUNT phần tử (NULL để bỏ qua)
+ * @return Độ dài payload, -1 nếu lỗi hoặc buffer không đủ
+ */
+int telemetry_build_status_json(char *buf, size_t size, uint32_t uptime_ms,
+                                const telemetry_alert_stats_t *alert,
+                                const conn_link_stats_t *links);
+
+/**
+ * @brief Tạo payload JSON chẩn đoán task/heap (topic diag)
+ *
+ * Dạng gọn: "heap" là [trống, trống thấp nhất, block lớn nhất] (bytes), mỗi
+ * phần tử của "tasks" là [tên, CPU phần nghìn của một core (-1 nếu không có),
+ * stack trống nhỏ nhất (bytes), ưu tiên, core (-1 nếu không ghim)].
+ *
+ * @param buf Buffer đầu ra (nên có TELEMETRY_DIAG_JSON_MAX_LEN bytes)
+ * @param size Kích thước buffer (bytes)
+ * @param uptime_ms Thời gian hoạt động (ms)
+ * @param diag Kết quả lấy mẫu
+ * @return Độ dài payload, -1 nếu lỗi hoặc buffer không đủ
+ */
+int telemetry_build_diag_json(char *buf, size_t size, uint32_t uptime_ms,
+                              const task_diag_snapshot_t *diag);
+
+/**
+ * @brief Tạo payload JSON báo cáo độ trễ theo điểm đo (topic diag)
+ *
+ * Đọc thống kê hiện tại của trace (gọi trace_fold() trước). Mỗi phần tử của
+ * "points" là [tên, số mẫu, không ghép được, stage p50, p95, p99, max,
+ * total p50, p99, max] (us), không gồm điểm gốc adc_frame.
+ *
+ * @param buf Buffer đầu ra (nên có TELEMETRY_TRACE_JSON_MAX_LEN bytes)
+ * @param size Kích thước buffer (bytes)
+ * @param uptime_ms Thời gian hoạt động (ms)
+ * @return Độ dài payload, -1 nếu lỗi hoặc buffer không đủ
+ */
+int telemetry_build_trace_json(char *buf, size_t size, uint32_t uptime_ms);
+
+/**
+ * @brief Tạo payload nhị phân cho một batch (topic sensor/data/bin)
+ *
+ * Các frame dữ liệu cảm biến nối tiếp nhau, giải mã bằng telemetry_frame_decode_next().
+ *
+ * @param buf Buffer đầu ra (nên có count * TELEMETRY_FRAME_MAX_LEN bytes)
+ * @param size Kích thước buffer (bytes)
+ * @param samples Mảng trạng thái các chu kỳ đọc
+ * @param count Số mẫu
+ * @return Độ dài payload, -1 nếu lỗi hoặc buffer không đủ
+ */
+int telemetry_build_batch_frame(uint8_t *buf, size_t size, const sensor_status_t *samples, uint8_t count);
+
+/**
+ * @brief Tạo frame nhị phân cảnh báo cháy (topic alert/bin)
+ * @param buf Buffer đầu ra (nên có TELEMETRY_FRAME_MAX_LEN bytes)
+ * @param size Kích thước buffer (bytes)
+ * @param status Bản chụp trạng thái cảm biến tại thời điểm phát hiện
+ * @return Độ dài frame, -1 nếu lỗi hoặc buffer không đủ
+ */
+int telemetry_build_alert_frame(uint8_t *buf, size_t size, const sensor_status_t *status);
+
+#endif // TELEMETRY_H
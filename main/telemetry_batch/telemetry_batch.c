@@ -0,0 +1,81 @@
+#include "telemetry_batch.h"
+#include <string.h>
+
+int telemetry_batch_init(telemetry_batch_t *batch, uint8_t max_samples, uint32_t window_ms)
+{
+    if (batch == NULL || max_samples == 0 || max_samples > TELEMETRY_BATCH_MAX_SAMPLES) {
+        return -1;
+    }
+
+    memset(batch, 0, sizeof(telemetry_batch_t));
+    batch->max_samples = max_samples;
+    batch->window_ms = window_ms;
+
+    return 0;
+}
+
+int telemetry_batch_add(telemetry_batch_t *batch, const sensor_status_t *sample, uint32_t now_ms)
+{
+    if (batch == NULL || sample == NULL) {
+        return -1;
+    }
+
+    if (batch->count >= batch->max_samples) {
+        batch->stats.dropped++;
+        return -1;
+    }
+
+    if (batch->count == 0) {
+        batch->first_ms = now_ms;
+    }
+
+    memcpy(&batch->samples[batch->count], sample, sizeof(sensor_status_t));
+    batch->count++;
+
+    return 0;
+}
+
+bool telemetry_batch_ready(const telemetry_batch_t *batch, uint32_t now_ms)
+{
+    if (batch == NULL || batch->count == 0) {
+        return false;
+    }
+
+    return (batch->count >= batch->max_samples) || (now_ms - batch->first_ms >= batch->window_ms);
+}
+
+uint32_t telemetry_batch_time_left(const telemetry_batch_t *batch, uint32_t now_ms)
+{
+    if (batch == NULL || batch->count == 0) {
+        return (batch != NULL) ? batch->window_ms : 0;
+    }
+
+    if (telemetry_batch_ready(batch, now_ms)) {
+        return 0;
+    }
+
+    return batch->window_ms - (now_ms - batch->first_ms);
+}
+
+void telemetry_batch_complete(telemetry_batch_t *batch, uint32_t bytes, uint32_t now_ms)
+{
+    if (batch == NULL || batch->count == 0) {
+        return;
+    }
+
+    if (bytes > 0) {
+        uint32_t latency_ms = now_ms - batch->first_ms;
+
+        batch->stats.batches++;
+        batch->stats.samples += batch->count;
+        batch->stats.bytes += bytes;
+        batch->stats.last_latency_ms = latency_ms;
+        if (latency_ms > batch->stats.max_latency_ms) {
+            batch->stats.max_latency_ms = latency_ms;
+        }
+    } else {
+        batch->stats.discarded += batch->count;
+    }
+
+    batch->count = 0;
+}
@@ -0,0 +1,81 @@
+#ifndef TELEMETRY_BATCH_H
+#define TELEMETRY_BATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sensor/sensor.h"
+
+// Số mẫu tối đa trong một batch (cũng là độ sâu queue mẫu)
+#ifndef TELEMETRY_BATCH_MAX_SAMPLES
+#define TELEMETRY_BATCH_MAX_SAMPLES 10
+#endif
+
+// Cửa sổ gom mặc định: gửi khi đủ số mẫu hoặc mẫu cũ nhất đã chờ quá thời gian này
+#ifndef TELEMETRY_BATCH_WINDOW_MS
+#define TELEMETRY_BATCH_WINDOW_MS 5000
+#endif
+
+// Thống kê bộ gom
+typedef struct {
+    uint32_t batches;           // Số batch đã gửi
+    uint32_t samples;           // Số mẫu đã gửi trong các batch
+    uint32_t bytes;             // Tổng bytes payload đã gửi
+    uint32_t discarded;         // Số mẫu bị bỏ do không gửi được
+    uint32_t dropped;           // Số mẫu bị bỏ do batch đầy
+    uint32_t last_latency_ms;   // Thời gian chờ của mẫu cũ nhất ở lần gửi gần nhất
+    uint32_t max_latency_ms;    // Thời gian chờ lớn nhất
+} telemetry_batch_stats_t;
+
+// Bộ gom các chu kỳ đọc cảm biến thành một lần publish
+typedef struct {
+    sensor_status_t samples[TELEMETRY_BATCH_MAX_SAMPLES];
+    uint8_t count;
+    uint8_t max_samples;        // Gửi khi đủ số mẫu này
+    uint32_t window_ms;         // Hoặc khi mẫu cũ nhất đã chờ quá thời gian này
+    uint32_t first_ms;          // Thời điểm nhận mẫu đầu tiên của batch
+    telemetry_batch_stats_t stats;
+} telemetry_batch_t;
+
+/**
+ * @brief Khởi tạo bộ gom
+ * @param batch Con trỏ đến bộ gom
+ * @param max_samples Số mẫu mỗi batch (1 - TELEMETRY_BATCH_MAX_SAMPLES)
+ * @param window_ms Thời gian chờ tối đa của một mẫu (ms)
+ * @return 0 nếu thành công, -1 nếu tham số không hợp lệ
+ */
+int telemetry_batch_init(telemetry_batch_t *batch, uint8_t max_samples, uint32_t window_ms);
+
+/**
+ * @brief Thêm một mẫu vào batch
+ * @param batch Con trỏ đến bộ gom
+ * @param sample Trạng thái của một chu kỳ đọc
+ * @param now_ms Thời điểm hiện tại (ms)
+ * @return 0 nếu thành công, -1 nếu batch đầy (mẫu bị bỏ)
+ */
+int telemetry_batch_add(telemetry_batch_t *batch, const sensor_status_t *sample, uint32_t now_ms);
+
+/**
+ * @brief Kiểm tra batch đã đến lúc gửi chưa
+ * @param batch Con trỏ đến bộ gom
+ * @param now_ms Thời điểm hiện tại (ms)
+ * @return true nếu đủ số mẫu hoặc hết cửa sổ thời gian
+ */
+bool telemetry_batch_ready(const telemetry_batch_t *batch, uint32_t now_ms);
+
+/**
+ * @brief Thời gian còn lại đến khi batch hết cửa sổ
+ * @param batch Con trỏ đến bộ gom
+ * @param now_ms Thời điểm hiện tại (ms)
+ * @return Thời gian (ms), window_ms nếu batch rỗng, 0 nếu đã đến lúc gửi
+ */
+uint32_t telemetry_batch_time_left(const telemetry_batch_t *batch, uint32_t now_ms);
+
+/**
+ * @brief Kết thúc batch sau khi gửi, cập nhật thống kê và xóa batch
+ * @param batch Con trỏ đến bộ gom
+ * @param bytes Số bytes payload đã gửi (0 nếu không gửi được, các mẫu bị tính là discarded)
+ * @param now_ms Thời điểm hiện tại (ms)
+ */
+void telemetry_batch_complete(telemetry_batch_t *batch, uint32_t bytes, uint32_t now_ms);
+
+#endif // TELEMETRY_BATCH_H
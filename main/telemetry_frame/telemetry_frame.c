@@ -0,0 +1,110 @@
+#include "telemetry_frame.h"
+#include <string.h>
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+size_t telemetry_frame_size(uint8_t count)
+{
+    return TELEMETRY_FRAME_HEADER_LEN + (size_t)count * TELEMETRY_FRAME_SENSOR_LEN;
+}
+
+int telemetry_frame_encode(const telemetry_frame_t *frame, uint8_t *buf, size_t size)
+{
+    if (frame == NULL || buf == NULL || frame->count > TELEMETRY_FRAME_MAX_SENSORS) {
+        return -1;
+    }
+
+    size_t len = telemetry_frame_size(frame->count);
+    if (len > size) {
+        return -1;
+    }
+
+    buf[0] = TELEMETRY_FRAME_VERSION;
+    buf[1] = frame->kind;
+    buf[2] = frame->flags;
+    buf[3] = frame->count;
+    put_u32(&buf[4], frame->timestamp_ms);
+    buf[8] = frame->triggered_mask;
+    put_u16(&buf[9], (uint16_t)frame->temperature_rate);
+
+    uint8_t *p = &buf[TELEMETRY_FRAME_HEADER_LEN];
+    for (uint8_t i = 0; i < frame->count; i++) {
+        p[0] = frame->sensor_type[i];
+        put_u16(&p[1], frame->value[i]);
+        p += TELEMETRY_FRAME_SENSOR_LEN;
+    }
+
+    return (int)len;
+}
+
+int telemetry_frame_decode(const uint8_t *buf, size_t len, telemetry_frame_t *frame)
+{
+    if (buf == NULL || frame == NULL || len < TELEMETRY_FRAME_HEADER_LEN) {
+        return -1;
+    }
+
+    // Chỉ chấp nhận phiên bản đã biết; phiên bản mới phải tăng TELEMETRY_FRAME_VERSION
+    if (buf[0] != TELEMETRY_FRAME_VERSION) {
+        return -1;
+    }
+
+    uint8_t count = buf[3];
+    if (count > TELEMETRY_FRAME_MAX_SENSORS || len != telemetry_frame_size(count)) {
+        return -1;
+    }
+
+    memset(frame, 0, sizeof(telemetry_frame_t));
+    frame->version = buf[0];
+    frame->kind = buf[1];
+    frame->flags = buf[2];
+    frame->count = count;
+    frame->timestamp_ms = get_u32(&buf[4]);
+    frame->triggered_mask = buf[8];
+    frame->temperature_rate = (int16_t)get_u16(&buf[9]);
+
+    const uint8_t *p = &buf[TELEMETRY_FRAME_HEADER_LEN];
+    for (uint8_t i = 0; i < count; i++) {
+        frame->sensor_type[i] = p[0];
+        frame->value[i] = get_u16(&p[1]);
+        p += TELEMETRY_FRAME_SENSOR_LEN;
+    }
+
+    return 0;
+}
+
+int telemetry_frame_decode_next(const uint8_t *buf, size_t len, telemetry_frame_t *frame)
+{
+    if (buf == NULL || len < TELEMETRY_FRAME_HEADER_LEN) {
+        return -1;
+    }
+
+    // Độ dài frame suy ra từ số cảm biến trong header
+    size_t frame_len = telemetry_frame_size(buf[3]);
+    if (frame_len > len || telemetry_frame_decode(buf, frame_len, frame) != 0) {
+        return -1;
+    }
+
+    return (int)frame_len;
+}
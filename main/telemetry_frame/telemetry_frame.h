@@ -0,0 +1,92 @@
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Frame telemetry nhị phân, phiên bản 1 (little-endian, không padding):
+ *
+ *   offset  size  trường
+ *   0       1     version (TELEMETRY_FRAME_VERSION)
+ *   1       1     kind (telemetry_frame_kind_t)
+ *   2       1     flags (TELEMETRY_FRAME_FLAG_*)
+ *   3       1     count: số cảm biến N
+ *   4       4     timestamp_ms
+ *   8       1     triggered_mask (bit i = cảm biến i kích hoạt)
+ *   9       2     temperature_rate (int16, raw / phút, bão hòa)
+ *   11      3*N   mỗi cảm biến: type (1) + value (2, raw 0-4095 sau lọc)
+ *
+ * value là filtered_value, giá trị đã dùng để so ngưỡng, không phải mẫu ADC
+ * thô. JSON của cùng chu kỳ mang cùng giá trị: cảm biến analog là value / 4095
+ * (4 chữ số thập phân), cảm biến digital là trạng thái kích hoạt, tức bit của
+ * nó trong triggered_mask (value digital chỉ là 0 / 4095 sau lọc).
+ *
+ * Không phụ thuộc ESP-IDF, dùng được cho bộ giải mã phía host/server.
+ */
+
+#define TELEMETRY_FRAME_VERSION 1
+#define TELEMETRY_FRAME_MAX_SENSORS 8
+#define TELEMETRY_FRAME_HEADER_LEN 11
+#define TELEMETRY_FRAME_SENSOR_LEN 3
+#define TELEMETRY_FRAME_MAX_LEN (TELEMETRY_FRAME_HEADER_LEN + TELEMETRY_FRAME_MAX_SENSORS * TELEMETRY_FRAME_SENSOR_LEN)
+
+// Cờ trạng thái trong byte flags
+#define TELEMETRY_FRAME_FLAG_FIRE (1U << 0)
+#define TELEMETRY_FRAME_FLAG_ROR  (1U << 1)
+
+// Loại frame
+typedef enum {
+    TELEMETRY_FRAME_SENSOR_DATA = 1,    // Dữ liệu cảm biến định kỳ
+    TELEMETRY_FRAME_ALERT = 2,          // Cảnh báo cháy
+} telemetry_frame_kind_t;
+
+// Frame đã giải mã
+typedef struct {
+    uint8_t version;
+    uint8_t kind;
+    uint8_t flags;
+    uint8_t count;
+    uint32_t timestamp_ms;
+    uint8_t triggered_mask;
+    int16_t temperature_rate;
+    uint8_t sensor_type[TELEMETRY_FRAME_MAX_SENSORS];
+    uint16_t value[TELEMETRY_FRAME_MAX_SENSORS];
+} telemetry_frame_t;
+
+/**
+ * @brief Độ dài frame đã mã hóa với N cảm biến
+ * @param count Số cảm biến
+ * @return Độ dài (bytes)
+ */
+size_t telemetry_frame_size(uint8_t count);
+
+/**
+ * @brief Mã hóa frame vào buffer
+ * @param frame Frame cần mã hóa (version được ghi là TELEMETRY_FRAME_VERSION)
+ * @param buf Buffer đầu ra
+ * @param size Kích thước buffer (bytes)
+ * @return Độ dài frame, -1 nếu lỗi hoặc buffer không đủ
+ */
+int telemetry_frame_encode(const telemetry_frame_t *frame, uint8_t *buf, size_t size);
+
+/**
+ * @brief Giải mã frame từ buffer
+ * @param buf Buffer chứa frame
+ * @param len Độ dài buffer (bytes)
+ * @param frame Frame đầu ra
+ * @return 0 nếu thành công, -1 nếu sai phiên bản, sai độ dài hoặc dữ liệu không hợp lệ
+ */
+int telemetry_frame_decode(const uint8_t *buf, size_t len, telemetry_frame_t *frame);
+
+/**
+ * @brief Giải mã frame đầu tiên trong một chuỗi frame nối tiếp (payload batch)
+ * @param buf Buffer chứa các frame
+ * @param len Độ dài còn lại của buffer (bytes)
+ * @param frame Frame đầu ra
+ * @return Số bytes của frame đã giải mã, -1 nếu dữ liệu không hợp lệ
+ */
+int telemetry_frame_decode_next(const uint8_t *buf, size_t len, telemetry_frame_t *frame);
+
+#endif // TELEMETRY_FRAME_H
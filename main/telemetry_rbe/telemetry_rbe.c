@@ -0,0 +1,89 @@
+#include "telemetry_rbe.h"
+#include <string.h>
+
+// Deadband theo loại cảm biến (raw 0-4095 sau lọc); 0 = chỉ gửi khi trạng thái kích hoạt đổi
+static const uint16_t rbe_deadband[SENSOR_TYPE_COUNT] = {
+    [SENSOR_TYPE_SMOKE]       = 40,     // ~1% thang đo
+    [SENSOR_TYPE_TEMPERATURE] = 20,     // ~0.5% thang đo
+    [SENSOR_TYPE_IR_FLAME]    = 0,      // Digital
+    [SENSOR_TYPE_GAS]         = 40,
+    [SENSOR_TYPE_CO]          = 40,
+};
+
+/**
+ * @brief Các cảm biến thay đổi vượt deadband so với giá trị đã gửi gần nhất
+ * @return Bitmask theo chỉ số cảm biến (0 nếu không có)
+ */
+static uint32_t values_changed(const telemetry_rbe_t *rbe, const sensor_status_t *sample)
+{
+    uint32_t changed = 0;
+
+    for (uint8_t i = 0; i < sample->count; i++) {
+        const sensor_desc_t *desc = sensor_get_desc(i);
+        if (desc == NULL || !desc->is_analog) {
+            continue;
+        }
+
+        uint16_t deadband = rbe_deadband[desc->type];
+        if (deadband == 0) {
+            continue;
+        }
+
+        int32_t delta = (int32_t)sample->filtered_value[i] - (int32_t)rbe->last_value[i];
+        if (delta >= deadband || delta <= -(int32_t)deadband) {
+            changed |= (1UL << i);
+        }
+    }
+
+    return changed;
+}
+
+void telemetry_rbe_init(telemetry_rbe_t *rbe, uint32_t heartbeat_ms)
+{
+    if (rbe == NULL) {
+        return;
+    }
+
+    memset(rbe, 0, sizeof(telemetry_rbe_t));
+    rbe->heartbeat_ms = heartbeat_ms;
+}
+
+bool telemetry_rbe_should_report(telemetry_rbe_t *rbe, const sensor_status_t *sample, uint32_t now_ms)
+{
+    if (rbe == NULL || sample == NULL) {
+        return false;
+    }
+
+    uint32_t value_mask = rbe->has_report ? values_changed(rbe, sample) : 0;
+    bool changed = !rbe->has_report ||
+                   sample->triggered_mask != rbe->last_mask ||
+                   sample->fire_detected != rbe->last_fire ||
+                   sample->ror_triggered != rbe->last_ror ||
+                   value_mask != 0;
+    bool heartbeat = !rbe->has_report || (now_ms - rbe->last_report_ms >= rbe->heartbeat_ms);
+
+    if (changed) {
+        rbe->stats.reported++;
+    } else if (heartbeat) {
+        rbe->stats.heartbeats++;
+    } else {
+        rbe->stats.suppressed++;
+        return false;
+    }
+
+    // Mốc deadband chỉ dời với cảm biến vượt deadband (mọi cảm biến khi heartbeat
+    // hoặc lần gửi đầu): gửi vì cảm biến khác không làm trôi mốc của cảm biến
+    // đang thay đổi chậm
+    for (uint8_t i = 0; i < sample->count && i < SENSOR_MAX_COUNT; i++) {
+        if (heartbeat || (value_mask & (1UL << i))) {
+            rbe->last_value[i] = sample->filtered_value[i];
+        }
+    }
+    rbe->last_mask = sample->triggered_mask;
+    rbe->last_fire = sample->fire_detected;
+    rbe->last_ror = sample->ror_triggered;
+    rbe->last_report_ms = now_ms;
+    rbe->has_report = true;
+
+    return true;
+}
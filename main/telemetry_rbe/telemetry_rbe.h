@@ -0,0 +1,59 @@
+#ifndef TELEMETRY_RBE_H
+#define TELEMETRY_RBE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sensor/sensor.h"
+
+// Bật chế độ report-by-exception (0: gửi mọi chu kỳ đọc)
+#ifndef TELEMETRY_RBE_ENABLED
+#define TELEMETRY_RBE_ENABLED 1
+#endif
+
+// Chu kỳ heartbeat: gửi đầy đủ trạng thái dù không có thay đổi (ms)
+#ifndef TELEMETRY_RBE_HEARTBEAT_MS
+#define TELEMETRY_RBE_HEARTBEAT_MS 60000
+#endif
+
+// Thống kê report-by-exception
+typedef struct {
+    uint32_t reported;          // Số chu kỳ được gửi do có thay đổi
+    uint32_t heartbeats;        // Số chu kỳ được gửi do đến hạn heartbeat
+    uint32_t suppressed;        // Số chu kỳ bị bỏ qua vì không có thay đổi
+} telemetry_rbe_stats_t;
+
+// Trạng thái đã gửi gần nhất của từng cảm biến
+typedef struct {
+    uint16_t last_value[SENSOR_MAX_COUNT];  // Mốc deadband: giá trị sau lọc lúc vượt deadband/heartbeat (raw)
+    uint32_t last_mask;                     // triggered_mask đã gửi gần nhất
+    bool last_fire;
+    bool last_ror;
+    bool has_report;                        // Đã gửi ít nhất một lần
+    uint32_t last_report_ms;
+    uint32_t heartbeat_ms;
+    telemetry_rbe_stats_t stats;
+} telemetry_rbe_t;
+
+/**
+ * @brief Khởi tạo bộ lọc report-by-exception
+ * @param rbe Con trỏ đến bộ lọc
+ * @param heartbeat_ms Chu kỳ heartbeat (ms)
+ */
+void telemetry_rbe_init(telemetry_rbe_t *rbe, uint32_t heartbeat_ms);
+
+/**
+ * @brief Quyết định có gửi một chu kỳ đọc hay không
+ *
+ * Gửi khi có cảm biến thay đổi vượt deadband so với mốc của nó, khi trạng
+ * thái kích hoạt/cháy/tốc độ tăng nhiệt độ thay đổi, hoặc khi đến hạn
+ * heartbeat. Nếu gửi, trạng thái kích hoạt được cập nhật; mốc deadband chỉ
+ * dời với cảm biến đã vượt deadband, hoặc mọi cảm biến khi đến hạn heartbeat.
+ *
+ * @param rbe Con trỏ đến bộ lọc
+ * @param sample Trạng thái của chu kỳ đọc
+ * @param now_ms Thời điểm hiện tại (ms)
+ * @return true nếu cần gửi
+ */
+bool telemetry_rbe_should_report(telemetry_rbe_t *rbe, const sensor_status_t *sample, uint32_t now_ms);
+
+#endif // TELEMETRY_RBE_H
@@ -0,0 +1,285 @@
+#include "trace.h"
+#include <string.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "esp_freertos_hooks.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "TRACE";
+
+#define TRACE_HISTORY_DEPTH 4           // Sự kiện gần nhất giữ lại cho mỗi điểm đo để ghép cha
+#define TRACE_NO_PARENT TRACE_POINT_COUNT
+
+_Static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "TRACE_RING_SIZE must be a power of 2");
+
+// Một sự kiện trong vòng đệm (8 bytes)
+typedef struct {
+    uint32_t time_us;                   // esp_timer (us), tràn sau ~71 phút
+    uint16_t point;
+    uint16_t tag;
+} trace_event_t;
+
+// Vòng đệm của một core: chỉ task trên core đó ghi, chỉ trace_fold() đọc
+typedef struct {
+    trace_event_t event[TRACE_RING_SIZE];
+    atomic_uint head;                   // Do bên ghi tăng
+    atomic_uint tail;                   // Do trace_fold() tăng
+    uint32_t dropped;
+    // Cặp hiệu chuẩn, do tick hook của cùng core ghi
+    uint32_t cal_ccount;
+    uint32_t cal_us;
+    bool calibrated;
+} trace_ring_t;
+
+// Sự kiện đã xử lý, dùng làm cha cho các điểm đo sau
+typedef struct {
+    uint32_t time_us;
+    uint32_t origin_us;                 // Thời điểm frame ADC gốc
+    uint16_t tag;
+} trace_record_t;
+
+typedef struct {
+    trace_record_t history[TRACE_HISTORY_DEPTH];    // Vòng, history[next - 1] là mới nhất
+    uint8_t count;
+    uint8_t next;
+    trace_stats_t stats;
+} trace_point_state_t;
+
+static trace_ring_t s_ring[portNUM_PROCESSORS];
+static uint32_t s_cycles_per_us = 1;
+
+static trace_point_state_t s_point[TRACE_POINT_COUNT];
+static SemaphoreHandle_t s_lock = NULL;
+
+// Điểm cha của mỗi điểm đo
+static const uint8_t s_parent[TRACE_POINT_COUNT] = {
+    [TRACE_ADC_FRAME] = TRACE_NO_PARENT,
+    [TRACE_SENSOR_EVALUATED] = TRACE_ADC_FRAME,
+    [TRACE_FIRE_DETECTED] = TRACE_ADC_FRAME,
+    [TRACE_ALARM_ON] = TRACE_FIRE_DETECTED,
+    [TRACE_ALERT_ENQUEUED] = TRACE_FIRE_DETECTED,
+    [TRACE_ALERT_PUBLISHED] = TRACE_ALERT_ENQUEUED,
+};
+
+static const char *const s_point_names[TRACE_POINT_COUNT] = {
+    [TRACE_ADC_FRAME] = "adc_frame",
+    [TRACE_SENSOR_EVALUATED] = "sensor_evaluated",
+    [TRACE_FIRE_DETECTED] = "fire_detected",
+    [TRACE_ALARM_ON] = "alarm_on",
+    [TRACE_ALERT_ENQUEUED] = "alert_enqueued",
+    [TRACE_ALERT_PUBLISHED] = "alert_published",
+};
+
+/**
+ * @brief Tick hook: ghi cặp (CCOUNT, esp_timer) của core hiện tại
+ *
+ * Chạy trong ngắt tick nên không xen vào giữa trace_point() trên cùng core.
+ */
+static void IRAM_ATTR trace_calibrate(void)
+{
+    trace_ring_t *ring = &s_ring[esp_cpu_get_core_id()];
+
+    ring->cal_ccount = esp_cpu_get_cycle_count();
+    ring->cal_us = (uint32_t)esp_timer_get_time();
+    ring->calibrated = true;
+}
+
+int trace_init(void)
+{
+    if (s_lock == NULL) {
+        s_lock = xSemaphoreCreateMutex();
+        if (s_lock == NULL) {
+            return -1;
+        }
+    }
+
+    memset(s_point, 0, sizeof(s_point));
+    for (int i = 0; i < TRACE_POINT_COUNT; i++) {
+        latency_hist_init(&s_point[i].stats.stage, TRACE_HIST_BASE_US);
+        latency_hist_init(&s_point[i].stats.total, TRACE_HIST_BASE_US);
+    }
+
+    s_cycles_per_us = esp_rom_get_cpu_ticks_per_us();
+    if (s_cycles_per_us == 0) {
+        s_cycles_per_us = 1;
+    }
+
+    for (int cpu = 0; cpu < portNUM_PROCESSORS; cpu++) {
+        if (esp_register_freertos_tick_hook_for_cpu(trace_calibrate, cpu) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to register tick hook on core %d", cpu);
+            return -1;
+        }
+    }
+
+    ESP_LOGI(TAG, "Trace initialized (%d events/core, %" PRIu32 " cycles/us)",
+             TRACE_RING_SIZE, s_cycles_per_us);
+    return 0;
+}
+
+void IRAM_ATTR trace_point(trace_point_t point, uint16_t tag)
+{
+    // Che ngắt: không bị tick hook hay task khác trên cùng core chen vào, không đổi core
+    UBaseType_t irq = portSET_INTERRUPT_MASK_FROM_ISR();
+    uint32_t ccount = esp_cpu_get_cycle_count();
+    trace_ring_t *ring = &s_ring[esp_cpu_get_core_id()];
+
+    unsigned int head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (ring->calibrated && head - tail < TRACE_RING_SIZE) {
+        trace_event_t *e = &ring->event[head & (TRACE_RING_SIZE - 1)];
+        e->time_us = ring->cal_us + (ccount - ring->cal_ccount) / s_cycles_per_us;
+        e->point = (uint16_t)point;
+        e->tag = tag;
+        atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    } else {
+        ring->dropped++;
+    }
+
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(irq);
+}
+
+/**
+ * @brief Sự kiện đã xử lý gần nhất của một điểm đo có tag khớp
+ *
+ * Sự kiện không tag khớp với mọi tag và ngược lại.
+ */
+static const trace_record_t *find_record(const trace_point_state_t *st, uint16_t tag)
+{
+    for (uint8_t i = 0; i < st->count; i++) {
+        uint8_t idx = (st->next + TRACE_HISTORY_DEPTH - 1 - i) % TRACE_HISTORY_DEPTH;
+        const trace_record_t *rec = &st->history[idx];
+        if (tag == TRACE_TAG_NONE || rec->tag == TRACE_TAG_NONE || rec->tag == tag) {
+            return rec;
+        }
+    }
+    return NULL;
+}
+
+static void push_record(trace_point_state_t *st, uint32_t time_us, uint32_t origin_us, uint16_t tag)
+{
+    trace_record_t *rec = &st->history[st->next];
+    rec->time_us = time_us;
+    rec->origin_us = origin_us;
+    rec->tag = tag;
+
+    st->next = (st->next + 1) % TRACE_HISTORY_DEPTH;
+    if (st->count < TRACE_HISTORY_DEPTH) {
+        st->count++;
+    }
+}
+
+/**
+ * @brief Ghép một sự kiện với sự kiện cha và ghi độ trễ
+ */
+static void fold_event(const trace_event_t *e)
+{
+    if (e->point >= TRACE_POINT_COUNT) {
+        return;
+    }
+
+    trace_point_state_t *st = &s_point[e->point];
+    uint8_t parent = s_parent[e->point];
+
+    if (parent == TRACE_NO_PARENT) {
+        push_record(st, e->time_us, e->time_us, e->tag);
+        return;
+    }
+
+    // Cùng một cảnh báo được publish nhiều lần (JSON + nhị phân, gửi lại): chỉ tính lần đầu
+    if (e->tag != TRACE_TAG_NONE) {
+        for (uint8_t i = 0; i < st->count; i++) {
+            if (st->history[i].tag == e->tag) {
+                return;
+            }
+        }
+    }
+
+    const trace_record_t *rec = find_record(&s_point[parent], e->tag);
+    if (rec == NULL) {
+        st->stats.unmatched++;
+        return;
+    }
+
+    latency_hist_record(&st->stats.stage, e->time_us - rec->time_us);
+    latency_hist_record(&st->stats.total, e->time_us - rec->origin_us);
+    push_record(st, e->time_us, rec->origin_us, e->tag);
+}
+
+int trace_fold(void)
+{
+    if (s_lock == NULL) {
+        return -1;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+
+    unsigned int head[portNUM_PROCESSORS];
+    unsigned int tail[portNUM_PROCESSORS];
+    for (int cpu = 0; cpu < portNUM_PROCESSORS; cpu++) {
+        head[cpu] = atomic_load_explicit(&s_ring[cpu].head, memory_order_acquire);
+        tail[cpu] = atomic_load_explicit(&s_ring[cpu].tail, memory_order_relaxed);
+    }
+
+    // Mỗi vòng đệm đã theo thứ tự thời gian: trộn bằng cách lấy sự kiện sớm nhất
+    int folded = 0;
+    while (1) {
+        int next = -1;
+        const trace_event_t *first = NULL;
+        for (int cpu = 0; cpu < portNUM_PROCESSORS; cpu++) {
+            if (tail[cpu] == head[cpu]) {
+                continue;
+            }
+            const trace_event_t *e = &s_ring[cpu].event[tail[cpu] & (TRACE_RING_SIZE - 1)];
+            if (first == NULL || (int32_t)(e->time_us - first->time_us) < 0) {
+                first = e;
+                next = cpu;
+            }
+        }
+        if (next < 0) {
+            break;
+        }
+
+        fold_event(first);
+        tail[next]++;
+        folded++;
+    }
+
+    for (int cpu = 0; cpu < portNUM_PROCESSORS; cpu++) {
+        atomic_store_explicit(&s_ring[cpu].tail, tail[cpu], memory_order_release);
+    }
+
+    xSemaphoreGive(s_lock);
+    return folded;
+}
+
+int trace_get_stats(trace_point_t point, trace_stats_t *stats)
+{
+    if (stats == NULL || point >= TRACE_POINT_COUNT || s_lock == NULL) {
+        return -1;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *stats = s_point[point].stats;
+    xSemaphoreGive(s_lock);
+    return 0;
+}
+
+uint32_t trace_get_dropped(void)
+{
+    uint32_t dropped = 0;
+    for (int cpu = 0; cpu < portNUM_PROCESSORS; cpu++) {
+        dropped += s_ring[cpu].dropped;
+    }
+    return dropped;
+}
+
+const char *trace_point_name(trace_point_t point)
+{
+    return (point < TRACE_POINT_COUNT) ? s_point_names[point] : "unknown";
+}
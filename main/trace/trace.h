@@ -0,0 +1,105 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "latency_hist/latency_hist.h"
+
+/*
+ * Điểm đo (trace point) trên đường nóng phát hiện cháy -> còi -> cảnh báo MQTT.
+ *
+ * Mỗi điểm đo ghi {thời điểm, điểm đo, tag} vào vòng đệm của core đang chạy:
+ * một bên ghi (task trên core đó, ngắt bị che trong lúc ghi) và một bên đọc
+ * (trace_fold()), không khóa. Thời điểm lấy từ bộ đếm chu kỳ CPU và được quy
+ * về micro giây esp_timer nhờ cặp hiệu chuẩn (CCOUNT, esp_timer) ghi lại mỗi
+ * tick trên từng core, nên các core so sánh được với nhau và một điểm đo chỉ
+ * tốn vài chục chu kỳ.
+ *
+ * trace_fold() gộp các sự kiện theo thời gian, ghép mỗi sự kiện với sự kiện
+ * cha gần nhất và ghi vào histogram độ trễ: "stage" tính từ điểm cha, "total"
+ * tính từ frame ADC đã khởi đầu chuỗi. Tag (16 bit thấp của event_time_us)
+ * ghép đúng cảnh báo khi có nhiều sự kiện cháy đang được xử lý.
+ */
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1                 // 0: TRACE_POINT() không sinh mã
+#endif
+
+#define TRACE_RING_SIZE 256             // Sự kiện mỗi core, lũy thừa của 2
+#define TRACE_HIST_BASE_US 16           // Giới hạn trên bucket 0 của histogram
+#define TRACE_TAG_NONE 0                // Sự kiện không gắn với một cảnh báo cụ thể
+
+typedef enum {
+    TRACE_ADC_FRAME = 0,                // Có frame ADC mới (gốc của chuỗi)
+    TRACE_SENSOR_EVALUATED,             // Đã đánh giá điều kiện cháy (mỗi chu kỳ)
+    TRACE_FIRE_DETECTED,                // Chuyển sang trạng thái cháy
+    TRACE_ALARM_ON,                     // Đã bật còi
+    TRACE_ALERT_ENQUEUED,               // Cảnh báo đã vào hàng đợi egress
+    TRACE_ALERT_PUBLISHED,              // Cảnh báo đã được publish
+    TRACE_POINT_COUNT
+} trace_point_t;
+
+// Thống kê của một điểm đo
+typedef struct {
+    latency_hist_t stage;               // Từ điểm cha
+    latency_hist_t total;               // Từ frame ADC gốc
+    uint32_t unmatched;                 // Không tìm thấy sự kiện cha
+} trace_stats_t;
+
+/**
+ * @brief Khởi tạo bộ đo và đăng ký hiệu chuẩn theo tick trên mọi core
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int trace_init(void);
+
+/**
+ * @brief Ghi một sự kiện vào vòng đệm của core hiện tại
+ *
+ * Không chặn, gọi được từ mọi task. Vòng đệm đầy thì sự kiện bị bỏ và đếm
+ * vào trace_get_dropped().
+ *
+ * @param point Điểm đo
+ * @param tag Tag của chuỗi sự kiện (trace_tag()) hoặc TRACE_TAG_NONE
+ */
+void trace_point(trace_point_t point, uint16_t tag);
+
+/**
+ * @brief Tag của chuỗi sự kiện từ thời điểm phát hiện (event_time_us)
+ */
+static inline uint16_t trace_tag(int64_t event_time_us)
+{
+    uint16_t tag = (uint16_t)event_time_us;
+    return (tag == TRACE_TAG_NONE) ? 1 : tag;
+}
+
+#if TRACE_ENABLED
+#define TRACE_POINT(point, tag) trace_point((point), (tag))
+#else
+#define TRACE_POINT(point, tag) do { } while (0)
+#endif
+
+/**
+ * @brief Đọc hết các vòng đệm và ghi vào histogram
+ * @return Số sự kiện đã xử lý, -1 nếu lỗi
+ */
+int trace_fold(void);
+
+/**
+ * @brief Lấy thống kê của một điểm đo (gọi trace_fold() trước để cập nhật)
+ * @param point Điểm đo
+ * @param stats Con trỏ đến cấu trúc thống kê
+ * @return 0 nếu thành công, -1 nếu lỗi
+ */
+int trace_get_stats(trace_point_t point, trace_stats_t *stats);
+
+/**
+ * @brief Tổng số sự kiện bị bỏ do vòng đệm đầy hoặc chưa hiệu chuẩn
+ */
+uint32_t trace_get_dropped(void);
+
+/**
+ * @brief Tên của một điểm đo ("adc_frame", "fire_detected", ...)
+ */
+const char *trace_point_name(trace_point_t point);
+
+#endif // TRACE_H
@@ -1,7 +1,11 @@
 #include "wifi.h"
+#include <string.h>
+#include <inttypes.h>
 #include "esp_log.h"
 #include "esp_netif.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
+#include "nvs.h"
 #include "lwip/err.h"
 #include "lwip/sys.h"
 
@@ -9,6 +13,111 @@ static const char *TAG = "WIFI";
 
 static wifi_manager_t *g_wifi_manager = NULL;
 
+// Thông tin kết nối nhanh lưu trong NVS. Không lưu IP: lease có thể đã hết hạn
+// và được cấp cho máy khác, IP luôn xin lại qua DHCP
+#define WIFI_FAST_NVS_NAMESPACE "wifi_fast"
+#define WIFI_FAST_NVS_KEY "cache"
+#define WIFI_FAST_CACHE_VERSION 2
+
+typedef struct {
+    uint8_t version;
+    uint8_t channel;
+    uint8_t bssid[6];
+    char ssid[32];
+} wifi_fast_cache_t;
+
+static wifi_fast_cache_t g_fast_cache;
+static bool g_fast_cache_valid = false;
+
+/**
+ * @brief Đọc thông tin kết nối nhanh từ NVS (chỉ hợp lệ nếu cùng SSID)
+ */
+static void fast_cache_load(const char *ssid)
+{
+    nvs_handle_t handle;
+    size_t len = sizeof(g_fast_cache);
+    
+    g_fast_cache_valid = false;
+    if (nvs_open(WIFI_FAST_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return;
+    }
+    
+    if (nvs_get_blob(handle, WIFI_FAST_NVS_KEY, &g_fast_cache, &len) == ESP_OK &&
+        len == sizeof(g_fast_cache) &&
+        g_fast_cache.version == WIFI_FAST_CACHE_VERSION &&
+        strncmp(g_fast_cache.ssid, ssid, sizeof(g_fast_cache.ssid)) == 0 &&
+        g_fast_cache.channel != 0) {
+        g_fast_cache_valid = true;
+    }
+    nvs_close(handle);
+}
+
+/**
+ * @brief Lưu BSSID/kênh của kết nối hiện tại (chỉ ghi flash khi có thay đổi)
+ */
+static void fast_cache_save(void)
+{
+    wifi_ap_record_t ap;
+    if (esp_wifi_sta_get_ap_info(&ap) != ESP_OK) {
+        return;
+    }
+    
+    wifi_fast_cache_t cache = {0};
+    cache.version = WIFI_FAST_CACHE_VERSION;
+    cache.channel = ap.primary;
+    memcpy(cache.bssid, ap.bssid, sizeof(cache.bssid));
+    strncpy(cache.ssid, g_wifi_manager->ssid, sizeof(cache.ssid));
+    
+    if (g_fast_cache_valid && memcmp(&cache, &g_fast_cache, sizeof(cache)) == 0) {
+        return;
+    }
+    
+    nvs_handle_t handle;
+    if (nvs_open(WIFI_FAST_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
+        return;
+    }
+    if (nvs_set_blob(handle, WIFI_FAST_NVS_KEY, &cache, sizeof(cache)) == ESP_OK &&
+        nvs_commit(handle) == ESP_OK) {
+        g_fast_cache = cache;
+        g_fast_cache_valid = true;
+        ESP_LOGI(TAG, "Fast-connect info saved (channel %d)", cache.channel);
+    }
+    nvs_close(handle);
+}
+
+/**
+ * @brief Cấu hình station cho lần kết nối tới
+ *
+ * IP luôn lấy qua DHCP; với CONFIG_LWIP_DHCP_RESTORE_LAST_IP, lwIP xin lại IP
+ * của lease trước (một REQUEST thay vì DISCOVER/OFFER) và server từ chối nếu
+ * lease đã hết hạn hoặc đổi mạng.
+ *
+ * @param fast true: kết nối thẳng tới BSSID/kênh đã lưu,
+ *             false: quét toàn bộ kênh
+ */
+static void apply_connect_mode(bool fast)
+{
+    wifi_config_t wifi_sta_config;
+    if (esp_wifi_get_config(WIFI_IF_STA, &wifi_sta_config) != ESP_OK) {
+        return;
+    }
+    
+    if (fast) {
+        wifi_sta_config.sta.bssid_set = true;
+        memcpy(wifi_sta_config.sta.bssid, g_fast_cache.bssid, sizeof(g_fast_cache.bssid));
+        wifi_sta_config.sta.channel = g_fast_cache.channel;
+        wifi_sta_config.sta.scan_method = WIFI_FAST_SCAN;
+    } else {
+        wifi_sta_config.sta.bssid_set = false;
+        wifi_sta_config.sta.channel = 0;
+        wifi_sta_config.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+    }
+    
+    esp_wifi_set_config(WIFI_IF_STA, &wifi_sta_config);
+    g_wifi_manager->fast_connect = fast;
+    g_wifi_manager->fast_retry_count = 0;
+}
+
 void wifi_event_handler(void* arg, esp_event_base_t event_base,
                        int32_t event_id, void* event_data)
 {
@@ -21,22 +130,49 @@ void wifi_event_handler(void* arg, esp_event_base_t event_base,
         ESP_LOGI(TAG, "WiFi station started, connecting...");
     } 
     else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        if (g_wifi_manager->retry_count < g_wifi_manager->max_retry) {
-            esp_wifi_connect();
-            g_wifi_manager->retry_count++;
-            ESP_LOGI(TAG, "Retry to connect to WiFi (%d/%d)", 
-                     g_wifi_manager->retry_count, g_wifi_manager->max_retry);
-        } else {
-            xEventGroupSetBits(g_wifi_manager->event_group, WIFI_FAIL_BIT);
-            ESP_LOGE(TAG, "Failed to connect to WiFi after %d retries", 
-                     g_wifi_manager->max_retry);
+        // Không tự kết nối lại ở đây: thời điểm thử lại do người gọi quyết định
+        // (bộ giám sát kết nối với backoff), chỉ chọn cách kết nối cho lần tới
+        if (g_wifi_manager->is_connected) {
+            // Mất kết nối: lần tới thử bằng thông tin đã lưu
+            ESP_LOGW(TAG, "WiFi connection lost");
+            if (WIFI_FAST_CONNECT_ENABLED && g_fast_cache_valid) {
+                apply_connect_mode(true);
+            }
+        } else if (g_wifi_manager->fast_connect) {
+            if (g_wifi_manager->fast_retry_count < WIFI_FAST_CONNECT_MAX_RETRY) {
+                g_wifi_manager->fast_retry_count++;
+            } else {
+                // AP đổi kênh/BSSID hoặc không còn ở đó: quét toàn bộ + DHCP
+                ESP_LOGW(TAG, "Fast connect failed, falling back to full scan");
+                apply_connect_mode(false);
+            }
         }
+        
         g_wifi_manager->is_connected = false;
+        xEventGroupClearBits(g_wifi_manager->event_group, WIFI_CONNECTED_BIT);
+        xEventGroupSetBits(g_wifi_manager->event_group, WIFI_FAIL_BIT);
     } 
     else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
         ESP_LOGI(TAG, "Got IP:" IPSTR, IP2STR(&event->ip_info.ip));
-        g_wifi_manager->retry_count = 0;
+        
+        int64_t now_us = esp_timer_get_time();
+        g_wifi_manager->connect_to_ip_ms = (uint32_t)((now_us - g_wifi_manager->connect_start_us) / 1000);
+        if (g_wifi_manager->boot_to_ip_ms == 0) {
+            g_wifi_manager->boot_to_ip_ms = (uint32_t)(now_us / 1000);
+        }
+        if (g_wifi_manager->fast_connect) {
+            g_wifi_manager->fast_connects++;
+        } else {
+            g_wifi_manager->full_connects++;
+            if (WIFI_FAST_CONNECT_ENABLED) {
+                fast_cache_save();
+            }
+        }
+        ESP_LOGI(TAG, "Connected in %" PRIu32 " ms (%s), boot to IP: %" PRIu32 " ms",
+                 g_wifi_manager->connect_to_ip_ms, g_wifi_manager->fast_connect ? "fast" : "full scan",
+                 g_wifi_manager->boot_to_ip_ms);
+        
         g_wifi_manager->is_connected = true;
         xEventGroupSetBits(g_wifi_manager->event_group, WIFI_CONNECTED_BIT);
     }
@@ -94,31 +230,77 @@ int wifi_init(wifi_manager_t *manager, const char *ssid, const char *password)
     strncpy(manager->ssid, ssid, sizeof(manager->ssid) - 1);
     strncpy(manager->password, password, sizeof(manager->password) - 1);
     manager->is_connected = false;
-    manager->retry_count = 0;
-    manager->max_retry = 5;
     manager->event_group = xEventGroupCreate();
+    manager->started = false;
+    manager->fast_connect = false;
+    manager->fast_retry_count = 0;
+    manager->boot_to_ip_ms = 0;
+    manager->connect_to_ip_ms = 0;
+    manager->fast_connects = 0;
+    manager->full_connects = 0;
+    
+    // Dùng BSSID/kênh đã lưu nếu có (bỏ qua quét)
+    if (WIFI_FAST_CONNECT_ENABLED) {
+        fast_cache_load(ssid);
+        if (g_fast_cache_valid) {
+            apply_connect_mode(true);
+            ESP_LOGI(TAG, "Fast connect enabled (cached channel %d)", g_fast_cache.channel);
+        }
+    }
     
     ESP_LOGI(TAG, "WiFi initialized with SSID: %s", ssid);
     
     return 0;
 }
 
-int wifi_connect(wifi_manager_t *manager)
+int wifi_start_connect(wifi_manager_t *manager)
+{
+    if (manager == NULL) {
+        return -1;
+    }
+    
+    ESP_LOGI(TAG, "Connecting to WiFi SSID: %s (%s)", manager->ssid,
+             manager->fast_connect ? "fast" : "full scan");
+    
+    xEventGroupClearBits(manager->event_group, WIFI_FAIL_BIT);
+    manager->connect_start_us = esp_timer_get_time();
+    
+    // Lần đầu: esp_wifi_start(), WIFI_EVENT_STA_START sẽ gọi esp_wifi_connect()
+    esp_err_t err;
+    if (!manager->started) {
+        err = esp_wifi_start();
+        manager->started = (err == ESP_OK);
+    } else {
+        err = esp_wifi_connect();
+    }
+    
+    return (err == ESP_OK) ? 0 : -1;
+}
+
+int wifi_abort_connect(wifi_manager_t *manager)
 {
     if (manager == NULL) {
         return -1;
     }
     
-    ESP_LOGI(TAG, "Connecting to WiFi SSID: %s", manager->ssid);
+    // Sự kiện STA_DISCONNECTED sẽ đánh dấu lần thử thất bại
+    esp_wifi_disconnect();
     
-    ESP_ERROR_CHECK(esp_wifi_start());
+    return 0;
+}
+
+int wifi_connect(wifi_manager_t *manager)
+{
+    if (wifi_start_connect(manager) != 0) {
+        return -1;
+    }
     
     // Chờ kết nối
     EventBits_t bits = xEventGroupWaitBits(manager->event_group,
                                            WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
                                            pdFALSE,
                                            pdFALSE,
-                                           portMAX_DELAY);
+                                           pdMS_TO_TICKS(WIFI_CONNECT_TIMEOUT_MS));
     
     if (bits & WIFI_CONNECTED_BIT) {
         ESP_LOGI(TAG, "Connected to WiFi SSID: %s", manager->ssid);
@@ -127,7 +309,7 @@ int wifi_connect(wifi_manager_t *manager)
         ESP_LOGE(TAG, "Failed to connect to WiFi SSID: %s", manager->ssid);
         return -1;
     } else {
-        ESP_LOGE(TAG, "Unexpected event");
+        ESP_LOGE(TAG, "Timed out connecting to WiFi SSID: %s", manager->ssid);
         return -1;
     }
 }
@@ -143,6 +325,7 @@ int wifi_disconnect(wifi_manager_t *manager)
     esp_wifi_disconnect();
     esp_wifi_stop();
     
+    manager->started = false;
     manager->is_connected = false;
     xEventGroupClearBits(manager->event_group, WIFI_CONNECTED_BIT);
     
@@ -2,6 +2,7 @@
 #define WIFI_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "esp_wifi.h"
 #include "esp_event.h"
 #include "freertos/FreeRTOS.h"
@@ -11,14 +12,28 @@
 #define WIFI_CONNECTED_BIT BIT0
 #define WIFI_FAIL_BIT      BIT1
 
+// Thời gian chờ tối đa của wifi_connect() (ms)
+#define WIFI_CONNECT_TIMEOUT_MS 30000
+
+// Kết nối nhanh: dùng BSSID/kênh của lần kết nối thành công trước (lưu NVS), bỏ
+// qua quét kênh; IP vẫn lấy qua DHCP. Thất bại thì quay về quét toàn bộ
+#define WIFI_FAST_CONNECT_ENABLED 1
+#define WIFI_FAST_CONNECT_MAX_RETRY 1   // Số lần thử lại kết nối nhanh trước khi quét toàn bộ
+
 // Cấu trúc quản lý WiFi
 typedef struct {
     char ssid[32];
     char password[64];
     bool is_connected;
-    int retry_count;
-    int max_retry;
     EventGroupHandle_t event_group;
+    bool started;               // esp_wifi_start() đã được gọi
+    bool fast_connect;          // Lần kết nối hiện tại dùng thông tin đã lưu
+    int fast_retry_count;       // Số lần kết nối nhanh thất bại liên tiếp
+    int64_t connect_start_us;   // Thời điểm bắt đầu kết nối (esp_timer)
+    uint32_t boot_to_ip_ms;     // Từ lúc khởi động đến khi có IP lần đầu
+    uint32_t connect_to_ip_ms;  // Từ lúc bắt đầu kết nối đến khi có IP (lần gần nhất)
+    uint32_t fast_connects;     // Số lần có IP qua kết nối nhanh
+    uint32_t full_connects;     // Số lần có IP qua quét toàn bộ + DHCP
 } wifi_manager_t;
 
 /**
@@ -31,9 +46,33 @@ typedef struct {
 int wifi_init(wifi_manager_t *manager, const char *ssid, const char *password);
 
 /**
- * @brief Kết nối WiFi
+ * @brief Bắt đầu một lần kết nối WiFi (không chặn)
+ *
+ * Thử kết nối nhanh nếu có thông tin đã lưu; sau WIFI_FAST_CONNECT_MAX_RETRY
+ * lần thất bại, lần tiếp theo quét toàn bộ + DHCP. Driver không tự thử lại:
+ * khi lần thử thất bại hoặc mất kết nối, WIFI_FAIL_BIT được đặt và người gọi
+ * quyết định thời điểm gọi lại.
+ *
  * @param manager Con trỏ đến cấu trúc quản lý WiFi
- * @return 0 nếu thành công, -1 nếu lỗi
+ * @return 0 nếu đã bắt đầu, -1 nếu lỗi
+ */
+int wifi_start_connect(wifi_manager_t *manager);
+
+/**
+ * @brief Hủy lần kết nối đang chạy hoặc kết nối hiện tại (giữ WiFi driver chạy)
+ * @param manager Con trỏ đến cấu trúc quản lý WiFi
+ * @return 0 nếu thành công
+ */
+int wifi_abort_connect(wifi_manager_t *manager);
+
+/**
+ * @brief Kết nối WiFi (chặn, một lần thử)
+ *
+ * Gọi wifi_start_connect() và chờ có IP, thất bại hoặc tối đa
+ * WIFI_CONNECT_TIMEOUT_MS. Có thể gọi lại sau khi thất bại để thử lại.
+ *
+ * @param manager Con trỏ đến cấu trúc quản lý WiFi
+ * @return 0 nếu thành công, -1 nếu lỗi hoặc hết thời gian chờ
  */
 int wifi_connect(wifi_manager_t *manager);
 